@@ -90,13 +90,11 @@ set_key(const uint8_t *key)
 }
 /*---------------------------------------------------------------------------*/
 static void
-encrypt(uint8_t *plaintext_and_result)
+encrypt_block(uint8_t *plaintext_and_result)
 {
-  uint8_t crypto_enabled, ret;
+  uint8_t ret;
   int8_t res;
 
-  crypto_enabled = enable_crypto();
-
   ret = ecb_crypt_start(true, CC2538_AES_128_KEY_AREA, plaintext_and_result,
                         plaintext_and_result, AES_128_BLOCK_SIZE, NULL);
   if(ret != CRYPTO_SUCCESS) {
@@ -109,13 +107,35 @@ encrypt(uint8_t *plaintext_and_result)
     PRINTF("%s: ecb_crypt_check_status() error %d\n", MODULE_NAME, res);
     sys_ctrl_reset();
   }
+}
+/*---------------------------------------------------------------------------*/
+static void
+encrypt(uint8_t *plaintext_and_result)
+{
+  uint8_t crypto_enabled;
 
+  crypto_enabled = enable_crypto();
+  encrypt_block(plaintext_and_result);
+  restore_crypto(crypto_enabled);
+}
+/*---------------------------------------------------------------------------*/
+static void
+encrypt_blocks(uint8_t *plaintexts_and_results, uint8_t count)
+{
+  uint8_t crypto_enabled;
+
+  crypto_enabled = enable_crypto();
+  while(count--) {
+    encrypt_block(plaintexts_and_results);
+    plaintexts_and_results += AES_128_BLOCK_SIZE;
+  }
   restore_crypto(crypto_enabled);
 }
 /*---------------------------------------------------------------------------*/
 const struct aes_128_driver cc2538_aes_128_driver = {
   set_key,
-  encrypt
+  encrypt,
+  encrypt_blocks
 };
 
 /** @} */
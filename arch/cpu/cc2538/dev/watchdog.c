@@ -45,6 +45,7 @@
 #include "reg.h"
 #include "cpu.h"
 #include "dev/smwdthrosc.h"
+#include "sys/log.h"
 /*---------------------------------------------------------------------------*/
 /* Enabled by default */
 #ifndef WATCHDOG_CONF_ENABLE
@@ -93,6 +94,8 @@ watchdog_periodic(void)
 void
 watchdog_reboot(void)
 {
+  LOG_SYNC();
+
   INTERRUPTS_DISABLE();
 
   /*
@@ -45,6 +45,7 @@
 #include "contiki.h"
 #include "dev/watchdog.h"
 #include "ti-lib.h"
+#include "sys/log.h"
 
 #include <stdbool.h>
 #include <stdint.h>
@@ -154,6 +155,7 @@ watchdog_stop(void)
 void
 watchdog_reboot(void)
 {
+  LOG_SYNC();
   watchdog_start();
   while(1);
 }
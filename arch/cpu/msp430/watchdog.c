@@ -33,6 +33,7 @@
 #include "contiki.h"
 #include "dev/watchdog.h"
 #include "isr_compat.h"
+#include "sys/log.h"
 
 static int counter = 0;
 
@@ -148,6 +149,7 @@ watchdog_stop(void)
 void
 watchdog_reboot(void)
 {
+  LOG_SYNC();
   WDTCTL = 0;
 }
 /*---------------------------------------------------------------------------*/
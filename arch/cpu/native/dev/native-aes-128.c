@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2019, RISE SICS AB.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         AES-128 driver for native platforms. Uses the AES-NI instructions
+ *         of x86 CPUs when available, and falls back to the software
+ *         implementation otherwise.
+ */
+
+#include "contiki.h"
+#include "dev/native-aes-128.h"
+
+#include <string.h>
+/*---------------------------------------------------------------------------*/
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define NATIVE_AES_128_WITH_AESNI 1
+#else
+#define NATIVE_AES_128_WITH_AESNI 0
+#endif
+
+#if NATIVE_AES_128_WITH_AESNI
+#include <wmmintrin.h>
+
+#define AESNI __attribute__((target("aes,sse2")))
+
+static __m128i round_keys[11];
+static int8_t has_aesni = -1;
+/*---------------------------------------------------------------------------*/
+static int
+use_aesni(void)
+{
+  if(has_aesni < 0) {
+    __builtin_cpu_init();
+    has_aesni = __builtin_cpu_supports("aes") ? 1 : 0;
+  }
+  return has_aesni;
+}
+/*---------------------------------------------------------------------------*/
+static inline AESNI __m128i
+expand_step(__m128i key, __m128i assist)
+{
+  assist = _mm_shuffle_epi32(assist, _MM_SHUFFLE(3, 3, 3, 3));
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+  return _mm_xor_si128(key, assist);
+}
+/*---------------------------------------------------------------------------*/
+#define EXPAND(i, rcon) \
+  round_keys[i] = expand_step(round_keys[i - 1], \
+                              _mm_aeskeygenassist_si128(round_keys[i - 1], rcon))
+
+static AESNI void
+aesni_set_key(const uint8_t *key)
+{
+  round_keys[0] = _mm_loadu_si128((const __m128i *)key);
+  EXPAND(1, 0x01);
+  EXPAND(2, 0x02);
+  EXPAND(3, 0x04);
+  EXPAND(4, 0x08);
+  EXPAND(5, 0x10);
+  EXPAND(6, 0x20);
+  EXPAND(7, 0x40);
+  EXPAND(8, 0x80);
+  EXPAND(9, 0x1b);
+  EXPAND(10, 0x36);
+}
+/*---------------------------------------------------------------------------*/
+static AESNI void
+aesni_encrypt_blocks(uint8_t *blocks, uint8_t count)
+{
+  __m128i b0, b1, b2, b3;
+  uint8_t round;
+
+  /* Interleave four blocks to keep the AES unit busy */
+  while(count >= 4) {
+    b0 = _mm_xor_si128(_mm_loadu_si128((__m128i *)blocks), round_keys[0]);
+    b1 = _mm_xor_si128(_mm_loadu_si128((__m128i *)(blocks + 16)), round_keys[0]);
+    b2 = _mm_xor_si128(_mm_loadu_si128((__m128i *)(blocks + 32)), round_keys[0]);
+    b3 = _mm_xor_si128(_mm_loadu_si128((__m128i *)(blocks + 48)), round_keys[0]);
+    for(round = 1; round < 10; round++) {
+      b0 = _mm_aesenc_si128(b0, round_keys[round]);
+      b1 = _mm_aesenc_si128(b1, round_keys[round]);
+      b2 = _mm_aesenc_si128(b2, round_keys[round]);
+      b3 = _mm_aesenc_si128(b3, round_keys[round]);
+    }
+    _mm_storeu_si128((__m128i *)blocks, _mm_aesenclast_si128(b0, round_keys[10]));
+    _mm_storeu_si128((__m128i *)(blocks + 16), _mm_aesenclast_si128(b1, round_keys[10]));
+    _mm_storeu_si128((__m128i *)(blocks + 32), _mm_aesenclast_si128(b2, round_keys[10]));
+    _mm_storeu_si128((__m128i *)(blocks + 48), _mm_aesenclast_si128(b3, round_keys[10]));
+    blocks += 4 * AES_128_BLOCK_SIZE;
+    count -= 4;
+  }
+
+  while(count--) {
+    b0 = _mm_xor_si128(_mm_loadu_si128((__m128i *)blocks), round_keys[0]);
+    for(round = 1; round < 10; round++) {
+      b0 = _mm_aesenc_si128(b0, round_keys[round]);
+    }
+    _mm_storeu_si128((__m128i *)blocks, _mm_aesenclast_si128(b0, round_keys[10]));
+    blocks += AES_128_BLOCK_SIZE;
+  }
+}
+#else /* NATIVE_AES_128_WITH_AESNI */
+#define use_aesni() 0
+#define aesni_set_key(key)
+#define aesni_encrypt_blocks(blocks, count)
+#endif /* NATIVE_AES_128_WITH_AESNI */
+/*---------------------------------------------------------------------------*/
+static void
+set_key(const uint8_t *key)
+{
+  if(use_aesni()) {
+    aesni_set_key(key);
+  } else {
+    aes_128_driver.set_key(key);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+encrypt(uint8_t *plaintext_and_result)
+{
+  if(use_aesni()) {
+    aesni_encrypt_blocks(plaintext_and_result, 1);
+  } else {
+    aes_128_driver.encrypt(plaintext_and_result);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+encrypt_blocks(uint8_t *plaintexts_and_results, uint8_t count)
+{
+  if(use_aesni()) {
+    aesni_encrypt_blocks(plaintexts_and_results, count);
+  } else {
+    aes_128_driver.encrypt_blocks(plaintexts_and_results, count);
+  }
+}
+/*---------------------------------------------------------------------------*/
+const struct aes_128_driver native_aes_128_driver = {
+  set_key,
+  encrypt,
+  encrypt_blocks
+};
+/*---------------------------------------------------------------------------*/
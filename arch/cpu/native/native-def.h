@@ -34,5 +34,9 @@
 /*---------------------------------------------------------------------------*/
 #define GPIO_HAL_CONF_ARCH_SW_TOGGLE 1
 /*---------------------------------------------------------------------------*/
+#ifndef AES_128_CONF
+#define AES_128_CONF native_aes_128_driver
+#endif /* AES_128_CONF */
+/*---------------------------------------------------------------------------*/
 #endif /* NATIVE_DEF_H_ */
 /*---------------------------------------------------------------------------*/
@@ -42,6 +42,7 @@
 #include <nrf_drv_wdt.h>
 #include "app_error.h"
 #include "contiki.h"
+#include "sys/log.h"
 
 static nrf_drv_wdt_channel_id wdt_channel_id;
 static uint8_t wdt_initialized = 0;
@@ -85,6 +86,7 @@ watchdog_periodic(void)
 void
 watchdog_reboot(void)
 {
+  LOG_SYNC();
   NVIC_SystemReset();
 }
 /**
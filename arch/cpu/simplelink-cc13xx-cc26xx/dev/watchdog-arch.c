@@ -45,6 +45,7 @@
 /*---------------------------------------------------------------------------*/
 #include "contiki.h"
 #include "dev/watchdog.h"
+#include "sys/log.h"
 /*---------------------------------------------------------------------------*/
 #include <Board.h>
 
@@ -132,6 +133,8 @@ watchdog_reboot(void)
     return;
   }
 
+  LOG_SYNC();
+
   watchdog_start();
 
   /* Busy loop until watchdog times out */
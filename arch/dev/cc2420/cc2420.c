@@ -569,9 +569,19 @@ encrypt(uint8_t *plaintext_and_result)
   RELEASE_LOCK();
 }
 /*---------------------------------------------------------------------------*/
+static void
+encrypt_blocks(uint8_t *plaintexts_and_results, uint8_t count)
+{
+  while(count--) {
+    encrypt(plaintexts_and_results);
+    plaintexts_and_results += AES_128_BLOCK_SIZE;
+  }
+}
+/*---------------------------------------------------------------------------*/
 const struct aes_128_driver cc2420_aes_128_driver = {
   set_key,
-  encrypt
+  encrypt,
+  encrypt_blocks
 };
 /*---------------------------------------------------------------------------*/
 static void
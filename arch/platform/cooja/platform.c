@@ -84,6 +84,7 @@
 #define COOJA_JNI_PATH Java_org_contikios_cooja_corecomm_
 #define Java_org_contikios_cooja_corecomm_CLASSNAME_init COOJA__QUOTEME(COOJA_JNI_PATH,CLASSNAME,_init)
 #define Java_org_contikios_cooja_corecomm_CLASSNAME_getMemory COOJA__QUOTEME(COOJA_JNI_PATH,CLASSNAME,_getMemory)
+#define Java_org_contikios_cooja_corecomm_CLASSNAME_getChangedMemory COOJA__QUOTEME(COOJA_JNI_PATH,CLASSNAME,_getChangedMemory)
 #define Java_org_contikios_cooja_corecomm_CLASSNAME_setMemory COOJA__QUOTEME(COOJA_JNI_PATH,CLASSNAME,_setMemory)
 #define Java_org_contikios_cooja_corecomm_CLASSNAME_tick COOJA__QUOTEME(COOJA_JNI_PATH,CLASSNAME,_tick)
 #define Java_org_contikios_cooja_corecomm_CLASSNAME_setReferenceAddress COOJA__QUOTEME(COOJA_JNI_PATH,CLASSNAME,_setReferenceAddress)
@@ -265,6 +266,56 @@ Java_org_contikios_cooja_corecomm_CLASSNAME_getMemory(JNIEnv *env, jobject obj,
   );
 }
 /*---------------------------------------------------------------------------*/
+/**
+ * \brief      Copy the changed blocks of a segment from the process memory.
+ * \param env        JNI Environment interface pointer
+ * \param obj        unused
+ * \param rel_addr   Start address of segment
+ * \param length     Size of memory segment
+ * \param mem_arr    Byte array holding an earlier copy of the segment
+ * \param block_size Size of the compared blocks
+ * \param changed_arr Byte array set to 1 per changed block, 0 otherwise
+ * \return     The number of changed blocks
+ *
+ *             Compares the memory segment starting at (rel_addr), with size
+ *             (length), block by block with the Java array, and copies only
+ *             the blocks that differ. The arrays are accessed in place, so
+ *             unchanged blocks are never copied. Like getMemory(), this
+ *             function does not perform ANY error checking.
+ *
+ *             This is a JNI function and should only be called via the
+ *             responsible Java part (MoteType.java).
+ */
+JNIEXPORT jint JNICALL
+Java_org_contikios_cooja_corecomm_CLASSNAME_getChangedMemory(JNIEnv *env, jobject obj, jint rel_addr, jint length, jbyteArray mem_arr, jint block_size, jbyteArray changed_arr)
+{
+  const jbyte *core = (jbyte *) (((long)rel_addr) + referenceVar);
+  jbyte *mem;
+  jbyte *changed;
+  jint count = 0;
+  jint start;
+  jint len;
+
+  /* No JNI calls are allowed until the arrays are released */
+  mem = (*env)->GetPrimitiveArrayCritical(env, mem_arr, NULL);
+  changed = (*env)->GetPrimitiveArrayCritical(env, changed_arr, NULL);
+
+  for(start = 0; start < length; start += block_size) {
+    len = length - start < block_size ? length - start : block_size;
+    if(memcmp(mem + start, core + start, len) != 0) {
+      memcpy(mem + start, core + start, len);
+      changed[start / block_size] = 1;
+      count++;
+    } else {
+      changed[start / block_size] = 0;
+    }
+  }
+
+  (*env)->ReleasePrimitiveArrayCritical(env, changed_arr, changed, 0);
+  (*env)->ReleasePrimitiveArrayCritical(env, mem_arr, mem, 0);
+  return count;
+}
+/*---------------------------------------------------------------------------*/
 /**
  * \brief      Replace a segment of the process memory with given byte array.
  * \param env      JNI Environment interface pointer
@@ -283,11 +334,15 @@ Java_org_contikios_cooja_corecomm_CLASSNAME_getMemory(JNIEnv *env, jobject obj,
 JNIEXPORT void JNICALL
 Java_org_contikios_cooja_corecomm_CLASSNAME_setMemory(JNIEnv *env, jobject obj, jint rel_addr, jint length, jbyteArray mem_arr)
 {
-  jbyte *mem = (*env)->GetByteArrayElements(env, mem_arr, 0);
-  memcpy((char*) (((long)rel_addr) + referenceVar),
-         mem,
-         length);
-  (*env)->ReleaseByteArrayElements(env, mem_arr, mem, 0);
+  /* Copy straight into the process memory - GetByteArrayElements() would
+     copy the array in, and back out again on release */
+  (*env)->GetByteArrayRegion(
+      env,
+      mem_arr,
+      0,
+      (size_t) length,
+      (jbyte *) (((long)rel_addr) + referenceVar)
+  );
 }
 /*---------------------------------------------------------------------------*/
 /**
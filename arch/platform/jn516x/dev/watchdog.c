@@ -39,6 +39,7 @@
  */
 
 #include "dev/watchdog.h"
+#include "sys/log.h"
 #include "AppHardwareApi.h"
 
 /*---------------------------------------------------------------------------*/
@@ -85,6 +86,7 @@ watchdog_stop(void)
 void
 watchdog_reboot(void)
 {
+  LOG_SYNC();
   vAHI_SwReset();
 }
 /*---------------------------------------------------------------------------*/
@@ -43,6 +43,7 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <sys/select.h>
@@ -249,6 +250,10 @@ platform_init_stage_one()
   gpio_hal_init();
   button_hal_init();
   leds_init();
+#if LOG_DEFERRED
+  /* Output the queued messages when the program exits */
+  atexit(log_deferred_flush);
+#endif /* LOG_DEFERRED */
   return;
 }
 /*---------------------------------------------------------------------------*/
@@ -0,0 +1,248 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2019, RISE SICS AB.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+# 1. Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+# 2. Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+# 3. Neither the name of the copyright holder nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+# FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+# COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+# INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+# (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+# HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+# STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+# ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+# OF THE POSSIBILITY OF SUCH DAMAGE.
+
+"""
+Runs the rpl-req-resp benchmark over a matrix of MAC, routing, topology
+size and traffic pattern, with tools/cooja-batch, and summarizes every
+configuration as the mean over its seeds. The summary can be compared to
+a baseline summary to catch performance regressions:
+
+    ./benchmark.py run -o bench
+    ./benchmark.py compare bench/summary.json baseline.json
+
+Topologies other than the one of sim.csc are random connected layouts,
+generated from sim.csc with one mote every DENSITY square meters.
+"""
+
+import argparse
+import copy
+import csv
+import json
+import math
+import os
+import random
+import subprocess
+import sys
+import xml.etree.ElementTree as ET
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+COOJA_BATCH = os.path.normpath(os.path.join(HERE, "../../../tools/cooja-batch/cooja-batch.py"))
+
+# The parameters of a configuration, as passed to make
+MATRIX_KEYS = ("CONFIG", "ROUTING", "NODES", "TRAFFIC")
+
+# Metrics compared to the baseline, and whether higher values are better
+METRICS = {
+    "pdr": True,
+    "latency": False,
+    "latency-p50": False,
+    "latency-p90": False,
+    "latency-p99": False,
+    "duty-cycle": False,
+    "channel-utilization": False,
+    "control-overhead": False,
+    "network-formation-time": False,
+}
+
+# Area per mote, in square meters, of generated topologies
+DENSITY = 1200.0
+
+
+def generate_topology(csc, nodes, out, seed=1):
+    """Writes a copy of csc with a random connected layout of the given size."""
+    tree = ET.parse(csc)
+    simulation = tree.getroot().find("simulation")
+    motes = simulation.findall("mote")
+    if len(motes) == nodes:
+        tree.write(out, encoding="UTF-8", xml_declaration=True)
+        return
+
+    radio_range = float(simulation.find("radiomedium/transmitting_range").text)
+    side = math.sqrt(nodes * DENSITY)
+    rng = random.Random(seed)
+    # Place every new mote in range of one that is already placed
+    positions = [(0.0, 0.0)]
+    while len(positions) < nodes:
+        x, y = rng.uniform(0, side), rng.uniform(0, side)
+        if any(math.hypot(x - px, y - py) < 0.9 * radio_range for px, py in positions):
+            positions.append((x, y))
+
+    template = motes[0]
+    for mote in motes:
+        simulation.remove(mote)
+    for i, (x, y) in enumerate(positions):
+        mote = copy.deepcopy(template)
+        for config in mote.findall("interface_config"):
+            if config.find("x") is not None:
+                config.find("x").text = "%.2f" % x
+                config.find("y").text = "%.2f" % y
+            if config.find("id") is not None:
+                config.find("id").text = str(i + 1)
+        simulation.append(mote)
+    tree.write(out, encoding="UTF-8", xml_declaration=True)
+
+
+def summarize(rows):
+    """Returns one entry per configuration with the mean of every metric over its seeds."""
+    configs = {}
+    for row in rows:
+        key = tuple(str(row.get(k, "")) for k in MATRIX_KEYS)
+        configs.setdefault(key, []).append(row)
+
+    summary = []
+    for key, runs in sorted(configs.items()):
+        entry = dict(zip(MATRIX_KEYS, key))
+        ok = [run for run in runs if run.get("status") == "OK"]
+        entry["runs"] = len(runs)
+        entry["failed"] = len(runs) - len(ok)
+        for metric in METRICS:
+            values = [run[metric] for run in ok if isinstance(run.get(metric), (int, float))]
+            if values:
+                entry[metric] = round(sum(values) / len(values), 4)
+        summary.append(entry)
+    return summary
+
+
+def write_summary(out, summary):
+    columns = list(MATRIX_KEYS) + ["runs", "failed"] + list(METRICS)
+    with open(os.path.join(out, "summary.csv"), "w", newline="") as f:
+        writer = csv.DictWriter(f, fieldnames=columns)
+        writer.writeheader()
+        writer.writerows(summary)
+    with open(os.path.join(out, "summary.json"), "w") as f:
+        json.dump(summary, f, indent=2)
+
+
+def compare(summary, baseline, tolerance):
+    """Prints the change of every metric against the baseline, returns the regressions."""
+    reference = {tuple(entry[k] for k in MATRIX_KEYS): entry for entry in baseline}
+    regressions = []
+    for entry in summary:
+        key = tuple(entry[k] for k in MATRIX_KEYS)
+        base = reference.get(key)
+        if base is None:
+            print("%-60s no baseline" % " ".join(key))
+            continue
+        for metric, higher_is_better in METRICS.items():
+            if metric not in entry or metric not in base:
+                continue
+            new, old = entry[metric], base[metric]
+            change = (new - old) / abs(old) if old != 0 else (0.0 if new == old else math.inf)
+            worse = -change if higher_is_better else change
+            status = "REGRESSION" if worse > tolerance else ""
+            if status:
+                regressions.append((key, metric, old, new))
+            print("%-60s %-24s %10.4f -> %10.4f %+8.1f%% %s"
+                  % (" ".join(key), metric, old, new, 100 * change, status))
+        if entry.get("failed", 0) > base.get("failed", 0):
+            regressions.append((key, "failed", base.get("failed", 0), entry["failed"]))
+            print("%-60s %-24s %10d -> %10d %s"
+                  % (" ".join(key), "failed", base.get("failed", 0), entry["failed"], "REGRESSION"))
+    return regressions
+
+
+def cmd_run(args):
+    os.makedirs(args.out, exist_ok=True)
+    rows = []
+    for nodes in args.nodes.split(","):
+        out = os.path.join(args.out, "nodes-%s" % nodes)
+        os.makedirs(out, exist_ok=True)
+        csc = os.path.join(out, "topology.csc")
+        generate_topology(os.path.join(HERE, "sim.csc"), int(nodes), csc)
+        cmd = [sys.executable, COOJA_BATCH, csc,
+               "--parser", os.path.join(HERE, "parse.py"),
+               "-p", "CONFIG=" + args.mac,
+               "-p", "ROUTING=" + args.routing,
+               "-p", "NODES=" + nodes,
+               "-p", "TRAFFIC=" + args.traffic,
+               "-s", str(args.seeds), "-d", str(args.duration), "-o", out]
+        if args.jobs:
+            cmd += ["-j", str(args.jobs)]
+        print(" ".join(cmd))
+        subprocess.call(cmd)
+        results = os.path.join(out, "results.json")
+        if os.path.exists(results):
+            with open(results) as f:
+                rows += json.load(f)
+
+    summary = summarize(rows)
+    write_summary(args.out, summary)
+    print("Summary in %s" % os.path.join(args.out, "summary.{csv,json}"))
+
+    if args.baseline:
+        with open(args.baseline) as f:
+            return 1 if compare(summary, json.load(f), args.tolerance) else 0
+    return 1 if any(entry["failed"] for entry in summary) else 0
+
+
+def cmd_compare(args):
+    with open(args.summary) as f:
+        summary = json.load(f)
+    with open(args.baseline) as f:
+        baseline = json.load(f)
+    regressions = compare(summary, baseline, args.tolerance)
+    print("%d regression(s)" % len(regressions))
+    return 1 if regressions else 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Run the rpl-req-resp benchmark matrix and compare it to a baseline.")
+    subparsers = parser.add_subparsers(dest="command")
+    subparsers.required = True
+
+    run = subparsers.add_parser("run", help="run the benchmark matrix")
+    run.add_argument("--mac", default="CONFIG_CSMA,CONFIG_TSCH_OPTIMS",
+                     help="MAC configurations (CONFIG in the Makefile)")
+    run.add_argument("--routing", default="RPL_LITE,RPL_CLASSIC_STORING,RPL_CLASSIC_NON_STORING",
+                     help="routing protocols")
+    run.add_argument("--nodes", default="8,16,32", help="topology sizes")
+    run.add_argument("--traffic", default="DOWN,UP,ANY,BURSTY", help="traffic patterns")
+    run.add_argument("-s", "--seeds", type=int, default=3, help="number of random seeds per configuration")
+    run.add_argument("-d", "--duration", type=int, default=30, help="simulated minutes")
+    run.add_argument("-j", "--jobs", type=int, help="simulations to run in parallel")
+    run.add_argument("-o", "--out", default="bench", help="output directory")
+    run.add_argument("--baseline", help="baseline summary to compare to")
+    run.add_argument("--tolerance", type=float, default=0.1,
+                     help="relative change of a metric counted as a regression")
+    run.set_defaults(func=cmd_run)
+
+    cmp = subparsers.add_parser("compare", help="compare a summary to a baseline")
+    cmp.add_argument("summary", help="summary.json of a run")
+    cmp.add_argument("baseline", help="baseline summary.json")
+    cmp.add_argument("--tolerance", type=float, default=0.1,
+                     help="relative change of a metric counted as a regression")
+    cmp.set_defaults(func=cmd_compare)
+
+    args = parser.parse_args()
+    return args.func(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -32,8 +32,16 @@
 
 /**
  * \file
- *         Benchmark: the root sends requests to all nodes in a randomized
- *         order, and receives resopnses back.
+ *         Benchmark: nodes send requests and receive responses back,
+ *         following one of the traffic patterns below.
+ *         - TRAFFIC_DOWN: the root sends requests to all nodes in a
+ *           randomized order
+ *         - TRAFFIC_UP: all nodes send requests to the root
+ *         - TRAFFIC_ANY: all nodes send requests to random other nodes
+ *         - TRAFFIC_BURSTY: like TRAFFIC_DOWN, but in bursts of
+ *           BURST_SIZE back-to-back requests
+ *         In all patterns, the network as a whole sends one request per
+ *         SEND_INTERVAL on average.
  * \author
  *         Simon Duquennoy <simon.duquennoy@ri.se>
  */
@@ -41,6 +49,7 @@
 #include "contiki.h"
 #include "contiki-net.h"
 #include "services/deployment/deployment.h"
+#include "services/radio-accounting/radio-accounting.h"
 
 /* Log configuration */
 #include "sys/log.h"
@@ -49,12 +58,25 @@
 
 #define UDP_PORT 8214
 #define SEND_INTERVAL (CLOCK_SECOND)
+#define BURST_SIZE 5
+#define STATS_INTERVAL (60 * CLOCK_SECOND)
+
+#define TRAFFIC_DOWN    0
+#define TRAFFIC_UP      1
+#define TRAFFIC_ANY     2
+#define TRAFFIC_BURSTY  3
+
+#ifndef TRAFFIC
+#define TRAFFIC TRAFFIC_DOWN
+#endif
 
 static struct simple_udp_connection udp_conn;
+static uint32_t count;
 
 /*---------------------------------------------------------------------------*/
 PROCESS(app_process, "App process");
-AUTOSTART_PROCESSES(&app_process);
+PROCESS(stats_process, "Stats process");
+AUTOSTART_PROCESSES(&app_process, &stats_process);
 
 /*---------------------------------------------------------------------------*/
 static void
@@ -91,6 +113,44 @@ udp_rx_callback(struct simple_udp_connection *c,
   }
 }
 /*---------------------------------------------------------------------------*/
+static int
+joined_node_count(void)
+{
+#if ROUTING_CONF_RPL_CLASSIC && RPL_WITH_STORING
+  /* The root has a route to every other node */
+  return uip_ds6_route_num_routes() + 1;
+#else
+  return uip_sr_num_nodes();
+#endif
+}
+/*---------------------------------------------------------------------------*/
+static void
+send_request(uip_ipaddr_t *dest_ipaddr)
+{
+  /* Request: most significant bit not unset */
+  LOG_INFO("Sending request %"PRIu32" to ", count);
+  LOG_INFO_6ADDR(dest_ipaddr);
+  LOG_INFO_("\n");
+  simple_udp_sendto(&udp_conn, &count, sizeof(count), dest_ipaddr);
+  count++;
+}
+/*---------------------------------------------------------------------------*/
+#if TRAFFIC != TRAFFIC_UP
+static void
+set_random_dest(uip_ipaddr_t *dest_ipaddr)
+{
+  uint16_t dest_id;
+
+  /* Select a destination at random. Iterate until we select neither
+   * ourselves nor the root */
+  do {
+    dest_id = deployment_id_from_index(random_rand() % deployment_node_count());
+  } while(dest_id == ROOT_ID || dest_id == node_id);
+  /* Prefix was already set, set IID now */
+  deployment_iid_from_id(dest_ipaddr, dest_id);
+}
+#endif /* TRAFFIC != TRAFFIC_UP */
+/*---------------------------------------------------------------------------*/
 PROCESS_THREAD(app_process, ev, data)
 {
   static struct etimer timer;
@@ -122,33 +182,81 @@ PROCESS_THREAD(app_process, ev, data)
         LOG_WARN("Not enough routing entries for deployment: %u/%u\n",
                   deployment_node_count(), NETSTACK_MAX_ROUTE_ENTRIES);
       }
-      LOG_INFO("Node count: %u/%u\n", uip_sr_num_nodes(), deployment_node_count());
+      LOG_INFO("Node count: %u/%u\n", joined_node_count(), deployment_node_count());
 
-    } while(uip_sr_num_nodes() < deployment_node_count());
+    } while(joined_node_count() < deployment_node_count());
+    /* Requests sent before this point are not part of the results */
+    LOG_INFO("Network formed\n");
 
+#if TRAFFIC == TRAFFIC_DOWN || TRAFFIC == TRAFFIC_BURSTY
     /* Now start requesting nodes at random */
-    etimer_set(&timer, SEND_INTERVAL);
-    while(uip_sr_num_nodes() == deployment_node_count()) {
-      static uint32_t count = 0;
-      uint16_t dest_id;
+    etimer_set(&timer, TRAFFIC == TRAFFIC_BURSTY ? BURST_SIZE * SEND_INTERVAL : SEND_INTERVAL);
+    while(joined_node_count() == deployment_node_count()) {
+      static uint8_t i;
 
       PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&timer));
       etimer_reset(&timer);
 
-      /* Select a destination at random. Iterate until we do not select ourselve */
-      do {
-        dest_id = deployment_id_from_index(random_rand() % deployment_node_count());
-      } while(dest_id == ROOT_ID);
-      /* Prefix was already set, set IID now */
-      deployment_iid_from_id(&dest_ipaddr, dest_id);
-
-      /* Request: most significant bit not unset */
-      LOG_INFO("Sending request %"PRIu32" to ", count);
-      LOG_INFO_6ADDR(&dest_ipaddr);
-      LOG_INFO_("\n");
-      simple_udp_sendto(&udp_conn, &count, sizeof(count), &dest_ipaddr);
-      count++;
+      for(i = 0; i < (TRAFFIC == TRAFFIC_BURSTY ? BURST_SIZE : 1); i++) {
+        set_random_dest(&dest_ipaddr);
+        send_request(&dest_ipaddr);
+      }
+    }
+#endif /* TRAFFIC == TRAFFIC_DOWN || TRAFFIC == TRAFFIC_BURSTY */
+  }
+#if TRAFFIC == TRAFFIC_UP || TRAFFIC == TRAFFIC_ANY
+  else {
+    /* Every node sends at a fraction of the rate so that the network
+     * sends one request per SEND_INTERVAL */
+    etimer_set(&timer, random_rand() % ((deployment_node_count() - 1) * SEND_INTERVAL));
+    while(1) {
+      PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&timer));
+      etimer_set(&timer, (deployment_node_count() - 1) * SEND_INTERVAL / 2
+                 + random_rand() % ((deployment_node_count() - 1) * SEND_INTERVAL));
+
+      if(NETSTACK_ROUTING.node_is_reachable()
+         && NETSTACK_ROUTING.get_root_ipaddr(&dest_ipaddr)) {
+#if TRAFFIC == TRAFFIC_ANY
+        set_random_dest(&dest_ipaddr);
+#endif /* TRAFFIC == TRAFFIC_ANY */
+        send_request(&dest_ipaddr);
+      }
+    }
+  }
+#endif /* TRAFFIC == TRAFFIC_UP || TRAFFIC == TRAFFIC_ANY */
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(stats_process, ev, data)
+{
+  static struct etimer timer;
+  const struct radio_accounting_stats *stats;
+  unsigned long frames, bytes;
+  unsigned long control_frames, control_bytes;
+  uint8_t i;
+
+  PROCESS_BEGIN();
+
+  etimer_set(&timer, STATS_INTERVAL);
+  while(1) {
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&timer));
+    etimer_reset(&timer);
+
+    /* Control traffic is everything sent by MAC, RPL and ICMPv6 */
+    frames = bytes = control_frames = control_bytes = 0;
+    for(i = 0; i < RADIO_ACCOUNTING_CATEGORY_MAX; i++) {
+      stats = radio_accounting_get(i);
+      frames += stats->tx.frames;
+      bytes += stats->tx.bytes;
+      if(i == RADIO_ACCOUNTING_MAC || i == RADIO_ACCOUNTING_RPL
+         || i == RADIO_ACCOUNTING_ICMP6) {
+        control_frames += stats->tx.frames;
+        control_bytes += stats->tx.bytes;
+      }
     }
+    LOG_INFO("Tx control frames %lu/%lu bytes %lu/%lu\n",
+             control_frames, frames, control_bytes, bytes);
   }
 
   PROCESS_END();
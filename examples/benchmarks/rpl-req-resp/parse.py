@@ -86,6 +86,18 @@ def parseEnergest(log):
     return None
 
 def parseApp(log):
+    res = re.compile('Network formed').match(log)
+    if res:
+        return {'event': 'formed' }
+    res = re.compile('Tx control frames (\d+)/(\d+) bytes (\d+)/(\d+)').match(log)
+    if res:
+        controlFrames = int(res.group(1))
+        frames = int(res.group(2))
+        controlBytes = int(res.group(3))
+        bytes = int(res.group(4))
+        return {'event': 'tx-stats', 'control-frames': controlFrames, 'frames': frames,
+                'control-bytes': controlBytes, 'bytes': bytes,
+                'control-overhead': 100.*controlBytes/bytes if bytes > 0 else 0. }
     res = re.compile('Sending (.+?) (\d+) to 6G-(\d+)').match(log)
     if res:
         type = res.group(1)
@@ -117,8 +129,12 @@ def doParse(file):
     time = None
     lastPrintedTime = 0
 
+    # Sent requests, indexed by sender and request id
+    requests = {}
+
     arrays = {
         "packets": [],
+        "overhead": [],
         "energest": [],
         "ranks": [],
         "trickle": [],
@@ -151,17 +167,22 @@ def doParse(file):
                 ret = parseApp(log)
                 if(ret != None):
                     entry.update(ret)
-                    if(ret['event'] == 'send' and ret['type'] == 'request'):
-                        # populate series of sent requests
-                        entry['pdr'] = 0.
-                        arrays["packets"].append(entry)
-                        if networkFormationTime == None:
-                            networkFormationTime = time
+                    if(ret['event'] == 'formed'):
+                        networkFormationTime = time
+                    elif(ret['event'] == 'send' and ret['type'] == 'request'):
+                        # populate series of sent requests, once the network is formed
+                        if networkFormationTime != None:
+                            entry['pdr'] = 0.
+                            arrays["packets"].append(entry)
+                            requests[(nodeid, ret['id'])] = entry
                     elif(ret['event'] == 'recv' and ret['type'] == 'response'):
                         # update sent request series with latency and PDR
-                        txElement = [x for x in arrays["packets"] if x['event']=='send' and x['id']==ret['id']][0]
-                        txElement['latency'] = time - txElement['timestamp'].seconds
-                        txElement['pdr'] = 100.
+                        txElement = requests.get((nodeid, ret['id']))
+                        if txElement != None:
+                            txElement['latency'] = time - txElement['timestamp'].total_seconds()
+                            txElement['pdr'] = 100.
+                    elif(ret['event'] == 'tx-stats'):
+                        arrays["overhead"].append(entry)
 
             if module == "Energest":
                 ret = parseEnergest(log)
@@ -220,7 +241,7 @@ def outputStats(dfs, key, metric, agg, name, metricLabel = None):
     print("      x: [%s]" %(", ".join(["%u"%x for x in sort(df.node.unique())])))
     print("      y: [%s]" %(', '.join(["%.4f"%(x) for x in perNode])))
     print("    per-time:")
-    print("      x: [%s]" %(", ".join(["%u"%x for x in range(0, 2*len(df.groupby([pd.Grouper(freq="2Min")]).mean().index), 2)])))
+    print("      x: [%s]" %(", ".join(["%u"%x for x in range(0, 2*len(perTime), 2)])))
     print("      y: [%s]" %(', '.join(["%.4f"%(x) for x in perTime]).replace("nan", "null")))
 
 def main():
@@ -241,8 +262,16 @@ def main():
     print("  packets-sent: %u" %(dfs["packets"]["pdr"].count()))
     print("  packets-received: %u" %(dfs["packets"]["pdr"].sum()/100))
     print("  latency: %.4f" %(dfs["packets"]["latency"].mean()))
+    print("  latency-p50: %.4f" %(dfs["packets"]["latency"].quantile(.50)))
+    print("  latency-p90: %.4f" %(dfs["packets"]["latency"].quantile(.90)))
+    print("  latency-p99: %.4f" %(dfs["packets"]["latency"].quantile(.99)))
     print("  duty-cycle: %.2f" %(dfs["energest"]["duty-cycle"].mean()))
     print("  channel-utilization: %.2f" %(dfs["energest"]["channel-utilization"].mean()))
+    if "overhead" in dfs:
+        # Counters are cumulative: use the last report of every node
+        last = dfs["overhead"].groupby("node").last()
+        print("  control-overhead: %.2f" %(100.*last["control-bytes"].sum()/max(last["bytes"].sum(), 1)))
+        print("  control-frames: %u" %(last["control-frames"].sum()))
     print("  network-formation-time: %.2f" %(networkFormationTime))
     print("stats:")
 
@@ -252,6 +281,7 @@ def main():
 
     outputStats(dfs, "energest", "duty-cycle", "mean", "Radio duty cycle (%)")
     outputStats(dfs, "energest", "channel-utilization", "mean", "Channel utilization (%)")
+    outputStats(dfs, "overhead", "control-overhead", "last", "Control overhead (% of tx bytes)")
 
     outputStats(dfs, "ranks", "rank", "mean", "RPL rank (ETX-128)")
     outputStats(dfs, "switches", "pswitch", "count", "RPL parent switches (#)")
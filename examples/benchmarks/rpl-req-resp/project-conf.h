@@ -4,7 +4,13 @@
 /* Testbed configuration */
 #define ROOT_ID 1
 #if CONTIKI_TARGET_COOJA
+#if NODES == 32
+#define DEPLOYMENT_MAPPING deployment_cooja32
+#elif NODES == 16
+#define DEPLOYMENT_MAPPING deployment_cooja16
+#else /* NODES */
 #define DEPLOYMENT_MAPPING deployment_cooja8
+#endif /* NODES */
 #else /* CONTIKI_TARGET_COOJA */
 #define DEPLOYMENT_MAPPING deployment_sics_firefly
 #endif /* CONTIKI_TARGET_COOJA */
@@ -16,7 +22,11 @@
 #define LOG_CONF_WITH_COMPACT_ADDR 1
 
 /* Provisioning */
+#if NODES > 24
+#define NETSTACK_MAX_ROUTE_ENTRIES 40
+#else /* NODES > 24 */
 #define NETSTACK_MAX_ROUTE_ENTRIES 25
+#endif /* NODES > 24 */
 #define NBR_TABLE_CONF_MAX_NEIGHBORS 8
 
 #if CONFIG_OPTIMS >= 1
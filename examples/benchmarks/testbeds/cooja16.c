@@ -0,0 +1,22 @@
+#include "services/deployment/deployment.h"
+
+/** \brief A mapping table for a 16-node Cooja mote simulation. */
+const struct id_mac deployment_cooja16[] = {
+  {  1, {{0x00,0x01,0x00,0x01,0x00,0x01,0x00,0x01}}},
+  {  2, {{0x00,0x02,0x00,0x02,0x00,0x02,0x00,0x02}}},
+  {  3, {{0x00,0x03,0x00,0x03,0x00,0x03,0x00,0x03}}},
+  {  4, {{0x00,0x04,0x00,0x04,0x00,0x04,0x00,0x04}}},
+  {  5, {{0x00,0x05,0x00,0x05,0x00,0x05,0x00,0x05}}},
+  {  6, {{0x00,0x06,0x00,0x06,0x00,0x06,0x00,0x06}}},
+  {  7, {{0x00,0x07,0x00,0x07,0x00,0x07,0x00,0x07}}},
+  {  8, {{0x00,0x08,0x00,0x08,0x00,0x08,0x00,0x08}}},
+  {  9, {{0x00,0x09,0x00,0x09,0x00,0x09,0x00,0x09}}},
+  { 10, {{0x00,0x0a,0x00,0x0a,0x00,0x0a,0x00,0x0a}}},
+  { 11, {{0x00,0x0b,0x00,0x0b,0x00,0x0b,0x00,0x0b}}},
+  { 12, {{0x00,0x0c,0x00,0x0c,0x00,0x0c,0x00,0x0c}}},
+  { 13, {{0x00,0x0d,0x00,0x0d,0x00,0x0d,0x00,0x0d}}},
+  { 14, {{0x00,0x0e,0x00,0x0e,0x00,0x0e,0x00,0x0e}}},
+  { 15, {{0x00,0x0f,0x00,0x0f,0x00,0x0f,0x00,0x0f}}},
+  { 16, {{0x00,0x10,0x00,0x10,0x00,0x10,0x00,0x10}}},
+  {  0, {{0}}}
+};
@@ -0,0 +1,38 @@
+#include "services/deployment/deployment.h"
+
+/** \brief A mapping table for a 32-node Cooja mote simulation. */
+const struct id_mac deployment_cooja32[] = {
+  {  1, {{0x00,0x01,0x00,0x01,0x00,0x01,0x00,0x01}}},
+  {  2, {{0x00,0x02,0x00,0x02,0x00,0x02,0x00,0x02}}},
+  {  3, {{0x00,0x03,0x00,0x03,0x00,0x03,0x00,0x03}}},
+  {  4, {{0x00,0x04,0x00,0x04,0x00,0x04,0x00,0x04}}},
+  {  5, {{0x00,0x05,0x00,0x05,0x00,0x05,0x00,0x05}}},
+  {  6, {{0x00,0x06,0x00,0x06,0x00,0x06,0x00,0x06}}},
+  {  7, {{0x00,0x07,0x00,0x07,0x00,0x07,0x00,0x07}}},
+  {  8, {{0x00,0x08,0x00,0x08,0x00,0x08,0x00,0x08}}},
+  {  9, {{0x00,0x09,0x00,0x09,0x00,0x09,0x00,0x09}}},
+  { 10, {{0x00,0x0a,0x00,0x0a,0x00,0x0a,0x00,0x0a}}},
+  { 11, {{0x00,0x0b,0x00,0x0b,0x00,0x0b,0x00,0x0b}}},
+  { 12, {{0x00,0x0c,0x00,0x0c,0x00,0x0c,0x00,0x0c}}},
+  { 13, {{0x00,0x0d,0x00,0x0d,0x00,0x0d,0x00,0x0d}}},
+  { 14, {{0x00,0x0e,0x00,0x0e,0x00,0x0e,0x00,0x0e}}},
+  { 15, {{0x00,0x0f,0x00,0x0f,0x00,0x0f,0x00,0x0f}}},
+  { 16, {{0x00,0x10,0x00,0x10,0x00,0x10,0x00,0x10}}},
+  { 17, {{0x00,0x11,0x00,0x11,0x00,0x11,0x00,0x11}}},
+  { 18, {{0x00,0x12,0x00,0x12,0x00,0x12,0x00,0x12}}},
+  { 19, {{0x00,0x13,0x00,0x13,0x00,0x13,0x00,0x13}}},
+  { 20, {{0x00,0x14,0x00,0x14,0x00,0x14,0x00,0x14}}},
+  { 21, {{0x00,0x15,0x00,0x15,0x00,0x15,0x00,0x15}}},
+  { 22, {{0x00,0x16,0x00,0x16,0x00,0x16,0x00,0x16}}},
+  { 23, {{0x00,0x17,0x00,0x17,0x00,0x17,0x00,0x17}}},
+  { 24, {{0x00,0x18,0x00,0x18,0x00,0x18,0x00,0x18}}},
+  { 25, {{0x00,0x19,0x00,0x19,0x00,0x19,0x00,0x19}}},
+  { 26, {{0x00,0x1a,0x00,0x1a,0x00,0x1a,0x00,0x1a}}},
+  { 27, {{0x00,0x1b,0x00,0x1b,0x00,0x1b,0x00,0x1b}}},
+  { 28, {{0x00,0x1c,0x00,0x1c,0x00,0x1c,0x00,0x1c}}},
+  { 29, {{0x00,0x1d,0x00,0x1d,0x00,0x1d,0x00,0x1d}}},
+  { 30, {{0x00,0x1e,0x00,0x1e,0x00,0x1e,0x00,0x1e}}},
+  { 31, {{0x00,0x1f,0x00,0x1f,0x00,0x1f,0x00,0x1f}}},
+  { 32, {{0x00,0x20,0x00,0x20,0x00,0x20,0x00,0x20}}},
+  {  0, {{0}}}
+};
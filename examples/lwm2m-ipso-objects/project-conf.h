@@ -65,6 +65,7 @@
    #define LWM2M_QUEUE_MODE_CONF_DEFAULT_CLIENT_AWAKE_TIME 2000
    #define LWM2M_QUEUE_MODE_CONF_DEFAULT_CLIENT_SLEEP_TIME 10000
    #define LWM2M_QUEUE_MODE_CONF_DEFAULT_DYNAMIC_ADAPTATION_FLAG 0
-   #define LWM2M_QUEUE_MODE_OBJECT_CONF_ENABLED 1 */
+   #define LWM2M_QUEUE_MODE_OBJECT_CONF_ENABLED 1
+   #define LWM2M_QUEUE_MODE_CONF_SEND_PACK 1 */
 
 #endif /* PROJECT_CONF_H_ */
@@ -53,6 +53,7 @@
 #include "services/orchestra/orchestra.h"
 #include "services/shell/serial-shell.h"
 #include "services/simple-energest/simple-energest.h"
+#include "services/metrics/metrics.h"
 
 #include <stdio.h>
 #include <stdint.h>
@@ -146,8 +147,18 @@ main(void)
   simple_energest_init();
 #endif /* BUILD_WITH_SIMPLE_ENERGEST */
 
+#if BUILD_WITH_METRICS
+  metrics_init();
+  LOG_DBG("With Metrics\n");
+#endif /* BUILD_WITH_METRICS */
+
   autostart_start(autostart_processes);
 
+#if LOG_DEFERRED
+  /* Boot messages are flushed as needed; defer the rest */
+  log_deferred_init();
+#endif /* LOG_DEFERRED */
+
   watchdog_start();
 
 #if PLATFORM_PROVIDES_MAIN_LOOP
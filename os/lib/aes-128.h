@@ -51,22 +51,43 @@
 #define AES_128            aes_128_driver
 #endif /* AES_128_CONF */
 
+/* The number of keys whose expanded schedules are kept by the software
+   implementation, so that switching between keys does not expand them
+   again */
+#ifdef AES_128_CONF_KEY_CACHE_SIZE
+#define AES_128_KEY_CACHE_SIZE AES_128_CONF_KEY_CACHE_SIZE
+#else /* AES_128_CONF_KEY_CACHE_SIZE */
+#define AES_128_KEY_CACHE_SIZE 2
+#endif /* AES_128_CONF_KEY_CACHE_SIZE */
+
 /**
  * Structure of AES drivers.
  */
 struct aes_128_driver {
-  
+
   /**
    * \brief Sets the current key.
    */
   void (* set_key)(const uint8_t *key);
-  
+
   /**
    * \brief Encrypts.
    */
   void (* encrypt)(uint8_t *plaintext_and_result);
+
+  /**
+   * \brief Encrypts consecutive blocks independently of each other.
+   * \param plaintexts_and_results count * AES_128_BLOCK_SIZE bytes
+   * \param count The number of blocks
+   */
+  void (* encrypt_blocks)(uint8_t *plaintexts_and_results, uint8_t count);
 };
 
 extern const struct aes_128_driver AES_128;
 
+/**
+ * The software implementation, which other drivers may fall back to.
+ */
+extern const struct aes_128_driver aes_128_driver;
+
 #endif /* AES_128_H_ */
@@ -28,11 +28,16 @@
  *
  */
 
+#include "contiki.h"
+#include "sys/log.h"
+
 #include <stdio.h>
 
 void
 _xassert(const char *file, int lineno)
 {
+  /* Output the queued messages that led to the failure first */
+  LOG_SYNC();
   printf("Assertion failed: file %s, line %d.\n", file, lineno);
   /*
    * loop for a while;
@@ -59,47 +59,57 @@ set_iv(uint8_t *iv,
   iv[15] = counter;
 }
 /*---------------------------------------------------------------------------*/
-/* XORs the block m[pos] ... m[pos + 15] with K_{counter} */
+/*
+ * Encrypts the CBC-MAC block in x[0] ... x[15] and, in the same call, the
+ * counter block A_{counter}, which is left in x[16] ... x[31]. The two
+ * blocks are independent, so drivers with a multi-block path can process
+ * them together.
+ */
 static void
-ctr_step(const uint8_t *nonce,
-    uint8_t pos,
-    uint8_t *m_and_result,
-    uint8_t m_len,
-    uint8_t counter)
+mac_and_ctr_step(uint8_t *x, const uint8_t *nonce, uint8_t counter)
 {
-  uint8_t a[AES_128_BLOCK_SIZE];
-  uint8_t i;
-  
-  set_iv(a, CCM_STAR_ENCRYPTION_FLAGS, nonce, counter);
-  AES_128.encrypt(a);
-  
-  for(i = 0; (pos + i < m_len) && (i < AES_128_BLOCK_SIZE); i++) {
-    m_and_result[pos + i] ^= a[i];
-  }
+  set_iv(x + AES_128_BLOCK_SIZE, CCM_STAR_ENCRYPTION_FLAGS, nonce, counter);
+  AES_128.encrypt_blocks(x, 2);
 }
 /*---------------------------------------------------------------------------*/
 static void
-mic(const uint8_t *nonce,
-    const uint8_t *m, uint8_t m_len,
-    const uint8_t *a, uint8_t a_len,
-    uint8_t *result,
-    uint8_t mic_len)
+set_key(const uint8_t *key)
+{
+  AES_128.set_key(key);
+}
+/*---------------------------------------------------------------------------*/
+static void
+aead(const uint8_t* nonce,
+    uint8_t* m, uint8_t m_len,
+    const uint8_t* a, uint8_t a_len,
+    uint8_t *result, uint8_t mic_len,
+    int forward)
 {
-  uint8_t x[AES_128_BLOCK_SIZE];
+  /* CBC-MAC state, followed by the most recent key stream block */
+  uint8_t x[2 * AES_128_BLOCK_SIZE];
+  uint8_t *s;
   uint8_t pos;
+  uint8_t len;
   uint8_t i;
-  
+
+  s = x + AES_128_BLOCK_SIZE;
+
+  /*
+   * CBC-MAC and CTR run in a single pass: the key stream block for the next
+   * message block is computed together with the preceding CBC-MAC block,
+   * and K_0 together with the last one.
+   */
   set_iv(x, CCM_STAR_AUTH_FLAGS(a_len, mic_len), nonce, m_len);
-  AES_128.encrypt(x);
-  
+  mac_and_ctr_step(x, nonce, m_len ? 1 : 0);
+
   if(a_len) {
     x[1] = x[1] ^ a_len;
     for(i = 2; (i - 2 < a_len) && (i < AES_128_BLOCK_SIZE); i++) {
       x[i] ^= a[i - 2];
     }
-    
+
     AES_128.encrypt(x);
-    
+
     pos = 14;
     while(pos < a_len) {
       for(i = 0; (pos + i < a_len) && (i < AES_128_BLOCK_SIZE); i++) {
@@ -109,64 +119,28 @@ mic(const uint8_t *nonce,
       AES_128.encrypt(x);
     }
   }
-  
-  if(m_len) {
-    pos = 0;
-    while(pos < m_len) {
-      for(i = 0; (pos + i < m_len) && (i < AES_128_BLOCK_SIZE); i++) {
+
+  pos = 0;
+  while(pos < m_len) {
+    len = MIN(m_len - pos, AES_128_BLOCK_SIZE);
+    for(i = 0; i < len; i++) {
+      if(forward) {
+        /* encrypt after the plaintext went into the MIC */
+        x[i] ^= m[pos + i];
+        m[pos + i] ^= s[i];
+      } else {
+        /* decrypt before the plaintext goes into the MIC */
+        m[pos + i] ^= s[i];
         x[i] ^= m[pos + i];
       }
-      pos += AES_128_BLOCK_SIZE;
-      AES_128.encrypt(x);
     }
+    pos += len;
+    mac_and_ctr_step(x, nonce,
+        pos < m_len ? (pos / AES_128_BLOCK_SIZE) + 1 : 0);
   }
-  
-  ctr_step(nonce, 0, x, AES_128_BLOCK_SIZE, 0);
-  
-  memcpy(result, x, mic_len);
-}
-/*---------------------------------------------------------------------------*/
-static void
-ctr(const uint8_t *nonce, uint8_t *m, uint8_t m_len)
-{
-  uint8_t pos;
-  uint8_t counter;
-  
-  pos = 0;
-  counter = 1;
-  while(pos < m_len) {
-    ctr_step(nonce, pos, m, m_len, counter++);
-    pos += AES_128_BLOCK_SIZE;
-  }
-}
-/*---------------------------------------------------------------------------*/
-static void
-set_key(const uint8_t *key)
-{
-  AES_128.set_key(key);
-}
-/*---------------------------------------------------------------------------*/
-static void
-aead(const uint8_t* nonce,
-    uint8_t* m, uint8_t m_len,
-    const uint8_t* a, uint8_t a_len,
-    uint8_t *result, uint8_t mic_len,
-    int forward)
-{
-  if(!forward) {
-    /* decrypt */
-    ctr(nonce, m, m_len);
-  }
-  
-  mic(nonce,
-    m, m_len,
-    a, a_len,
-    result,
-    mic_len);
-  
-  if(forward) {
-    /* encrypt */
-    ctr(nonce, m, m_len);
+
+  for(i = 0; i < mic_len; i++) {
+    result[i] = x[i] ^ s[i];
   }
 }
 /*---------------------------------------------------------------------------*/
@@ -37,10 +37,13 @@
 static int
 push(struct jsonparse_state *state, char c)
 {
+  if(state->depth == JSONPARSE_MAX_DEPTH) {
+    return 0;
+  }
   state->stack[state->depth] = c;
   state->depth++;
   state->vtype = 0;
-  return state->depth < JSONPARSE_MAX_DEPTH;
+  return 1;
 }
 /*--------------------------------------------------------------------*/
 static void
@@ -62,78 +65,6 @@ pop(struct jsonparse_state *state)
   return state->stack[state->depth];
 }
 /*--------------------------------------------------------------------*/
-/* will pass by the value and store the start and length of the value for
-   atomic types */
-/*--------------------------------------------------------------------*/
-static char
-atomic(struct jsonparse_state *state, char type)
-{
-  char c;
-  const char *str;
-  int len;
-
-  state->vstart = state->pos;
-  if(type == JSON_TYPE_STRING || type == JSON_TYPE_PAIR_NAME) {
-    while((c = state->json[state->pos++]) && c != '"') {
-      if(c == '\\') {
-        state->pos++;           /* skip current char */
-      }
-    }
-    if (c != '"') {
-      state->error = JSON_ERROR_SYNTAX;
-      return JSON_TYPE_ERROR;
-    }
-    state->vlen = state->pos - state->vstart - 1;
-  } else if(type == JSON_TYPE_NUMBER) {
-    do {
-      c = state->json[state->pos];
-      if((c < '0' || c > '9') && c != '.') {
-        c = 0;
-      } else {
-        state->pos++;
-      }
-    } while(c);
-    /* need to back one step since first char is already gone */
-    state->vstart--;
-    state->vlen = state->pos - state->vstart;
-  } else if(type == JSON_TYPE_NULL || type == JSON_TYPE_TRUE || type == JSON_TYPE_FALSE) {
-    state->vstart--;
-    switch (type) {
-    case JSON_TYPE_NULL:  str = "null";  break;
-    case JSON_TYPE_TRUE:  str = "true";  break;
-    case JSON_TYPE_FALSE: str = "false"; break;
-    default:              str = "";      break;
-    }
-
-    while ((c = state->json[state->pos]) && c != ' ' && c != ',' && c != ']' && c != '}') {
-      state->pos++;
-    }
-
-    state->vlen = state->pos - state->vstart;
-    len = strlen(str);
-    len = state->vlen > len ? state->vlen : len;
-
-    if (strncmp(str, &state->json[state->vstart], len) != 0) {
-      state->error = JSON_ERROR_SYNTAX;
-      return JSON_TYPE_ERROR;
-    }
-  }
-
-  state->vtype = type;
-  return state->vtype;
-}
-/*--------------------------------------------------------------------*/
-static void
-skip_ws(struct jsonparse_state *state)
-{
-  char c;
-
-  while(state->pos < state->len &&
-        ((c = state->json[state->pos]) == ' ' || c == '\n')) {
-    state->pos++;
-  }
-}
-/*--------------------------------------------------------------------*/
 static int
 is_atomic(struct jsonparse_state *state)
 {
@@ -148,6 +79,14 @@ is_atomic(struct jsonparse_state *state)
 void
 jsonparse_setup(struct jsonparse_state *state, const char *json, int len)
 {
+  const char *end;
+
+  /* the input ends at the first null character */
+  end = memchr(json, 0, len);
+  if(end != NULL) {
+    len = end - json;
+  }
+
   state->json = json;
   state->len = len;
   state->pos = 0;
@@ -155,111 +94,69 @@ jsonparse_setup(struct jsonparse_state *state, const char *json, int len)
   state->error = 0;
   state->vtype = 0;
   state->stack[0] = 0;
+  state->pending = 0;
+  jsontok_init(&state->tok);
+  jsontok_feed(&state->tok, json, len, 0);
 }
 /*--------------------------------------------------------------------*/
 int
 jsonparse_next(struct jsonparse_state *state)
 {
-  char c;
+  struct jsontok_token *token = &state->token;
   char s;
   char v;
+  int ret;
 
-  skip_ws(state);
-  c = state->json[state->pos];
   s = jsonparse_get_type(state);
   v = state->vtype;
-  state->pos++;
 
-  switch(c) {
-  case '{':
-    if((s == 0 && v == 0) || s == '[' || s == ':') {
-      push(state, c);
-    } else {
-      state->error = JSON_ERROR_UNEXPECTED_OBJECT;
-      return JSON_TYPE_ERROR;
-    }
-    return c;
-  case '}':
-    if((s == ':' && v != ',' && v != 0 ) || (s == '{' && v == 0)) {
-      pop(state);
-    } else {
-      state->error = JSON_ERROR_UNEXPECTED_END_OF_OBJECT;
+  if(state->pending) {
+    state->pending = 0;
+  } else {
+    ret = jsontok_next(&state->tok, token);
+    state->pos = state->tok.pos;
+    if(ret != JSONTOK_TOKEN) {
+      if(ret == JSONTOK_ERROR) {
+        state->error = state->tok.error;
+      }
       return JSON_TYPE_ERROR;
     }
-    return c;
-  case ']':
-    if(s == '[' && v != ',') {
-      pop(state);
-    } else {
-      state->error = JSON_ERROR_UNEXPECTED_END_OF_ARRAY;
-      return JSON_TYPE_ERROR;
+    if(token->type != '}' && token->type != ']' &&
+       v != 0 && v != ',' && v != 'N') {
+      /* the tokenizer skips the ',' between values, report it first */
+      if(s == ':') {
+        modify(state, '{');
+      }
+      state->vtype = ',';
+      state->pending = 1;
+      return ',';
     }
-    return c;
-  case ':':
-    if(s == '{' && v == 'N') {
+  }
+
+  switch(token->type) {
+  case '{':
+  case '[':
+    if(v == 'N') {
       modify(state, ':');
-      state->vtype = 0;
-    } else {
-      state->error = JSON_ERROR_SYNTAX;
-      return JSON_TYPE_ERROR;
-    }
-    return jsonparse_next(state);
-  case ',':
-    if(s == ':' && v != 0) {
-      modify(state, '{');
-      state->vtype = c;
-    } else if(s == '[') {
-      state->vtype = c;
-    } else {
-      state->error = JSON_ERROR_SYNTAX;
-      return JSON_TYPE_ERROR;
     }
-    return c;
-  case '"':
-    if((s == 0 && v == 0) || s == '{' || s == '[' || s == ':') {
-      return atomic(state, c = (s == '{' ? JSON_TYPE_PAIR_NAME : c));
-    } else {
-      state->error = JSON_ERROR_UNEXPECTED_STRING;
+    if(!push(state, token->type)) {
+      state->error = JSON_ERROR_TOO_DEEP;
       return JSON_TYPE_ERROR;
     }
-    return c;
-  case '[':
-    if((s == 0 && v == 0) || s == '[' || s == ':') {
-      push(state, c);
-    } else {
-      state->error = JSON_ERROR_UNEXPECTED_ARRAY;
-      return JSON_TYPE_ERROR;
-    }
-    return c;
-  case 0:
-    if(v == 0 || state->depth > 0) {
-      state->error = JSON_ERROR_SYNTAX;
-    }
-    return JSON_TYPE_ERROR;
+    return token->type;
+  case '}':
+  case ']':
+    pop(state);
+    return token->type;
   default:
-    if(s == 0 || s == ':' || s == '[') {
-      if (v != 0 && v != ',') {
-        state->error = JSON_ERROR_SYNTAX;
-        return JSON_TYPE_ERROR;
-      }
-      if(c == '-' || (c <= '9' && c >= '0')) {
-        return atomic(state, JSON_TYPE_NUMBER);
-      } else if(c == 'n') {
-        return atomic(state, JSON_TYPE_NULL);
-      } else if(c == 't') {
-        return atomic(state, JSON_TYPE_TRUE);
-      } else if(c == 'f') {
-        return atomic(state, JSON_TYPE_FALSE);
-      } else {
-        state->error = JSON_ERROR_SYNTAX;
-        return JSON_TYPE_ERROR;
-      }
-    } else if(s == '{') {
-      state->error = JSON_ERROR_SYNTAX;
-      return JSON_TYPE_ERROR;
+    if(v == 'N') {
+      modify(state, ':');
     }
+    state->vstart = token->value.ptr - state->json;
+    state->vlen = token->value.len;
+    state->vtype = token->type;
+    return token->type;
   }
-  return 0;
 }
 /*--------------------------------------------------------------------*/
 /* get the json value of the current position
@@ -34,6 +34,7 @@
 
 #include "contiki.h"
 #include "json.h"
+#include "jsontok.h"
 
 #ifdef JSONPARSE_CONF_MAX_DEPTH
 #define JSONPARSE_MAX_DEPTH JSONPARSE_CONF_MAX_DEPTH
@@ -52,6 +53,10 @@ struct jsonparse_state {
   char vtype;
   char error;
   char stack[JSONPARSE_MAX_DEPTH];
+  /* the tokenizer and a token held back while a ',' is reported */
+  struct jsontok_state tok;
+  struct jsontok_token token;
+  uint8_t pending;
 };
 
 /**
@@ -61,7 +66,10 @@ struct jsonparse_state {
  * \param len  The length of the string to parse
  *
  *             This function initializes a JSON parser state for
- *             parsing a string as JSON.
+ *             parsing a string as JSON. The parser is a wrapper
+ *             around the streaming tokenizer in jsontok.h, which
+ *             should be used directly for input that arrives in
+ *             chunks.
  */
 void jsonparse_setup(struct jsonparse_state *state, const char *json,
                      int len);
@@ -0,0 +1,531 @@
+/*
+ * Copyright (c) 2019, RISE SICS AB.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         A streaming JSON tokenizer.
+ *
+ *         The bodies of strings are scanned a word at a time for the
+ *         closing quote or an escape, with SSE2 when available.
+ */
+
+#include "jsontok.h"
+#include <string.h>
+
+#ifdef JSONTOK_CONF_WITH_SSE2
+#define JSONTOK_WITH_SSE2 JSONTOK_CONF_WITH_SSE2
+#elif defined(__SSE2__)
+#define JSONTOK_WITH_SSE2 1
+#else
+#define JSONTOK_WITH_SSE2 0
+#endif /* JSONTOK_CONF_WITH_SSE2 */
+
+#if JSONTOK_WITH_SSE2
+#include <emmintrin.h>
+#endif /* JSONTOK_WITH_SSE2 */
+
+/* What may come next in the input */
+enum {
+  EXPECT_VALUE,
+  EXPECT_VALUE_OR_END,
+  EXPECT_NAME,
+  EXPECT_NAME_OR_END,
+  EXPECT_COLON,
+  EXPECT_COMMA_OR_END,
+  EXPECT_DONE
+};
+
+/* A number or literal is being carried over to the next chunk */
+#define PARTIAL_ATOM 'a'
+
+/* Word-at-a-time test for a zero byte */
+#define WORD_ONES  (~0UL / 0xff)
+#define WORD_HIGHS (WORD_ONES << 7)
+#define WORD_HAS_ZERO(w) (((w) - WORD_ONES) & ~(w) & WORD_HIGHS)
+/*---------------------------------------------------------------------------*/
+/* Returns the offset of the first quote or backslash, or len if none */
+static int
+find_quote_or_escape(const char *p, int len)
+{
+  int i = 0;
+#if JSONTOK_WITH_SSE2
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  __m128i v;
+  int mask;
+
+  for(; i + 16 <= len; i += 16) {
+    v = _mm_loadu_si128((const __m128i *)(p + i));
+    mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, quote),
+                                          _mm_cmpeq_epi8(v, backslash)));
+    if(mask != 0) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+#else /* JSONTOK_WITH_SSE2 */
+  unsigned long w;
+
+  for(; i + (int)sizeof(w) <= len; i += sizeof(w)) {
+    memcpy(&w, p + i, sizeof(w));
+    if(WORD_HAS_ZERO(w ^ (WORD_ONES * '"')) |
+       WORD_HAS_ZERO(w ^ (WORD_ONES * '\\'))) {
+      break;
+    }
+  }
+#endif /* JSONTOK_WITH_SSE2 */
+  for(; i < len; i++) {
+    if(p[i] == '"' || p[i] == '\\') {
+      return i;
+    }
+  }
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+static int
+set_error(struct jsontok_state *state, char error)
+{
+  state->error = error;
+  return JSONTOK_ERROR;
+}
+/*---------------------------------------------------------------------------*/
+static int
+in_object(struct jsontok_state *state)
+{
+  uint8_t level = state->depth - 1;
+
+  return state->depth > 0 && (state->stack[level / 8] & (1 << (level % 8)));
+}
+/*---------------------------------------------------------------------------*/
+static void
+end_value(struct jsontok_state *state)
+{
+  state->expect = state->depth == 0 ? EXPECT_DONE : EXPECT_COMMA_OR_END;
+}
+/*---------------------------------------------------------------------------*/
+static int
+is_atom_char(char c)
+{
+  return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') ||
+    c == '-' || c == '+' || c == '.' || c == 'E';
+}
+/*---------------------------------------------------------------------------*/
+static int
+is_number(const char *p, int len)
+{
+  int i = 0;
+  int start;
+
+  if(i < len && p[i] == '-') {
+    i++;
+  }
+  for(start = i; i < len && p[i] >= '0' && p[i] <= '9'; i++);
+  if(i == start) {
+    return 0;
+  }
+  if(i < len && p[i] == '.') {
+    for(start = ++i; i < len && p[i] >= '0' && p[i] <= '9'; i++);
+    if(i == start) {
+      return 0;
+    }
+  }
+  if(i < len && (p[i] == 'e' || p[i] == 'E')) {
+    i++;
+    if(i < len && (p[i] == '+' || p[i] == '-')) {
+      i++;
+    }
+    for(start = i; i < len && p[i] >= '0' && p[i] <= '9'; i++);
+    if(i == start) {
+      return 0;
+    }
+  }
+  return i == len;
+}
+/*---------------------------------------------------------------------------*/
+static int
+is_literal(const char *p, int len, const char *literal)
+{
+  return (size_t)len == strlen(literal) && memcmp(p, literal, len) == 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+end_atom(struct jsontok_state *state, struct jsontok_token *token,
+         const char *p, int len)
+{
+  if(is_number(p, len)) {
+    token->type = JSON_TYPE_NUMBER;
+  } else if(is_literal(p, len, "true")) {
+    token->type = JSON_TYPE_TRUE;
+  } else if(is_literal(p, len, "false")) {
+    token->type = JSON_TYPE_FALSE;
+  } else if(is_literal(p, len, "null")) {
+    token->type = JSON_TYPE_NULL;
+  } else {
+    return set_error(state, JSON_ERROR_SYNTAX);
+  }
+  token->value.ptr = p;
+  token->value.len = len;
+  end_value(state);
+  return JSONTOK_TOKEN;
+}
+/*---------------------------------------------------------------------------*/
+static int
+scan_atom(struct jsontok_state *state, struct jsontok_token *token)
+{
+  const char *p = state->buf + state->pos;
+  int len = state->len - state->pos;
+  int i;
+
+  for(i = 0; i < len && is_atom_char(p[i]); i++);
+
+  if(state->partial == PARTIAL_ATOM) {
+    /* Append to the part from the previous chunks */
+    if(state->carry_len + i > JSONTOK_CARRY_LEN) {
+      return set_error(state, JSON_ERROR_TOO_LONG);
+    }
+    memcpy(state->carry + state->carry_len, p, i);
+    state->carry_len += i;
+    state->pos += i;
+    if(i == len && state->more) {
+      return JSONTOK_NEED_MORE;
+    }
+    state->partial = 0;
+    return end_atom(state, token, state->carry, state->carry_len);
+  }
+
+  if(i == len && state->more) {
+    /* The atom may continue in the next chunk */
+    if(len > JSONTOK_CARRY_LEN) {
+      return set_error(state, JSON_ERROR_TOO_LONG);
+    }
+    memcpy(state->carry, p, len);
+    state->carry_len = len;
+    state->partial = PARTIAL_ATOM;
+    state->pos = state->len;
+    return JSONTOK_NEED_MORE;
+  }
+  state->pos += i;
+  return end_atom(state, token, p, i);
+}
+/*---------------------------------------------------------------------------*/
+static int
+scan_string(struct jsontok_state *state, struct jsontok_token *token)
+{
+  const char *p = state->buf + state->pos;
+  int len = state->len - state->pos;
+  int i = 0;
+
+  token->type = state->partial;
+  token->value.ptr = p;
+
+  if(state->escape && len > 0) {
+    /* The previous chunk ended with a backslash */
+    state->escape = 0;
+    token->flags |= JSONTOK_FLAG_ESCAPED;
+    i = 1;
+  }
+
+  while(i < len) {
+    i += find_quote_or_escape(p + i, len - i);
+    if(i == len) {
+      break;
+    }
+    if(p[i] == '"') {
+      token->value.len = i;
+      state->pos += i + 1;
+      state->partial = 0;
+      if(token->type == JSON_TYPE_PAIR_NAME) {
+        state->expect = EXPECT_COLON;
+      } else {
+        end_value(state);
+      }
+      return JSONTOK_TOKEN;
+    }
+    token->flags |= JSONTOK_FLAG_ESCAPED;
+    if(i + 1 == len) {
+      state->escape = 1;
+      i = len;
+    } else {
+      i += 2;
+    }
+  }
+
+  if(!state->more) {
+    return set_error(state, JSON_ERROR_SYNTAX);
+  }
+  token->value.len = len;
+  token->flags |= JSONTOK_FLAG_PARTIAL;
+  state->pos = state->len;
+  return JSONTOK_TOKEN;
+}
+/*---------------------------------------------------------------------------*/
+void
+jsontok_init(struct jsontok_state *state)
+{
+  memset(state, 0, sizeof(*state));
+  state->expect = EXPECT_VALUE;
+  state->more = 1;
+}
+/*---------------------------------------------------------------------------*/
+void
+jsontok_feed(struct jsontok_state *state, const char *buf, int len, int more)
+{
+  state->buf = buf;
+  state->pos = 0;
+  state->len = len;
+  state->more = more != 0;
+}
+/*---------------------------------------------------------------------------*/
+int
+jsontok_next(struct jsontok_state *state, struct jsontok_token *token)
+{
+  uint8_t level;
+  char c;
+
+  if(state->error) {
+    return JSONTOK_ERROR;
+  }
+
+  token->flags = 0;
+  token->depth = state->depth;
+
+  if(state->partial == JSON_TYPE_STRING ||
+     state->partial == JSON_TYPE_PAIR_NAME) {
+    if(state->pos == state->len && state->more) {
+      return JSONTOK_NEED_MORE;
+    }
+    token->flags = JSONTOK_FLAG_CONTINUED;
+    return scan_string(state, token);
+  } else if(state->partial == PARTIAL_ATOM) {
+    return scan_atom(state, token);
+  }
+
+  while(state->pos < state->len &&
+        ((c = state->buf[state->pos]) == ' ' || c == '\n' ||
+         c == '\r' || c == '\t')) {
+    state->pos++;
+  }
+
+  if(state->pos == state->len) {
+    if(state->expect == EXPECT_DONE) {
+      return JSONTOK_DONE;
+    }
+    return state->more ? JSONTOK_NEED_MORE :
+      set_error(state, JSON_ERROR_SYNTAX);
+  }
+
+  c = state->buf[state->pos];
+
+  switch(c) {
+  case '{':
+  case '[':
+    if(state->expect != EXPECT_VALUE &&
+       state->expect != EXPECT_VALUE_OR_END) {
+      return set_error(state, c == '{' ? JSON_ERROR_UNEXPECTED_OBJECT :
+                       JSON_ERROR_UNEXPECTED_ARRAY);
+    }
+    if(state->depth == JSONTOK_MAX_DEPTH) {
+      return set_error(state, JSON_ERROR_TOO_DEEP);
+    }
+    level = state->depth++;
+    if(c == '{') {
+      state->stack[level / 8] |= 1 << (level % 8);
+      state->expect = EXPECT_NAME_OR_END;
+    } else {
+      state->stack[level / 8] &= ~(1 << (level % 8));
+      state->expect = EXPECT_VALUE_OR_END;
+    }
+    state->pos++;
+    token->type = c;
+    return JSONTOK_TOKEN;
+  case '}':
+  case ']':
+    if(state->depth == 0 || in_object(state) != (c == '}') ||
+       (state->expect != EXPECT_COMMA_OR_END &&
+        state->expect != (c == '}' ? EXPECT_NAME_OR_END :
+                          EXPECT_VALUE_OR_END))) {
+      return set_error(state, c == '}' ?
+                       JSON_ERROR_UNEXPECTED_END_OF_OBJECT :
+                       JSON_ERROR_UNEXPECTED_END_OF_ARRAY);
+    }
+    state->depth--;
+    end_value(state);
+    state->pos++;
+    token->type = c;
+    token->depth = state->depth;
+    return JSONTOK_TOKEN;
+  case ',':
+    if(state->expect != EXPECT_COMMA_OR_END) {
+      return set_error(state, JSON_ERROR_SYNTAX);
+    }
+    state->expect = in_object(state) ? EXPECT_NAME : EXPECT_VALUE;
+    state->pos++;
+    return jsontok_next(state, token);
+  case ':':
+    if(state->expect != EXPECT_COLON) {
+      return set_error(state, JSON_ERROR_SYNTAX);
+    }
+    state->expect = EXPECT_VALUE;
+    state->pos++;
+    return jsontok_next(state, token);
+  case '"':
+    if(state->expect == EXPECT_NAME || state->expect == EXPECT_NAME_OR_END) {
+      state->partial = JSON_TYPE_PAIR_NAME;
+    } else if(state->expect == EXPECT_VALUE ||
+              state->expect == EXPECT_VALUE_OR_END) {
+      state->partial = JSON_TYPE_STRING;
+    } else {
+      return set_error(state, JSON_ERROR_UNEXPECTED_STRING);
+    }
+    state->pos++;
+    return scan_string(state, token);
+  default:
+    if((state->expect != EXPECT_VALUE &&
+        state->expect != EXPECT_VALUE_OR_END) || !is_atom_char(c)) {
+      return set_error(state, JSON_ERROR_SYNTAX);
+    }
+    return scan_atom(state, token);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static int32_t
+parse_hex4(const char *p)
+{
+  int32_t value = 0;
+  int i;
+  char c;
+
+  for(i = 0; i < 4; i++) {
+    c = p[i];
+    if(c >= '0' && c <= '9') {
+      value = (value << 4) | (c - '0');
+    } else if(c >= 'a' && c <= 'f') {
+      value = (value << 4) | (c - 'a' + 10);
+    } else if(c >= 'A' && c <= 'F') {
+      value = (value << 4) | (c - 'A' + 10);
+    } else {
+      return -1;
+    }
+  }
+  return value;
+}
+/*---------------------------------------------------------------------------*/
+/* Writes a code point as UTF-8, returns 0 if it does not fit */
+static int
+put_utf8(char *buf, int size, uint32_t cp)
+{
+  if(cp < 0x80 && size >= 1) {
+    buf[0] = cp;
+    return 1;
+  } else if(cp < 0x800 && size >= 2) {
+    buf[0] = 0xc0 | (cp >> 6);
+    buf[1] = 0x80 | (cp & 0x3f);
+    return 2;
+  } else if(cp >= 0x800 && cp < 0x10000 && size >= 3) {
+    buf[0] = 0xe0 | (cp >> 12);
+    buf[1] = 0x80 | ((cp >> 6) & 0x3f);
+    buf[2] = 0x80 | (cp & 0x3f);
+    return 3;
+  } else if(cp >= 0x10000 && size >= 4) {
+    buf[0] = 0xf0 | (cp >> 18);
+    buf[1] = 0x80 | ((cp >> 12) & 0x3f);
+    buf[2] = 0x80 | ((cp >> 6) & 0x3f);
+    buf[3] = 0x80 | (cp & 0x3f);
+    return 4;
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+int
+jsontok_copy_string(const struct jsontok_slice *slice, char *buf, int size)
+{
+  const char *p = slice->ptr;
+  const char *end = p + slice->len;
+  int32_t cp, low;
+  int o = 0;
+  int n;
+  char c;
+
+  if(size <= 0) {
+    return 0;
+  }
+
+  while(p < end && o < size - 1) {
+    c = *p++;
+    if(c != '\\') {
+      buf[o++] = c;
+      continue;
+    }
+    if(p == end) {
+      break;
+    }
+    c = *p++;
+    switch(c) {
+    case 'b': c = '\b'; break;
+    case 'f': c = '\f'; break;
+    case 'n': c = '\n'; break;
+    case 'r': c = '\r'; break;
+    case 't': c = '\t'; break;
+    case 'u':
+      if(end - p < 4 || (cp = parse_hex4(p)) < 0) {
+        p = end;
+        continue;
+      }
+      p += 4;
+      /* Join a surrogate pair */
+      if(cp >= 0xd800 && cp < 0xdc00 && end - p >= 6 &&
+         p[0] == '\\' && p[1] == 'u' &&
+         (low = parse_hex4(p + 2)) >= 0xdc00 && low < 0xe000) {
+        cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+        p += 6;
+      }
+      n = put_utf8(buf + o, size - 1 - o, cp);
+      if(n == 0) {
+        p = end;
+      }
+      o += n;
+      continue;
+    }
+    buf[o++] = c;
+  }
+  buf[o] = 0;
+  return o;
+}
+/*---------------------------------------------------------------------------*/
+int
+jsontok_slice_cmp(const struct jsontok_slice *slice, const char *str)
+{
+  int len = strlen(str);
+
+  if(slice->len != len) {
+    return slice->len < len ? -1 : 1;
+  }
+  return memcmp(slice->ptr, str, len);
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2019, RISE SICS AB.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         A streaming JSON tokenizer.
+ *
+ *         The input is fed in chunks, for example CoAP block1 payloads
+ *         or websocket frames, and the tokenizer resumes where the
+ *         previous chunk ended. Values are returned as slices into the
+ *         caller's buffer and nothing is copied, except numbers and
+ *         literals that are split by a chunk boundary. Strings that
+ *         cross a chunk boundary are returned in pieces.
+ */
+
+#ifndef JSONTOK_H_
+#define JSONTOK_H_
+
+#include "contiki.h"
+#include "json.h"
+
+/* The maximum nesting of objects and arrays */
+#ifdef JSONTOK_CONF_MAX_DEPTH
+#define JSONTOK_MAX_DEPTH JSONTOK_CONF_MAX_DEPTH
+#else
+#define JSONTOK_MAX_DEPTH 32
+#endif /* JSONTOK_CONF_MAX_DEPTH */
+
+/* The longest number or literal that can be split across chunks */
+#ifdef JSONTOK_CONF_CARRY_LEN
+#define JSONTOK_CARRY_LEN JSONTOK_CONF_CARRY_LEN
+#else
+#define JSONTOK_CARRY_LEN 32
+#endif /* JSONTOK_CONF_CARRY_LEN */
+
+/* Return values of jsontok_next() */
+#define JSONTOK_ERROR     -1
+#define JSONTOK_NEED_MORE  0
+#define JSONTOK_TOKEN      1
+#define JSONTOK_DONE       2
+
+/* Token flags */
+/* The string continues in the next chunk */
+#define JSONTOK_FLAG_PARTIAL   0x01
+/* The string continues a piece from the previous chunk */
+#define JSONTOK_FLAG_CONTINUED 0x02
+/* The slice contains escape sequences */
+#define JSONTOK_FLAG_ESCAPED   0x04
+
+struct jsontok_slice {
+  const char *ptr;
+  int len;
+};
+
+struct jsontok_token {
+  /* One of '{', '}', '[', ']' or the JSON_TYPE_* of an atomic value */
+  char type;
+  uint8_t flags;
+  /* The nesting level, 0 for the top-level value */
+  uint8_t depth;
+  /* The value of atomic types. Strings are without quotes and escape
+     sequences are left as they are. */
+  struct jsontok_slice value;
+};
+
+struct jsontok_state {
+  const char *buf;
+  int pos;
+  int len;
+  uint8_t more;
+  uint8_t expect;
+  uint8_t depth;
+  /* A string, number or literal that is not yet complete */
+  char partial;
+  uint8_t escape;
+  uint8_t carry_len;
+  char error;
+  /* One bit per nesting level, set for objects */
+  uint8_t stack[(JSONTOK_MAX_DEPTH + 7) / 8];
+  char carry[JSONTOK_CARRY_LEN];
+};
+
+/**
+ * \brief      Initialize a JSON tokenizer state.
+ * \param state A pointer to a JSON tokenizer state
+ */
+void jsontok_init(struct jsontok_state *state);
+
+/**
+ * \brief      Give the next chunk of input to the tokenizer.
+ * \param state A pointer to a JSON tokenizer state
+ * \param buf  The chunk
+ * \param len  The length of the chunk
+ * \param more Non-zero if more chunks will follow
+ *
+ *             The chunk must stay valid until jsontok_next() returns
+ *             JSONTOK_NEED_MORE, since tokens point into it.
+ */
+void jsontok_feed(struct jsontok_state *state, const char *buf, int len,
+                  int more);
+
+/**
+ * \brief      Get the next token.
+ * \param state A pointer to a JSON tokenizer state
+ * \param token A pointer to the token to fill in
+ * \retval JSONTOK_TOKEN     A token was found
+ * \retval JSONTOK_NEED_MORE The chunk is used up, feed the next one
+ * \retval JSONTOK_DONE      The top-level value is complete
+ * \retval JSONTOK_ERROR     The input is not valid JSON, see state->error
+ */
+int jsontok_next(struct jsontok_state *state, struct jsontok_token *token);
+
+/**
+ * \brief      Copy a string slice and decode its escape sequences.
+ * \param slice The slice of a string token
+ * \param buf  The buffer to copy to
+ * \param size The size of the buffer
+ * \return     The length of the copied string, excluding the
+ *             terminating zero that is always written
+ *
+ *             Escape sequences must not be split, so pieces of a
+ *             string should be joined before they are decoded.
+ */
+int jsontok_copy_string(const struct jsontok_slice *slice, char *buf,
+                        int size);
+
+/**
+ * \brief      Compare a slice with a string.
+ * \return     Zero if the slice is equal to the string
+ */
+int jsontok_slice_cmp(const struct jsontok_slice *slice, const char *str);
+
+#endif /* JSONTOK_H_ */
@@ -52,11 +52,17 @@
 #include "sys/log.h"
 #endif /* COAP_LOG_CONF_PATH */
 
+/* Log backends without a queue have nothing to flush */
+#ifndef LOG_SYNC
+#define LOG_SYNC()
+#endif /* LOG_SYNC */
+
 #include "coap-endpoint.h"
 
 /* CoAP endpoint */
 #define LOG_COAP_EP(level, endpoint) do {                   \
     if(level <= (LOG_LEVEL)) {                              \
+      LOG_SYNC();                                           \
       coap_endpoint_log(endpoint);                          \
     }                                                       \
   } while (0)
@@ -69,6 +75,7 @@
 /* CoAP strings */
 #define LOG_COAP_STRING(level, text, len) do {              \
     if(level <= (LOG_LEVEL)) {                              \
+      LOG_SYNC();                                           \
       coap_log_string(text, len);                           \
     }                                                       \
   } while (0)
@@ -154,6 +154,23 @@ dtls_session_equals(const session_t *a, const session_t *b)
   return coap_endpoint_cmp(e1, e2);
 }
 /*---------------------------------------------------------------------------*/
+unsigned int
+dtls_session_hash(const session_t *a)
+{
+  const coap_endpoint_t *e = (const coap_endpoint_t *)a;
+  unsigned int hash;
+  uint8_t i;
+
+  /* FNV-1a over the fields compared by coap_endpoint_cmp() */
+  hash = 2166136261u;
+  for(i = 0; i < sizeof(e->ipaddr.u8); i++) {
+    hash = (hash ^ e->ipaddr.u8[i]) * 16777619u;
+  }
+  hash = (hash ^ (e->port & 0xff)) * 16777619u;
+  hash = (hash ^ (e->port >> 8)) * 16777619u;
+  return hash ^ e->secure;
+}
+/*---------------------------------------------------------------------------*/
 void *
 dtls_session_get_address(const session_t *a)
 {
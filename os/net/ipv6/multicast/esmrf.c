@@ -45,6 +45,7 @@
 #include "net/ipv6/multicast/uip-mcast6.h"
 #include "net/ipv6/multicast/uip-mcast6-route.h"
 #include "net/ipv6/multicast/uip-mcast6-stats.h"
+#include "net/ipv6/multicast/uip-mcast6-fwd.h"
 #include "net/ipv6/multicast/esmrf.h"
 #include "net/routing/routing.h"
 #include "net/ipv6/uip.h"
@@ -94,8 +95,7 @@ static struct esmrf_stats stats;
 /*---------------------------------------------------------------------------*/
 /* Internal Data */
 /*---------------------------------------------------------------------------*/
-static struct ctimer mcast_periodic;
-static uint8_t mcast_len;
+static uint16_t mcast_len;
 static uip_buf_t mcast_buf;
 static uint8_t fwd_delay;
 static uint8_t fwd_spread;
@@ -114,7 +114,6 @@ static uip_ipaddr_t des_ip;
 /*---------------------------------------------------------------------------*/
 static void icmp_input(void);
 static void icmp_output(void);
-static void mcast_fwd(void *p);
 int remove_ext_hdr(void);
 /*---------------------------------------------------------------------------*/
 /* Internal Data Structures */
@@ -255,16 +254,6 @@ icmp_input()
   uip_clear_buf();
 }
 /*---------------------------------------------------------------------------*/
-static void
-mcast_fwd(void *p)
-{
-  memcpy(&uip_buf[UIP_LLH_LEN], &mcast_buf, mcast_len);
-  uip_len = mcast_len;
-  UIP_IP_BUF->ttl--;
-  tcpip_output(NULL);
-  uip_clear_buf();
-}
-/*---------------------------------------------------------------------------*/
 static uint8_t
 in()
 {
@@ -315,6 +304,13 @@ in()
   }
 
   UIP_MCAST6_STATS_ADD(mcast_in_all);
+
+  if(uip_mcast6_fwd_is_dup()) {
+    UIP_MCAST6_STATS_ADD(mcast_dropped);
+    PRINTF("ESMRF: Duplicate, dropping\n");
+    return UIP_MCAST6_DROP;
+  }
+
   UIP_MCAST6_STATS_ADD(mcast_in_unique);
 
   /* If we have an entry in the mcast routing table, something with
@@ -352,9 +348,11 @@ in()
         fwd_delay = fwd_delay * (1 + ((random_rand() >> 11) % fwd_spread));
       }
 
-      memcpy(&mcast_buf, &uip_buf[UIP_LLH_LEN], uip_len);
-      mcast_len = uip_len;
-      ctimer_set(&mcast_periodic, fwd_delay, mcast_fwd, NULL);
+      /* Queue it, so that datagrams arriving during the delay are not lost */
+      if(uip_mcast6_fwd_schedule(fwd_delay) < 0) {
+        PRINTF("ESMRF: Forwarding queue full\n");
+        UIP_MCAST6_STATS_ADD(mcast_dropped);
+      }
     }
     PRINTF("ESMRF: %u bytes: fwd in %u [%u]\n",
            uip_len, fwd_delay, fwd_spread);
@@ -380,6 +378,7 @@ init()
   UIP_MCAST6_STATS_INIT(&stats);
 
   uip_mcast6_route_init();
+  uip_mcast6_fwd_init();
   /* Register the ICMPv6 input handler */
   uip_icmp6_register_input_handler(&esmrf_icmp_handler);
   c = udp_new(NULL, 0, NULL);
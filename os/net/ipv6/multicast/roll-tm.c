@@ -192,17 +192,36 @@ struct trickle_param {
  * \brief Add n to s: (s + n) modulo (2 ^ SERIAL_BITS) => ((s + n) % 0x8000)
  */
 #define SEQ_VAL_ADD(s, n) (((s) + (n)) % 0x8000)
+/**
+ * \brief Distance from s1 forward to s2: (s2 - s1) modulo (2 ^ SERIAL_BITS)
+ */
+#define SEQ_VAL_DIST(s1, s2) ((uint16_t)((s2) - (s1)) % 0x8000)
 /*---------------------------------------------------------------------------*/
 /* Sliding Windows */
+#define WINDOW_WORDS (ROLL_TM_WINDOW_SIZE / 32)
+
 struct sliding_window {
   seed_id_t seed_id;
   int16_t lower_bound;          /* lolipop */
   int16_t upper_bound;          /* lolipop */
   int16_t min_listed;           /* lolipop */
   uint8_t flags;                /* Is used, Trickle param, Is listed */
-  uint8_t count;
+  uint16_t count;
+  uint32_t held[WINDOW_WORDS];  /* Sequence values we have buffered */
+  uint32_t listed[WINDOW_WORDS]; /* Sequence values listed in the ICMP msg */
 };
 
+/**
+ * \brief Test, set or clear sequence value s in the bitmap map of a window.
+ * The values in a window span less than ROLL_TM_WINDOW_SIZE, so each of them
+ * has a bit of its own
+ */
+#define WINDOW_BIT(s)         ((s) & (ROLL_TM_WINDOW_SIZE - 1))
+#define WINDOW_MASK(s)        ((uint32_t)1 << (WINDOW_BIT(s) & 31))
+#define WINDOW_TEST(map, s)   ((map)[WINDOW_BIT(s) >> 5] & WINDOW_MASK(s))
+#define WINDOW_SET(map, s)    ((map)[WINDOW_BIT(s) >> 5] |= WINDOW_MASK(s))
+#define WINDOW_CLR(map, s)    ((map)[WINDOW_BIT(s) >> 5] &= ~WINDOW_MASK(s))
+
 #define SLIDING_WINDOW_U_BIT 0x80       /* Is used */
 #define SLIDING_WINDOW_M_BIT 0x40       /* Window trickle parametrization */
 #define SLIDING_WINDOW_L_BIT 0x20       /* Current ICMP message lists us */
@@ -275,14 +294,14 @@ struct mcast_packet {
   uint16_t buff_len;
   uint16_t seq_val;             /* host-byte order */
   struct sliding_window *sw;    /* Pointer to the SW this packet belongs to */
-  uint8_t flags;                /* Is-Used, Must Send, Is Listed */
+  struct mcast_packet *next;    /* Hash bucket chain, or the free list */
+  uint8_t flags;                /* Is-Used, Must Send */
   uint8_t buff[UIP_BUFSIZE - UIP_LLH_LEN];
 };
 
 /* Flag bits */
 #define MCAST_PACKET_U_BIT       0x80   /* Is Used */
 #define MCAST_PACKET_S_BIT       0x20   /* Must Send Next Pass */
-#define MCAST_PACKET_L_BIT       0x10   /* Is listed in ICMP message */
 
 /* Fetch a pointer to the Seed ID of a buffered message p */
 #if ROLL_TM_SHORT_SEEDS
@@ -333,24 +352,6 @@ struct mcast_packet {
  */
 #define MCAST_PACKET_SEND_CLR(p) ((p)->flags &= ~MCAST_PACKET_S_BIT)
 
-/**
- * \brief Is the message p listed in current ICMP message?
- * p: pointer to a struct mcast_packet
- */
-#define MCAST_PACKET_IS_LISTED(p) ((p)->flags & MCAST_PACKET_L_BIT)
-
-/**
- * \brief Set 'Is Listed' bit for message p
- * p: pointer to a struct mcast_packet
- */
-#define MCAST_PACKET_LISTED_SET(p) ((p)->flags |= MCAST_PACKET_L_BIT)
-
-/**
- * \brief Clear 'Is Listed' bit for message p
- * p: pointer to a struct mcast_packet
- */
-#define MCAST_PACKET_LISTED_CLR(p) ((p)->flags &= ~MCAST_PACKET_L_BIT)
-
 /**
  * \brief Free a multicast packet buffer
  * p: pointer to a struct mcast_packet
@@ -443,6 +444,8 @@ static struct roll_tm_stats stats;
 static struct trickle_param t[2];
 static struct sliding_window windows[ROLL_TM_WINS];
 static struct mcast_packet buffered_msgs[ROLL_TM_BUFF_NUM];
+static struct mcast_packet *buffer_hash[ROLL_TM_BUFF_HASH_SIZE];
+static struct mcast_packet *free_msgs;
 /*---------------------------------------------------------------------------*/
 /* Temporary Stores */
 /*---------------------------------------------------------------------------*/
@@ -470,9 +473,9 @@ extern uint16_t uip_slen;
 /*---------------------------------------------------------------------------*/
 static void icmp_input(void);
 static void icmp_output(void);
-static void window_update_bounds(void);
 static void reset_trickle_timer(uint8_t);
 static void handle_timer(void *);
+static void buffer_free(struct mcast_packet *);
 /*---------------------------------------------------------------------------*/
 /* ROLL TM ICMPv6 handler declaration */
 UIP_ICMP6_HANDLER(roll_tm_icmp_handler, ICMP6_ROLL_TM,
@@ -604,17 +607,10 @@ handle_timer(void *ptr)
                      TRICKLE_ACTIVE(param));
 
       if(locmpptr->dwell > TRICKLE_DWELL(param)) {
-        locmpptr->sw->count--;
         PRINTF("ROLL TM: M=%u Free Packet %u (%lu > %lu), Window now at %u\n",
                m, locmpptr->seq_val, locmpptr->dwell,
-               TRICKLE_DWELL(param), locmpptr->sw->count);
-        if(locmpptr->sw->count == 0) {
-          PRINTF("ROLL TM: M=%u Free Window ", m);
-          PRINT_SEED(&locmpptr->sw->seed_id);
-          PRINTF("\n");
-          window_free(locmpptr->sw);
-        }
-        MCAST_PACKET_FREE(locmpptr);
+               TRICKLE_DWELL(param), locmpptr->sw->count - 1);
+        buffer_free(locmpptr);
       } else if(MCAST_PACKET_TTL(locmpptr) > 0) {
         /* Handle multicast transmissions */
         if(locmpptr->active < TRICKLE_ACTIVE(param) &&
@@ -646,8 +642,6 @@ handle_timer(void *ptr)
   param->inconsistency = 0;
   param->c = 0;
 
-  window_update_bounds();
-
   /* Temporarily store 'now' in t_next */
   param->t_next = clock_time();
   if(param->t_next >= param->t_end) {
@@ -692,6 +686,8 @@ window_allocate()
       iterswptr->lower_bound = -1;
       iterswptr->upper_bound = -1;
       iterswptr->min_listed = -1;
+      memset(iterswptr->held, 0, sizeof(iterswptr->held));
+      memset(iterswptr->listed, 0, sizeof(iterswptr->listed));
       return iterswptr;
     }
   }
@@ -714,38 +710,129 @@ window_lookup(seed_id_t *s, uint8_t m)
   return NULL;
 }
 /*---------------------------------------------------------------------------*/
+/* Do we hold a buffered message with sequence value seq for window w? */
+static uint8_t
+window_holds(struct sliding_window *w, uint16_t seq)
+{
+  return w->count > 0 &&
+         SEQ_VAL_DIST(w->lower_bound, seq) <=
+         SEQ_VAL_DIST(w->lower_bound, w->upper_bound) &&
+         WINDOW_TEST(w->held, seq) != 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Record that window w now holds seq, which is not older than its bounds */
 static void
-window_update_bounds()
+window_add(struct sliding_window *w, uint16_t seq)
 {
-  for(iterswptr = &windows[ROLL_TM_WINS - 1]; iterswptr >= windows;
-      iterswptr--) {
-    iterswptr->lower_bound = -1;
+  if(w->count == 0) {
+    w->lower_bound = seq;
+    w->upper_bound = seq;
+    VERBOSE_PRINTF("ROLL TM: New Lower Bound %u\n", w->lower_bound);
+  } else if(SEQ_VAL_IS_GT(seq, w->upper_bound)) {
+    w->upper_bound = seq;
+    VERBOSE_PRINTF("ROLL TM: New Upper Bound %u\n", w->upper_bound);
   }
+  WINDOW_SET(w->held, seq);
+  w->count++;
+}
+/*---------------------------------------------------------------------------*/
+/* Record that window w no longer holds seq and move its bounds inwards */
+static void
+window_remove(struct sliding_window *w, uint16_t seq)
+{
+  WINDOW_CLR(w->held, seq);
+  WINDOW_CLR(w->listed, seq);
+  w->count--;
 
-  for(locmpptr = &buffered_msgs[ROLL_TM_BUFF_NUM - 1];
-      locmpptr >= buffered_msgs; locmpptr--) {
-    if(MCAST_PACKET_IS_USED(locmpptr)) {
-      iterswptr = locmpptr->sw;
-      VERBOSE_PRINTF("ROLL TM: Update Bounds: [%d - %d] vs %u\n",
-                     iterswptr->lower_bound, iterswptr->upper_bound,
-                     locmpptr->seq_val);
-      if(iterswptr->lower_bound < 0
-         || SEQ_VAL_IS_LT(locmpptr->seq_val, iterswptr->lower_bound)) {
-        iterswptr->lower_bound = locmpptr->seq_val;
-      }
-      if(iterswptr->upper_bound < 0 ||
-         SEQ_VAL_IS_GT(locmpptr->seq_val, iterswptr->upper_bound)) {
-        iterswptr->upper_bound = locmpptr->seq_val;
-      }
+  if(w->count == 0) {
+    PRINTF("ROLL TM: M=%u Free Window ", SLIDING_WINDOW_GET_M(w));
+    PRINT_SEED(&w->seed_id);
+    PRINTF("\n");
+    w->lower_bound = -1;
+    w->upper_bound = -1;
+    window_free(w);
+    return;
+  }
+
+  if(SEQ_VAL_IS_EQ(seq, w->lower_bound)) {
+    do {
+      seq = SEQ_VAL_ADD(seq, 1);
+    } while(!WINDOW_TEST(w->held, seq));
+    w->lower_bound = seq;
+  } else if(SEQ_VAL_IS_EQ(seq, w->upper_bound)) {
+    do {
+      seq = SEQ_VAL_ADD(seq, 0x7FFF);
+    } while(!WINDOW_TEST(w->held, seq));
+    w->upper_bound = seq;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static struct mcast_packet **
+buffer_bucket(struct sliding_window *w, uint16_t seq)
+{
+  return &buffer_hash[((w - windows) * ROLL_TM_WINDOW_SIZE + seq) &
+                      (ROLL_TM_BUFF_HASH_SIZE - 1)];
+}
+/*---------------------------------------------------------------------------*/
+static struct mcast_packet *
+buffer_lookup(struct sliding_window *w, uint16_t seq)
+{
+  struct mcast_packet *p;
+
+  for(p = *buffer_bucket(w, seq); p != NULL; p = p->next) {
+    if(p->sw == w && SEQ_VAL_IS_EQ(p->seq_val, seq)) {
+      return p;
     }
   }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+/* Index a freshly filled in buffer under its window and sequence value */
+static void
+buffer_insert(struct mcast_packet *p)
+{
+  struct mcast_packet **bucket = buffer_bucket(p->sw, p->seq_val);
+
+  p->next = *bucket;
+  *bucket = p;
+  window_add(p->sw, p->seq_val);
+  MCAST_PACKET_USED_SET(p);
+}
+/*---------------------------------------------------------------------------*/
+/* Drop a buffered message and return its buffer to the free list */
+static void
+buffer_free(struct mcast_packet *p)
+{
+  struct mcast_packet **prev;
+
+  for(prev = buffer_bucket(p->sw, p->seq_val); *prev != NULL;
+      prev = &(*prev)->next) {
+    if(*prev == p) {
+      *prev = p->next;
+      break;
+    }
+  }
+  window_remove(p->sw, p->seq_val);
+  MCAST_PACKET_FREE(p);
+  p->next = free_msgs;
+  free_msgs = p;
+}
+/*---------------------------------------------------------------------------*/
+static struct mcast_packet *
+buffer_allocate()
+{
+  struct mcast_packet *p = free_msgs;
+
+  if(p != NULL) {
+    free_msgs = p->next;
+  }
+  return p;
 }
 /*---------------------------------------------------------------------------*/
 static struct mcast_packet *
 buffer_reclaim()
 {
   struct sliding_window *largest = windows;
-  struct mcast_packet *rv;
 
   for(iterswptr = &windows[ROLL_TM_WINS - 1]; iterswptr >= windows;
       iterswptr--) {
@@ -754,7 +841,7 @@ buffer_reclaim()
     }
   }
 
-  if(largest->count == 1) {
+  if(largest->count <= 1) {
     /* Can't reclaim last entry for a window and this is the largest window */
     return NULL;
   }
@@ -763,36 +850,17 @@ buffer_reclaim()
   PRINT_SEED(&largest->seed_id);
   PRINTF(" M=%u, count was %u\n",
          SLIDING_WINDOW_GET_M(largest), largest->count);
-  /* Find the packet at the lowest bound for the largest window */
-  for(locmpptr = &buffered_msgs[ROLL_TM_BUFF_NUM - 1];
-      locmpptr >= buffered_msgs; locmpptr--) {
-    if(MCAST_PACKET_IS_USED(locmpptr) && (locmpptr->sw == largest) &&
-       SEQ_VAL_IS_EQ(locmpptr->seq_val, largest->lower_bound)) {
-      rv = locmpptr;
-      PRINTF("ROLL TM: Reclaim seq. val %u\n", locmpptr->seq_val);
-      MCAST_PACKET_FREE(rv);
-      largest->count--;
-      window_update_bounds();
-      VERBOSE_PRINTF("ROLL TM: Reclaim - new bounds [%u , %u]\n",
-                     largest->lower_bound, largest->upper_bound);
-      return rv;
-    }
-  }
-
-  /* oops */
-  return NULL;
-}
-/*---------------------------------------------------------------------------*/
-static struct mcast_packet *
-buffer_allocate()
-{
-  for(locmpptr = &buffered_msgs[ROLL_TM_BUFF_NUM - 1];
-      locmpptr >= buffered_msgs; locmpptr--) {
-    if(!MCAST_PACKET_IS_USED(locmpptr)) {
-      return locmpptr;
-    }
+  /* Free the packet at the lowest bound for the largest window */
+  locmpptr = buffer_lookup(largest, largest->lower_bound);
+  if(locmpptr == NULL) {
+    /* oops */
+    return NULL;
   }
-  return NULL;
+  PRINTF("ROLL TM: Reclaim seq. val %u\n", locmpptr->seq_val);
+  buffer_free(locmpptr);
+  VERBOSE_PRINTF("ROLL TM: Reclaim - new bounds [%u , %u]\n",
+                 largest->lower_bound, largest->upper_bound);
+  return buffer_allocate();
 }
 /*---------------------------------------------------------------------------*/
 static void
@@ -801,6 +869,7 @@ icmp_output()
   struct sequence_list_header *sl;
   uint8_t *buffer;
   uint16_t payload_len;
+  uint16_t seq_val;
 
   PRINTF("ROLL TM: ICMPv6 Out\n");
 
@@ -832,11 +901,12 @@ icmp_output()
 
       buffer = (uint8_t *)sl + sizeof(struct sequence_list_header);
 
-      for(locmpptr = &buffered_msgs[ROLL_TM_BUFF_NUM - 1];
-          locmpptr >= buffered_msgs; locmpptr--) {
-        if(MCAST_PACKET_IS_USED(locmpptr) &&
-           locmpptr->active < TRICKLE_ACTIVE((&t[SLIDING_WINDOW_GET_M(iterswptr)]))) {
-          if(locmpptr->sw == iterswptr) {
+      seq_val = iterswptr->lower_bound;
+      do {
+        if(WINDOW_TEST(iterswptr->held, seq_val)) {
+          locmpptr = buffer_lookup(iterswptr, seq_val);
+          if(locmpptr != NULL && locmpptr->active <
+             TRICKLE_ACTIVE((&t[SLIDING_WINDOW_GET_M(iterswptr)]))) {
             sl->seq_len++;
             PRINTF(", %u", locmpptr->seq_val);
             *buffer = (uint8_t)(locmpptr->seq_val >> 8);
@@ -845,7 +915,8 @@ icmp_output()
             buffer++;
           }
         }
-      }
+        seq_val = SEQ_VAL_ADD(seq_val, 1);
+      } while(!SEQ_VAL_IS_GT(seq_val, iterswptr->upper_bound));
       PRINTF(", Len=%u\n", sl->seq_len);
 
       /* Scrap the entire window if it has no content */
@@ -978,17 +1049,11 @@ accept(uint8_t in)
       UIP_MCAST6_STATS_ADD(mcast_dropped);
       return UIP_MCAST6_DROP;
     }
-    for(locmpptr = &buffered_msgs[ROLL_TM_BUFF_NUM - 1];
-        locmpptr >= buffered_msgs; locmpptr--) {
-      if(MCAST_PACKET_IS_USED(locmpptr) &&
-         locmpptr->sw == locswptr &&
-         SLIDING_WINDOW_GET_M(locmpptr->sw) == m &&
-         SEQ_VAL_IS_EQ(seq_val, locmpptr->seq_val)) {
-        /* Seen before , drop */
-        PRINTF("ROLL TM: Seen before\n");
-        UIP_MCAST6_STATS_ADD(mcast_dropped);
-        return UIP_MCAST6_DROP;
-      }
+    if(window_holds(locswptr, seq_val)) {
+      /* Seen before , drop */
+      PRINTF("ROLL TM: Seen before\n");
+      UIP_MCAST6_STATS_ADD(mcast_dropped);
+      return UIP_MCAST6_DROP;
     }
   }
 
@@ -1007,6 +1072,17 @@ accept(uint8_t in)
     return UIP_MCAST6_DROP;
   }
 
+  /*
+   * Keep the window within ROLL_TM_WINDOW_SIZE sequence values so that each
+   * of them maps to its own bit: slide it forward by dropping its oldest
+   * messages
+   */
+  while(locswptr->count > 0 &&
+        SEQ_VAL_DIST(locswptr->lower_bound, seq_val) >= ROLL_TM_WINDOW_SIZE) {
+    PRINTF("ROLL TM: Slide window past %u\n", locswptr->lower_bound);
+    buffer_free(buffer_lookup(locswptr, locswptr->lower_bound));
+  }
+
   /* Allocate a buffer */
   locmpptr = buffer_allocate();
   if(!locmpptr) {
@@ -1020,9 +1096,9 @@ accept(uint8_t in)
     PRINTF("ROLL TM: Buffer reclaim failed\n");
     if(locswptr->count == 0) {
       window_free(locswptr);
-      UIP_MCAST6_STATS_ADD(mcast_dropped);
-      return UIP_MCAST6_DROP;
     }
+    UIP_MCAST6_STATS_ADD(mcast_dropped);
+    return UIP_MCAST6_DROP;
   }
 #if UIP_MCAST6_STATS
   if(in == ROLL_TM_DGRAM_IN) {
@@ -1043,26 +1119,14 @@ accept(uint8_t in)
   PRINTF(" M=%u, count=%u\n",
          SLIDING_WINDOW_GET_M(locswptr), locswptr->count);
 
-  /* If this window was previously empty, set its lower bound to this packet */
-  if(locswptr->count == 0) {
-    locswptr->lower_bound = seq_val;
-    VERBOSE_PRINTF("ROLL TM: New Lower Bound %u\n", locswptr->lower_bound);
-  }
-
-  /* If this is a new Seq Num, update the window upper bound */
-  if(locswptr->count == 0 || SEQ_VAL_IS_GT(seq_val, locswptr->upper_bound)) {
-    locswptr->upper_bound = seq_val;
-    VERBOSE_PRINTF("ROLL TM: New Upper Bound %u\n", locswptr->upper_bound);
-  }
-
-  locswptr->count++;
-
   memset(locmpptr, 0, sizeof(struct mcast_packet));
   memcpy(&locmpptr->buff, UIP_IP_BUF, uip_len);
   locmpptr->sw = locswptr;
   locmpptr->buff_len = uip_len;
   locmpptr->seq_val = seq_val;
-  MCAST_PACKET_USED_SET(locmpptr);
+
+  /* Index the buffer and update the window bounds */
+  buffer_insert(locmpptr);
 
   PRINTF("ROLL TM: Window for seed ");
   PRINT_SEED(&locswptr->seed_id);
@@ -1136,16 +1200,11 @@ icmp_input()
 
   ROLL_TM_STATS_ADD(icmp_in);
 
-  /* Reset Is-Listed bit for all windows */
+  /* Reset Is-Listed bits for all windows and their cached packets */
   for(iterswptr = &windows[ROLL_TM_WINS - 1]; iterswptr >= windows;
       iterswptr--) {
     SLIDING_WINDOW_LISTED_CLR(iterswptr);
-  }
-
-  /* Reset Is-Listed bit for all cached packets */
-  for(locmpptr = &buffered_msgs[ROLL_TM_BUFF_NUM - 1];
-      locmpptr >= buffered_msgs; locmpptr--) {
-    MCAST_PACKET_LISTED_CLR(locmpptr);
+    memset(iterswptr->listed, 0, sizeof(iterswptr->listed));
   }
 
   locslhptr = (struct sequence_list_header *)UIP_ICMP_PAYLOAD;
@@ -1222,23 +1281,16 @@ icmp_input()
 
           inconsistency = 1;
           /* Check if the advertised sequence is in our buffer */
-          for(locmpptr = &buffered_msgs[ROLL_TM_BUFF_NUM - 1];
-              locmpptr >= buffered_msgs; locmpptr--) {
-            if(MCAST_PACKET_IS_USED(locmpptr) && locmpptr->sw == locswptr) {
-              if(SEQ_VAL_IS_EQ(locmpptr->seq_val, val)) {
-
-                inconsistency = 0;
-                MCAST_PACKET_LISTED_SET(locmpptr);
-                PRINTF("ROLL TM: ICMPv6 In, %u listed\n", locmpptr->seq_val);
-
-                /* Update lowest seq. num listed for this window
-                 * We need this to check for "we have new" */
-                if(locswptr->min_listed == -1 ||
-                   SEQ_VAL_IS_LT(val, locswptr->min_listed)) {
-                  locswptr->min_listed = val;
-                }
-                break;
-              }
+          if(window_holds(locswptr, val)) {
+            inconsistency = 0;
+            WINDOW_SET(locswptr->listed, val);
+            PRINTF("ROLL TM: ICMPv6 In, %u listed\n", val);
+
+            /* Update lowest seq. num listed for this window
+             * We need this to check for "we have new" */
+            if(locswptr->min_listed == -1 ||
+               SEQ_VAL_IS_LT(val, locswptr->min_listed)) {
+              locswptr->min_listed = val;
             }
           }
           if(inconsistency) {
@@ -1265,37 +1317,43 @@ icmp_input()
 
   /* Check for "We have new */
   PRINTF("ROLL TM: ICMPv6 In, Check our buffer\n");
-  for(locmpptr = &buffered_msgs[ROLL_TM_BUFF_NUM - 1];
-      locmpptr >= buffered_msgs; locmpptr--) {
-    if(MCAST_PACKET_IS_USED(locmpptr)) {
-      locswptr = locmpptr->sw;
-      PRINTF("ROLL TM: ICMPv6 In, ");
-      PRINTF("Check %u, Seed L: %u, This L: %u Min L: %d\n",
-             locmpptr->seq_val, SLIDING_WINDOW_IS_LISTED(locswptr),
-             MCAST_PACKET_IS_LISTED(locmpptr), locswptr->min_listed);
-
-      /* Point to the sliding window's trickle param */
-      loctpptr = &t[SLIDING_WINDOW_GET_M(locswptr)];
-      if(!SLIDING_WINDOW_IS_LISTED(locswptr)) {
-        /* If a buffered packet's Seed ID was not listed */
-        PRINTF("ROLL TM: Inconsistency - Seed ID ");
-        PRINT_SEED(&locswptr->seed_id);
-        PRINTF(" was not listed\n");
-        loctpptr->inconsistency = 1;
-        MCAST_PACKET_SEND_SET(locmpptr);
-      } else {
-        /* This packet was not listed but a prior one was */
-        if(!MCAST_PACKET_IS_LISTED(locmpptr) &&
-           (locswptr->min_listed >= 0) &&
-           SEQ_VAL_IS_GT(locmpptr->seq_val, locswptr->min_listed)) {
+  for(iterswptr = &windows[ROLL_TM_WINS - 1]; iterswptr >= windows;
+      iterswptr--) {
+    if(!SLIDING_WINDOW_IS_USED(iterswptr) || iterswptr->count == 0) {
+      continue;
+    }
+    /* Point to the sliding window's trickle param */
+    loctpptr = &t[SLIDING_WINDOW_GET_M(iterswptr)];
+    val = iterswptr->lower_bound;
+    do {
+      if(WINDOW_TEST(iterswptr->held, val) &&
+         (locmpptr = buffer_lookup(iterswptr, val)) != NULL) {
+        PRINTF("ROLL TM: ICMPv6 In, ");
+        PRINTF("Check %u, Seed L: %u, This L: %u Min L: %d\n",
+               val, SLIDING_WINDOW_IS_LISTED(iterswptr),
+               WINDOW_TEST(iterswptr->listed, val) != 0,
+               iterswptr->min_listed);
+
+        if(!SLIDING_WINDOW_IS_LISTED(iterswptr)) {
+          /* If a buffered packet's Seed ID was not listed */
+          PRINTF("ROLL TM: Inconsistency - Seed ID ");
+          PRINT_SEED(&iterswptr->seed_id);
+          PRINTF(" was not listed\n");
+          loctpptr->inconsistency = 1;
+          MCAST_PACKET_SEND_SET(locmpptr);
+        } else if(!WINDOW_TEST(iterswptr->listed, val) &&
+                  (iterswptr->min_listed >= 0) &&
+                  SEQ_VAL_IS_GT(val, iterswptr->min_listed)) {
+          /* This packet was not listed but a prior one was */
           PRINTF("ROLL TM: Inconsistency - ");
           PRINTF("Seq. %u was not listed but %u was\n",
-                 locmpptr->seq_val, locswptr->min_listed);
+                 val, iterswptr->min_listed);
           loctpptr->inconsistency = 1;
           MCAST_PACKET_SEND_SET(locmpptr);
         }
       }
-    }
+      val = SEQ_VAL_ADD(val, 1);
+    } while(!SEQ_VAL_IS_GT(val, iterswptr->upper_bound));
   }
 
 drop:
@@ -1415,8 +1473,17 @@ init()
 
   memset(windows, 0, sizeof(windows));
   memset(buffered_msgs, 0, sizeof(buffered_msgs));
+  memset(buffer_hash, 0, sizeof(buffer_hash));
   memset(t, 0, sizeof(t));
 
+  /* Chain all buffers into the free list */
+  free_msgs = NULL;
+  for(locmpptr = &buffered_msgs[ROLL_TM_BUFF_NUM - 1];
+      locmpptr >= buffered_msgs; locmpptr--) {
+    locmpptr->next = free_msgs;
+    free_msgs = locmpptr;
+  }
+
   ROLL_TM_STATS_INIT();
   UIP_MCAST6_STATS_INIT(&stats);
 
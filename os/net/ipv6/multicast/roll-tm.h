@@ -187,6 +187,29 @@
 #define ROLL_TM_BUFF_NUM 6
 #endif
 /*---------------------------------------------------------------------------*/
+/**
+ * Span of Sequence Values held by a Sliding Window
+ * Each window keeps a bitmap of the sequence values it holds a buffer for, so
+ * the buffered messages of a seed must lie within this many consecutive
+ * sequence values. When a newer message arrives, the oldest ones are dropped.
+ * Must be a power of two and a multiple of 32
+ */
+#ifdef ROLL_TM_CONF_WINDOW_SIZE
+#define ROLL_TM_WINDOW_SIZE ROLL_TM_CONF_WINDOW_SIZE
+#else
+#define ROLL_TM_WINDOW_SIZE 32
+#endif
+/*---------------------------------------------------------------------------*/
+/**
+ * Number of hash buckets used to find a buffered message by seed and sequence
+ * value. Must be a power of two
+ */
+#ifdef ROLL_TM_CONF_BUFF_HASH_SIZE
+#define ROLL_TM_BUFF_HASH_SIZE ROLL_TM_CONF_BUFF_HASH_SIZE
+#else
+#define ROLL_TM_BUFF_HASH_SIZE 8
+#endif
+/*---------------------------------------------------------------------------*/
 /**
  * Use Short Seed IDs [short: 2, long: 16 (default)]
  * It can be argued that we should (and it would be easy to) support both at
@@ -46,6 +46,7 @@
 #include "net/ipv6/multicast/uip-mcast6.h"
 #include "net/ipv6/multicast/uip-mcast6-route.h"
 #include "net/ipv6/multicast/uip-mcast6-stats.h"
+#include "net/ipv6/multicast/uip-mcast6-fwd.h"
 #include "net/ipv6/multicast/smrf.h"
 #include "net/routing/routing.h"
 #include "net/netstack.h"
@@ -71,9 +72,6 @@
 /*---------------------------------------------------------------------------*/
 /* Internal Data */
 /*---------------------------------------------------------------------------*/
-static struct ctimer mcast_periodic;
-static uint8_t mcast_len;
-static uip_buf_t mcast_buf;
 static uint8_t fwd_delay;
 static uint8_t fwd_spread;
 /*---------------------------------------------------------------------------*/
@@ -81,16 +79,6 @@ static uint8_t fwd_spread;
 /*---------------------------------------------------------------------------*/
 #define UIP_IP_BUF        ((struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN])
 /*---------------------------------------------------------------------------*/
-static void
-mcast_fwd(void *p)
-{
-  memcpy(&uip_buf[UIP_LLH_LEN], &mcast_buf, mcast_len);
-  uip_len = mcast_len;
-  UIP_IP_BUF->ttl--;
-  tcpip_output(NULL);
-  uip_clear_buf();
-}
-/*---------------------------------------------------------------------------*/
 static uint8_t
 in()
 {
@@ -141,6 +129,13 @@ in()
   }
 
   UIP_MCAST6_STATS_ADD(mcast_in_all);
+
+  if(uip_mcast6_fwd_is_dup()) {
+    UIP_MCAST6_STATS_ADD(mcast_dropped);
+    PRINTF("SMRF: Duplicate, dropping\n");
+    return UIP_MCAST6_DROP;
+  }
+
   UIP_MCAST6_STATS_ADD(mcast_in_unique);
 
   /* If we have an entry in the mcast routing table, something with
@@ -178,9 +173,11 @@ in()
         fwd_delay = fwd_delay * (1 + ((random_rand() >> 11) % fwd_spread));
       }
 
-      memcpy(&mcast_buf, &uip_buf[UIP_LLH_LEN], uip_len);
-      mcast_len = uip_len;
-      ctimer_set(&mcast_periodic, fwd_delay, mcast_fwd, NULL);
+      /* Queue it, so that datagrams arriving during the delay are not lost */
+      if(uip_mcast6_fwd_schedule(fwd_delay) < 0) {
+        PRINTF("SMRF: Forwarding queue full\n");
+        UIP_MCAST6_STATS_ADD(mcast_dropped);
+      }
     }
     PRINTF("SMRF: %u bytes: fwd in %u [%u]\n",
            uip_len, fwd_delay, fwd_spread);
@@ -205,6 +202,7 @@ init()
   UIP_MCAST6_STATS_INIT(NULL);
 
   uip_mcast6_route_init();
+  uip_mcast6_fwd_init();
 }
 /*---------------------------------------------------------------------------*/
 static void
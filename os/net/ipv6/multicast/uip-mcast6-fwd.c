@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2019, RISE SICS AB.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * \addtogroup uip-multicast
+ * @{
+ */
+/**
+ * \file
+ *    Forwarding queue and duplicate cache used by the SMRF and ESMRF
+ *    engines
+ */
+
+#include "contiki.h"
+#include "contiki-net.h"
+#include "lib/crc16.h"
+#include "lib/memb.h"
+#include "net/ipv6/multicast/uip-mcast6-fwd.h"
+
+#include <string.h>
+
+#define DEBUG DEBUG_NONE
+#include "net/ipv6/uip-debug.h"
+
+/*---------------------------------------------------------------------------*/
+#define UIP_IP_BUF        ((struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN])
+/* Datagrams are hashed from the source address onwards */
+#define HASH_OFFSET       (UIP_LLH_LEN + 8)
+/*---------------------------------------------------------------------------*/
+/* A datagram waiting for its forwarding delay */
+struct fwd_entry {
+  struct ctimer timer;
+  uint16_t len;
+  uip_buf_t buf;
+};
+MEMB(fwd_memb, struct fwd_entry, UIP_MCAST6_FWD_QUEUE_SIZE);
+/*---------------------------------------------------------------------------*/
+#if UIP_MCAST6_FWD_DUP_CACHE_SIZE
+/* A datagram seen recently */
+struct dup_entry {
+  clock_time_t seen;
+  uint16_t crc;
+  uint16_t len;
+};
+static struct dup_entry dup_cache[UIP_MCAST6_FWD_DUP_CACHE_SIZE];
+static uint8_t dup_next;
+#endif /* UIP_MCAST6_FWD_DUP_CACHE_SIZE */
+/*---------------------------------------------------------------------------*/
+int
+uip_mcast6_fwd_is_dup(void)
+{
+#if UIP_MCAST6_FWD_DUP_CACHE_SIZE
+  struct dup_entry *e;
+  uint16_t crc;
+  clock_time_t now;
+
+  if(uip_len <= HASH_OFFSET - UIP_LLH_LEN) {
+    return 0;
+  }
+
+  crc = crc16_data(&uip_buf[HASH_OFFSET], uip_len - (HASH_OFFSET - UIP_LLH_LEN),
+                   0);
+  now = clock_time();
+
+  for(e = dup_cache; e < &dup_cache[UIP_MCAST6_FWD_DUP_CACHE_SIZE]; e++) {
+    if(e->len == uip_len && e->crc == crc &&
+       now - e->seen < UIP_MCAST6_FWD_DUP_LIFETIME) {
+      PRINTF("MCAST6 FWD: Duplicate, %u bytes, crc 0x%04x\n", uip_len, crc);
+      return 1;
+    }
+  }
+
+  /* New datagram: overwrite the oldest entry */
+  e = &dup_cache[dup_next];
+  e->seen = now;
+  e->crc = crc;
+  e->len = uip_len;
+  dup_next = (dup_next + 1) % UIP_MCAST6_FWD_DUP_CACHE_SIZE;
+#endif /* UIP_MCAST6_FWD_DUP_CACHE_SIZE */
+
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+fwd(void *p)
+{
+  struct fwd_entry *e = p;
+
+  memcpy(&uip_buf[UIP_LLH_LEN], &e->buf, e->len);
+  uip_len = e->len;
+  memb_free(&fwd_memb, e);
+
+  UIP_IP_BUF->ttl--;
+  tcpip_output(NULL);
+  uip_clear_buf();
+}
+/*---------------------------------------------------------------------------*/
+int
+uip_mcast6_fwd_schedule(clock_time_t delay)
+{
+  struct fwd_entry *e;
+
+  e = memb_alloc(&fwd_memb);
+  if(e == NULL) {
+    PRINTF("MCAST6 FWD: Queue full, %u bytes not forwarded\n", uip_len);
+    return -1;
+  }
+
+  memcpy(&e->buf, &uip_buf[UIP_LLH_LEN], uip_len);
+  e->len = uip_len;
+  ctimer_set(&e->timer, delay, fwd, e);
+
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_mcast6_fwd_init(void)
+{
+  memb_init(&fwd_memb);
+
+#if UIP_MCAST6_FWD_DUP_CACHE_SIZE
+  memset(dup_cache, 0, sizeof(dup_cache));
+  dup_next = 0;
+#endif /* UIP_MCAST6_FWD_DUP_CACHE_SIZE */
+}
+/*---------------------------------------------------------------------------*/
+/** @} */
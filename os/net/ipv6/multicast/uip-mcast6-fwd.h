@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2019, RISE SICS AB.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * \addtogroup uip-multicast
+ * @{
+ */
+/**
+ * \file
+ *    Header file for the forwarding queue and duplicate cache used by the
+ *    SMRF and ESMRF engines
+ */
+#ifndef UIP_MCAST6_FWD_H_
+#define UIP_MCAST6_FWD_H_
+
+#include "contiki.h"
+
+#include <stdint.h>
+/*---------------------------------------------------------------------------*/
+/* Configuration */
+/*---------------------------------------------------------------------------*/
+/*
+ * Number of datagrams that can wait for their forwarding delay at once.
+ * Each entry holds a full uip_buf_t, i.e. UIP_BUFSIZE bytes plus a ctimer
+ * (about 1.3 KB with the default buffer size). The default of 1 uses the
+ * same RAM as the single pending datagram SMRF and ESMRF used to keep. A
+ * datagram arriving while the queue is full is not forwarded.
+ */
+#ifdef UIP_MCAST6_FWD_CONF_QUEUE_SIZE
+#define UIP_MCAST6_FWD_QUEUE_SIZE UIP_MCAST6_FWD_CONF_QUEUE_SIZE
+#else
+#define UIP_MCAST6_FWD_QUEUE_SIZE 1
+#endif
+
+/*
+ * Number of recently seen datagrams remembered, in order to drop
+ * duplicates. Each entry takes sizeof(clock_time_t) + 4 bytes. The cache is
+ * off by default (0): SMRF and ESMRF then deliver and forward every copy
+ * of a datagram, as they always did.
+ */
+#ifdef UIP_MCAST6_FWD_CONF_DUP_CACHE_SIZE
+#define UIP_MCAST6_FWD_DUP_CACHE_SIZE UIP_MCAST6_FWD_CONF_DUP_CACHE_SIZE
+#else
+#define UIP_MCAST6_FWD_DUP_CACHE_SIZE 0
+#endif
+
+/* For how long a datagram seen is considered a duplicate, in clock ticks */
+#ifdef UIP_MCAST6_FWD_CONF_DUP_LIFETIME
+#define UIP_MCAST6_FWD_DUP_LIFETIME UIP_MCAST6_FWD_CONF_DUP_LIFETIME
+#else
+#define UIP_MCAST6_FWD_DUP_LIFETIME (CLOCK_SECOND * 4)
+#endif
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Check whether the datagram in uip_buf has been seen recently
+ * \retval 0 The datagram is new, or the cache is disabled. A new datagram
+ *           is remembered for UIP_MCAST6_FWD_DUP_LIFETIME ticks
+ * \retval 1 The datagram is a duplicate
+ *
+ * Datagrams are told apart by a CRC over their source and destination
+ * addresses and their payload, together with their length. The hop limit
+ * is not included, so the same datagram relayed again is recognised.
+ */
+int uip_mcast6_fwd_is_dup(void);
+
+/**
+ * \brief Schedule the datagram in uip_buf for forwarding
+ * \param delay The number of clock ticks to wait before forwarding
+ * \retval 0 The datagram was queued
+ * \retval -1 The queue is full and the datagram was not queued
+ *
+ * Each queued datagram has its own timer, so datagrams arriving while
+ * others are still waiting are not lost. The hop limit is decremented when
+ * the datagram is sent.
+ */
+int uip_mcast6_fwd_schedule(clock_time_t delay);
+
+/**
+ * \brief Initialise the forwarding queue and the duplicate cache
+ */
+void uip_mcast6_fwd_init(void);
+/*---------------------------------------------------------------------------*/
+#endif /* UIP_MCAST6_FWD_H_ */
+/*---------------------------------------------------------------------------*/
+/** @} */
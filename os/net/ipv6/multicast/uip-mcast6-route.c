@@ -60,15 +60,25 @@
 LIST(mcast_route_list);
 MEMB(mcast_route_memb, uip_mcast6_route_t, UIP_MCAST6_ROUTE_ROUTES);
 
+/* Routes are also chained in buckets keyed by the group ID */
+static uip_mcast6_route_t *mcast_route_hash[UIP_MCAST6_ROUTE_HASH_SIZE];
+
 static uip_mcast6_route_t *locmcastrt;
 /*---------------------------------------------------------------------------*/
+static uip_mcast6_route_t **
+bucket(const uip_ipaddr_t *group)
+{
+  /* The low-order bytes hold the group ID, which is what tells groups apart */
+  return &mcast_route_hash[(group->u8[15] ^ group->u8[14] ^ group->u8[13] ^
+                            group->u8[1]) & (UIP_MCAST6_ROUTE_HASH_SIZE - 1)];
+}
+/*---------------------------------------------------------------------------*/
 uip_mcast6_route_t *
 uip_mcast6_route_lookup(uip_ipaddr_t *group)
 {
-  locmcastrt = NULL;
-  for(locmcastrt = list_head(mcast_route_list);
+  for(locmcastrt = *bucket(group);
       locmcastrt != NULL;
-      locmcastrt = list_item_next(locmcastrt)) {
+      locmcastrt = locmcastrt->hash_next) {
     if(uip_ipaddr_cmp(&locmcastrt->group, group)) {
       return locmcastrt;
     }
@@ -89,23 +99,29 @@ uip_mcast6_route_add(uip_ipaddr_t *group)
       return NULL;
     }
     list_add(mcast_route_list, locmcastrt);
+    uip_ipaddr_copy(&(locmcastrt->group), group);
+    locmcastrt->hash_next = *bucket(group);
+    *bucket(group) = locmcastrt;
   }
 
   /* Reaching here means we either found the prefix or allocated a new one */
 
-  uip_ipaddr_copy(&(locmcastrt->group), group);
-
   return locmcastrt;
 }
 /*---------------------------------------------------------------------------*/
 void
 uip_mcast6_route_rm(uip_mcast6_route_t *route)
 {
-  /* Make sure it's actually in the list */
-  for(locmcastrt = list_head(mcast_route_list);
-      locmcastrt != NULL;
-      locmcastrt = list_item_next(locmcastrt)) {
-    if(locmcastrt == route) {
+  uip_mcast6_route_t **prev;
+
+  /* Make sure it's actually in the table */
+  if(route == NULL) {
+    return;
+  }
+  for(prev = bucket(&route->group); *prev != NULL;
+      prev = &(*prev)->hash_next) {
+    if(*prev == route) {
+      *prev = route->hash_next;
       list_remove(mcast_route_list, route);
       memb_free(&mcast_route_memb, route);
       return;
@@ -130,6 +146,7 @@ uip_mcast6_route_init()
 {
   memb_init(&mcast_route_memb);
   list_init(mcast_route_list);
+  memset(mcast_route_hash, 0, sizeof(mcast_route_hash));
 }
 /*---------------------------------------------------------------------------*/
 /** @} */
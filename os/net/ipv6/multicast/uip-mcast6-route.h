@@ -47,9 +47,17 @@
 
 #include <stdint.h>
 /*---------------------------------------------------------------------------*/
+/* Number of buckets of the group hash used for lookups (power of two) */
+#ifdef UIP_MCAST6_ROUTE_CONF_HASH_SIZE
+#define UIP_MCAST6_ROUTE_HASH_SIZE UIP_MCAST6_ROUTE_CONF_HASH_SIZE
+#else
+#define UIP_MCAST6_ROUTE_HASH_SIZE 8
+#endif
+/*---------------------------------------------------------------------------*/
 /** \brief An entry in the multicast routing table */
 typedef struct uip_mcast6_route {
   struct uip_mcast6_route *next; /**< Routes are arranged in a linked list */
+  struct uip_mcast6_route *hash_next; /**< Next route in the same bucket */
   uip_ipaddr_t group; /**< The multicast group */
   uint32_t lifetime; /**< Entry lifetime seconds */
   void *dag; /**< Pointer to an rpl_dag_t struct */
@@ -75,6 +75,7 @@
 #include "net/queuebuf.h"
 
 #include "net/routing/routing.h"
+#include "services/radio-accounting/radio-accounting.h"
 
 /* Log configuration */
 #include "sys/log.h"
@@ -1582,6 +1583,9 @@ output(const linkaddr_t *localdest)
 
   LOG_INFO("output: sending IPv6 packet with len %d\n", uip_len);
 
+  /* Tag the packet for radio accounting */
+  RADIO_ACCOUNTING_SET_CATEGORY(radio_accounting_classify());
+
   /* copy over the retransmission count from uipbuf attributes */
   packetbuf_set_attr(PACKETBUF_ATTR_MAX_MAC_TRANSMISSIONS,
                      uipbuf_get_attr(UIPBUF_ATTR_MAX_MAC_TRANSMISSIONS));
@@ -1686,6 +1690,8 @@ output(const linkaddr_t *localdest)
     /* Update fragment tag */
     frag_tag = my_tag++;
 
+    RADIO_ACCOUNTING_SET_CATEGORY(RADIO_ACCOUNTING_FRAG);
+
     /* Move IPHC/IPv6 header to make room for FRAG1 header */
     memmove(packetbuf_ptr + SICSLOWPAN_FRAG1_HDR_LEN, packetbuf_ptr, packetbuf_hdr_len);
     packetbuf_hdr_len += SICSLOWPAN_FRAG1_HDR_LEN;
@@ -1802,6 +1808,8 @@ input(void)
   packetbuf_ptr = packetbuf_dataptr();
 
   if(packetbuf_datalen() == 0) {
+    /* No 6LoWPAN payload, e.g. a TSCH keepalive */
+    RADIO_ACCOUNTING_RX(RADIO_ACCOUNTING_MAC, packetbuf_totlen());
     LOG_WARN("input: empty packet\n");
     return;
   }
@@ -1874,6 +1882,10 @@ input(void)
       break;
   }
 
+  if(is_fragment) {
+    RADIO_ACCOUNTING_RX(RADIO_ACCOUNTING_FRAG, packetbuf_totlen());
+  }
+
   if(is_fragment && !first_fragment) {
     /* this is a FRAGN, skip the header compression dispatch section */
     goto copypayload;
@@ -1998,6 +2010,14 @@ input(void)
       LOG_DBG_("\n");
     }
 
+#if SICSLOWPAN_CONF_FRAG
+    if(!is_fragment) {
+      RADIO_ACCOUNTING_RX(radio_accounting_classify(), packetbuf_totlen());
+    }
+#else /* SICSLOWPAN_CONF_FRAG */
+    RADIO_ACCOUNTING_RX(radio_accounting_classify(), packetbuf_totlen());
+#endif /* SICSLOWPAN_CONF_FRAG */
+
     /* if callback is set then set attributes and call */
     if(callback) {
       set_packet_attrs();
@@ -49,6 +49,7 @@
 #include "net/netstack.h"
 #include "lib/list.h"
 #include "lib/memb.h"
+#include "services/radio-accounting/radio-accounting.h"
 
 #if CONTIKI_TARGET_COOJA
 #include "lib/simEnvChange.h"
@@ -180,6 +181,7 @@ send_one_packet(void *ptr)
     ret = MAC_TX_ERR_FATAL;
   } else {
     int is_broadcast;
+    int tx_result;
     uint8_t dsn;
     dsn = ((uint8_t *)packetbuf_hdrptr())[2] & 0xff;
 
@@ -196,7 +198,12 @@ send_one_packet(void *ptr)
       ret = MAC_TX_COLLISION;
     } else {
 
-      switch(NETSTACK_RADIO.transmit(packetbuf_totlen())) {
+      tx_result = NETSTACK_RADIO.transmit(packetbuf_totlen());
+      /* Count every attempt, including the ones that the radio reports
+         as a collision or as not acknowledged */
+      RADIO_ACCOUNTING_TX(packetbuf_totlen(), 1);
+
+      switch(tx_result) {
       case RADIO_TX_OK:
         if(is_broadcast) {
           ret = MAC_TX_OK;
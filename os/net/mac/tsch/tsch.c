@@ -57,6 +57,7 @@
 #include "net/mac/mac-sequence.h"
 #include "lib/random.h"
 #include "net/routing/routing.h"
+#include "services/radio-accounting/radio-accounting.h"
 
 #if TSCH_WITH_SIXTOP
 #include "net/mac/tsch/sixtop/sixtop.h"
@@ -301,6 +302,7 @@ keepalive_send(void *ptr)
         /* Simply send an empty packet */
         packetbuf_clear();
         packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, &n->addr);
+        RADIO_ACCOUNTING_SET_CATEGORY(RADIO_ACCOUNTING_MAC);
         NETSTACK_MAC.send(keepalive_packet_sent, NULL);
         LOG_INFO("sending KA to ");
         LOG_INFO_LLADDR(&n->addr);
@@ -443,6 +445,7 @@ tsch_rx_process_pending()
       /* Pass to upper layers */
       packet_input();
     } else if(is_eb) {
+      RADIO_ACCOUNTING_RX(RADIO_ACCOUNTING_MAC, current_input->len);
       eb_input(current_input);
     }
 
@@ -461,6 +464,7 @@ tsch_tx_process_pending(void)
     struct tsch_packet *p = dequeued_array[dequeued_index];
     /* Put packet into packetbuf for packet_sent callback */
     queuebuf_to_packetbuf(p->qb);
+    RADIO_ACCOUNTING_TX(packetbuf_totlen(), p->transmissions);
     LOG_INFO("packet sent to ");
     LOG_INFO_LLADDR(packetbuf_addr(PACKETBUF_ADDR_RECEIVER));
     LOG_INFO_(", seqno %u, status %d, tx %d\n",
@@ -827,6 +831,7 @@ PROCESS_THREAD(tsch_send_eb_process, ev, data)
         /* Prepare the EB packet and schedule it to be sent */
         if(tsch_packet_create_eb(&hdr_len, &tsch_sync_ie_offset) > 0) {
           struct tsch_packet *p;
+          RADIO_ACCOUNTING_SET_CATEGORY(RADIO_ACCOUNTING_MAC);
           /* Enqueue EB packet, for a single transmission only */
           if(!(p = tsch_queue_add_packet(&tsch_eb_address, 1, NULL, NULL))) {
             LOG_ERR("! could not enqueue EB packet\n");
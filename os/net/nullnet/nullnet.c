@@ -47,6 +47,7 @@
 #include "net/packetbuf.h"
 #include "net/netstack.h"
 #include "net/nullnet/nullnet.h"
+#include "services/radio-accounting/radio-accounting.h"
 
 /* Log configuration */
 #include "sys/log.h"
@@ -67,6 +68,7 @@ init(void)
 static void
 input(void)
 {
+  RADIO_ACCOUNTING_RX(RADIO_ACCOUNTING_OTHER, packetbuf_totlen());
   if(current_callback != NULL) {
     LOG_INFO("received %u bytes from ", packetbuf_datalen());
     LOG_INFO_LLADDR(packetbuf_addr(PACKETBUF_ADDR_SENDER));
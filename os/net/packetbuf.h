@@ -227,6 +227,9 @@ enum {
   PACKETBUF_ATTR_TSCH_SLOTFRAME,
   PACKETBUF_ATTR_TSCH_TIMESLOT,
 #endif /* TSCH_WITH_LINK_SELECTOR */
+#if BUILD_WITH_RADIO_ACCOUNTING
+  PACKETBUF_ATTR_RADIO_ACCOUNTING,
+#endif /* BUILD_WITH_RADIO_ACCOUNTING */
 
   /* Scope 1 attributes: used between two neighbors only. */
   PACKETBUF_ATTR_FRAME_TYPE,
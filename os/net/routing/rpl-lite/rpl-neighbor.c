@@ -64,6 +64,15 @@ static rpl_nbr_t * best_parent(int fresh_only);
 /* Per-neighbor RPL information */
 NBR_TABLE_GLOBAL(rpl_nbr_t, rpl_neighbors);
 
+/* Parent candidates, kept in a binary min-heap ordered by path cost. The
+ * heap is updated whenever the rank or link metric of a neighbor changes,
+ * so that parent selection does not need to evaluate every neighbor. */
+static rpl_nbr_t *candidates[NBR_TABLE_MAX_NEIGHBORS];
+static uint16_t candidate_count;
+
+/* Preferred parent churn statistics */
+static struct rpl_parent_stats parent_stats;
+
 /*---------------------------------------------------------------------------*/
 static int
 max_acceptable_rank(void)
@@ -190,6 +199,75 @@ rpl_get_ds6_nbr(rpl_nbr_t *nbr)
 }
 #endif /* UIP_ND6_SEND_NS */
 /*---------------------------------------------------------------------------*/
+static int
+is_candidate(rpl_nbr_t *nbr)
+{
+  return nbr->candidate_index < candidate_count
+      && candidates[nbr->candidate_index] == nbr;
+}
+/*---------------------------------------------------------------------------*/
+static void
+set_candidate(uint16_t index, rpl_nbr_t *nbr)
+{
+  candidates[index] = nbr;
+  nbr->candidate_index = index;
+}
+/*---------------------------------------------------------------------------*/
+static void
+sift_up(uint16_t index)
+{
+  rpl_nbr_t *nbr = candidates[index];
+  uint16_t parent;
+
+  while(index > 0) {
+    parent = (index - 1) / 2;
+    if(candidates[parent]->path_cost <= nbr->path_cost) {
+      break;
+    }
+    set_candidate(index, candidates[parent]);
+    index = parent;
+  }
+  set_candidate(index, nbr);
+}
+/*---------------------------------------------------------------------------*/
+static void
+sift_down(uint16_t index)
+{
+  rpl_nbr_t *nbr = candidates[index];
+  uint16_t child;
+
+  while((child = 2 * index + 1) < candidate_count) {
+    if(child + 1 < candidate_count
+        && candidates[child + 1]->path_cost < candidates[child]->path_cost) {
+      child++;
+    }
+    if(nbr->path_cost <= candidates[child]->path_cost) {
+      break;
+    }
+    set_candidate(index, candidates[child]);
+    index = child;
+  }
+  set_candidate(index, nbr);
+}
+/*---------------------------------------------------------------------------*/
+static void
+remove_candidate(rpl_nbr_t *nbr)
+{
+  rpl_nbr_t *last;
+
+  if(!is_candidate(nbr)) {
+    return;
+  }
+
+  /* Fill the gap with the last candidate, and move it to its position */
+  last = candidates[--candidate_count];
+  if(last != nbr) {
+    set_candidate(nbr->candidate_index, last);
+    sift_up(last->candidate_index);
+    sift_down(last->candidate_index);
+  }
+}
+/*---------------------------------------------------------------------------*/
 static void
 remove_neighbor(rpl_nbr_t *nbr)
 {
@@ -202,6 +280,7 @@ remove_neighbor(rpl_nbr_t *nbr)
   if(nbr == curr_instance.dag.unicast_dio_target) {
     curr_instance.dag.unicast_dio_target = NULL;
   }
+  remove_candidate(nbr);
   nbr_table_remove(rpl_neighbors, nbr);
   rpl_timers_schedule_state_update(); /* Updating from here is unsafe; postpone */
 }
@@ -313,10 +392,69 @@ rpl_neighbor_set_preferred_parent(rpl_nbr_t *nbr)
       rpl_neighbor_get_ipaddr(curr_instance.dag.preferred_parent)));
     uip_ds6_defrt_add(rpl_neighbor_get_ipaddr(nbr), 0);
 
+    /* Update churn statistics */
+    if(curr_instance.dag.preferred_parent == NULL) {
+      parent_stats.selections++;
+    } else if(nbr == NULL) {
+      parent_stats.losses++;
+    } else {
+      parent_stats.switches++;
+    }
+    parent_stats.last_change = clock_time();
+
     curr_instance.dag.preferred_parent = nbr;
   }
 }
 /*---------------------------------------------------------------------------*/
+const struct rpl_parent_stats *
+rpl_neighbor_get_parent_stats(void)
+{
+  return &parent_stats;
+}
+/*---------------------------------------------------------------------------*/
+void
+rpl_neighbor_update(rpl_nbr_t *nbr)
+{
+  uint16_t old_cost;
+
+  if(nbr == NULL || !curr_instance.used) {
+    return;
+  }
+
+  old_cost = nbr->path_cost;
+  nbr->path_cost = curr_instance.of->nbr_path_cost(nbr);
+
+  if(!is_candidate(nbr)) {
+    set_candidate(candidate_count++, nbr);
+    sift_up(nbr->candidate_index);
+  } else if(nbr->path_cost < old_cost) {
+    sift_up(nbr->candidate_index);
+  } else if(nbr->path_cost > old_cost) {
+    sift_down(nbr->candidate_index);
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+rpl_neighbor_update_all(void)
+{
+  rpl_nbr_t *nbr;
+  uint16_t i;
+
+  if(!curr_instance.used) {
+    return;
+  }
+
+  candidate_count = 0;
+  for(nbr = nbr_table_head(rpl_neighbors); nbr != NULL; nbr = nbr_table_next(rpl_neighbors, nbr)) {
+    nbr->path_cost = curr_instance.of->nbr_path_cost(nbr);
+    set_candidate(candidate_count++, nbr);
+  }
+
+  for(i = candidate_count / 2; i > 0; i--) {
+    sift_down(i - 1);
+  }
+}
+/*---------------------------------------------------------------------------*/
 /* Remove DAG neighbors with a rank that is at least the same as minimum_rank. */
 void
 rpl_neighbor_remove_all(void)
@@ -344,41 +482,79 @@ rpl_neighbor_get_from_ipaddr(uip_ipaddr_t *addr)
   return nbr_table_get_from_lladdr(rpl_neighbors, (linkaddr_t *)lladdr);
 }
 /*---------------------------------------------------------------------------*/
+static int
+is_usable_parent(rpl_nbr_t *nbr, int fresh_only)
+{
+  if(!acceptable_rank(nbr->rank) || !curr_instance.of->nbr_is_acceptable_parent(nbr)) {
+    /* Exclude neighbors with a rank that is not acceptable) */
+    return 0;
+  }
+
+  if(fresh_only && !rpl_neighbor_is_fresh(nbr)) {
+    /* Filter out non-fresh nerighbors if fresh_only is set */
+    return 0;
+  }
+
+#if UIP_ND6_SEND_NS
+  {
+  uip_ds6_nbr_t *ds6_nbr = rpl_get_ds6_nbr(nbr);
+  /* Exclude links to a neighbor that is not reachable at a NUD level */
+  if(ds6_nbr == NULL || ds6_nbr->state != NBR_REACHABLE) {
+    return 0;
+  }
+  }
+#endif /* UIP_ND6_SEND_NS */
+
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
 static rpl_nbr_t *
 best_parent(int fresh_only)
 {
   rpl_nbr_t *nbr;
   rpl_nbr_t *best = NULL;
+  rpl_nbr_t *preferred_parent = curr_instance.dag.preferred_parent;
+  uint16_t index;
 
   if(curr_instance.used == 0) {
     return NULL;
   }
 
-  /* Search for the best parent according to the OF */
-  for(nbr = nbr_table_head(rpl_neighbors); nbr != NULL; nbr = nbr_table_next(rpl_neighbors, nbr)) {
+  /* Search for the best parent according to the OF. Walk the candidate
+  heap in pre-order, skipping the subtrees of candidates with a higher path
+  cost than the best parent found so far. In the common case, the root of
+  the heap is usable and only a few candidates are visited. */
+  index = 0;
+  while(index < candidate_count) {
+    nbr = candidates[index];
 
-    if(!acceptable_rank(nbr->rank) || !curr_instance.of->nbr_is_acceptable_parent(nbr)) {
-      /* Exclude neighbors with a rank that is not acceptable) */
-      continue;
-    }
-
-    if(fresh_only && !rpl_neighbor_is_fresh(nbr)) {
-      /* Filter out non-fresh nerighbors if fresh_only is set */
-      continue;
+    if(best == NULL || nbr->path_cost <= best->path_cost) {
+      if(is_usable_parent(nbr, fresh_only)) {
+        /* Now we have an acceptable parent, check if it is the new best */
+        best = curr_instance.of->best_parent(best, nbr);
+      }
+      if(2 * index + 1 < candidate_count) {
+        /* Visit the children */
+        index = 2 * index + 1;
+        continue;
+      }
     }
 
-#if UIP_ND6_SEND_NS
-    {
-    uip_ds6_nbr_t *ds6_nbr = rpl_get_ds6_nbr(nbr);
-    /* Exclude links to a neighbor that is not reachable at a NUD level */
-    if(ds6_nbr == NULL || ds6_nbr->state != NBR_REACHABLE) {
-      continue;
+    /* Move on to the next subtree */
+    while(index > 0 && (index % 2 == 0 || index + 1 >= candidate_count)) {
+      index = (index - 1) / 2;
     }
+    if(index == 0) {
+      break;
     }
-#endif /* UIP_ND6_SEND_NS */
+    index++;
+  }
 
-    /* Now we have an acceptable parent, check if it is the new best */
-    best = curr_instance.of->best_parent(best, nbr);
+  /* The OF may stick to the preferred parent even if it has a higher
+  path cost, as per its hysteresis */
+  if(preferred_parent != NULL && preferred_parent != best
+      && is_usable_parent(preferred_parent, fresh_only)) {
+    best = curr_instance.of->best_parent(best, preferred_parent);
   }
 
   return best;
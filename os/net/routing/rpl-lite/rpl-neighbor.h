@@ -64,6 +64,14 @@
  */
 NBR_TABLE_DECLARE(rpl_neighbors);
 
+/* Statistics on the changes of preferred parent */
+struct rpl_parent_stats {
+  uint16_t selections; /* A parent was selected while we had none */
+  uint16_t switches; /* The preferred parent was replaced by another */
+  uint16_t losses; /* The preferred parent was lost with no replacement */
+  clock_time_t last_change; /* The time of the last change */
+};
+
 /********** Public functions **********/
 
 /**
@@ -185,6 +193,28 @@ void rpl_neighbor_print_list(const char *str);
 */
 void rpl_neighbor_remove_all(void);
 
+/**
+ * Updates the position of a neighbor among the parent candidates. Must be
+ * called whenever the rank or the link metric of the neighbor changes, and
+ * when a neighbor is added.
+ *
+ * \param nbr The neighbor
+*/
+void rpl_neighbor_update(rpl_nbr_t *nbr);
+
+/**
+ * Recomputes the path cost of all neighbors and reorders the parent
+ * candidates accordingly
+*/
+void rpl_neighbor_update_all(void);
+
+/**
+ * Returns the preferred parent churn statistics
+ *
+ * \return A pointer to the statistics
+*/
+const struct rpl_parent_stats *rpl_neighbor_get_parent_stats(void);
+
 /**
  * Returns the best candidate for preferred parent
  *
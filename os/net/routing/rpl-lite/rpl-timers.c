@@ -507,6 +507,9 @@ handle_periodic_timer(void *ptr)
   if(curr_instance.used) {
     rpl_dag_periodic(PERIODIC_DELAY_SECONDS);
     uip_sr_periodic(PERIODIC_DELAY_SECONDS);
+    /* Catch up with link metric updates that RPL was not notified of,
+    e.g., from TSCH keepalives */
+    rpl_neighbor_update_all();
   }
 
   if(!curr_instance.used ||
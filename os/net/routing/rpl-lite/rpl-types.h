@@ -141,6 +141,10 @@ struct rpl_nbr {
   rpl_metric_container_t mc;
 #endif /* RPL_WITH_MC */
   rpl_rank_t rank;
+  uint16_t path_cost; /* The path cost by which the neighbor is ordered
+  among parent candidates, as last computed by the OF */
+  uint16_t candidate_index; /* The position of the neighbor in the parent
+  candidate heap */
   uint8_t dtsn;
 };
 typedef struct rpl_nbr rpl_nbr_t;
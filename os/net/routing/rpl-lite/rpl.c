@@ -104,8 +104,9 @@ rpl_link_callback(const linkaddr_t *addr, int status, int numtx)
       if(curr_instance.dag.urgent_probing_target == nbr) {
         curr_instance.dag.urgent_probing_target = NULL;
       }
-      /* Link stats were updated, and we need to update our internal state.
-      Updating from here is unsafe; postpone */
+      /* Link stats were updated. Reorder the parent candidates right away,
+      but updating our internal state from here is unsafe; postpone */
+      rpl_neighbor_update(nbr);
       LOG_INFO("packet sent to ");
       LOG_INFO_LLADDR(addr);
       LOG_INFO_(", status %u, tx %u, new link metric %u\n", status, numtx, rpl_neighbor_get_link_metric(nbr));
@@ -55,6 +55,21 @@ dtls_session_equals(const session_t *a, const session_t *b)
     && uip_ipaddr_cmp(&((a)->addr),&(b->addr));
 }
 /*---------------------------------------------------------------------------*/
+unsigned int
+dtls_session_hash(const session_t *a)
+{
+  unsigned int hash;
+  uint8_t i;
+
+  /* FNV-1a over the address and the port */
+  hash = 2166136261u;
+  for(i = 0; i < sizeof(a->addr.u8); i++) {
+    hash = (hash ^ a->addr.u8[i]) * 16777619u;
+  }
+  hash = (hash ^ (a->port & 0xff)) * 16777619u;
+  return (hash ^ (a->port >> 8)) * 16777619u;
+}
+/*---------------------------------------------------------------------------*/
 void *
 dtls_session_get_address(const session_t *a)
 {
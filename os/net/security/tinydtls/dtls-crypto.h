@@ -48,6 +48,8 @@
 /** Length of DTLS master_secret */
 #define DTLS_MASTER_SECRET_LENGTH 48
 #define DTLS_RANDOM_LENGTH 32
+/** Length of the session ids that are generated for resumption */
+#define DTLS_SESSION_ID_LENGTH 32
 
 typedef enum { AES128=0 
 } dtls_crypto_alg;
@@ -119,6 +121,9 @@ typedef struct {
   dtls_compression_t compression;		/**< compression method */
   dtls_cipher_t cipher;		/**< cipher type */
   unsigned int do_client_auth:1;
+  unsigned int resumed:1;	/**< abbreviated handshake */
+  uint8_t session_id_length;
+  uint8_t session_id[DTLS_SESSION_ID_LENGTH]; /**< offered or assigned session id */
   union {
 #ifdef DTLS_ECC
     dtls_handshake_parameters_ecdsa_t ecdsa;
@@ -26,6 +26,11 @@
 #include "dtls-log-default.h"
 #endif /* DTLS_LOG_CONF_PATH */
 
+/* Log backends without a queue have nothing to flush */
+#ifndef LOG_SYNC
+#define LOG_SYNC()
+#endif /* LOG_SYNC */
+
 /** Returns a zero-terminated string with the name of this library. */
 const char *dtls_package_name(void);
 
@@ -45,6 +50,7 @@ void dtls_log_dump(const unsigned char *buf, int len);
 /* DTLS address */
 #define LOG_DTLS_ADDR(level, endpoint) do {                 \
     if(level <= (LOG_LEVEL)) {                              \
+      LOG_SYNC();                                           \
       dtls_session_log(endpoint);                           \
     }                                                       \
   } while (0)
@@ -57,6 +63,7 @@ void dtls_log_dump(const unsigned char *buf, int len);
 /* DTLS log data as a hexdump */
 #define LOG_DTLS_DUMP(level, data, len) do {                \
     if(level <= (LOG_LEVEL)) {                              \
+      LOG_SYNC();                                           \
       dtls_log_dump(data, len);                             \
     }                                                       \
   } while (0)
@@ -69,6 +76,7 @@ void dtls_log_dump(const unsigned char *buf, int len);
 /* DTLS log as narrow string of hex digits */
 #define LOG_DTLS_DUMP(level, data, len) do {                \
     if(level <= (LOG_LEVEL)) {                              \
+      LOG_SYNC();                                           \
       dtls_log_dump(data, len);                             \
     }                                                       \
   } while (0)
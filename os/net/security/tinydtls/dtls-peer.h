@@ -93,6 +93,23 @@ static inline void dtls_security_params_switch(dtls_peer_t *peer)
   peer->security_params[0] = security;
 }
 
+/**
+ * Holds what is needed to resume a session with an abbreviated
+ * handshake. A server looks sessions up by their id, a client by the
+ * transport address of the server.
+ */
+typedef struct dtls_cached_session_t {
+  session_t session;	     /**< last known address of the remote peer */
+  dtls_peer_type role;       /**< our role in the session */
+  dtls_tick_t timestamp;     /**< time of the last (re)connect */
+
+  dtls_cipher_t cipher;
+  dtls_compression_t compression;
+  uint8_t session_id_length; /**< 0 if this entry is unused */
+  uint8_t session_id[DTLS_SESSION_ID_LENGTH];
+  uint8_t master_secret[DTLS_MASTER_SECRET_LENGTH];
+} dtls_cached_session_t;
+
 void dtls_peer_init(void);
 
 /**
@@ -31,6 +31,12 @@ void dtls_session_init(session_t *sess);
  */
 int dtls_session_equals(const session_t *a, const session_t *b);
 
+/**
+ * Returns a hash of the transport address of @p a. Sessions that
+ * compare equal with dtls_session_equals() must have the same hash.
+ */
+unsigned int dtls_session_hash(const session_t *a);
+
 /**
  * Get the address information for this session as an opaque (void *)
  */
@@ -52,13 +52,19 @@
 #define dtls_get_sequence_number(H) dtls_uint48_to_ulong((H)->sequence_number)
 #define dtls_get_fragment_length(H) dtls_uint24_to_int((H)->fragment_length)
 
+/* Peers are kept in a hash table indexed by their transport address,
+ * with the peers of a bucket in a singly-linked list. */
+#define PEER_BUCKET(Session) (dtls_session_hash(Session) % DTLS_PEER_HASH_SIZE)
+
 static void
-delete_peer(dtls_peer_t **peers, dtls_peer_t *peer)
+delete_peer(dtls_context_t *ctx, dtls_peer_t *peer)
 {
   struct dtls_peer_t *l, *r;
-  if(peers == NULL || *peers == NULL || peer == NULL) {
+  dtls_peer_t **peers;
+  if(ctx == NULL || peer == NULL) {
     return;
   }
+  peers = &ctx->peers[PEER_BUCKET(&peer->session)];
   r = NULL;
   for(l = *peers; l != NULL; l = l->next) {
     if(l == peer) {
@@ -77,8 +83,10 @@ delete_peer(dtls_peer_t **peers, dtls_peer_t *peer)
 }
 
 static void
-add_peer(dtls_peer_t **peers, dtls_peer_t *peer)
+add_peer(dtls_context_t *ctx, dtls_peer_t *peer)
 {
+  dtls_peer_t **peers = &ctx->peers[PEER_BUCKET(&peer->session)];
+
   peer->next = *peers;
   *peers = peer;
 }
@@ -202,7 +210,7 @@ dtls_peer_t *
 dtls_get_peer(const dtls_context_t *ctx, const session_t *session) {
   dtls_peer_t *p;
   if(ctx && session) {
-    p = ctx->peers;
+    p = ctx->peers[PEER_BUCKET(session)];
     while(p) {
       if (dtls_session_equals(&(p->session), session)) {
         return p;
@@ -221,11 +229,120 @@ dtls_get_peer(const dtls_context_t *ctx, const session_t *session) {
 static int
 dtls_add_peer(dtls_context_t *ctx, dtls_peer_t *peer) {
   if(peer) {
-    add_peer(&ctx->peers, peer);
+    add_peer(ctx, peer);
   }
   return 0;
 }
 
+#if DTLS_SESSION_CACHE_SIZE
+/* The session cache is direct-mapped: a server keeps a session in the
+ * slot selected by its (random) session id, a client in the slot
+ * selected by the address of the server. */
+static dtls_cached_session_t *
+session_cache_slot(dtls_context_t *ctx, dtls_peer_type role,
+		   const session_t *session, const uint8_t *id) {
+  unsigned int i;
+
+  if (role == DTLS_SERVER) {
+    i = dtls_uint16_to_int(id);
+  } else {
+    i = dtls_session_hash(session);
+  }
+  return &ctx->session_cache[i % DTLS_SESSION_CACHE_SIZE];
+}
+#endif /* DTLS_SESSION_CACHE_SIZE */
+
+/**
+ * Returns the cached session that can be resumed in role \p role: by
+ * a server, the session with id \p id; by a client, the session with
+ * the server at \p session. Returns \c NULL if there is none.
+ */
+static dtls_cached_session_t *
+find_cached_session(dtls_context_t *ctx, dtls_peer_type role,
+		    const session_t *session,
+		    const uint8_t *id, size_t id_length) {
+#if DTLS_SESSION_CACHE_SIZE
+  dtls_cached_session_t *cached;
+  dtls_tick_t now;
+
+  /* we only assign ids of this length */
+  if (role == DTLS_SERVER && id_length != DTLS_SESSION_ID_LENGTH) {
+    return NULL;
+  }
+
+  cached = session_cache_slot(ctx, role, session, id);
+  if (!cached->session_id_length || cached->role != role) {
+    return NULL;
+  }
+
+  if (role == DTLS_SERVER
+      ? memcmp(cached->session_id, id, DTLS_SESSION_ID_LENGTH) != 0
+      : !dtls_session_equals(&cached->session, session)) {
+    return NULL;
+  }
+
+  dtls_ticks(&now);
+  if (now - cached->timestamp >
+      (dtls_tick_t)DTLS_SESSION_CACHE_LIFETIME * DTLS_TICKS_PER_SECOND) {
+    dtls_debug("cached session has expired\n");
+    memset(cached, 0, sizeof(dtls_cached_session_t));
+    return NULL;
+  }
+
+  return cached;
+#else /* DTLS_SESSION_CACHE_SIZE */
+  return NULL;
+#endif /* DTLS_SESSION_CACHE_SIZE */
+}
+
+/**
+ * Remembers the session that has just been established with \p peer
+ * for later resumption, unless it has no id.
+ */
+static void
+cache_session(dtls_context_t *ctx, dtls_peer_t *peer) {
+#if DTLS_SESSION_CACHE_SIZE
+  dtls_handshake_parameters_t *handshake = peer->handshake_params;
+  dtls_cached_session_t *cached;
+
+  /* A resumed session keeps its entry and its original lifetime. */
+  if (!handshake->session_id_length || handshake->resumed) {
+    return;
+  }
+
+  cached = session_cache_slot(ctx, peer->role, &peer->session,
+			      handshake->session_id);
+  memcpy(&cached->session, &peer->session, sizeof(session_t));
+  cached->role = peer->role;
+  dtls_ticks(&cached->timestamp);
+  cached->cipher = handshake->cipher;
+  cached->compression = handshake->compression;
+  cached->session_id_length = handshake->session_id_length;
+  memcpy(cached->session_id, handshake->session_id,
+	 handshake->session_id_length);
+  memcpy(cached->master_secret, handshake->tmp.master_secret,
+	 DTLS_MASTER_SECRET_LENGTH);
+#endif /* DTLS_SESSION_CACHE_SIZE */
+}
+
+/**
+ * Invalidates all cached sessions with the peer at \p session, as
+ * required after a fatal alert.
+ */
+static void
+forget_cached_sessions(dtls_context_t *ctx, const session_t *session) {
+#if DTLS_SESSION_CACHE_SIZE
+  int i;
+
+  for (i = 0; i < DTLS_SESSION_CACHE_SIZE; i++) {
+    if (ctx->session_cache[i].session_id_length &&
+	dtls_session_equals(&ctx->session_cache[i].session, session)) {
+      memset(&ctx->session_cache[i], 0, sizeof(dtls_cached_session_t));
+    }
+  }
+#endif /* DTLS_SESSION_CACHE_SIZE */
+}
+
 int
 dtls_write(struct dtls_context_t *ctx, 
 	   session_t *dst, uint8_t *buf, size_t len) {
@@ -622,6 +739,37 @@ static char *dtls_handshake_type_to_name(int type)
   }
 }
 
+/**
+ * Creates the key block of \p security from \p master_secret and the
+ * random values of \p handshake. The master secret is kept in \p
+ * handshake for the Finished messages.
+ */
+static void
+derive_key_block(dtls_handshake_parameters_t *handshake,
+		 dtls_peer_t *peer,
+		 dtls_security_parameters_t *security,
+		 const uint8_t *master_secret,
+		 dtls_peer_type role) {
+  /* create key_block from master_secret
+   * key_block = PRF(master_secret,
+                    "key expansion" + tmp.random.server + tmp.random.client) */
+
+  dtls_prf(master_secret,
+	   DTLS_MASTER_SECRET_LENGTH,
+	   PRF_LABEL(key), PRF_LABEL_SIZE(key),
+	   handshake->tmp.random.server, DTLS_RANDOM_LENGTH,
+	   handshake->tmp.random.client, DTLS_RANDOM_LENGTH,
+	   security->key_block,
+	   dtls_kb_size(security, role));
+
+  memcpy(handshake->tmp.master_secret, master_secret, DTLS_MASTER_SECRET_LENGTH);
+  dtls_debug_keyblock(security, peer);
+
+  security->cipher = handshake->cipher;
+  security->compression = handshake->compression;
+  security->rseq = 0;
+}
+
 /**
  * Calculate the pre master secret and after that calculate the master-secret.
  */
@@ -709,24 +857,30 @@ calculate_key_block(dtls_context_t *ctx,
 
   dtls_debug_dump("master_secret", master_secret, DTLS_MASTER_SECRET_LENGTH);
 
-  /* create key_block from master_secret
-   * key_block = PRF(master_secret,
-                    "key expansion" + tmp.random.server + tmp.random.client) */
+  derive_key_block(handshake, peer, security, master_secret, role);
 
-  dtls_prf(master_secret,
-	   DTLS_MASTER_SECRET_LENGTH,
-	   PRF_LABEL(key), PRF_LABEL_SIZE(key),
-	   handshake->tmp.random.server, DTLS_RANDOM_LENGTH,
-	   handshake->tmp.random.client, DTLS_RANDOM_LENGTH,
-	   security->key_block,
-	   dtls_kb_size(security, role));
+  return 0;
+}
 
-  memcpy(handshake->tmp.master_secret, master_secret, DTLS_MASTER_SECRET_LENGTH);
-  dtls_debug_keyblock(security, peer);
+/**
+ * Calculates the key block for an abbreviated handshake from the
+ * master secret of the session that is resumed.
+ */
+static int
+calculate_resumed_key_block(dtls_peer_t *peer,
+			    const dtls_cached_session_t *cached) {
+  dtls_security_parameters_t *security;
 
-  security->cipher = handshake->cipher;
-  security->compression = handshake->compression;
-  security->rseq = 0;
+  if (!peer || !peer->handshake_params) {
+    return dtls_alert_fatal_create(DTLS_ALERT_INTERNAL_ERROR);
+  }
+  security = dtls_security_params_next(peer);
+  if (!security) {
+    return dtls_alert_fatal_create(DTLS_ALERT_INTERNAL_ERROR);
+  }
+
+  derive_key_block(peer->handshake_params, peer, security,
+		   cached->master_secret, peer->role);
 
   return 0;
 }
@@ -966,8 +1120,16 @@ dtls_update_parameters(dtls_context_t *ctx,
   data += DTLS_RANDOM_LENGTH;
   data_length -= DTLS_RANDOM_LENGTH;
 
+  /* store the session id that the client wants to resume */
+  i = dtls_uint8_to_int(data);
+  if (i > DTLS_SESSION_ID_LENGTH)
+    goto error;
+
   /* Caution: SKIP_VAR_FIELD may jump to error: */
   SKIP_VAR_FIELD(data, data_length);	/* skip session id */
+  config->session_id_length = i;
+  memcpy(config->session_id, data - i, i);
+
   SKIP_VAR_FIELD(data, data_length);	/* skip cookie */
 
   i = dtls_uint16_to_int(data);
@@ -1570,7 +1732,7 @@ static void dtls_destroy_peer(dtls_context_t *ctx, dtls_peer_t *peer, int unlink
   if (peer->state != DTLS_STATE_CLOSED && peer->state != DTLS_STATE_CLOSING)
     dtls_close(ctx, &peer->session);
   if (unlink) {
-    delete_peer(&ctx->peers, peer);
+    delete_peer(ctx, peer);
     dtls_debug_session("removed peer", &peer->session);
   }
   dtls_free_peer(peer);
@@ -1802,7 +1964,7 @@ dtls_send_server_hello(dtls_context_t *ctx, dtls_peer_t *peer)
   /* Ensure that the largest message to create fits in our source
    * buffer. (The size of the destination buffer is checked by the
    * encoding function, so we do not need to guess.) */
-  uint8_t buf[DTLS_SH_LENGTH + 2 + 5 + 5 + 8 + 6];
+  uint8_t buf[DTLS_SH_LENGTH + DTLS_SESSION_ID_LENGTH + 2 + 5 + 5 + 8 + 6];
   uint8_t *p;
   int ecdsa;
   uint8_t extension_size;
@@ -1835,7 +1997,11 @@ dtls_send_server_hello(dtls_context_t *ctx, dtls_peer_t *peer)
   memcpy(p, handshake->tmp.random.server, DTLS_RANDOM_LENGTH);
   p += DTLS_RANDOM_LENGTH;
 
-  *p++ = 0;			/* no session id */
+  /* session id, empty if the session cannot be resumed */
+  dtls_int_to_uint8(p, handshake->session_id_length);
+  p += sizeof(uint8_t);
+  memcpy(p, handshake->session_id, handshake->session_id_length);
+  p += handshake->session_id_length;
 
   if (handshake->cipher != TLS_NULL_WITH_NULL_NULL) {
     /* selected cipher suite */
@@ -2238,6 +2404,48 @@ dtls_send_ccs(dtls_context_t *ctx, dtls_peer_t *peer) {
   return dtls_send(ctx, peer, DTLS_CT_CHANGE_CIPHER_SPEC, buf, 1);
 }
 
+static int dtls_send_finished(dtls_context_t *ctx, dtls_peer_t *peer,
+			      const unsigned char *label, size_t labellen);
+
+/**
+ * Answers a ClientHello that resumes \p cached with the abbreviated
+ * handshake, i.e. ServerHello, ChangeCipherSpec and Finished.
+ */
+static int
+dtls_send_server_hello_resumed(dtls_context_t *ctx, dtls_peer_t *peer,
+			       const dtls_cached_session_t *cached)
+{
+  int res;
+
+  if(!peer || !peer->handshake_params) {
+    return dtls_alert_fatal_create(DTLS_ALERT_INTERNAL_ERROR);
+  }
+
+  peer->handshake_params->resumed = 1;
+
+  res = dtls_send_server_hello(ctx, peer);
+  if (res < 0) {
+    dtls_debug("dtls_server_hello: cannot prepare ServerHello record\n");
+    return res;
+  }
+
+  res = calculate_resumed_key_block(peer, cached);
+  if (res < 0) {
+    return res;
+  }
+
+  res = dtls_send_ccs(ctx, peer);
+  if (res < 0) {
+    dtls_debug("cannot send CCS message\n");
+    return res;
+  }
+
+  /* and switch cipher suite */
+  dtls_security_params_switch(peer);
+
+  return dtls_send_finished(ctx, peer, PRF_LABEL(server), PRF_LABEL_SIZE(server));
+}
+
     
 static int
 dtls_send_client_key_exchange(dtls_context_t *ctx, dtls_peer_t *peer)
@@ -2399,7 +2607,7 @@ dtls_send_finished(dtls_context_t *ctx, dtls_peer_t *peer,
 static int
 dtls_send_client_hello(dtls_context_t *ctx, dtls_peer_t *peer,
                        uint8_t cookie[], size_t cookie_length) {
-  uint8_t buf[DTLS_CH_LENGTH_MAX];
+  uint8_t buf[DTLS_CH_LENGTH_MAX + DTLS_SESSION_ID_LENGTH];
   uint8_t *p = buf;
   uint8_t cipher_size;
   uint8_t extension_size;
@@ -2443,9 +2651,11 @@ dtls_send_client_hello(dtls_context_t *ctx, dtls_peer_t *peer,
   memcpy(p, handshake->tmp.random.client, DTLS_RANDOM_LENGTH);
   p += DTLS_RANDOM_LENGTH;
 
-  /* session id (length 0) */
-  dtls_int_to_uint8(p, 0);
+  /* session id of a cached session to resume, if any */
+  dtls_int_to_uint8(p, handshake->session_id_length);
   p += sizeof(uint8_t);
+  memcpy(p, handshake->session_id, handshake->session_id_length);
+  p += handshake->session_id_length;
 
   /* cookie */
   dtls_int_to_uint8(p, cookie_length);
@@ -2559,6 +2769,10 @@ check_server_hello(dtls_context_t *ctx,
 		      uint8_t *data, size_t data_length)
 {
   dtls_handshake_parameters_t *handshake;
+  dtls_cached_session_t *cached;
+  uint8_t *session_id;
+  uint8_t session_id_length;
+  int err;
 
   /* This function is called when we expect a ServerHello (i.e. we
    * have sent a ClientHello).  We might instead receive a HelloVerify
@@ -2601,6 +2815,12 @@ check_server_hello(dtls_context_t *ctx,
   data += DTLS_RANDOM_LENGTH;
   data_length -= DTLS_RANDOM_LENGTH;
 
+  /* The server either resumes the session we offered or assigns a
+   * new session id, which may be empty. */
+  session_id_length = dtls_uint8_to_int(data);
+  if (session_id_length > DTLS_SESSION_ID_LENGTH)
+    goto error;
+  session_id = data + sizeof(uint8_t);
   SKIP_VAR_FIELD(data, data_length); /* skip session id */
     
   /* Check cipher suite. As we offer all we have, it is sufficient
@@ -2623,7 +2843,28 @@ check_server_hello(dtls_context_t *ctx,
   data += sizeof(uint8_t);
   data_length -= sizeof(uint8_t);
 
-  return dtls_check_tls_extension(peer, data, data_length, 0);
+  if (handshake->session_id_length &&
+      session_id_length == handshake->session_id_length &&
+      memcmp(session_id, handshake->session_id, session_id_length) == 0) {
+    cached = find_cached_session(ctx, DTLS_CLIENT, &peer->session, NULL, 0);
+    if (!cached || cached->cipher != handshake->cipher) {
+      dtls_alert("server resumed a session we do not have\n");
+      return dtls_alert_fatal_create(DTLS_ALERT_ILLEGAL_PARAMETER);
+    }
+  } else {
+    cached = NULL;
+    handshake->session_id_length = session_id_length;
+    memcpy(handshake->session_id, session_id, session_id_length);
+  }
+
+  err = dtls_check_tls_extension(peer, data, data_length, 0);
+  if (err < 0 || !cached) {
+    return err;
+  }
+
+  dtls_debug("resuming cached session\n");
+  handshake->resumed = 1;
+  return calculate_resumed_key_block(peer, cached);
 
 error:
   return dtls_alert_fatal_create(DTLS_ALERT_DECODE_ERROR);
@@ -3121,6 +3362,7 @@ handle_handshake_msg(dtls_context_t *ctx, dtls_peer_t *peer, session_t *session,
 		 uint8_t *data, size_t data_length) {
 
   int err = 0;
+  dtls_cached_session_t *cached;
 
   /* This will clear the retransmission buffer if we get an expected
    * handshake message. We have to make sure that no handshake message
@@ -3170,7 +3412,9 @@ handle_handshake_msg(dtls_context_t *ctx, dtls_peer_t *peer, session_t *session,
       dtls_warn("error in check_server_hello err: %i\n", err);
       return err;
     }
-    if (is_tls_ecdhe_ecdsa_with_aes_128_ccm_8(peer->handshake_params->cipher))
+    if (peer->handshake_params->resumed)
+      peer->state = DTLS_STATE_WAIT_CHANGECIPHERSPEC;
+    else if (is_tls_ecdhe_ecdsa_with_aes_128_ccm_8(peer->handshake_params->cipher))
       peer->state = DTLS_STATE_WAIT_SERVERCERTIFICATE;
     else
       peer->state = DTLS_STATE_WAIT_SERVERHELLODONE;
@@ -3287,8 +3531,9 @@ handle_handshake_msg(dtls_context_t *ctx, dtls_peer_t *peer, session_t *session,
       dtls_warn("error in check_finished err: %i\n", err);
       return err;
     }
-    if (role == DTLS_SERVER) {
-      /* send ServerFinished */
+    /* The first Finished is answered with our own: by the server in
+     * a full handshake, by the client in an abbreviated one. */
+    if ((role == DTLS_SERVER) != peer->handshake_params->resumed) {
       update_hs_hash(peer, data, data_length);
 
       /* send change cipher spec message and switch to new configuration */
@@ -3300,12 +3545,17 @@ handle_handshake_msg(dtls_context_t *ctx, dtls_peer_t *peer, session_t *session,
 
       dtls_security_params_switch(peer);
 
-      err = dtls_send_finished(ctx, peer, PRF_LABEL(server), PRF_LABEL_SIZE(server));
+      if (role == DTLS_SERVER) {
+        err = dtls_send_finished(ctx, peer, PRF_LABEL(server), PRF_LABEL_SIZE(server));
+      } else {
+        err = dtls_send_finished(ctx, peer, PRF_LABEL(client), PRF_LABEL_SIZE(client));
+      }
       if (err < 0) {
-        dtls_warn("sending server Finished failed\n");
+        dtls_warn("sending Finished failed\n");
         return err;
       }
     }
+    cache_session(ctx, peer);
     dtls_handshake_free(peer->handshake_params);
     peer->handshake_params = NULL;
     dtls_debug("Handshake complete\n");
@@ -3400,7 +3650,7 @@ handle_handshake_msg(dtls_context_t *ctx, dtls_peer_t *peer, session_t *session,
       * the cookie exchange */
     if (peer && state == DTLS_STATE_WAIT_CLIENTHELLO) {
        dtls_debug("removing the peer\n");
-       delete_peer(&ctx->peers, peer);
+       delete_peer(ctx, peer);
 
        dtls_free_peer(peer);
        peer = NULL;
@@ -3459,6 +3709,29 @@ handle_handshake_msg(dtls_context_t *ctx, dtls_peer_t *peer, session_t *session,
     /* update finish MAC */
     update_hs_hash(peer, data, data_length);
 
+    cached = find_cached_session(ctx, DTLS_SERVER, session,
+				 peer->handshake_params->session_id,
+				 peer->handshake_params->session_id_length);
+    if (cached && cached->cipher == peer->handshake_params->cipher &&
+	cached->compression == peer->handshake_params->compression) {
+      dtls_debug("resuming cached session\n");
+      err = dtls_send_server_hello_resumed(ctx, peer, cached);
+      if (err < 0) {
+        return err;
+      }
+      peer->state = DTLS_STATE_WAIT_CHANGECIPHERSPEC;
+      break;
+    }
+
+    /* Assign a new session id for later resumption. */
+    peer->handshake_params->session_id_length = 0;
+#if DTLS_SESSION_CACHE_SIZE
+    if (dtls_fill_random(peer->handshake_params->session_id,
+			 DTLS_SESSION_ID_LENGTH)) {
+      peer->handshake_params->session_id_length = DTLS_SESSION_ID_LENGTH;
+    }
+#endif /* DTLS_SESSION_CACHE_SIZE */
+
     err = dtls_send_server_hello_msgs(ctx, peer);
     if (err < 0) {
       return err;
@@ -3647,8 +3920,10 @@ handle_ccs(dtls_context_t *ctx, dtls_peer_t *peer,
   if (data_length < 1 || data[0] != 1)
     return dtls_alert_fatal_create(DTLS_ALERT_DECODE_ERROR);
 
-  /* Just change the cipher when we are on the same epoch */
-  if (peer->role == DTLS_SERVER) {
+  /* Just change the cipher when we are on the same epoch. In an
+   * abbreviated handshake, the server has done so already. */
+  if (peer->role == DTLS_SERVER &&
+      !(peer->handshake_params && peer->handshake_params->resumed)) {
     err = calculate_key_block(ctx, peer->handshake_params, peer,
 			      &peer->session, peer->role);
     if (err < 0) {
@@ -3689,7 +3964,11 @@ handle_alert(dtls_context_t *ctx, dtls_peer_t *peer,
   if (data[0] == DTLS_ALERT_LEVEL_FATAL || data[1] == DTLS_ALERT_CLOSE_NOTIFY) {
     dtls_alert("%d invalidate peer\n", data[1]);
 
-    delete_peer(&ctx->peers, peer);
+    if (data[0] == DTLS_ALERT_LEVEL_FATAL && data[1] != DTLS_ALERT_CLOSE_NOTIFY) {
+      forget_cached_sessions(ctx, &peer->session);
+    }
+
+    delete_peer(ctx, peer);
 
     dtls_debug_session("removed peer", &peer->session);
 
@@ -3862,10 +4141,12 @@ dtls_handle_message(dtls_context_t *ctx,
 
 	/* The new security parameters must be used for all messages
 	 * that are sent after the ChangeCipherSpec message. This
-	 * means that the client's Finished message uses epoch + 1
-	 * while the server is still in the old epoch.
+	 * means that the first Finished message uses epoch + 1 while
+	 * its receiver is still in the old epoch: the server in a full
+	 * handshake, the client in an abbreviated one.
 	 */
-	if (role == DTLS_SERVER && state == DTLS_STATE_WAIT_FINISHED) {
+	if (state == DTLS_STATE_WAIT_FINISHED && peer->security_params[1] &&
+	    peer->security_params[1]->epoch > expected_epoch) {
 	  expected_epoch++;
 	}
 
@@ -3954,14 +4235,14 @@ void dtls_reset_peer(dtls_context_t *ctx, dtls_peer_t *peer)
 void
 dtls_free_context(dtls_context_t *ctx) {
   dtls_peer_t *p, *tmp;
+  unsigned int i;
 
   if (!ctx) {
     return;
   }
 
-  if (ctx->peers) {
-    //      LL_FOREACH_SAFE(ctx->peers, p, tmp) {
-    p = ctx->peers;
+  for (i = 0; i < DTLS_PEER_HASH_SIZE; i++) {
+    p = ctx->peers[i];
     while(p) {
       tmp = p->next;
       dtls_destroy_peer(ctx, p, 1);
@@ -3974,6 +4255,7 @@ dtls_free_context(dtls_context_t *ctx) {
 
 int
 dtls_connect_peer(dtls_context_t *ctx, dtls_peer_t *peer) {
+  dtls_cached_session_t *cached;
   int res;
 
   assert(peer);
@@ -4001,6 +4283,15 @@ dtls_connect_peer(dtls_context_t *ctx, dtls_peer_t *peer) {
 
   peer->handshake_params->hs_state.mseq_r = 0;
   peer->handshake_params->hs_state.mseq_s = 0;
+
+  /* offer to resume the last session with this server */
+  cached = find_cached_session(ctx, DTLS_CLIENT, &peer->session, NULL, 0);
+  if (cached) {
+    peer->handshake_params->session_id_length = cached->session_id_length;
+    memcpy(peer->handshake_params->session_id, cached->session_id,
+	   cached->session_id_length);
+  }
+
   res = dtls_send_client_hello(ctx, peer, NULL, 0);
   if (res < 0)
     dtls_warn("cannot send ClientHello\n");
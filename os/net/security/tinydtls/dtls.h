@@ -211,7 +211,11 @@ typedef struct dtls_context_t {
   unsigned char cookie_secret[DTLS_COOKIE_SECRET_LENGTH];
   dtls_tick_t cookie_secret_age; /**< the time the secret has been generated */
 
-  dtls_peer_t *peers;		/**< peer hash map */
+  dtls_peer_t *peers[DTLS_PEER_HASH_SIZE]; /**< peer hash map */
+
+#if DTLS_SESSION_CACHE_SIZE
+  dtls_cached_session_t session_cache[DTLS_SESSION_CACHE_SIZE]; /**< for resumption */
+#endif /* DTLS_SESSION_CACHE_SIZE */
 
 #ifdef DTLS_SUPPORT_CONF_CONTEXT_STATE
   DTLS_SUPPORT_CONF_CONTEXT_STATE support;
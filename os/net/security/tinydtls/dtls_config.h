@@ -142,6 +142,36 @@
 #define DTLS_HASH_MAX (3 * DTLS_PEER_MAX)
 #endif
 
+#ifndef DTLS_PEER_HASH_SIZE
+/** The number of buckets in the peer table of a context. On Contiki
+    it is the smallest power of two of at least DTLS_PEER_MAX / 4, so
+    that a bucket holds about four peers. */
+#ifdef CONTIKI
+#define DTLS_PEER_BUCKETS_(n) ((n) <= 1 ? 1 : (n) <= 2 ? 2 : (n) <= 4 ? 4 : \
+                               (n) <= 8 ? 8 : (n) <= 16 ? 16 : \
+                               (n) <= 32 ? 32 : (n) <= 64 ? 64 : \
+                               (n) <= 128 ? 128 : 256)
+#define DTLS_PEER_HASH_SIZE DTLS_PEER_BUCKETS_(DTLS_PEER_MAX / 4)
+#else /* CONTIKI */
+#define DTLS_PEER_HASH_SIZE 256
+#endif /* CONTIKI */
+#endif
+
+#ifndef DTLS_SESSION_CACHE_SIZE
+/** The number of sessions that are remembered for resumption. Set
+    to 0 to always perform a full handshake. */
+#ifdef CONTIKI
+#define DTLS_SESSION_CACHE_SIZE DTLS_PEER_MAX
+#else /* CONTIKI */
+#define DTLS_SESSION_CACHE_SIZE 256
+#endif /* CONTIKI */
+#endif
+
+#ifndef DTLS_SESSION_CACHE_LIFETIME
+/** The number of seconds a cached session can be resumed. */
+#define DTLS_SESSION_CACHE_LIFETIME (24 * 60 * 60)
+#endif
+
 /** Defined to 1 if tinydtls is built with support for ECC */
 #define DTLS_ECC 1
 
@@ -133,7 +133,8 @@ static int isGreater(const uint32_t *A, const uint32_t *B, uint8_t length){
 	return 0;
 }
 
-
+#ifdef TEST_INCLUDE
+//only the tests use this now, the point arithmetic uses fieldAddModP
 static int fieldAdd(const uint32_t *x, const uint32_t *y, const uint32_t *reducer, uint32_t *result){
 	if(add(x, y, result, arrayLength)){ //add prime if carry is still set!
 		uint32_t tempas[8];
@@ -143,6 +144,7 @@ static int fieldAdd(const uint32_t *x, const uint32_t *y, const uint32_t *reduce
 	}
 	return 0;
 }
+#endif /* TEST_INCLUDE */
 
 static int fieldSub(const uint32_t *x, const uint32_t *y, const uint32_t *modulus, uint32_t *result){
 	if(sub(x, y, result, arrayLength)){ //add modulus if carry is set
@@ -154,101 +156,156 @@ static int fieldSub(const uint32_t *x, const uint32_t *y, const uint32_t *modulu
 	return 0;
 }
 
+#if ECC_WITH_64BIT_LIMBS
+//multiplication of two 256 bit numbers
+//64bit * 64bit = 128bit
+static void fieldMult64(const uint32_t *x, const uint32_t *y, uint32_t *result){
+	uint64_t a[4], b[4], r[8];
+	unsigned __int128 l;
+	uint64_t carry;
+	uint8_t k, n;
+	for (n = 0; n < 4; n++){
+		a[n] = (uint64_t)x[2 * n + 1] << 32 | x[2 * n];
+		b[n] = (uint64_t)y[2 * n + 1] << 32 | y[2 * n];
+		r[n] = 0;
+	}
+	for (k = 0; k < 4; k++){
+		carry = 0;
+		for (n = 0; n < 4; n++){
+			l = (unsigned __int128)a[n] * b[k] + r[n + k] + carry;
+			r[n + k] = (uint64_t)l;
+			carry = l >> 64;
+		}
+		r[k + 4] = carry;
+	}
+	for (n = 0; n < 8; n++){
+		result[2 * n] = (uint32_t)r[n];
+		result[2 * n + 1] = r[n] >> 32;
+	}
+}
+#endif /* ECC_WITH_64BIT_LIMBS */
+
 //finite Field multiplication
 //32bit * 32bit = 64bit
+//result must not overlap x or y
 static int fieldMult(const uint32_t *x, const uint32_t *y, uint32_t *result, uint8_t length){
-	uint32_t temp[length * 2];
-	setZero(temp, length * 2);
-	setZero(result, length * 2);
 	uint8_t k, n;
 	uint64_t l;
+	uint32_t carry;
+#if ECC_WITH_64BIT_LIMBS
+	if (length == arrayLength){
+		fieldMult64(x, y, result);
+		return 0;
+	}
+#endif /* ECC_WITH_64BIT_LIMBS */
+	setZero(result, length * 2);
 	for (k = 0; k < length; k++){
+		carry = 0;
 		for (n = 0; n < length; n++){ 
-			l = (uint64_t)x[n]*(uint64_t)y[k];
-			temp[n+k] = l&0xFFFFFFFF;
-			temp[n+k+1] = l>>32;
-			add(&temp[n+k], &result[n+k], &result[n+k], (length * 2) - (n + k));
-
-			setZero(temp, length * 2);
+			l = (uint64_t)x[n]*(uint64_t)y[k] + result[n+k] + carry;
+			result[n+k] = l&0xFFFFFFFF;
+			carry = l>>32;
 		}
+		result[k+length] = carry;
 	}
 	return 0;
 }
 
-//TODO: maximum:
-//fffffffe00000002fffffffe0000000100000001fffffffe00000001fffffffe00000001fffffffefffffffffffffffffffffffe000000000000000000000001_16
+/*
+ * Addition and subtraction modulo p for x, y < p. Unlike fieldAdd and
+ * fieldSub, the result is always fully reduced.
+ */
+static void fieldAddModP(const uint32_t *x, const uint32_t *y, uint32_t *result){
+	if(add(x, y, result, arrayLength) || isGreater(result, ecc_prime_m, arrayLength) >= 0)
+		sub(result, ecc_prime_m, result, arrayLength);
+}
+
+static void fieldSubModP(const uint32_t *x, const uint32_t *y, uint32_t *result){
+	if(sub(x, y, result, arrayLength))
+		add(result, ecc_prime_m, result, arrayLength);
+}
+
+//reduces any 256 bit number below p
+static void reduceP(uint32_t *A){
+	if(isGreater(A, ecc_prime_m, arrayLength) >= 0)
+		sub(A, ecc_prime_m, A, arrayLength);
+}
+
+/*
+ * Fast reduction modulo p of a 512 bit number B, see FIPS 186-4 D.2.3.
+ * Every term is reduced below p before it is added, so this works for
+ * any input, not only for products of numbers below p.
+ */
 static void fieldModP(uint32_t *A, const uint32_t *B)
 {
 	uint32_t tempm[8];
-	uint32_t tempm2[8];
 	uint8_t n;
-	setZero(tempm, 8);
-	setZero(tempm2, 8);
 	/* A = T */ 
 	copy(B,A,arrayLength);
+	reduceP(A);
 
 	/* Form S1 */ 
 	for(n=0;n<3;n++) tempm[n]=0; 
 	for(n=3;n<8;n++) tempm[n]=B[n+8];
-
-	/* tempm2=T+S1 */ 
-	fieldAdd(A,tempm,ecc_prime_r,tempm2);
+	reduceP(tempm);
 	/* A=T+S1+S1 */ 
-	fieldAdd(tempm2,tempm,ecc_prime_r,A);
+	fieldAddModP(A,tempm,A);
+	fieldAddModP(A,tempm,A);
 	/* Form S2 */ 
 	for(n=0;n<3;n++) tempm[n]=0; 
 	for(n=3;n<7;n++) tempm[n]=B[n+9]; 
 	for(n=7;n<8;n++) tempm[n]=0;
-	/* tempm2=T+S1+S1+S2 */ 
-	fieldAdd(A,tempm,ecc_prime_r,tempm2);
 	/* A=T+S1+S1+S2+S2 */ 
-	fieldAdd(tempm2,tempm,ecc_prime_r,A);
+	fieldAddModP(A,tempm,A);
+	fieldAddModP(A,tempm,A);
 	/* Form S3 */ 
 	for(n=0;n<3;n++) tempm[n]=B[n+8]; 
 	for(n=3;n<6;n++) tempm[n]=0; 
 	for(n=6;n<8;n++) tempm[n]=B[n+8];
-	/* tempm2=T+S1+S1+S2+S2+S3 */ 
-	fieldAdd(A,tempm,ecc_prime_r,tempm2);
+	reduceP(tempm);
+	/* A=T+S1+S1+S2+S2+S3 */ 
+	fieldAddModP(A,tempm,A);
 	/* Form S4 */ 
 	for(n=0;n<3;n++) tempm[n]=B[n+9]; 
 	for(n=3;n<6;n++) tempm[n]=B[n+10]; 
 	for(n=6;n<7;n++) tempm[n]=B[n+7]; 
 	for(n=7;n<8;n++) tempm[n]=B[n+1];
+	reduceP(tempm);
 	/* A=T+S1+S1+S2+S2+S3+S4 */ 
-	fieldAdd(tempm2,tempm,ecc_prime_r,A);
+	fieldAddModP(A,tempm,A);
 	/* Form D1 */ 
 	for(n=0;n<3;n++) tempm[n]=B[n+11]; 
 	for(n=3;n<6;n++) tempm[n]=0; 
 	for(n=6;n<7;n++) tempm[n]=B[n+2]; 
 	for(n=7;n<8;n++) tempm[n]=B[n+3];
-	/* tempm2=T+S1+S1+S2+S2+S3+S4-D1 */ 
-	fieldSub(A,tempm,ecc_prime_m,tempm2);
+	reduceP(tempm);
+	/* A=T+S1+S1+S2+S2+S3+S4-D1 */ 
+	fieldSubModP(A,tempm,A);
 	/* Form D2 */ 
 	for(n=0;n<4;n++) tempm[n]=B[n+12]; 
 	for(n=4;n<6;n++) tempm[n]=0; 
 	for(n=6;n<7;n++) tempm[n]=B[n+3]; 
 	for(n=7;n<8;n++) tempm[n]=B[n+4];
+	reduceP(tempm);
 	/* A=T+S1+S1+S2+S2+S3+S4-D1-D2 */ 
-	fieldSub(tempm2,tempm,ecc_prime_m,A);
+	fieldSubModP(A,tempm,A);
 	/* Form D3 */ 
 	for(n=0;n<3;n++) tempm[n]=B[n+13]; 
 	for(n=3;n<6;n++) tempm[n]=B[n+5]; 
 	for(n=6;n<7;n++) tempm[n]=0; 
 	for(n=7;n<8;n++) tempm[n]=B[n+5];
-	/* tempm2=T+S1+S1+S2+S2+S3+S4-D1-D2-D3 */ 
-	fieldSub(A,tempm,ecc_prime_m,tempm2);
+	reduceP(tempm);
+	/* A=T+S1+S1+S2+S2+S3+S4-D1-D2-D3 */ 
+	fieldSubModP(A,tempm,A);
 	/* Form D4 */ 
 	for(n=0;n<2;n++) tempm[n]=B[n+14]; 
 	for(n=2;n<3;n++) tempm[n]=0; 
 	for(n=3;n<6;n++) tempm[n]=B[n+6]; 
 	for(n=6;n<7;n++) tempm[n]=0; 
 	for(n=7;n<8;n++) tempm[n]=B[n+6];
+	reduceP(tempm);
 	/* A=T+S1+S1+S2+S2+S3+S4-D1-D2-D3-D4 */ 
-	fieldSub(tempm2,tempm,ecc_prime_m,A);
-	if(isGreater(A, ecc_prime_m, arrayLength) >= 0){
-		fieldSub(A, ecc_prime_m, ecc_prime_m, tempm);
-		copy(tempm, A, arrayLength);
-	}
+	fieldSubModP(A,tempm,A);
 }
 
 /**
@@ -408,108 +465,331 @@ static void fieldInv(const uint32_t *A, const uint32_t *modulus, const uint32_t
 	}
 }
 
-void static ec_double(const uint32_t *px, const uint32_t *py, uint32_t *Dx, uint32_t *Dy){
+/*
+ * Points in Jacobian coordinates: (x, y, z) stands for the affine point
+ * (x / z^2, y / z^3), z = 0 for the point at infinity. Additions and
+ * doublings then need no field inversion; only the conversion back to
+ * affine coordinates at the end of a multiplication does.
+ * All coordinates are kept fully reduced modulo p.
+ */
+typedef struct {
+	uint32_t x[8];
+	uint32_t y[8];
+	uint32_t z[8];
+} ec_point_t;
+
+static void fieldMultModP(const uint32_t *x, const uint32_t *y, uint32_t *result){
+	uint32_t temp[16];
+	fieldMult(x, y, temp, arrayLength);
+	fieldModP(result, temp);
+}
+
+//affine point, (0, 0) for the point at infinity
+static void ec_from_affine(const uint32_t *px, const uint32_t *py, ec_point_t *P){
+	copy(px, P->x, arrayLength);
+	copy(py, P->y, arrayLength);
+	reduceP(P->x);
+	reduceP(P->y);
+	setZero(P->z, 8);
+	if(!isZero(px) || !isZero(py))
+		P->z[0] = 1;
+}
+
+static void ec_to_affine(const ec_point_t *P, uint32_t *resultx, uint32_t *resulty){
+	uint32_t zinv[8];
+	uint32_t temp[8];
+
+	if(isZero(P->z)){
+		setZero(resultx, 8);
+		setZero(resulty, 8);
+		return;
+	}
+
+	fieldInv(P->z, ecc_prime_m, ecc_prime_r, zinv);
+	fieldMultModP(zinv, zinv, temp); //temp = 1/z^2
+	fieldMultModP(P->x, temp, resultx);
+	fieldMultModP(temp, zinv, temp); //temp = 1/z^3
+	fieldMultModP(P->y, temp, resulty);
+}
+
+/*
+ * R = 2 * P, R may be P.
+ * This is dbl-2001-b for curves with a = -3.
+ */
+static void ec_double_jacobian(const ec_point_t *P, ec_point_t *R){
+	uint32_t delta[8];
+	uint32_t gamma[8];
+	uint32_t beta[8];
+	uint32_t alpha[8];
 	uint32_t tempA[8];
 	uint32_t tempB[8];
-	uint32_t tempC[8];
-	uint32_t tempD[16];
 
-	if(isZero(px) && isZero(py)){
-		copy(px, Dx,arrayLength);
-		copy(py, Dy,arrayLength);
+	if(isZero(P->z)){
+		*R = *P;
 		return;
 	}
 
-	fieldMult(px, px, tempD, arrayLength);
-	fieldModP(tempA, tempD);
-	setZero(tempB, 8);
-	tempB[0] = 0x00000001;
-	fieldSub(tempA, tempB, ecc_prime_m, tempC); //tempC = (qx^2-1)
-	tempB[0] = 0x00000003;
-	fieldMult(tempC, tempB, tempD, arrayLength);
-	fieldModP(tempA, tempD);//tempA = 3*(qx^2-1)
-	fieldAdd(py, py, ecc_prime_r, tempB); //tempB = 2*qy
-	fieldInv(tempB, ecc_prime_m, ecc_prime_r, tempC); //tempC = 1/(2*qy)
-	fieldMult(tempA, tempC, tempD, arrayLength); //tempB = lambda = (3*(qx^2-1))/(2*qy)
-	fieldModP(tempB, tempD);
-
-	fieldMult(tempB, tempB, tempD, arrayLength); //tempC = lambda^2
-	fieldModP(tempC, tempD);
-	fieldSub(tempC, px, ecc_prime_m, tempA); //lambda^2 - Px
-	fieldSub(tempA, px, ecc_prime_m, Dx); //lambda^2 - Px - Qx
-
-	fieldSub(px, Dx, ecc_prime_m, tempA); //tempA = qx-dx
-	fieldMult(tempB, tempA, tempD, arrayLength); //tempC = lambda * (qx-dx)
-	fieldModP(tempC, tempD);
-	fieldSub(tempC, py, ecc_prime_m, Dy); //Dy = lambda * (qx-dx) - px
-}
-
-void static ec_add(const uint32_t *px, const uint32_t *py, const uint32_t *qx, const uint32_t *qy, uint32_t *Sx, uint32_t *Sy){
-	uint32_t tempA[8];
-	uint32_t tempB[8];
-	uint32_t tempC[8];
-	uint32_t tempD[16];
+	fieldMultModP(P->z, P->z, delta); //delta = z^2
+	fieldMultModP(P->y, P->y, gamma); //gamma = y^2
+	fieldMultModP(P->x, gamma, beta); //beta = x * gamma
+	fieldSubModP(P->x, delta, tempA);
+	fieldAddModP(P->x, delta, tempB);
+	fieldMultModP(tempA, tempB, alpha);
+	fieldAddModP(alpha, alpha, tempA);
+	fieldAddModP(tempA, alpha, alpha); //alpha = 3 * (x - delta) * (x + delta)
+
+	fieldAddModP(P->y, P->z, tempA);
+	fieldMultModP(tempA, tempA, tempB);
+	fieldSubModP(tempB, gamma, tempB);
+	fieldSubModP(tempB, delta, R->z); //Rz = (y + z)^2 - gamma - delta
+
+	fieldAddModP(beta, beta, beta);
+	fieldAddModP(beta, beta, beta); //beta = 4 * beta
+	fieldAddModP(beta, beta, tempA);
+	fieldMultModP(alpha, alpha, tempB);
+	fieldSubModP(tempB, tempA, R->x); //Rx = alpha^2 - 8 * beta
+
+	fieldSubModP(beta, R->x, tempA);
+	fieldMultModP(alpha, tempA, tempB);
+	fieldMultModP(gamma, gamma, tempA);
+	fieldAddModP(tempA, tempA, tempA);
+	fieldAddModP(tempA, tempA, tempA);
+	fieldAddModP(tempA, tempA, tempA);
+	fieldSubModP(tempB, tempA, R->y); //Ry = alpha * (4 * beta - Rx) - 8 * gamma^2
+}
 
-	if(isZero(px) && isZero(py)){
-		copy(qx, Sx,arrayLength);
-		copy(qy, Sy,arrayLength);
+/*
+ * R = P + Q, R may be P or Q.
+ * This is add-1998-cmo-2, which gets cheaper if Q is affine (Qz = 1).
+ */
+static void ec_add_jacobian(const ec_point_t *P, const ec_point_t *Q, ec_point_t *R){
+	uint32_t u1[8];
+	uint32_t u2[8];
+	uint32_t s1[8];
+	uint32_t s2[8];
+	uint32_t h[8];
+	uint32_t r[8];
+	uint32_t temp[8];
+
+	if(isZero(P->z)){
+		*R = *Q;
 		return;
-	} else if(isZero(qx) && isZero(qy)) {
-		copy(px, Sx,arrayLength);
-		copy(py, Sy,arrayLength);
+	} else if(isZero(Q->z)) {
+		*R = *P;
 		return;
 	}
 
-	if(isSame(px, qx, arrayLength)){
-		if(!isSame(py, qy, arrayLength)){
-			setZero(Sx, 8);
-			setZero(Sy, 8);
-			return;
+	if(isOne(Q->z)){
+		copy(P->x, u1, arrayLength);
+		copy(P->y, s1, arrayLength);
+	} else {
+		fieldMultModP(Q->z, Q->z, temp);
+		fieldMultModP(P->x, temp, u1); //u1 = Px * Qz^2
+		fieldMultModP(temp, Q->z, temp);
+		fieldMultModP(P->y, temp, s1); //s1 = Py * Qz^3
+	}
+	fieldMultModP(P->z, P->z, temp);
+	fieldMultModP(Q->x, temp, u2); //u2 = Qx * Pz^2
+	fieldMultModP(temp, P->z, temp);
+	fieldMultModP(Q->y, temp, s2); //s2 = Qy * Pz^3
+
+	fieldSubModP(u2, u1, h);
+	fieldSubModP(s2, s1, r);
+	if(isZero(h)){
+		if(isZero(r)){
+			ec_double_jacobian(P, R);
 		} else {
-			ec_double(px, py, Sx, Sy);
-			return;
+			setZero(R->z, 8);
 		}
+		return;
 	}
 
-	fieldSub(py, qy, ecc_prime_m, tempA);
-	fieldSub(px, qx, ecc_prime_m, tempB);
-	fieldInv(tempB, ecc_prime_m, ecc_prime_r, tempB);
-	fieldMult(tempA, tempB, tempD, arrayLength); 
-	fieldModP(tempC, tempD); //tempC = lambda
+	if(isOne(Q->z)){
+		fieldMultModP(P->z, h, R->z);
+	} else {
+		fieldMultModP(P->z, Q->z, temp);
+		fieldMultModP(temp, h, R->z); //Rz = Pz * Qz * h
+	}
+
+	fieldMultModP(h, h, temp);
+	fieldMultModP(u1, temp, u1); //u1 = u1 * h^2
+	fieldMultModP(h, temp, h); //h = h^3
+
+	fieldMultModP(r, r, temp);
+	fieldSubModP(temp, h, temp);
+	fieldSubModP(temp, u1, temp);
+	fieldSubModP(temp, u1, R->x); //Rx = r^2 - h^3 - 2 * u1 * h^2
+
+	fieldSubModP(u1, R->x, temp);
+	fieldMultModP(r, temp, temp);
+	fieldMultModP(s1, h, s1);
+	fieldSubModP(temp, s1, R->y); //Ry = r * (u1 * h^2 - Rx) - s1 * h^3
+}
+
+/*
+ * Recodes the 256 bit number k in width-w NAF: every digit is zero or
+ * odd and below 2^(w-1) in magnitude, and any w consecutive digits hold
+ * at most one that is not zero. Returns the number of digits, at most
+ * 257.
+ */
+static int wnaf(const uint32_t *k, int8_t *naf){
+	static const uint32_t carry[9] = { 1 << ECC_WNAF_WIDTH };
+	uint32_t d[9];
+	int i, n, digit;
+
+	copy(k, d, arrayLength);
+	d[8] = 0;
+	for (i = 0; !isZero(d) || d[8]; i++){
+		digit = 0;
+		if (d[0] & 1){
+			digit = d[0] & ((1 << ECC_WNAF_WIDTH) - 1);
+			d[0] &= ~((1 << ECC_WNAF_WIDTH) - 1);
+			if (digit >= 1 << (ECC_WNAF_WIDTH - 1)){
+				digit -= 1 << ECC_WNAF_WIDTH;
+				add(d, carry, d, 9);
+			}
+		}
+		naf[i] = digit;
+		for (n = 0; n < 8; n++)
+			d[n] = d[n] >> 1 | d[n + 1] << 31;
+		d[8] >>= 1;
+	}
+	return i;
+}
 
-	fieldMult(tempC, tempC, tempD, arrayLength); //tempA = lambda^2
-	fieldModP(tempA, tempD);
-	fieldSub(tempA, px, ecc_prime_m, tempB); //lambda^2 - Px
-	fieldSub(tempB, qx, ecc_prime_m, Sx); //lambda^2 - Px - Qx
+static void ec_mult_jacobian(const uint32_t *px, const uint32_t *py, const uint32_t *secret, ec_point_t *Q){
+	ec_point_t table[1 << (ECC_WNAF_WIDTH - 2)];
+	ec_point_t temp;
+	int8_t naf[257];
+	int i;
 
-	fieldSub(qx, Sx, ecc_prime_m, tempB);
-	fieldMult(tempC, tempB, tempD, arrayLength);
-	fieldModP(tempC, tempD);
-	fieldSub(tempC, qy, ecc_prime_m, Sy);
+	//table[i] = (2 * i + 1) * P
+	ec_from_affine(px, py, &table[0]);
+	ec_double_jacobian(&table[0], &temp);
+	for (i = 1; i < 1 << (ECC_WNAF_WIDTH - 2); i++)
+		ec_add_jacobian(&table[i - 1], &temp, &table[i]);
+
+	setZero(Q->z, 8);
+	for (i = wnaf(secret, naf); i--;){
+		ec_double_jacobian(Q, Q);
+		if (naf[i] > 0){
+			ec_add_jacobian(Q, &table[naf[i] / 2], Q);
+		} else if (naf[i] < 0){
+			temp = table[-naf[i] / 2];
+			if (!isZero(temp.y))
+				sub(ecc_prime_m, temp.y, temp.y, arrayLength); //-P = (x, p - y, z)
+			ec_add_jacobian(Q, &temp, Q);
+		}
+	}
 }
 
 void ecc_ec_mult(const uint32_t *px, const uint32_t *py, const uint32_t *secret, uint32_t *resultx, uint32_t *resulty){
-	uint32_t Qx[8];
-	uint32_t Qy[8];
-	setZero(Qx, 8);
-	setZero(Qy, 8);
+	ec_point_t Q;
 
-	uint32_t tempx[8];
-	uint32_t tempy[8];
+	ec_mult_jacobian(px, py, secret, &Q);
+	ec_to_affine(&Q, resultx, resulty);
+}
 
-	int i;
-	for (i = 256;i--;){
-		ec_double(Qx, Qy, tempx, tempy);
-		copy(tempx, Qx,arrayLength);
-		copy(tempy, Qy,arrayLength);
-		if (((secret[i / 32]) & ((uint32_t)1 << (i % 32)))) {
-			ec_add(Qx, Qy, px, py, tempx, tempy); //eccAdd
-			copy(tempx, Qx,arrayLength);
-			copy(tempy, Qy,arrayLength);
+#if ECC_WITH_FIXED_BASE
+/*
+ * Comb for multiplications of the base point G, with 4 teeth 64 bits
+ * apart: ecc_g_comb[j - 1] is the sum of 2^(64 * i) * G over all bits
+ * i that are set in j.
+ */
+static const uint32_t ecc_g_comb[15][2][8] = {
+	{ { 0xD898C296, 0xF4A13945, 0x2DEB33A0, 0x77037D81,
+	      0x63A440F2, 0xF8BCE6E5, 0xE12C4247, 0x6B17D1F2 },
+	  { 0x37BF51F5, 0xCBB64068, 0x6B315ECE, 0x2BCE3357,
+	      0x7C0F9E16, 0x8EE7EB4A, 0xFE1A7F9B, 0x4FE342E2 } },
+	{ { 0x8E14DB63, 0x90E75CB4, 0xAD651F7E, 0x29493BAA,
+	      0x326E25DE, 0x8492592E, 0x2811AAA5, 0x0FA822BC },
+	  { 0x5F462EE7, 0xE4112454, 0x50FE82F5, 0x34B1A650,
+	      0xB3DF188B, 0x6F4AD4BC, 0xF5DBA80D, 0xBFF44AE8 } },
+	{ { 0x097992AF, 0x93391CE2, 0x0D35F1FA, 0xE96C98FD,
+	      0x95E02789, 0xB257C0DE, 0x89D6726F, 0x300A4BBC },
+	  { 0xC08127A0, 0xAA54A291, 0xA9D806A5, 0x5BB1EEAD,
+	      0xFF1E3C6F, 0x7F1DDB25, 0xD09B4644, 0x72AAC7E0 } },
+	{ { 0xD789BD85, 0x57C84FC9, 0xC297EAC3, 0xFC35FF7D,
+	      0x88C6766E, 0xFB982FD5, 0xEEDB5E67, 0x447D739B },
+	  { 0x72E25B32, 0x0C7E33C9, 0xA7FAE500, 0x3D349B95,
+	      0x3A4AAFF7, 0xE12E9D95, 0x834131EE, 0x2D4825AB } },
+	{ { 0x2A1D367F, 0x13949C93, 0x1A0A11B7, 0xEF7FBD2B,
+	      0xB91DFC60, 0xDDC6068B, 0x8A9C72FF, 0xEF951932 },
+	  { 0x7376D8A8, 0x196035A7, 0x95CA1740, 0x23183B08,
+	      0x022C219C, 0xC1EE9807, 0x7DBB2C9B, 0x611E9FC3 } },
+	{ { 0x0B57F4BC, 0xCAE2B192, 0xC6C9BC36, 0x2936DF5E,
+	      0xE11238BF, 0x7DEA6482, 0x7B51F5D8, 0x55066379 },
+	  { 0x348A964C, 0x44FFE216, 0xDBDEFBE1, 0x9FB3D576,
+	      0x8D9D50E5, 0x0AFA4001, 0x8AECB851, 0x15716484 } },
+	{ { 0xFC5CDE01, 0xE48ECAFF, 0x0D715F26, 0x7CCD84E7,
+	      0xF43E4391, 0xA2E8F483, 0xB21141EA, 0xEB5D7745 },
+	  { 0x731A3479, 0xCAC917E2, 0x2844B645, 0x85F22CFE,
+	      0x58006CEE, 0x0990E6A1, 0xDBECC17B, 0xEAFD72EB } },
+	{ { 0x313728BE, 0x6CF20FFB, 0xA3C6B94A, 0x96439591,
+	      0x44315FC5, 0x2736FF83, 0xA7849276, 0xA6D39677 },
+	  { 0xC357F5F4, 0xF2BAB833, 0x2284059B, 0x824A920C,
+	      0x2D27ECDF, 0x66B8BABD, 0x9B0B8816, 0x674F8474 } },
+	{ { 0x677C8A3E, 0x2DF48C04, 0x0203A56B, 0x74E02F08,
+	      0xB8C7FEDB, 0x31855F7D, 0x72C9DDAD, 0x4E769E76 },
+	  { 0xB824BBB0, 0xA4C36165, 0x3B9122A5, 0xFB9AE16F,
+	      0x06947281, 0x1EC00572, 0xDE830663, 0x42B99082 } },
+	{ { 0xDDA868B9, 0x6EF95150, 0x9C0CE131, 0xD1F89E79,
+	      0x08A1C478, 0x7FDC1CA0, 0x1C6CE04D, 0x78878EF6 },
+	  { 0x1FE0D976, 0x9C62B912, 0xBDE08D4F, 0x6ACE570E,
+	      0x12309DEF, 0xDE53142C, 0x7B72C321, 0xB6CB3F5D } },
+	{ { 0xC31A3573, 0x7F991ED2, 0xD54FB496, 0x5B82DD5B,
+	      0x812FFCAE, 0x595C5220, 0x716B1287, 0x0C88BC4D },
+	  { 0x5F48ACA8, 0x3A57BF63, 0xDF2564F3, 0x7C8181F4,
+	      0x9C04E6AA, 0x18D1B5B3, 0xF3901DC6, 0xDD5DDEA3 } },
+	{ { 0x3E72AD0C, 0xE96A79FB, 0x42BA792F, 0x43A0A28C,
+	      0x083E49F3, 0xEFE0A423, 0x6B317466, 0x68F344AF },
+	  { 0x3FB24D4A, 0xCDFE17DB, 0x71F5C626, 0x668BFC22,
+	      0x24D67FF3, 0x604ED93C, 0xF8540A20, 0x31B9C405 } },
+	{ { 0xA2582E7F, 0xD36B4789, 0x4EC39C28, 0x0D1A1014,
+	      0xEDBAD7A0, 0x663C62C3, 0x6F461DB9, 0x4052BF4B },
+	  { 0x188D25EB, 0x235A27C3, 0x99BFCC5B, 0xE724F339,
+	      0x71D70CC8, 0x862BE6BD, 0x90B0FC61, 0xFECF4D51 } },
+	{ { 0xA1D4CFAC, 0x74346C10, 0x8526A7A4, 0xAFDF5CC0,
+	      0xF62BFF7A, 0x123202A8, 0xC802E41A, 0x1EDDBAE2 },
+	  { 0xD603F844, 0x8FA0AF2D, 0x4C701917, 0x36E06B7E,
+	      0x73DB33A0, 0x0C45F452, 0x560EBCFC, 0x43104D86 } },
+	{ { 0x0D1D78E5, 0x9615B511, 0x25C4744B, 0x66B0DE32,
+	      0x6AAF363A, 0x0A4A46FB, 0x84F7A21C, 0xB48E26B4 },
+	  { 0x21A01B2D, 0x06EBB0F6, 0x8B7B0F98, 0xC004E404,
+	      0xFED6F668, 0x64131BCD, 0x4D4D3DAB, 0xFAC01540 } }
+};
+
+static void ec_mult_base_jacobian(const uint32_t *secret, ec_point_t *Q){
+	ec_point_t T;
+	uint8_t idx;
+	int i, j;
+
+	setZero(Q->z, 8);
+	setZero(T.z, 8);
+	T.z[0] = 1;
+	for (i = 64; i--;){
+		ec_double_jacobian(Q, Q);
+		idx = 0;
+		for (j = 0; j < 4; j++)
+			idx |= ((secret[i / 32 + 2 * j] >> (i % 32)) & 1) << j;
+		if (idx){
+			copy(ecc_g_comb[idx - 1][0], T.x, arrayLength);
+			copy(ecc_g_comb[idx - 1][1], T.y, arrayLength);
+			ec_add_jacobian(Q, &T, Q);
 		}
 	}
-	copy(Qx, resultx,arrayLength);
-	copy(Qy, resulty,arrayLength);
+}
+#else /* ECC_WITH_FIXED_BASE */
+static void ec_mult_base_jacobian(const uint32_t *secret, ec_point_t *Q){
+	ec_mult_jacobian(ecc_g_point_x, ecc_g_point_y, secret, Q);
+}
+#endif /* ECC_WITH_FIXED_BASE */
+
+void ecc_ec_mult_base(const uint32_t *secret, uint32_t *resultx, uint32_t *resulty){
+	ec_point_t Q;
+
+	ec_mult_base_jacobian(secret, &Q);
+	ec_to_affine(&Q, resultx, resulty);
 }
 
 /**
@@ -541,7 +821,7 @@ int ecc_ecdsa_sign_hash(const uint32_t *d, const uint32_t *e, const uint32_t *k,
 		return -1;
 
 	// 4. Calculate the curve point (x_1, y_1) = k * G.
-	ecc_ec_mult(ecc_g_point_x, ecc_g_point_y, k, r, tmp1);
+	ecc_ec_mult_base(k, r, tmp1);
 
 	// 5. Calculate r = x_1 \pmod{n}.
 	fieldModO(r, r, 8);
@@ -596,12 +876,10 @@ int ecc_ecdsa_validate(const uint32_t *x, const uint32_t *y, const uint32_t *e,
 	uint32_t tmp[16];
 	uint32_t u1[9];
 	uint32_t u2[9];
-	uint32_t tmp1_x[8];
-	uint32_t tmp1_y[8];
-	uint32_t tmp2_x[8];
-	uint32_t tmp2_y[8];
 	uint32_t tmp3_x[8];
 	uint32_t tmp3_y[8];
+	ec_point_t tmp1;
+	ec_point_t tmp2;
 
 	// 3. Calculate w = s^{-1} \pmod{n}
 	fieldInv(s, ecc_order_m, ecc_order_r, w);
@@ -616,13 +894,14 @@ int ecc_ecdsa_validate(const uint32_t *x, const uint32_t *y, const uint32_t *e,
 
 	// 5. Calculate the curve point (x_1, y_1) = u_1 * G + u_2 * Q_A.
 	// tmp1 = u_1 * G
-	ecc_ec_mult(ecc_g_point_x, ecc_g_point_y, u1, tmp1_x, tmp1_y);
+	ec_mult_base_jacobian(u1, &tmp1);
 
 	// tmp2 = u_2 * Q_A
-	ecc_ec_mult(x, y, u2, tmp2_x, tmp2_y);
+	ec_mult_jacobian(x, y, u2, &tmp2);
 
 	// tmp3 = tmp1 + tmp2
-	ec_add(tmp1_x, tmp1_y, tmp2_x, tmp2_y, tmp3_x, tmp3_y);
+	ec_add_jacobian(&tmp1, &tmp2, &tmp1);
+	ec_to_affine(&tmp1, tmp3_x, tmp3_y);
 	// TODO: this u_1 * G + u_2 * Q_A  could be optimiced with Straus's algorithm.
 
 	return isSame(tmp3_x, r, arrayLength) ? 0 : -1;
@@ -697,11 +976,20 @@ int ecc_isGreater(const uint32_t *A, const uint32_t *B, uint8_t length)
 
 void ecc_ec_add(const uint32_t *px, const uint32_t *py, const uint32_t *qx, const uint32_t *qy, uint32_t *Sx, uint32_t *Sy)
 {
-	ec_add(px, py, qx, qy, Sx, Sy);
+	ec_point_t P, Q;
+
+	ec_from_affine(px, py, &P);
+	ec_from_affine(qx, qy, &Q);
+	ec_add_jacobian(&P, &Q, &P);
+	ec_to_affine(&P, Sx, Sy);
 }
 void ecc_ec_double(const uint32_t *px, const uint32_t *py, uint32_t *Dx, uint32_t *Dy)
 {
-	ec_double(px, py, Dx, Dy);
+	ec_point_t P;
+
+	ec_from_affine(px, py, &P);
+	ec_double_jacobian(&P, &P);
+	ec_to_affine(&P, Dx, Dy);
 }
 
 #endif /* TEST_INCLUDE */
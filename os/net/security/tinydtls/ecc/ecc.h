@@ -40,11 +40,34 @@
 #define keyLengthInBytes 32
 #define arrayLength 8
 
+/* Window width of the NAF used to multiply arbitrary points; it takes
+ * 2^(w-2) precomputed points on the stack. */
+#ifndef ECC_WNAF_WIDTH
+#define ECC_WNAF_WIDTH 4
+#endif
+
+/* Multiply the generator with a precomputed comb of 15 points, which
+ * costs 960 bytes of constant data. */
+#ifndef ECC_WITH_FIXED_BASE
+#define ECC_WITH_FIXED_BASE 1
+#endif
+
+/* Multiply field elements with 64 bit limbs where the compiler
+ * provides a 128 bit type, e.g. on the native platform. */
+#ifndef ECC_WITH_64BIT_LIMBS
+#ifdef __SIZEOF_INT128__
+#define ECC_WITH_64BIT_LIMBS 1
+#else
+#define ECC_WITH_64BIT_LIMBS 0
+#endif
+#endif
+
 extern const uint32_t ecc_g_point_x[8];
 extern const uint32_t ecc_g_point_y[8];
 
 //ec Functions
 void ecc_ec_mult(const uint32_t *px, const uint32_t *py, const uint32_t *secret, uint32_t *resultx, uint32_t *resulty);
+void ecc_ec_mult_base(const uint32_t *secret, uint32_t *resultx, uint32_t *resulty);
 
 static inline void ecc_ecdh(const uint32_t *px, const uint32_t *py, const uint32_t *secret, uint32_t *resultx, uint32_t *resulty) {
 	ecc_ec_mult(px, py, secret, resultx, resulty);
@@ -55,7 +78,7 @@ int ecc_ecdsa_sign_hash(const uint32_t *d, const uint32_t *e, const uint32_t *k,
 int ecc_is_valid_key(const uint32_t * priv_key);
 static inline void ecc_gen_pub_key(const uint32_t *priv_key, uint32_t *pub_x, uint32_t *pub_y)
 {
-	ecc_ec_mult(ecc_g_point_x, ecc_g_point_y, priv_key, pub_x, pub_y);
+	ecc_ec_mult_base(priv_key, pub_x, pub_y);
 }
 
 #ifdef TEST_INCLUDE
@@ -142,6 +142,23 @@ void multTest(){
 	assert(ecc_isSame(tempy, resultMulty, arrayLength));
 }
 
+void baseMultTest(){
+	uint32_t tempx[8];
+	uint32_t tempy[8];
+	uint32_t tempBx[8];
+	uint32_t tempBy[8];
+	uint32_t secretA[8];
+	int i;
+
+	for (i = 0; i < 16; i++){
+		ecc_setRandom(secretA);
+		ecc_ec_mult(BasePointx, BasePointy, secretA, tempx, tempy);
+		ecc_ec_mult_base(secretA, tempBx, tempBy);
+		assert(ecc_isSame(tempx, tempBx, arrayLength));
+		assert(ecc_isSame(tempy, tempBy, arrayLength));
+	}
+}
+
 void eccdhTest(){
 	uint32_t tempx[8];
 	uint32_t tempy[8];
@@ -205,6 +222,7 @@ PROCESS_THREAD(ecc_filed_test, ev, d)
 	addTest();
 	doubleTest();
 	multTest();
+	baseMultTest();
 	eccdhTest();
 	ecdsaTest();
 	printf("%s\n", "All Tests successful.");
@@ -218,6 +236,7 @@ int main(int argc, char const *argv[])
 	addTest();
 	doubleTest();
 	multTest();
+	baseMultTest();
 	eccdhTest();
 	ecdsaTest();
 	printf("%s\n", "All Tests successful.");
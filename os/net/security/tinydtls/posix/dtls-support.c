@@ -171,6 +171,41 @@ dtls_session_equals(const session_t *a, const session_t *b) {
   return 0;
 }
 
+unsigned int
+dtls_session_hash(const session_t *a) {
+  const uint8_t *p;
+  size_t len;
+  in_port_t port;
+  unsigned int hash;
+
+  assert(a);
+
+  /* hash only the parts that dtls_session_equals() compares */
+  switch (a->addr.sa.sa_family) {
+  case AF_INET:
+    p = (const uint8_t *)&a->addr.sin.sin_addr;
+    len = sizeof(struct in_addr);
+    port = a->addr.sin.sin_port;
+    break;
+  case AF_INET6:
+    p = (const uint8_t *)&a->addr.sin6.sin6_addr;
+    len = sizeof(struct in6_addr);
+    port = a->addr.sin6.sin6_port;
+    break;
+  default:
+    return a->ifindex;
+  }
+
+  /* FNV-1a */
+  hash = 2166136261u;
+  while (len--) {
+    hash = (hash ^ *p++) * 16777619u;
+  }
+  hash = (hash ^ (port & 0xff)) * 16777619u;
+  hash = (hash ^ (port >> 8)) * 16777619u;
+  return hash ^ a->ifindex;
+}
+
 void *
 dtls_session_get_address(const session_t *a)
 {
@@ -0,0 +1,393 @@
+#include "tinydtls.h"
+
+/*
+ * Runs one DTLS server and many clients over loopback in a single
+ * process. All clients first perform a full handshake, then drop
+ * their association and connect again from a new port, which lets
+ * them resume the cached session. Prints the time, the number of
+ * datagrams and the handshake rate of both rounds. With -e, the full
+ * handshakes use ECDHE-ECDSA instead of a pre-shared key. A round
+ * fails, and the exit status is non-zero, when a handshake is aborted
+ * or not all clients are connected in time.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <netinet/in.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <arpa/inet.h>
+
+#include "dtls.h"
+
+/* Log configuration */
+#define LOG_MODULE "dtls-peers"
+#define LOG_LEVEL  LOG_LEVEL_DTLS
+#include "dtls-log.h"
+
+#define DEFAULT_CLIENTS 64
+#define MAX_CLIENTS     512
+/* Clients start their handshakes in a window of at most MAX_HANDSHAKES,
+ * as a burst of hundreds of simultaneous handshakes only overflows the
+ * socket buffer of the server and measures the retransmission timers. */
+#define MAX_HANDSHAKES  32
+/* A round that has not completed within this time fails (ms) */
+#define ROUND_TIMEOUT   (5000 + 50UL * num_clients)
+
+#define PSK_IDENTITY "Client_identity"
+#define PSK_KEY      "secretPSK"
+
+static const unsigned char ecdsa_priv_key[] = {
+			0x41, 0xC1, 0xCB, 0x6B, 0x51, 0x24, 0x7A, 0x14,
+			0x43, 0x21, 0x43, 0x5B, 0x7A, 0x80, 0xE7, 0x14,
+			0x89, 0x6A, 0x33, 0xBB, 0xAD, 0x72, 0x94, 0xCA,
+			0x40, 0x14, 0x55, 0xA1, 0x94, 0xA9, 0x49, 0xFA};
+
+static const unsigned char ecdsa_pub_key_x[] = {
+			0x36, 0xDF, 0xE2, 0xC6, 0xF9, 0xF2, 0xED, 0x29,
+			0xDA, 0x0A, 0x9A, 0x8F, 0x62, 0x68, 0x4E, 0x91,
+			0x63, 0x75, 0xBA, 0x10, 0x30, 0x0C, 0x28, 0xC5,
+			0xE4, 0x7C, 0xFB, 0xF2, 0x5F, 0xA5, 0x8F, 0x52};
+
+static const unsigned char ecdsa_pub_key_y[] = {
+			0x71, 0xA0, 0xD4, 0xFC, 0xDE, 0x1A, 0xB8, 0x78,
+			0x5A, 0x3C, 0x78, 0x69, 0x35, 0xA7, 0xCF, 0xAB,
+			0xE9, 0x3F, 0x98, 0x72, 0x09, 0xDA, 0xED, 0x0B,
+			0x4F, 0xAB, 0xC3, 0x6F, 0xC7, 0x72, 0xF8, 0x29};
+
+#ifdef __GNUC__
+#define UNUSED_PARAM __attribute__((unused))
+#else
+#define UNUSED_PARAM
+#endif /* __GNUC__ */
+
+typedef struct {
+  int fd;
+  struct sockaddr_in addr;
+  dtls_context_t *ctx;
+  int connected;
+  int failed;
+} endpoint_t;
+
+static endpoint_t server;
+static endpoint_t clients[MAX_CLIENTS];
+static int num_clients = DEFAULT_CLIENTS;
+static session_t server_session;
+static unsigned long datagrams;
+
+static int
+get_psk_info(struct dtls_context_t *ctx UNUSED_PARAM,
+	     const session_t *session UNUSED_PARAM,
+	     dtls_credentials_type_t type,
+	     const unsigned char *id, size_t id_len,
+	     unsigned char *result, size_t result_length) {
+  switch (type) {
+  case DTLS_PSK_IDENTITY:
+  case DTLS_PSK_HINT:
+    if (result_length < strlen(PSK_IDENTITY)) {
+      return dtls_alert_fatal_create(DTLS_ALERT_INTERNAL_ERROR);
+    }
+    memcpy(result, PSK_IDENTITY, strlen(PSK_IDENTITY));
+    return strlen(PSK_IDENTITY);
+  case DTLS_PSK_KEY:
+    if (id_len != strlen(PSK_IDENTITY) ||
+	memcmp(PSK_IDENTITY, id, id_len) != 0) {
+      return dtls_alert_fatal_create(DTLS_ALERT_ILLEGAL_PARAMETER);
+    } else if (result_length < strlen(PSK_KEY)) {
+      return dtls_alert_fatal_create(DTLS_ALERT_INTERNAL_ERROR);
+    }
+    memcpy(result, PSK_KEY, strlen(PSK_KEY));
+    return strlen(PSK_KEY);
+  default:
+    dtls_warn("unsupported request type: %d\n", type);
+  }
+  return dtls_alert_fatal_create(DTLS_ALERT_INTERNAL_ERROR);
+}
+
+static int
+get_ecdsa_key(struct dtls_context_t *ctx UNUSED_PARAM,
+	      const session_t *session UNUSED_PARAM,
+	      const dtls_ecdsa_key_t **result) {
+  static const dtls_ecdsa_key_t ecdsa_key = {
+    .curve = DTLS_ECDH_CURVE_SECP256R1,
+    .priv_key = ecdsa_priv_key,
+    .pub_key_x = ecdsa_pub_key_x,
+    .pub_key_y = ecdsa_pub_key_y
+  };
+
+  *result = &ecdsa_key;
+  return 0;
+}
+
+static int
+verify_ecdsa_key(struct dtls_context_t *ctx UNUSED_PARAM,
+		 const session_t *session UNUSED_PARAM,
+		 const unsigned char *other_pub_x UNUSED_PARAM,
+		 const unsigned char *other_pub_y UNUSED_PARAM,
+		 size_t key_size UNUSED_PARAM) {
+  return 0;
+}
+
+static int
+read_from_peer(struct dtls_context_t *ctx UNUSED_PARAM,
+	       session_t *session UNUSED_PARAM,
+	       uint8_t *data UNUSED_PARAM, size_t len UNUSED_PARAM) {
+  return 0;
+}
+
+static int
+send_to_peer(struct dtls_context_t *ctx,
+	     session_t *session, uint8_t *data, size_t len) {
+  endpoint_t *ep = dtls_get_app_data(ctx);
+
+  datagrams++;
+  return sendto(ep->fd, data, len, MSG_DONTWAIT,
+		&session->addr.sa, session->size);
+}
+
+/* Returns the client that uses the address of a session of the server */
+static endpoint_t *
+find_client(const session_t *session) {
+  int i;
+
+  for (i = 0; i < num_clients; i++) {
+    if (clients[i].addr.sin_port == session->addr.sin.sin_port) {
+      return &clients[i];
+    }
+  }
+  return NULL;
+}
+
+static int
+handle_event(struct dtls_context_t *ctx, session_t *session,
+	     dtls_alert_level_t level, unsigned short code) {
+  endpoint_t *ep = dtls_get_app_data(ctx);
+
+  if (level == 0 && code == DTLS_EVENT_CONNECTED) {
+    ep->connected++;
+  } else if (level == DTLS_ALERT_LEVEL_FATAL) {
+    /* The handshake has been aborted, on either side */
+    if (ep == &server) {
+      ep = find_client(session);
+    }
+    if (ep) {
+      ep->failed = 1;
+    }
+  }
+  return 0;
+}
+
+static dtls_handler_t cb = {
+  .write = send_to_peer,
+  .read  = read_from_peer,
+  .event = handle_event,
+  .get_psk_info = get_psk_info,
+};
+
+static dtls_handler_t cb_ecdsa = {
+  .write = send_to_peer,
+  .read  = read_from_peer,
+  .event = handle_event,
+  .get_ecdsa_key = get_ecdsa_key,
+  .verify_ecdsa_key = verify_ecdsa_key,
+};
+
+static int
+open_socket(struct sockaddr_in *addr) {
+  socklen_t size = sizeof(*addr);
+  int fd;
+
+  fd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (fd < 0) {
+    return -1;
+  }
+
+  memset(addr, 0, sizeof(*addr));
+  addr->sin_family = AF_INET;
+  addr->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (bind(fd, (struct sockaddr *)addr, size) < 0 ||
+      getsockname(fd, (struct sockaddr *)addr, &size) < 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+static void
+handle_read(endpoint_t *ep) {
+  static uint8_t buf[2000];
+  session_t session;
+  int len;
+
+  /* Drain the socket; several datagrams may be pending per wakeup */
+  for (;;) {
+    memset(&session, 0, sizeof(session_t));
+    session.size = sizeof(session.addr);
+    len = recvfrom(ep->fd, buf, sizeof(buf), MSG_DONTWAIT,
+		   &session.addr.sa, &session.size);
+    if (len < 0) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+	perror("recvfrom");
+      }
+      if (errno != EINTR) {
+	return;
+      }
+    } else if (len > 0) {
+      dtls_handle_message(ep->ctx, &session, buf, len);
+    }
+  }
+}
+
+static unsigned long
+now_ms(void) {
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec * 1000UL + tv.tv_usec / 1000;
+}
+
+/* Drives all endpoints until every client is connected. */
+static int
+run_round(const char *name) {
+  static struct pollfd fds[MAX_CLIENTS + 1];
+  unsigned long start, elapsed;
+  int i, done, failed, started;
+
+  datagrams = 0;
+  start = now_ms();
+
+  for (i = 0; i < num_clients; i++) {
+    clients[i].connected = 0;
+    clients[i].failed = 0;
+  }
+  done = failed = started = 0;
+
+  do {
+    while (started < num_clients && started - done - failed < MAX_HANDSHAKES) {
+      dtls_connect(clients[started++].ctx, &server_session);
+    }
+
+    fds[0].fd = server.fd;
+    fds[0].events = POLLIN;
+    for (i = 0; i < num_clients; i++) {
+      fds[i + 1].fd = clients[i].fd;
+      fds[i + 1].events = POLLIN;
+    }
+
+    if (poll(fds, num_clients + 1, 10) < 0 && errno != EINTR) {
+      perror("poll");
+      return -1;
+    }
+
+    for (i = 0; i <= num_clients; i++) {
+      if (fds[i].revents & POLLIN) {
+        handle_read(i == 0 ? &server : &clients[i - 1]);
+      }
+    }
+
+    dtls_check_retransmit(server.ctx, NULL, 0);
+    for (done = failed = 0, i = 0; i < num_clients; i++) {
+      dtls_check_retransmit(clients[i].ctx, NULL, 0);
+      done += clients[i].connected > 0;
+      failed += clients[i].failed && clients[i].connected == 0;
+    }
+    elapsed = now_ms() - start;
+  } while (done + failed < num_clients && elapsed < ROUND_TIMEOUT);
+
+  printf("%-10s %4d/%d connected, %6lu datagrams, %6lu ms, %6lu handshakes/s\n",
+         name, done, num_clients, datagrams, elapsed,
+         done * 1000UL / (elapsed ? elapsed : 1));
+  if (failed > 0) {
+    printf("%-10s FAILED: %d handshakes aborted\n", name, failed);
+    return -1;
+  }
+  if (done < num_clients) {
+    printf("%-10s FAILED: timeout after %lu ms\n", name, elapsed);
+    return -1;
+  }
+  return 0;
+}
+
+int
+main(int argc, char **argv) {
+  struct sockaddr_in addr;
+  dtls_handler_t *handler = &cb;
+  dtls_peer_t *peer;
+  int i, opt, res = 0;
+
+  while ((opt = getopt(argc, argv, "e")) != -1) {
+    switch (opt) {
+    case 'e':
+      handler = &cb_ecdsa;
+      break;
+    default:
+      num_clients = 0;
+    }
+  }
+  if (optind < argc) {
+    num_clients = atoi(argv[optind]);
+  }
+  if (num_clients < 1 || num_clients > MAX_CLIENTS) {
+    fprintf(stderr, "usage: %s [-e] [clients (1-%d)]\n", argv[0], MAX_CLIENTS);
+    exit(1);
+  }
+
+  dtls_init();
+
+  server.fd = open_socket(&addr);
+  server.ctx = dtls_new_context(&server);
+  if (server.fd < 0 || !server.ctx) {
+    dtls_emerg("cannot create server\n");
+    exit(-1);
+  }
+  dtls_set_handler(server.ctx, handler);
+
+  memset(&server_session, 0, sizeof(session_t));
+  server_session.size = sizeof(addr);
+  server_session.addr.sin = addr;
+
+  for (i = 0; i < num_clients; i++) {
+    clients[i].fd = open_socket(&clients[i].addr);
+    clients[i].ctx = dtls_new_context(&clients[i]);
+    if (clients[i].fd < 0 || !clients[i].ctx) {
+      dtls_emerg("cannot create client %d\n", i);
+      exit(-1);
+    }
+    dtls_set_handler(clients[i].ctx, handler);
+  }
+
+  if (run_round("full") < 0) {
+    res = 1;
+  }
+
+  /* Drop the associations without notifying the server and come back
+   * from a new port; the session caches survive in the contexts. A
+   * peer that is already closed is freed without sending close_notify. */
+  for (i = 0; i < num_clients; i++) {
+    peer = dtls_get_peer(clients[i].ctx, &server_session);
+    if (peer) {
+      peer->state = DTLS_STATE_CLOSED;
+      dtls_reset_peer(clients[i].ctx, peer);
+    }
+    close(clients[i].fd);
+    clients[i].fd = open_socket(&clients[i].addr);
+  }
+
+  if (run_round("resumed") < 0) {
+    res = 1;
+  }
+
+  for (i = 0; i < num_clients; i++) {
+    dtls_free_context(clients[i].ctx);
+    close(clients[i].fd);
+  }
+  dtls_free_context(server.ctx);
+  close(server.fd);
+
+  return res;
+}
@@ -33,6 +33,7 @@
 
 #include "lib/memb.h"
 #include "lib/list.h"
+#include "sys/ctimer.h"
 
 #include "ip64-conf.h"
 
@@ -40,64 +41,149 @@
 
 #include <string.h>
 
+#define DEBUG 0
+
+#if DEBUG
+#include <stdio.h>
+#define PRINTF(...) printf(__VA_ARGS__)
+#else /* DEBUG */
+#define PRINTF(...)
+#endif /* DEBUG */
+
 #ifdef IP64_ADDRMAP_CONF_ENTRIES
 #define NUM_ENTRIES IP64_ADDRMAP_CONF_ENTRIES
 #else /* IP64_ADDRMAP_CONF_ENTRIES */
 #define NUM_ENTRIES 32
 #endif /* IP64_ADDRMAP_CONF_ENTRIES */
 
+/* Number of buckets in each of the two hash indices. */
+#ifdef IP64_ADDRMAP_CONF_HASH_SIZE
+#define HASH_SIZE IP64_ADDRMAP_CONF_HASH_SIZE
+#else /* IP64_ADDRMAP_CONF_HASH_SIZE */
+#define HASH_SIZE 16
+#endif /* IP64_ADDRMAP_CONF_HASH_SIZE */
+
+/* How often expired mappings are removed from the table. Lookups
+   skip expired mappings on their own, so this only bounds how long
+   they keep their memory. */
+#ifdef IP64_ADDRMAP_CONF_SWEEP_INTERVAL
+#define SWEEP_INTERVAL IP64_ADDRMAP_CONF_SWEEP_INTERVAL
+#else /* IP64_ADDRMAP_CONF_SWEEP_INTERVAL */
+#define SWEEP_INTERVAL (10 * CLOCK_SECOND)
+#endif /* IP64_ADDRMAP_CONF_SWEEP_INTERVAL */
+
 MEMB(entrymemb, struct ip64_addrmap_entry, NUM_ENTRIES);
 LIST(entrylist);
 
+/* The hash indices: mappings by the IPv6 to IPv4 flow they translate,
+   and by their mapped port and protocol. */
+static struct ip64_addrmap_entry *flowtable[HASH_SIZE];
+static struct ip64_addrmap_entry *porttable[HASH_SIZE];
+
+static struct ctimer sweep_timer;
+
 #define FIRST_MAPPED_PORT 10000
 #define LAST_MAPPED_PORT  20000
 static uint16_t mapped_port = FIRST_MAPPED_PORT;
 
-#define printf(...)
+/*---------------------------------------------------------------------------*/
+static unsigned int
+flow_hash(const uip_ip6addr_t *ip6addr, uint16_t ip6port,
+          const uip_ip4addr_t *ip4addr, uint16_t ip4port,
+          uint8_t protocol)
+{
+  uint32_t h;
+  int i;
 
+  /* The prefix is mostly the same for all hosts, so we only hash the
+     interface identifier of the IPv6 address. */
+  h = protocol;
+  for(i = 4; i < 8; i++) {
+    h = (h * 33) ^ ip6addr->u16[i];
+  }
+  h = (h * 33) ^ ip4addr->u16[0];
+  h = (h * 33) ^ ip4addr->u16[1];
+  h = (h * 33) ^ ip6port;
+  h = (h * 33) ^ ip4port;
+  return (h ^ (h >> 16)) % HASH_SIZE;
+}
 /*---------------------------------------------------------------------------*/
-struct ip64_addrmap_entry *
-ip64_addrmap_list(void)
+static unsigned int
+port_hash(uint16_t port, uint8_t protocol)
 {
-  return list_head(entrylist);
+  return (port ^ ((uint16_t)protocol << 8)) % HASH_SIZE;
 }
 /*---------------------------------------------------------------------------*/
-void
-ip64_addrmap_init(void)
+static void
+remove_entry(struct ip64_addrmap_entry *m)
 {
-  memb_init(&entrymemb);
-  list_init(entrylist);
-  mapped_port = FIRST_MAPPED_PORT;
+  struct ip64_addrmap_entry **p;
+
+  for(p = &flowtable[flow_hash(&m->ip6addr, m->ip6port,
+                               &m->ip4addr, m->ip4port, m->protocol)];
+      *p != NULL; p = &(*p)->flow_next) {
+    if(*p == m) {
+      *p = m->flow_next;
+      break;
+    }
+  }
+  for(p = &porttable[port_hash(m->mapped_port, m->protocol)];
+      *p != NULL; p = &(*p)->port_next) {
+    if(*p == m) {
+      *p = m->port_next;
+      break;
+    }
+  }
+  list_remove(entrylist, m);
+  memb_free(&entrymemb, m);
 }
 /*---------------------------------------------------------------------------*/
 static void
 check_age(void)
 {
-  struct ip64_addrmap_entry *m;
+  struct ip64_addrmap_entry *m, *next;
 
   /* Walk through the list of address mappings, throw away the ones
      that are too old. */
-  m = list_head(entrylist);
-  while(m != NULL) {
+  for(m = list_head(entrylist); m != NULL; m = next) {
+    next = list_item_next(m);
     if(timer_expired(&m->timer)) {
-      list_remove(entrylist, m);
-      memb_free(&entrymemb, m);
-      m = list_head(entrylist);
-    } else {
-      m = list_item_next(m);
+      PRINTF("ip64_addrmap: mapped port %d expired\n", m->mapped_port);
+      remove_entry(m);
     }
   }
 }
 /*---------------------------------------------------------------------------*/
+static void
+sweep(void *ptr)
+{
+  check_age();
+  ctimer_reset(&sweep_timer);
+}
+/*---------------------------------------------------------------------------*/
+struct ip64_addrmap_entry *
+ip64_addrmap_list(void)
+{
+  return list_head(entrylist);
+}
+/*---------------------------------------------------------------------------*/
+void
+ip64_addrmap_init(void)
+{
+  memb_init(&entrymemb);
+  list_init(entrylist);
+  memset(flowtable, 0, sizeof(flowtable));
+  memset(porttable, 0, sizeof(porttable));
+  mapped_port = FIRST_MAPPED_PORT;
+  ctimer_set(&sweep_timer, SWEEP_INTERVAL, sweep, NULL);
+}
+/*---------------------------------------------------------------------------*/
 static int
 recycle(void)
 {
   /* Find the oldest recyclable mapping and remove it. */
   struct ip64_addrmap_entry *m, *oldest;
 
-  /* Walk through the list of address mappings, throw away the ones
-     that are too old. */
-
   oldest = NULL;
   for(m = list_head(entrylist);
       m != NULL;
@@ -117,8 +203,7 @@ recycle(void)
   /* If we found an oldest recyclable entry, remove it and return
      non-zero. */
   if(oldest != NULL) {
-    list_remove(entrylist, oldest);
-    memb_free(&entrymemb, oldest);
+    remove_entry(oldest);
     return 1;
   }
 
@@ -134,21 +219,19 @@ ip64_addrmap_lookup(const uip_ip6addr_t *ip6addr,
 {
   struct ip64_addrmap_entry *m;
 
-  printf("lookup ip4port %d ip6port %d\n", uip_htons(ip4port),
+  PRINTF("lookup ip4port %d ip6port %d\n", uip_htons(ip4port),
 	 uip_htons(ip6port));
-  check_age();
-  for(m = list_head(entrylist); m != NULL; m = list_item_next(m)) {
-    printf("protocol %d %d, ip4port %d %d, ip6port %d %d, ip4 %d ip6 %d\n",
-	   m->protocol, protocol,
-	   m->ip4port, ip4port,
-	   m->ip6port, ip6port,
-	   uip_ip4addr_cmp(&m->ip4addr, ip4addr),
-	   uip_ip6addr_cmp(&m->ip6addr, ip6addr));
+  for(m = flowtable[flow_hash(ip6addr, ip6port, ip4addr, ip4port, protocol)];
+      m != NULL; m = m->flow_next) {
     if(m->protocol == protocol &&
        m->ip4port == ip4port &&
        m->ip6port == ip6port &&
        uip_ip4addr_cmp(&m->ip4addr, ip4addr) &&
        uip_ip6addr_cmp(&m->ip6addr, ip6addr)) {
+      if(timer_expired(&m->timer)) {
+        remove_entry(m);
+        return NULL;
+      }
       m->ip6to4++;
       return m;
     }
@@ -156,25 +239,38 @@ ip64_addrmap_lookup(const uip_ip6addr_t *ip6addr,
   return NULL;
 }
 /*---------------------------------------------------------------------------*/
-struct ip64_addrmap_entry *
-ip64_addrmap_lookup_port(uint16_t mapped_port, uint8_t protocol)
+static struct ip64_addrmap_entry *
+find_port(uint16_t mapped_port, uint8_t protocol)
 {
   struct ip64_addrmap_entry *m;
 
-  check_age();
-  for(m = list_head(entrylist); m != NULL; m = list_item_next(m)) {
-    printf("mapped port %d %d, protocol %d %d\n",
-	   m->mapped_port, mapped_port,
-	   m->protocol, protocol);
+  for(m = porttable[port_hash(mapped_port, protocol)];
+      m != NULL; m = m->port_next) {
     if(m->mapped_port == mapped_port &&
        m->protocol == protocol) {
-      m->ip4to6++;
+      if(timer_expired(&m->timer)) {
+        remove_entry(m);
+        return NULL;
+      }
       return m;
     }
   }
   return NULL;
 }
 /*---------------------------------------------------------------------------*/
+struct ip64_addrmap_entry *
+ip64_addrmap_lookup_port(uint16_t mapped_port, uint8_t protocol)
+{
+  struct ip64_addrmap_entry *m;
+
+  PRINTF("lookup mapped port %d, protocol %d\n", mapped_port, protocol);
+  m = find_port(mapped_port, protocol);
+  if(m != NULL) {
+    m->ip4to6++;
+  }
+  return m;
+}
+/*---------------------------------------------------------------------------*/
 static void
 increase_mapped_port(void)
 {
@@ -191,12 +287,14 @@ ip64_addrmap_create(const uip_ip6addr_t *ip6addr,
 {
   struct ip64_addrmap_entry *m;
 
-  check_age();
   m = memb_alloc(&entrymemb);
   if(m == NULL) {
-    /* We could not allocate an entry, try to recycle one and try to
-       allocate again. */
-    if(recycle()) {
+    /* We could not allocate an entry, so we first throw away the
+       expired ones, then try to recycle one, and try to allocate
+       again. */
+    check_age();
+    m = memb_alloc(&entrymemb);
+    if(m == NULL && recycle()) {
       m = memb_alloc(&entrymemb);
     }
   }
@@ -214,22 +312,18 @@ ip64_addrmap_create(const uip_ip6addr_t *ip6addr,
     /* Pick a new, unused local port. First make sure that the
        mapped_port number does not belong to any active connection. If
        so, we keep increasing the mapped_port until we're free. */
-    {
-      struct ip64_addrmap_entry *n;
-      n = list_head(entrylist);
-      while(n != NULL) {
-	if(n->mapped_port == mapped_port) {
-	  increase_mapped_port();
-	  n = list_head(entrylist);
-	} else {
-	  n = list_item_next(m);
-	}
-      }
+    while(find_port(mapped_port, protocol) != NULL) {
+      increase_mapped_port();
     }
     m->mapped_port = mapped_port;
     increase_mapped_port();
 
     list_add(entrylist, m);
+    m->flow_next = flowtable[flow_hash(ip6addr, ip6port,
+                                       ip4addr, ip4port, protocol)];
+    flowtable[flow_hash(ip6addr, ip6port, ip4addr, ip4port, protocol)] = m;
+    m->port_next = porttable[port_hash(m->mapped_port, protocol)];
+    porttable[port_hash(m->mapped_port, protocol)] = m;
     return m;
   }
   return NULL;
@@ -38,6 +38,7 @@
 
 struct ip64_addrmap_entry {
   struct ip64_addrmap_entry *next;
+  struct ip64_addrmap_entry *flow_next, *port_next;
   struct timer timer;
   uip_ip6addr_t ip6addr;
   uip_ip4addr_t ip4addr;
@@ -129,11 +129,12 @@ output(void)
   if(uip_ipaddr_cmp(&last_sender, &UIP_IP_BUF->srcipaddr)) {
     PRINTF("ip64-interface: output, not sending bounced message\n");
   } else {
+    /* The IPv4 header is smaller than the IPv6 header, so the packet
+       is translated in place. */
     len = ip64_6to4(&uip_buf[UIP_LLH_LEN], uip_len,
-		    ip64_packet_buffer);
+		    &uip_buf[UIP_LLH_LEN]);
     PRINTF("ip64-interface: output len %d\n", len);
     if(len > 0) {
-      memcpy(&uip_buf[UIP_LLH_LEN], ip64_packet_buffer, len);
       uip_len = len;
       slip_send();
       return len;
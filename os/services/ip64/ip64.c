@@ -187,6 +187,7 @@ ip64_init(void)
   ip64_hostaddr_configured = 0;
 
   PRINTF("ip64_init\n");
+  ip64_addrmap_init();
   IP64_ETH_DRIVER.init();
 #if IP64_DHCP
   ip64_ipv4_dhcp_init();
@@ -336,11 +337,11 @@ ipv4_transport_checksum(const uint8_t *packet, uint16_t len, uint8_t proto)
 }
 /*---------------------------------------------------------------------------*/
 static uint16_t
-ipv6_transport_checksum(const uint8_t *packet, uint16_t len, uint8_t proto)
+ipv6_transport_checksum(const struct ipv6_hdr *v6hdr, const uint8_t *transport,
+                        uint16_t len, uint8_t proto)
 {
   uint16_t transport_layer_len;
   uint16_t sum;
-  struct ipv6_hdr *v6hdr = (struct ipv6_hdr *)packet;
 
   transport_layer_len = len - IPV6_HDRLEN;
 
@@ -353,25 +354,66 @@ ipv6_transport_checksum(const uint8_t *packet, uint16_t len, uint8_t proto)
   sum = chksum(sum, (uint8_t *)&v6hdr->destipaddr, sizeof(uip_ip6addr_t));
 
   /* Sum transport layer header and data. */
-  sum = chksum(sum, &packet[IPV6_HDRLEN], transport_layer_len);
+  sum = chksum(sum, transport, transport_layer_len);
 
   return (sum == 0) ? 0xffff : uip_htons(sum);
 }
 /*---------------------------------------------------------------------------*/
+static uint16_t
+chksum_add(uint16_t sum, uint16_t t)
+{
+  sum += t;
+  if(sum < t) {
+    sum++;		/* carry */
+  }
+  return sum;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Adjusts the TCP or UDP checksum of a translated packet as described
+ * in RFC 1624, instead of recomputing it over the whole payload. The
+ * length and protocol terms of the pseudo-header are the same for
+ * IPv4 and IPv6, so only the pseudo-header addresses and the two port
+ * numbers that start the transport header need to be accounted for.
+ */
+static uint16_t
+transport_checksum_update(uint16_t chksum_field,
+                          const uint8_t *oldaddrs, uint16_t oldaddrslen,
+                          const uint8_t *newaddrs, uint16_t newaddrslen,
+                          const uint8_t *oldports, const uint8_t *newports)
+{
+  uint16_t oldsum, newsum, sum;
+
+  oldsum = chksum(0, oldaddrs, oldaddrslen);
+  oldsum = chksum(oldsum, oldports, 2 * sizeof(uint16_t));
+  newsum = chksum(0, newaddrs, newaddrslen);
+  newsum = chksum(newsum, newports, 2 * sizeof(uint16_t));
+
+  /* HC' = ~(~HC + ~m + m') */
+  sum = chksum_add(~uip_ntohs(chksum_field), ~oldsum);
+  sum = chksum_add(sum, newsum);
+  return uip_htons(~sum);
+}
+/*---------------------------------------------------------------------------*/
 int
 ip64_6to4(const uint8_t *ipv6packet, const uint16_t ipv6packet_len,
 	  uint8_t *resultpacket)
 {
   struct ipv4_hdr *v4hdr;
-  struct ipv6_hdr *v6hdr;
+  struct ipv6_hdr *v6hdr, v6hdr_copy;
   struct udp_hdr *udphdr;
   struct tcp_hdr *tcphdr;
   struct icmpv4_hdr *icmpv4hdr;
   struct icmpv6_hdr *icmpv6hdr;
   uint16_t ipv6len, ipv4len;
+  uint8_t ports[2 * sizeof(uint16_t)];
   struct ip64_addrmap_entry *m;
 
-  v6hdr = (struct ipv6_hdr *)ipv6packet;
+  /* The result packet may be in the same buffer as the IPv6 packet,
+     so we keep a copy of the IPv6 header before it is overwritten by
+     the IPv4 header. */
+  memcpy(&v6hdr_copy, ipv6packet, IPV6_HDRLEN);
+  v6hdr = &v6hdr_copy;
   v4hdr = (struct ipv4_hdr *)resultpacket;
 
   if((v6hdr->len[0] << 8) + v6hdr->len[1] <= ipv6packet_len) {
@@ -382,15 +424,23 @@ ip64_6to4(const uint8_t *ipv6packet, const uint16_t ipv6packet_len,
   }
 
   /* We copy the data from the IPv6 packet into the IPv4 packet. We do
-     not modify the data in any way. */
-  memcpy(&resultpacket[IPV4_HDRLEN],
-	 &ipv6packet[IPV6_HDRLEN],
-	 ipv6len - IPV6_HDRLEN);
+     not modify the data in any way. If the caller has placed the
+     result packet so that the data already is in the right place, the
+     packet is translated without any copying. */
+  if(&resultpacket[IPV4_HDRLEN] != &ipv6packet[IPV6_HDRLEN]) {
+    memmove(&resultpacket[IPV4_HDRLEN],
+            &ipv6packet[IPV6_HDRLEN],
+            ipv6len - IPV6_HDRLEN);
+  }
 
   udphdr = (struct udp_hdr *)&resultpacket[IPV4_HDRLEN];
   tcphdr = (struct tcp_hdr *)&resultpacket[IPV4_HDRLEN];
   icmpv4hdr = (struct icmpv4_hdr *)&resultpacket[IPV4_HDRLEN];
-  icmpv6hdr = (struct icmpv6_hdr *)&ipv6packet[IPV6_HDRLEN];
+  icmpv6hdr = (struct icmpv6_hdr *)&resultpacket[IPV4_HDRLEN];
+
+  /* Remember the original port numbers, which are part of the
+     transport checksum that we update below. */
+  memcpy(ports, udphdr, sizeof(ports));
 
   /* Translate the IPv6 header into an IPv4 header. */
 
@@ -425,14 +475,8 @@ ip64_6to4(const uint8_t *ipv6packet, const uint16_t ipv6packet_len,
     PRINTF("ip64_6to4: TCP header\n");
     v4hdr->proto = IP_PROTO_TCP;
 
-    /* Compute and check the TCP checksum - since we're going to
-       recompute it ourselves, we must ensure that it was correct in
-       the first place. */
-    if(ipv6_transport_checksum(ipv6packet, ipv6len,
-                               IP_PROTO_TCP) != 0xffff) {
-      PRINTF("Bad TCP checksum, dropping packet\n");
-    }
-
+    /* The TCP checksum is updated incrementally below, so a corrupt
+       segment keeps a bad checksum and is caught by the receiver. */
     break;
 
   case IP_PROTO_UDP:
@@ -440,20 +484,21 @@ ip64_6to4(const uint8_t *ipv6packet, const uint16_t ipv6packet_len,
     v4hdr->proto = IP_PROTO_UDP;
 
     /* Check if this is a DNS request. If so, we should rewrite it
-       with the DNS64 module. */
+       with the DNS64 module. The request already has been copied into
+       the result packet, so it is rewritten there. */
     if(udphdr->destport == UIP_HTONS(DNS_PORT)) {
-      ip64_dns64_6to4((uint8_t *)v6hdr + IPV6_HDRLEN + sizeof(struct udp_hdr),
+      /* Compute and check the UDP checksum - since we're going to
+         recompute it ourselves, we must ensure that it was correct in
+         the first place. */
+      if(ipv6_transport_checksum(v6hdr, (uint8_t *)udphdr, ipv6len,
+                                 IP_PROTO_UDP) != 0xffff) {
+        PRINTF("Bad UDP checksum, dropping packet\n");
+      }
+      ip64_dns64_6to4((uint8_t *)udphdr + sizeof(struct udp_hdr),
                       ipv6len - IPV6_HDRLEN - sizeof(struct udp_hdr),
                       (uint8_t *)udphdr + sizeof(struct udp_hdr),
                       BUFSIZE - IPV4_HDRLEN - sizeof(struct udp_hdr));
     }
-    /* Compute and check the UDP checksum - since we're going to
-       recompute it ourselves, we must ensure that it was correct in
-       the first place. */
-    if(ipv6_transport_checksum(ipv6packet, ipv6len,
-                               IP_PROTO_UDP) != 0xffff) {
-      PRINTF("Bad UDP checksum, dropping packet\n");
-    }
     break;
 
   case IP_PROTO_ICMPV6:
@@ -616,17 +661,33 @@ ip64_6to4(const uint8_t *ipv6packet, const uint16_t ipv6packet_len,
 
   /* The checksum is in different places in the different protocol
      headers, so we need to be sure that we update the correct
-     field. */
+     field. TCP and UDP checksums are updated for the new addresses
+     and ports without touching the payload, unless the payload has
+     been rewritten by DNS64 or the checksum is missing. */
   switch(v4hdr->proto) {
   case IP_PROTO_TCP:
-    tcphdr->tcpchksum = 0;
-    tcphdr->tcpchksum = ~(ipv4_transport_checksum(resultpacket, ipv4len,
-						  IP_PROTO_TCP));
+    tcphdr->tcpchksum =
+      transport_checksum_update(tcphdr->tcpchksum,
+                                (uint8_t *)&v6hdr->srcipaddr,
+                                2 * sizeof(uip_ip6addr_t),
+                                (uint8_t *)&v4hdr->srcipaddr,
+                                2 * sizeof(uip_ip4addr_t),
+                                ports, (uint8_t *)tcphdr);
     break;
   case IP_PROTO_UDP:
-    udphdr->udpchksum = 0;
-    udphdr->udpchksum = ~(ipv4_transport_checksum(resultpacket, ipv4len,
-						  IP_PROTO_UDP));
+    if(udphdr->destport != UIP_HTONS(DNS_PORT) && udphdr->udpchksum != 0) {
+      udphdr->udpchksum =
+        transport_checksum_update(udphdr->udpchksum,
+                                  (uint8_t *)&v6hdr->srcipaddr,
+                                  2 * sizeof(uip_ip6addr_t),
+                                  (uint8_t *)&v4hdr->srcipaddr,
+                                  2 * sizeof(uip_ip4addr_t),
+                                  ports, (uint8_t *)udphdr);
+    } else {
+      udphdr->udpchksum = 0;
+      udphdr->udpchksum = ~(ipv4_transport_checksum(resultpacket, ipv4len,
+                                                    IP_PROTO_UDP));
+    }
     if(udphdr->udpchksum == 0) {
       udphdr->udpchksum = 0xffff;
     }
@@ -854,18 +915,34 @@ ip64_4to6(const uint8_t *ipv4packet, const uint16_t ipv4packet_len,
      field. */
   switch(v6hdr->nxthdr) {
   case IP_PROTO_TCP:
-    tcphdr->tcpchksum = 0;
-    tcphdr->tcpchksum = ~(ipv6_transport_checksum(resultpacket,
-						  ipv6len,
-						  IP_PROTO_TCP));
+    tcphdr->tcpchksum =
+      transport_checksum_update(tcphdr->tcpchksum,
+                                (uint8_t *)&v4hdr->srcipaddr,
+                                2 * sizeof(uip_ip4addr_t),
+                                (uint8_t *)&v6hdr->srcipaddr,
+                                2 * sizeof(uip_ip6addr_t),
+                                &ipv4packet[IPV4_HDRLEN], (uint8_t *)tcphdr);
     break;
   case IP_PROTO_UDP:
-    udphdr->udpchksum = 0;
-    /* As the udplen might have changed (DNS) we need to update it also */
-    udphdr->udplen = uip_htons(ipv6_packet_len);
-    udphdr->udpchksum = ~(ipv6_transport_checksum(resultpacket,
-						  ipv6len,
-						  IP_PROTO_UDP));
+    if(udphdr->srcport != UIP_HTONS(DNS_PORT) && udphdr->udpchksum != 0) {
+      udphdr->udpchksum =
+        transport_checksum_update(udphdr->udpchksum,
+                                  (uint8_t *)&v4hdr->srcipaddr,
+                                  2 * sizeof(uip_ip4addr_t),
+                                  (uint8_t *)&v6hdr->srcipaddr,
+                                  2 * sizeof(uip_ip6addr_t),
+                                  &ipv4packet[IPV4_HDRLEN], (uint8_t *)udphdr);
+    } else {
+      /* A missing IPv4 UDP checksum is not allowed in IPv6, so it is
+         computed here. As the udplen might have changed (DNS) we need
+         to update it also */
+      udphdr->udpchksum = 0;
+      udphdr->udplen = uip_htons(ipv6_packet_len);
+      udphdr->udpchksum = ~(ipv6_transport_checksum(v6hdr,
+                                                    &resultpacket[IPV6_HDRLEN],
+                                                    ipv6len,
+                                                    IP_PROTO_UDP));
+    }
     if(udphdr->udpchksum == 0) {
       udphdr->udpchksum = 0xffff;
     }
@@ -873,7 +950,8 @@ ip64_4to6(const uint8_t *ipv4packet, const uint16_t ipv4packet_len,
 
   case IP_PROTO_ICMPV6:
     icmpv6hdr->icmpchksum = 0;
-    icmpv6hdr->icmpchksum = ~(ipv6_transport_checksum(resultpacket,
+    icmpv6hdr->icmpchksum = ~(ipv6_transport_checksum(v6hdr,
+                                                &resultpacket[IPV6_HDRLEN],
                                                 ipv6len,
                                                 IP_PROTO_ICMPV6));
     break;
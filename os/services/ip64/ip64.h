@@ -35,6 +35,13 @@
 #include "net/ipv6/uip.h"
 
 void ip64_init(void);
+
+/* Translate a packet between IPv6 and IPv4 and return the length of
+   the result, or 0 if the packet could not be translated. The IPv4
+   header is smaller than the IPv6 header, so ip64_6to4() may put the
+   result in the same buffer as the IPv6 packet; the payload is not
+   moved at all if resultpacket starts 20 bytes into the IPv6 packet.
+   ip64_4to6() needs a separate result buffer. */
 int ip64_6to4(const uint8_t *ipv6packet, const uint16_t ipv6len,
               uint8_t *resultpacket);
 int ip64_4to6(const uint8_t *ipv4packet, const uint16_t ipv4len,
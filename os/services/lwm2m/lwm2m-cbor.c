@@ -0,0 +1,508 @@
+/*
+ * Copyright (c) 2019, RISE SICS AB.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \addtogroup lwm2m
+ * @{
+ */
+
+/**
+ * \file
+ *         Implementation of the Contiki OMA LWM2M CBOR encoder, decoder and
+ *         the plain CBOR content format
+ */
+
+#include "lwm2m-object.h"
+#include "lwm2m-cbor.h"
+#include <string.h>
+
+/* Log configuration */
+#include "coap-log.h"
+#define LOG_MODULE "lwm2m-cbor"
+#define LOG_LEVEL  LOG_LEVEL_NONE
+
+/* Nesting accepted when skipping over a data item */
+#define MAX_DEPTH 4
+/*---------------------------------------------------------------------------*/
+size_t
+lwm2m_cbor_write_head(uint8_t *outbuf, size_t outlen, uint8_t type,
+                      uint64_t value)
+{
+  uint8_t info;
+  size_t n;
+  size_t i;
+
+  if(value < 24) {
+    info = (uint8_t)value;
+    n = 0;
+  } else if(value <= 0xff) {
+    info = 24;
+    n = 1;
+  } else if(value <= 0xffff) {
+    info = 25;
+    n = 2;
+  } else if(value <= 0xffffffff) {
+    info = 26;
+    n = 4;
+  } else {
+    info = 27;
+    n = 8;
+  }
+
+  if(outlen < n + 1) {
+    return 0;
+  }
+  outbuf[0] = (type << 5) | info;
+  for(i = n; i > 0; i--) {
+    outbuf[i] = value & 0xff;
+    value >>= 8;
+  }
+  return n + 1;
+}
+/*---------------------------------------------------------------------------*/
+size_t
+lwm2m_cbor_write_int(uint8_t *outbuf, size_t outlen, int32_t value)
+{
+  if(value < 0) {
+    return lwm2m_cbor_write_head(outbuf, outlen, LWM2M_CBOR_TYPE_NINT,
+                                 (uint32_t)-(value + 1));
+  }
+  return lwm2m_cbor_write_head(outbuf, outlen, LWM2M_CBOR_TYPE_UINT, value);
+}
+/*---------------------------------------------------------------------------*/
+size_t
+lwm2m_cbor_write_text(uint8_t *outbuf, size_t outlen,
+                      const char *value, size_t len)
+{
+  size_t s;
+
+  s = lwm2m_cbor_write_head(outbuf, outlen, LWM2M_CBOR_TYPE_TEXT, len);
+  if(s == 0 || outlen - s < len) {
+    return 0;
+  }
+  memcpy(&outbuf[s], value, len);
+  return s + len;
+}
+/*---------------------------------------------------------------------------*/
+size_t
+lwm2m_cbor_write_boolean(uint8_t *outbuf, size_t outlen, int value)
+{
+  if(outlen < 1) {
+    return 0;
+  }
+  outbuf[0] = (LWM2M_CBOR_TYPE_SIMPLE << 5) |
+    (value ? LWM2M_CBOR_TRUE : LWM2M_CBOR_FALSE);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Write the fixpoint value (value / 2^bits) exactly: as an integer if it
+ * has no fraction, else as a single precision float if the significand
+ * fits in 24 bits, else as a double.
+ */
+size_t
+lwm2m_cbor_write_float32fix(uint8_t *outbuf, size_t outlen,
+                            int32_t value, int bits)
+{
+  uint32_t mag;
+  uint64_t raw;
+  int msb;
+  int exp;
+  size_t n;
+  size_t i;
+
+  if((value & ((1L << bits) - 1)) == 0) {
+    return lwm2m_cbor_write_int(outbuf, outlen, value >> bits);
+  }
+
+  mag = value < 0 ? -(uint32_t)value : (uint32_t)value;
+  for(msb = 31; (mag & (1UL << msb)) == 0; msb--);
+  exp = msb - bits;
+
+  if(msb <= 23) {
+    raw = (uint32_t)(exp + 127) << 23 | ((mag << (23 - msb)) & 0x7fffff);
+    if(value < 0) {
+      raw |= 0x80000000UL;
+    }
+    outbuf[0] = (LWM2M_CBOR_TYPE_SIMPLE << 5) | LWM2M_CBOR_FLOAT32;
+    n = 4;
+  } else {
+    raw = (uint64_t)(exp + 1023) << 52 |
+      (((uint64_t)mag << (52 - msb)) & 0xfffffffffffffULL);
+    if(value < 0) {
+      raw |= 0x8000000000000000ULL;
+    }
+    outbuf[0] = (LWM2M_CBOR_TYPE_SIMPLE << 5) | LWM2M_CBOR_FLOAT64;
+    n = 8;
+  }
+
+  if(outlen < n + 1) {
+    return 0;
+  }
+  for(i = n; i > 0; i--) {
+    outbuf[i] = raw & 0xff;
+    raw >>= 8;
+  }
+  return n + 1;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Decode the head of the data item at inbuf. Returns the size of the head
+ * plus, for strings, their contents - or zero if the item is truncated or
+ * not supported (indefinite length strings).
+ */
+size_t
+lwm2m_cbor_read(lwm2m_cbor_t *item, const uint8_t *inbuf, size_t len)
+{
+  size_t n;
+  size_t i;
+
+  if(len < 1) {
+    return 0;
+  }
+  item->type = inbuf[0] >> 5;
+  item->info = inbuf[0] & 0x1f;
+  item->value = 0;
+  item->data = NULL;
+
+  if(item->info < 24) {
+    item->value = item->info;
+    n = 0;
+  } else if(item->info <= 27) {
+    n = 1 << (item->info - 24);
+    if(len < n + 1) {
+      return 0;
+    }
+    for(i = 1; i <= n; i++) {
+      item->value = (item->value << 8) | inbuf[i];
+    }
+  } else if(item->info == LWM2M_CBOR_INDEFINITE &&
+            (item->type == LWM2M_CBOR_TYPE_ARRAY ||
+             item->type == LWM2M_CBOR_TYPE_MAP ||
+             item->type == LWM2M_CBOR_TYPE_SIMPLE)) {
+    /* Indefinite length array or map, or a break */
+    n = 0;
+  } else {
+    LOG_DBG("unsupported item 0x%02x\n", inbuf[0]);
+    return 0;
+  }
+
+  if(item->type == LWM2M_CBOR_TYPE_BYTES ||
+     item->type == LWM2M_CBOR_TYPE_TEXT) {
+    if(item->value > len - n - 1) {
+      return 0;
+    }
+    item->data = &inbuf[n + 1];
+    return n + 1 + (size_t)item->value;
+  }
+  return n + 1;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+skip(const uint8_t *inbuf, size_t len, int depth)
+{
+  lwm2m_cbor_t item;
+  uint64_t count;
+  size_t size;
+  size_t s;
+
+  size = lwm2m_cbor_read(&item, inbuf, len);
+  if(size == 0) {
+    return 0;
+  }
+
+  switch(item.type) {
+  case LWM2M_CBOR_TYPE_ARRAY:
+  case LWM2M_CBOR_TYPE_MAP:
+    if(depth >= MAX_DEPTH) {
+      return 0;
+    }
+    if(item.info == LWM2M_CBOR_INDEFINITE) {
+      while(size < len && inbuf[size] != LWM2M_CBOR_BREAK) {
+        if((s = skip(&inbuf[size], len - size, depth + 1)) == 0) {
+          return 0;
+        }
+        size += s;
+      }
+      /* Include the break */
+      return size < len ? size + 1 : 0;
+    }
+    count = item.type == LWM2M_CBOR_TYPE_MAP ? item.value * 2 : item.value;
+    for(; count > 0; count--) {
+      if((s = skip(&inbuf[size], len - size, depth + 1)) == 0) {
+        return 0;
+      }
+      size += s;
+    }
+    return size;
+  case LWM2M_CBOR_TYPE_TAG:
+    s = skip(&inbuf[size], len - size, depth);
+    return s > 0 ? size + s : 0;
+  case LWM2M_CBOR_TYPE_SIMPLE:
+    /* A break is not an item of its own */
+    return item.info == LWM2M_CBOR_INDEFINITE ? 0 : size;
+  default:
+    return size;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Returns the size of the complete data item at inbuf, or zero */
+size_t
+lwm2m_cbor_skip(const uint8_t *inbuf, size_t len)
+{
+  return skip(inbuf, len, 0);
+}
+/*---------------------------------------------------------------------------*/
+int
+lwm2m_cbor_get_int32(const lwm2m_cbor_t *item, int32_t *value)
+{
+  if(item->value > INT32_MAX) {
+    return 0;
+  }
+  if(item->type == LWM2M_CBOR_TYPE_UINT) {
+    *value = (int32_t)item->value;
+    return 1;
+  }
+  if(item->type == LWM2M_CBOR_TYPE_NINT) {
+    *value = -1 - (int32_t)item->value;
+    return 1;
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+int
+lwm2m_cbor_get_float32fix(const lwm2m_cbor_t *item, int32_t *value, int bits)
+{
+  uint64_t mant;
+  int mbits;
+  int ebits;
+  int exp;
+  int shift;
+
+  if(item->type == LWM2M_CBOR_TYPE_UINT ||
+     item->type == LWM2M_CBOR_TYPE_NINT) {
+    if(!lwm2m_cbor_get_int32(item, value) ||
+       *value > (INT32_MAX >> bits) || *value < (INT32_MIN >> bits)) {
+      return 0;
+    }
+    *value *= (int32_t)1 << bits;
+    return 1;
+  }
+  if(item->type != LWM2M_CBOR_TYPE_SIMPLE) {
+    return 0;
+  }
+
+  switch(item->info) {
+  case LWM2M_CBOR_FLOAT16:
+    ebits = 5;
+    mbits = 10;
+    break;
+  case LWM2M_CBOR_FLOAT32:
+    ebits = 8;
+    mbits = 23;
+    break;
+  case LWM2M_CBOR_FLOAT64:
+    ebits = 11;
+    mbits = 52;
+    break;
+  default:
+    return 0;
+  }
+
+  mant = item->value & ((1ULL << mbits) - 1);
+  exp = (item->value >> mbits) & ((1 << ebits) - 1);
+  if(exp == (1 << ebits) - 1) {
+    /* Infinity or NaN */
+    return 0;
+  }
+  if(exp == 0) {
+    /* Zero or subnormal */
+    exp = 1;
+  } else {
+    mant |= 1ULL << mbits;
+  }
+  /* value = mant * 2^(exp - bias - mbits), scaled up by 2^bits */
+  shift = exp - ((1 << (ebits - 1)) - 1) - mbits + bits;
+  if(shift >= 0) {
+    /* Compare before shifting, since the shift can overflow */
+    if(mant != 0 && (shift > 31 || mant > ((uint64_t)INT32_MAX >> shift))) {
+      return 0;
+    }
+    mant <<= shift;
+  } else {
+    mant = -shift < 64 ? mant >> -shift : 0;
+  }
+  if(mant > INT32_MAX) {
+    return 0;
+  }
+
+  *value = (int32_t)mant;
+  if(item->value >> (ebits + mbits)) {
+    *value = -*value;
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+init_write(lwm2m_context_t *ctx)
+{
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+end_write(lwm2m_context_t *ctx)
+{
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+write_int(lwm2m_context_t *ctx, uint8_t *outbuf, size_t outlen,
+          int32_t value)
+{
+  return lwm2m_cbor_write_int(outbuf, outlen, value);
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+write_string(lwm2m_context_t *ctx, uint8_t *outbuf, size_t outlen,
+             const char *value, size_t stringlen)
+{
+  return lwm2m_cbor_write_text(outbuf, outlen, value, stringlen);
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+write_float32fix(lwm2m_context_t *ctx, uint8_t *outbuf, size_t outlen,
+                 int32_t value, int bits)
+{
+  return lwm2m_cbor_write_float32fix(outbuf, outlen, value, bits);
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+write_boolean(lwm2m_context_t *ctx, uint8_t *outbuf, size_t outlen,
+              int value)
+{
+  return lwm2m_cbor_write_boolean(outbuf, outlen, value);
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+write_opaque_header(lwm2m_context_t *ctx, size_t payloadsize)
+{
+  return lwm2m_cbor_write_head(&ctx->outbuf->buffer[ctx->outbuf->len],
+                               ctx->outbuf->size - ctx->outbuf->len,
+                               LWM2M_CBOR_TYPE_BYTES, payloadsize);
+}
+/*---------------------------------------------------------------------------*/
+const lwm2m_writer_t lwm2m_cbor_writer = {
+  init_write,
+  end_write,
+  NULL, /* No support for sub resources here! */
+  NULL,
+  write_int,
+  write_string,
+  write_float32fix,
+  write_boolean,
+  write_opaque_header
+};
+/*---------------------------------------------------------------------------*/
+static size_t
+read_int(lwm2m_context_t *ctx, const uint8_t *inbuf, size_t len,
+         int32_t *value)
+{
+  lwm2m_cbor_t item;
+  size_t size;
+
+  size = lwm2m_cbor_read(&item, inbuf, len);
+  if(size == 0 || !lwm2m_cbor_get_int32(&item, value)) {
+    return 0;
+  }
+  ctx->last_value_len = size;
+  return size;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+read_string(lwm2m_context_t *ctx, const uint8_t *inbuf, size_t len,
+            uint8_t *value, size_t stringlen)
+{
+  lwm2m_cbor_t item;
+  size_t size;
+
+  size = lwm2m_cbor_read(&item, inbuf, len);
+  if(size == 0 || item.data == NULL) {
+    return 0;
+  }
+  if(stringlen <= item.value) {
+    /* The outbuffer can not contain the full string including ending zero */
+    return 0;
+  }
+  memcpy(value, item.data, (size_t)item.value);
+  value[item.value] = '\0';
+  ctx->last_value_len = (uint16_t)item.value;
+  return size;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+read_float32fix(lwm2m_context_t *ctx, const uint8_t *inbuf, size_t len,
+                int32_t *value, int bits)
+{
+  lwm2m_cbor_t item;
+  size_t size;
+
+  size = lwm2m_cbor_read(&item, inbuf, len);
+  if(size == 0 || !lwm2m_cbor_get_float32fix(&item, value, bits)) {
+    return 0;
+  }
+  ctx->last_value_len = size;
+  return size;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+read_boolean(lwm2m_context_t *ctx, const uint8_t *inbuf, size_t len,
+             int *value)
+{
+  lwm2m_cbor_t item;
+  size_t size;
+
+  size = lwm2m_cbor_read(&item, inbuf, len);
+  if(size == 0 || item.type != LWM2M_CBOR_TYPE_SIMPLE ||
+     (item.info != LWM2M_CBOR_FALSE && item.info != LWM2M_CBOR_TRUE)) {
+    return 0;
+  }
+  *value = item.info == LWM2M_CBOR_TRUE;
+  ctx->last_value_len = size;
+  return size;
+}
+/*---------------------------------------------------------------------------*/
+const lwm2m_reader_t lwm2m_cbor_reader = {
+  read_int,
+  read_string,
+  read_float32fix,
+  read_boolean
+};
+/*---------------------------------------------------------------------------*/
+/** @} */
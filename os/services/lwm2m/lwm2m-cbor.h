@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2019, RISE SICS AB.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \addtogroup lwm2m
+ * @{
+ */
+
+/**
+ * \file
+ *         Header file for the Contiki OMA LWM2M CBOR encoder, decoder and
+ *         the plain CBOR content format (a single resource value)
+ */
+
+#ifndef LWM2M_CBOR_H_
+#define LWM2M_CBOR_H_
+
+#include "lwm2m-object.h"
+#include <stdint.h>
+#include <stddef.h>
+
+/* CBOR major types (RFC 7049) */
+enum {
+  LWM2M_CBOR_TYPE_UINT   = 0,
+  LWM2M_CBOR_TYPE_NINT   = 1,
+  LWM2M_CBOR_TYPE_BYTES  = 2,
+  LWM2M_CBOR_TYPE_TEXT   = 3,
+  LWM2M_CBOR_TYPE_ARRAY  = 4,
+  LWM2M_CBOR_TYPE_MAP    = 5,
+  LWM2M_CBOR_TYPE_TAG    = 6,
+  LWM2M_CBOR_TYPE_SIMPLE = 7
+};
+
+/* Additional information values with a special meaning */
+#define LWM2M_CBOR_FALSE       20
+#define LWM2M_CBOR_TRUE        21
+#define LWM2M_CBOR_FLOAT16     25
+#define LWM2M_CBOR_FLOAT32     26
+#define LWM2M_CBOR_FLOAT64     27
+#define LWM2M_CBOR_INDEFINITE  31
+
+#define LWM2M_CBOR_BREAK       0xff
+
+/* A decoded CBOR data item head */
+typedef struct {
+  uint8_t type;         /* major type */
+  uint8_t info;         /* additional information */
+  uint64_t value;       /* integer, length, count or raw float bits */
+  const uint8_t *data;  /* contents of byte and text strings */
+} lwm2m_cbor_t;
+
+size_t lwm2m_cbor_write_head(uint8_t *outbuf, size_t outlen,
+                             uint8_t type, uint64_t value);
+size_t lwm2m_cbor_write_int(uint8_t *outbuf, size_t outlen, int32_t value);
+size_t lwm2m_cbor_write_text(uint8_t *outbuf, size_t outlen,
+                             const char *value, size_t len);
+size_t lwm2m_cbor_write_boolean(uint8_t *outbuf, size_t outlen, int value);
+size_t lwm2m_cbor_write_float32fix(uint8_t *outbuf, size_t outlen,
+                                   int32_t value, int bits);
+
+size_t lwm2m_cbor_read(lwm2m_cbor_t *item, const uint8_t *inbuf, size_t len);
+size_t lwm2m_cbor_skip(const uint8_t *inbuf, size_t len);
+int lwm2m_cbor_get_int32(const lwm2m_cbor_t *item, int32_t *value);
+int lwm2m_cbor_get_float32fix(const lwm2m_cbor_t *item, int32_t *value,
+                              int bits);
+
+extern const lwm2m_writer_t lwm2m_cbor_writer;
+extern const lwm2m_reader_t lwm2m_cbor_reader;
+
+#endif /* LWM2M_CBOR_H_ */
+/** @} */
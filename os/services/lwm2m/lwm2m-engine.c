@@ -47,6 +47,8 @@
 #include "lwm2m-device.h"
 #include "lwm2m-plain-text.h"
 #include "lwm2m-json.h"
+#include "lwm2m-cbor.h"
+#include "lwm2m-senml-cbor.h"
 #include "coap-constants.h"
 #include "coap-engine.h"
 #include "lwm2m-tlv.h"
@@ -81,6 +83,13 @@
 #endif /* LWM2M_ENGINE_CONF_USE_RD_CLIENT */
 
 
+/* Number of buckets in the object and instance tables (power of two) */
+#ifdef LWM2M_ENGINE_CONF_HASH_SIZE
+#define HASH_SIZE LWM2M_ENGINE_CONF_HASH_SIZE
+#else
+#define HASH_SIZE 16
+#endif /* LWM2M_ENGINE_CONF_HASH_SIZE */
+
 #if LWM2M_QUEUE_MODE_ENABLED
  /* Queue Mode is handled using the RD Client and the Q-Mode object */
 #define USE_RD_CLIENT 1
@@ -147,21 +156,77 @@ COAP_HANDLER(lwm2m_handler, lwm2m_handler_callback);
 LIST(object_list);
 LIST(generic_object_list);
 
+/*
+ * The lists keep the registration order for the RD list and for
+ * iteration. Instances are also chained in buckets keyed by object and
+ * instance ID, and generic objects in buckets keyed by object ID, so that
+ * requests are resolved without walking the lists.
+ */
+static lwm2m_object_instance_t *instance_table[HASH_SIZE];
+static lwm2m_object_t *object_table[HASH_SIZE];
+
+/* Position of the last resource looked up in its instance */
+static struct {
+  const lwm2m_object_instance_t *instance;
+  uint16_t resource_id;
+  uint16_t pos;
+} last_resource;
+
+/*---------------------------------------------------------------------------*/
+static lwm2m_object_instance_t **
+instance_bucket(uint16_t object_id, uint16_t instance_id)
+{
+  return &instance_table[(object_id + instance_id) & (HASH_SIZE - 1)];
+}
+/*---------------------------------------------------------------------------*/
+static lwm2m_object_t **
+object_bucket(uint16_t object_id)
+{
+  return &object_table[object_id & (HASH_SIZE - 1)];
+}
 /*---------------------------------------------------------------------------*/
 static lwm2m_object_t *
 get_object(uint16_t object_id)
 {
   lwm2m_object_t *object;
-  for(object = list_head(generic_object_list);
+  for(object = *object_bucket(object_id);
       object != NULL;
-      object = object->next) {
-    if(object->impl && object->impl->object_id == object_id) {
+      object = object->hash_next) {
+    if(object->impl->object_id == object_id) {
       return object;
     }
   }
   return NULL;
 }
 /*---------------------------------------------------------------------------*/
+/* Returns the position of resource rid in the instance, or -1 if none */
+static int
+get_resource_pos(const lwm2m_object_instance_t *instance, uint16_t rid)
+{
+  int i;
+
+  /* Notifications and repeated reads tend to hit the same resource */
+  if(last_resource.instance == instance &&
+     last_resource.resource_id == rid &&
+     last_resource.pos < instance->resource_count &&
+     RSC_ID(instance->resource_ids[last_resource.pos]) == rid) {
+    return last_resource.pos;
+  }
+
+  if(instance->resource_ids == NULL) {
+    return -1;
+  }
+  for(i = 0; i < instance->resource_count; i++) {
+    if(RSC_ID(instance->resource_ids[i]) == rid) {
+      last_resource.instance = instance;
+      last_resource.resource_id = rid;
+      last_resource.pos = i;
+      return i;
+    }
+  }
+  return -1;
+}
+/*---------------------------------------------------------------------------*/
 static int
 has_non_generic_object(uint16_t object_id)
 {
@@ -187,12 +252,21 @@ get_instance(uint16_t object_id, uint16_t instance_id, lwm2m_object_t **o)
     *o = NULL;
   }
 
-  for(instance = list_head(object_list);
-      instance != NULL;
-      instance = instance->next) {
-    if(instance->object_id == object_id) {
-      if(instance->instance_id == instance_id ||
-         instance_id == LWM2M_OBJECT_INSTANCE_NONE) {
+  if(instance_id != LWM2M_OBJECT_INSTANCE_NONE) {
+    for(instance = *instance_bucket(object_id, instance_id);
+        instance != NULL;
+        instance = instance->hash_next) {
+      if(instance->object_id == object_id &&
+         instance->instance_id == instance_id) {
+        return instance;
+      }
+    }
+  } else {
+    /* First registered instance of the object */
+    for(instance = list_head(object_list);
+        instance != NULL;
+        instance = instance->next) {
+      if(instance->object_id == object_id) {
         return instance;
       }
     }
@@ -285,7 +359,7 @@ get_method_as_string(coap_resource_flags_t method)
 static const char *
 get_status_as_string(lwm2m_status_t status)
 {
-  static char buffer[8];
+  static char buffer[14];
   switch(status) {
   case LWM2M_STATUS_OK:
     return "OK";
@@ -508,6 +582,9 @@ lwm2m_engine_init(void)
 {
   list_init(object_list);
   list_init(generic_object_list);
+  memset(instance_table, 0, sizeof(instance_table));
+  memset(object_table, 0, sizeof(object_table));
+  last_resource.instance = NULL;
 
 #ifdef LWM2M_ENGINE_CLIENT_ENDPOINT_NAME
   const char *endpoint = LWM2M_ENGINE_CLIENT_ENDPOINT_NAME;
@@ -598,6 +675,12 @@ lwm2m_engine_select_writer(lwm2m_context_t *context, unsigned int accept)
     case APPLICATION_JSON:
       context->writer = &lwm2m_json_writer;
       break;
+    case LWM2M_SENML_CBOR:
+      context->writer = &lwm2m_senml_cbor_writer;
+      break;
+    case LWM2M_CBOR:
+      context->writer = &lwm2m_cbor_writer;
+      break;
     default:
       LOG_WARN("Unknown Accept type %u, using LWM2M plain text\n", accept);
       context->writer = &lwm2m_plain_text_writer;
@@ -627,6 +710,11 @@ lwm2m_engine_select_reader(lwm2m_context_t *context, unsigned int content_format
     case LWM2M_OLD_JSON:
       context->reader = &lwm2m_plain_text_reader;
       break;
+    case LWM2M_SENML_CBOR:
+    case LWM2M_CBOR:
+      /* SenML values are plain CBOR data items */
+      context->reader = &lwm2m_cbor_reader;
+      break;
     case LWM2M_TEXT_PLAIN:
     case TEXT_PLAIN:
       context->reader = &lwm2m_plain_text_reader;
@@ -665,6 +753,7 @@ perform_multi_resource_read_op(lwm2m_object_t *object,
   if(ctx->level < 3 &&
      (ctx->content_type == LWM2M_TEXT_PLAIN ||
       ctx->content_type == TEXT_PLAIN ||
+      ctx->content_type == LWM2M_CBOR ||
       ctx->content_type == LWM2M_OLD_OPAQUE)) {
     return LWM2M_STATUS_OPERATION_NOT_ALLOWED;
   }
@@ -696,6 +785,13 @@ perform_multi_resource_read_op(lwm2m_object_t *object,
     last_instance_id =
       ((uint32_t)instance->object_id << 16) | instance->instance_id;
     last_rsc_pos = 0;
+    if(ctx->level == 3) {
+      /* Single resource - go straight to it */
+      last_rsc_pos = get_resource_pos(instance, ctx->resource_id);
+      if(last_rsc_pos < 0) {
+        last_rsc_pos = instance->resource_count;
+      }
+    }
     /* reset any callback */
     current_opaque_callback = NULL;
     /* reset lwm2m_buf_len - so that we can use the double-size buffer */
@@ -854,7 +950,12 @@ perform_multi_resource_read_op(lwm2m_object_t *object,
         }
         if(current_opaque_callback == NULL) {
           /* This resource is now done - (only when the opaque is also done) */
-          last_rsc_pos++;
+          if(ctx->level < 3) {
+            last_rsc_pos++;
+          } else {
+            /* There is only the one resource to read */
+            last_rsc_pos = instance->resource_count;
+          }
         } else {
           LOG_DBG("Opaque is set - continue with that.\n");
         }
@@ -982,25 +1083,20 @@ static int
 check_write(lwm2m_context_t *ctx, lwm2m_object_instance_t *instance, int rid)
 {
   int i;
-  if(instance->resource_ids != NULL && instance->resource_count > 0) {
-    int count = instance->resource_count;
-    for(i = 0; i < count; i++) {
-      if(RSC_ID(instance->resource_ids[i]) == rid) {
-        if(RSC_WRITABLE(instance->resource_ids[i])) {
-          /* yes - writable */
-          return 1;
-        }
-        if(RSC_UNSPECIFIED(instance->resource_ids[i]) &&
-           created.instance_id == instance->instance_id &&
-           created.object_id == instance->object_id &&
-           created.token_len == ctx->request->token_len &&
-           memcmp(&created.token, ctx->request->token,
-                  created.token_len) == 0) {
-          /* yes - writeable at create - never otherwise - sec / srv */
-          return 1;
-        }
-        break;
-      }
+  i = get_resource_pos(instance, rid);
+  if(i >= 0) {
+    if(RSC_WRITABLE(instance->resource_ids[i])) {
+      /* yes - writable */
+      return 1;
+    }
+    if(RSC_UNSPECIFIED(instance->resource_ids[i]) &&
+       created.instance_id == instance->instance_id &&
+       created.object_id == instance->object_id &&
+       created.token_len == ctx->request->token_len &&
+       memcmp(&created.token, ctx->request->token,
+              created.token_len) == 0) {
+      /* yes - writeable at create - never otherwise - sec / srv */
+      return 1;
     }
   }
   /* Resource did not exist... - Ignore to avoid problems. */
@@ -1047,7 +1143,7 @@ perform_multi_resource_write_op(lwm2m_object_t *object,
                                 lwm2m_object_instance_t *instance,
                                 lwm2m_context_t *ctx, int format)
 {
-  /* Only for JSON and TLV formats */
+  /* Only for JSON, SenML CBOR and TLV formats */
   uint16_t oid = 0, iid = 0, rid = 0;
   uint8_t olv = 0;
   uint8_t mode = 0;
@@ -1189,8 +1285,54 @@ perform_multi_resource_write_op(lwm2m_object_t *object,
       }
       tlvpos += len;
     }
+  } else if(format == LWM2M_SENML_CBOR) {
+    struct senml_cbor_record record;
+    char path[32];
+    int len;
+    lwm2m_status_t status;
+
+    memset(&record, 0, sizeof(record));
+    while(lwm2m_senml_cbor_next_record(ctx, &record)) {
+      if(record.value == NULL) {
+        /* No value to write */
+        continue;
+      }
+      if(record.base_name_len + record.name_len >= sizeof(path)) {
+        return LWM2M_STATUS_ERROR;
+      }
+      len = 0;
+      if(record.base_name_len > 0) {
+        memcpy(path, record.base_name, record.base_name_len);
+        len = record.base_name_len;
+      }
+      if(record.name_len > 0) {
+        memcpy(&path[len], record.name, record.name_len);
+        len += record.name_len;
+      }
+      /* Names are absolute paths */
+      i = len > 0 && path[0] == '/' ? 1 : 0;
+      if(parse_path(&path[i], len - i, &oid, &iid, &rid) < 3 ||
+         oid != ctx->object_id) {
+        return LWM2M_STATUS_ERROR;
+      }
+      LOG_DBG("SenML: %u/%u/%u (%u bytes)\n", oid, iid, rid,
+              record.value_len);
+
+      inpos = ctx->inbuf->pos;
+      ctx->object_instance_id = iid;
+      status = process_tlv_write(ctx, object, rid, (uint8_t *)record.value,
+                                 record.value_len);
+      ctx->inbuf->buffer = inbuf;
+      ctx->inbuf->pos = inpos;
+      ctx->inbuf->size = insize;
+      ctx->level = olv;
+      if(status != LWM2M_STATUS_OK) {
+        return status;
+      }
+    }
   } else if(format == LWM2M_TEXT_PLAIN ||
             format == TEXT_PLAIN ||
+            format == LWM2M_CBOR ||
             format == LWM2M_OLD_OPAQUE) {
     return call_instance(instance, ctx);
 
@@ -1215,10 +1357,33 @@ lwm2m_engine_has_instance(uint16_t object_id, uint16_t instance_id)
   return get_instance(object_id, instance_id, NULL) != NULL;
 }
 /*---------------------------------------------------------------------------*/
+lwm2m_status_t
+lwm2m_engine_read_resource(lwm2m_context_t *ctx)
+{
+  lwm2m_object_instance_t *instance;
+  int pos;
+
+  instance = get_instance(ctx->object_id, ctx->object_instance_id, NULL);
+  if(instance == NULL) {
+    return LWM2M_STATUS_NOT_FOUND;
+  }
+  pos = get_resource_pos(instance, ctx->resource_id);
+  if(pos < 0) {
+    return LWM2M_STATUS_NOT_FOUND;
+  }
+  if(!RSC_READABLE(instance->resource_ids[pos])) {
+    return LWM2M_STATUS_OPERATION_NOT_ALLOWED;
+  }
+  ctx->operation = LWM2M_OP_READ;
+  ctx->level = 3;
+  return call_instance(instance, ctx);
+}
+/*---------------------------------------------------------------------------*/
 int
 lwm2m_engine_add_object(lwm2m_object_instance_t *object)
 {
   lwm2m_object_instance_t *instance;
+  lwm2m_object_instance_t **bucket;
   uint16_t min_id = 0xffff;
   uint16_t max_id = 0;
   int found = 0;
@@ -1266,6 +1431,9 @@ lwm2m_engine_add_object(lwm2m_object_instance_t *object)
     }
   }
   list_add(object_list, object);
+  bucket = instance_bucket(object->object_id, object->instance_id);
+  object->hash_next = *bucket;
+  *bucket = object;
 #if USE_RD_CLIENT
   lwm2m_rd_client_set_update_rd();
 #endif
@@ -1275,6 +1443,15 @@ lwm2m_engine_add_object(lwm2m_object_instance_t *object)
 void
 lwm2m_engine_remove_object(lwm2m_object_instance_t *object)
 {
+  lwm2m_object_instance_t **prev;
+
+  for(prev = instance_bucket(object->object_id, object->instance_id);
+      *prev != NULL; prev = &(*prev)->hash_next) {
+    if(*prev == object) {
+      *prev = object->hash_next;
+      break;
+    }
+  }
   list_remove(object_list, object);
 #if USE_RD_CLIENT
   lwm2m_rd_client_set_update_rd();
@@ -1304,6 +1481,8 @@ lwm2m_engine_add_generic_object(lwm2m_object_t *object)
     return 0;
   }
   list_add(generic_object_list, object);
+  object->hash_next = *object_bucket(object->impl->object_id);
+  *object_bucket(object->impl->object_id) = object;
 
 #if USE_RD_CLIENT
   lwm2m_rd_client_set_update_rd();
@@ -1315,6 +1494,15 @@ lwm2m_engine_add_generic_object(lwm2m_object_t *object)
 void
 lwm2m_engine_remove_generic_object(lwm2m_object_t *object)
 {
+  lwm2m_object_t **prev;
+
+  for(prev = object_bucket(object->impl->object_id);
+      *prev != NULL; prev = &(*prev)->hash_next) {
+    if(*prev == object) {
+      *prev = object->hash_next;
+      break;
+    }
+  }
   list_remove(generic_object_list, object);
 #if USE_RD_CLIENT
   lwm2m_rd_client_set_update_rd();
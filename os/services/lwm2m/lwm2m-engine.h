@@ -54,6 +54,8 @@
 /* LWM2M / CoAP Content-Formats */
 typedef enum {
   LWM2M_TEXT_PLAIN = 1541,
+  LWM2M_CBOR       = 60,
+  LWM2M_SENML_CBOR = 112,
   LWM2M_TLV        = 11542,
   LWM2M_JSON       = 11543,
   LWM2M_OLD_TLV    = 1542,
@@ -76,6 +78,8 @@ typedef int
 
 struct lwm2m_object_instance {
   lwm2m_object_instance_t *next;
+  /* next instance in the same bucket of the engine's instance table */
+  lwm2m_object_instance_t *hash_next;
   uint16_t object_id;
   uint16_t instance_id;
   /* an array of resource IDs for discovery, etc */
@@ -101,12 +105,17 @@ typedef struct {
 typedef struct lwm2m_object lwm2m_object_t;
 struct lwm2m_object {
   lwm2m_object_t *next;
+  /* next object in the same bucket of the engine's object table */
+  lwm2m_object_t *hash_next;
   const lwm2m_object_impl_t *impl;
 };
 
 lwm2m_object_instance_t *lwm2m_engine_get_instance_buffer(void);
 
 int  lwm2m_engine_has_instance(uint16_t object_id, uint16_t instance_id);
+/* Read the resource addressed by ctx into ctx->outbuf with ctx->writer,
+   for payloads that are not a response to a request */
+lwm2m_status_t lwm2m_engine_read_resource(lwm2m_context_t *ctx);
 int  lwm2m_engine_add_object(lwm2m_object_instance_t *object);
 void lwm2m_engine_remove_object(lwm2m_object_instance_t *object);
 int  lwm2m_engine_add_generic_object(lwm2m_object_t *object);
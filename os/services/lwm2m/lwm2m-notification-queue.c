@@ -47,7 +47,11 @@
 
 #include "lwm2m-queue-mode.h"
 #include "lwm2m-engine.h"
+#include "lwm2m-rd-client.h"
+#include "lwm2m-senml-cbor.h"
+#include "lwm2m-device.h"
 #include "coap-engine.h"
+#include "coap-callback-api.h"
 #include "lib/memb.h"
 #include "lib/list.h"
 #include <string.h>
@@ -66,15 +70,34 @@
 #define LWM2M_NOTIFICATION_QUEUE_LENGTH COAP_MAX_OBSERVERS
 #endif
 
+/* Number of buckets for the duplicate check (power of two) */
+#ifdef LWM2M_NOTIFICATION_QUEUE_CONF_HASH_SIZE
+#define LWM2M_NOTIFICATION_QUEUE_HASH_SIZE LWM2M_NOTIFICATION_QUEUE_CONF_HASH_SIZE
+#else
+#define LWM2M_NOTIFICATION_QUEUE_HASH_SIZE 8
+#endif
+
 /*---------------------------------------------------------------------------*/
 /* Queue to store the notifications in the period when the client has woken up, sent the update and it's waiting for the server response*/
 MEMB(notification_memb, notification_path_t, LWM2M_NOTIFICATION_QUEUE_LENGTH); /* Length + 1 to allocate the new path to add */
 LIST(notification_paths_queue);
+/* The queued paths are also chained in buckets keyed by the path */
+static notification_path_t *notification_path_table[LWM2M_NOTIFICATION_QUEUE_HASH_SIZE];
+
+#if LWM2M_QUEUE_MODE_SEND_PACK
+static coap_callback_request_state_t pack_request_state;
+static coap_message_t pack_request[1];
+static uint8_t pack_buffer[COAP_MAX_CHUNK_SIZE];
+static uint8_t pack_in_flight;
+/* Set when the server does not support the Send operation */
+static uint8_t pack_unsupported;
+#endif /* LWM2M_QUEUE_MODE_SEND_PACK */
 /*---------------------------------------------------------------------------*/
 void
 lwm2m_notification_queue_init(void)
 {
   list_init(notification_paths_queue);
+  memset(notification_path_table, 0, sizeof(notification_path_table));
 }
 /*---------------------------------------------------------------------------*/
 static void
@@ -93,23 +116,42 @@ extend_path(notification_path_t *path_object, char *path, int path_size)
   }
 }
 /*---------------------------------------------------------------------------*/
-static int
-is_notification_path_present(uint16_t object_id, uint16_t instance_id, uint16_t resource_id)
+static notification_path_t **
+notification_path_bucket(uint16_t object_id, uint16_t instance_id, uint16_t resource_id)
 {
-  notification_path_t *iteration_path = (notification_path_t *)list_head(notification_paths_queue);
-  while(iteration_path != NULL) {
+  return &notification_path_table[(object_id + instance_id * 7 + resource_id * 31) &
+                                  (LWM2M_NOTIFICATION_QUEUE_HASH_SIZE - 1)];
+}
+/*---------------------------------------------------------------------------*/
+static notification_path_t *
+get_notification_path(uint16_t object_id, uint16_t instance_id, uint16_t resource_id)
+{
+  notification_path_t *iteration_path;
+
+  for(iteration_path = *notification_path_bucket(object_id, instance_id, resource_id);
+      iteration_path != NULL;
+      iteration_path = iteration_path->hash_next) {
     if(iteration_path->reduced_path[0] == object_id && iteration_path->reduced_path[1] == instance_id
        && iteration_path->reduced_path[2] == resource_id) {
-      return 1;
+      return iteration_path;
     }
-    iteration_path = iteration_path->next;
   }
-  return 0;
+  return NULL;
 }
 /*---------------------------------------------------------------------------*/
 static void
 remove_notification_path(notification_path_t *path)
 {
+  notification_path_t **prev;
+
+  for(prev = notification_path_bucket(path->reduced_path[0], path->reduced_path[1],
+                                      path->reduced_path[2]);
+      *prev != NULL; prev = &(*prev)->hash_next) {
+    if(*prev == path) {
+      *prev = path->hash_next;
+      break;
+    }
+  }
   list_remove(notification_paths_queue, path);
   memb_free(&notification_memb, path);
 }
@@ -117,11 +159,17 @@ remove_notification_path(notification_path_t *path)
 void
 lwm2m_notification_queue_add_notification_path(uint16_t object_id, uint16_t instance_id, uint16_t resource_id)
 {
-  if(is_notification_path_present(object_id, instance_id, resource_id)) {
+  notification_path_t **bucket;
+  notification_path_t *path_object;
+
+  path_object = get_notification_path(object_id, instance_id, resource_id);
+  if(path_object != NULL) {
+    /* A value sent in a pack is outdated now, keep the path queued */
+    path_object->in_pack = 0;
     LOG_DBG("Notification path already present, not queueing it\n");
     return;
   }
-  notification_path_t *path_object = memb_alloc(&notification_memb);
+  path_object = memb_alloc(&notification_memb);
   if(path_object == NULL) {
     LOG_DBG("Queue is full, could not allocate new notification\n");
     return;
@@ -130,29 +178,193 @@ lwm2m_notification_queue_add_notification_path(uint16_t object_id, uint16_t inst
   path_object->reduced_path[1] = instance_id;
   path_object->reduced_path[2] = resource_id;
   path_object->level = 3;
+  path_object->in_pack = 0;
   list_add(notification_paths_queue, path_object);
+  bucket = notification_path_bucket(object_id, instance_id, resource_id);
+  path_object->hash_next = *bucket;
+  *bucket = path_object;
   LOG_DBG("Notification path added to the list: %u/%u/%u\n", object_id, instance_id, resource_id);
 }
 /*---------------------------------------------------------------------------*/
-void
-lwm2m_notification_queue_send_notifications()
+static void
+send_notification(notification_path_t *path_object)
 {
   char path[20];
-  notification_path_t *iteration_path = (notification_path_t *)list_head(notification_paths_queue);
-  notification_path_t *aux = iteration_path;
 
-  while(iteration_path != NULL) {
-    extend_path(iteration_path, path, sizeof(path));
+  extend_path(path_object, path, sizeof(path));
 #if LWM2M_QUEUE_MODE_INCLUDE_DYNAMIC_ADAPTATION
-    if(lwm2m_queue_mode_get_dynamic_adaptation_flag()) {
-      lwm2m_queue_mode_set_handler_from_notification();
+  if(lwm2m_queue_mode_get_dynamic_adaptation_flag()) {
+    lwm2m_queue_mode_set_handler_from_notification();
+  }
+#endif
+  LOG_DBG("Sending stored notification with path: %s\n", path);
+  coap_notify_observers_sub(NULL, path);
+}
+/*---------------------------------------------------------------------------*/
+#if LWM2M_QUEUE_MODE_SEND_PACK
+static void
+pack_callback(coap_callback_request_state_t *callback_state)
+{
+  coap_request_state_t *state = &callback_state->state;
+  notification_path_t *iteration_path;
+  notification_path_t *aux;
+  uint8_t delivered;
+
+  if(state->status == COAP_REQUEST_STATUS_MORE || !pack_in_flight) {
+    /* Wait for the last block, or the pack has been handled already */
+    return;
+  }
+  pack_in_flight = 0;
+
+  if(state->status == COAP_REQUEST_STATUS_RESPONSE) {
+    delivered = state->response->code < BAD_REQUEST_4_00;
+    if(!delivered) {
+      LOG_WARN("Send failed with code %d, using notifications\n",
+               state->response->code);
+      pack_unsupported = 1;
+    }
+  } else {
+    /* Timeout, block error, or finished without a response */
+    LOG_WARN("Send failed with status %d, using notifications\n",
+             state->status);
+    delivered = 0;
+  }
+
+  iteration_path = (notification_path_t *)list_head(notification_paths_queue);
+  while(iteration_path != NULL) {
+    aux = iteration_path;
+    iteration_path = iteration_path->next;
+    if(aux->in_pack) {
+      if(!delivered) {
+        send_notification(aux);
+      }
+      remove_notification_path(aux);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Writes the queued resources into one SenML CBOR pack and sends it to the
+ * server. Resources that do not fit are left in the queue.
+ */
+static void
+send_pack(void)
+{
+  lwm2m_context_t context;
+  lwm2m_buffer_t outbuf;
+  notification_path_t *iteration_path;
+  notification_path_t *last_path = NULL;
+  uint16_t mark;
+  uint8_t flags;
+  int32_t now;
+  int count = 0;
+
+  memset(&context, 0, sizeof(context));
+  memset(&outbuf, 0, sizeof(outbuf));
+  outbuf.buffer = pack_buffer;
+  /* Leave room for the end of the pack */
+  outbuf.size = sizeof(pack_buffer) - 1;
+  context.outbuf = &outbuf;
+  context.writer = &lwm2m_senml_cbor_writer;
+  context.content_type = LWM2M_SENML_CBOR;
+  /* The values are read now; the time is only known once a server set it */
+  now = lwm2m_device_get_time();
+  if(now >= LWM2M_SENML_MIN_ABSOLUTE_TIME) {
+    context.timestamp = now;
+  }
+  outbuf.len += context.writer->init_write(&context);
+
+  for(iteration_path = (notification_path_t *)list_head(notification_paths_queue);
+      iteration_path != NULL;
+      iteration_path = iteration_path->next) {
+    mark = outbuf.len;
+    flags = context.writer_flags;
+    if(last_path == NULL ||
+       last_path->reduced_path[0] != iteration_path->reduced_path[0] ||
+       last_path->reduced_path[1] != iteration_path->reduced_path[1]) {
+      /* A new instance - repeat the base name */
+      context.writer_flags &= ~WRITER_OUTPUT_VALUE;
+    }
+    context.object_id = iteration_path->reduced_path[0];
+    context.object_instance_id = iteration_path->reduced_path[1];
+    context.resource_id = iteration_path->reduced_path[2];
+    if(lwm2m_engine_read_resource(&context) != LWM2M_STATUS_OK ||
+       outbuf.len == mark || outbuf.len >= outbuf.size) {
+      /* Did not fit - notify the observers of this resource instead */
+      LOG_DBG("Could not pack %u/%u/%u\n", context.object_id,
+              context.object_instance_id, context.resource_id);
+      outbuf.len = mark;
+      context.writer_flags = flags;
+      continue;
     }
+    iteration_path->in_pack = 1;
+    last_path = iteration_path;
+    count++;
+    /* The base time holds for all the following records */
+    context.timestamp = 0;
+  }
+
+  if(count == 0) {
+    return;
+  }
+  outbuf.size = sizeof(pack_buffer);
+  outbuf.len += context.writer->end_write(&context);
+
+  coap_init_message(pack_request, COAP_TYPE_CON, COAP_POST, 0);
+  coap_set_header_uri_path(pack_request, "dp");
+  coap_set_header_content_format(pack_request, LWM2M_SENML_CBOR);
+  coap_set_payload(pack_request, pack_buffer, outbuf.len);
+
+#if LWM2M_QUEUE_MODE_INCLUDE_DYNAMIC_ADAPTATION
+  if(lwm2m_queue_mode_get_dynamic_adaptation_flag()) {
+    lwm2m_queue_mode_set_handler_from_notification();
+  }
 #endif
-    LOG_DBG("Sending stored notification with path: %s\n", path);
-    coap_notify_observers_sub(NULL, path);
+  LOG_DBG("Sending %d stored notifications in one pack (%u bytes)\n",
+          count, outbuf.len);
+  /* The response may arrive before coap_send_request() returns */
+  pack_in_flight = 1;
+  if(!coap_send_request(&pack_request_state, lwm2m_rd_client_get_server_endpoint(),
+                        pack_request, pack_callback)) {
+    pack_in_flight = 0;
+    for(iteration_path = (notification_path_t *)list_head(notification_paths_queue);
+        iteration_path != NULL;
+        iteration_path = iteration_path->next) {
+      iteration_path->in_pack = 0;
+    }
+  }
+}
+#endif /* LWM2M_QUEUE_MODE_SEND_PACK */
+/*---------------------------------------------------------------------------*/
+void
+lwm2m_notification_queue_registered(void)
+{
+#if LWM2M_QUEUE_MODE_SEND_PACK
+  /* The server may support Send now */
+  pack_unsupported = 0;
+#endif /* LWM2M_QUEUE_MODE_SEND_PACK */
+}
+/*---------------------------------------------------------------------------*/
+void
+lwm2m_notification_queue_send_notifications()
+{
+  notification_path_t *iteration_path;
+  notification_path_t *aux;
+
+#if LWM2M_QUEUE_MODE_SEND_PACK
+  if(!pack_unsupported && !pack_in_flight) {
+    send_pack();
+  }
+#endif /* LWM2M_QUEUE_MODE_SEND_PACK */
+
+  iteration_path = (notification_path_t *)list_head(notification_paths_queue);
+  while(iteration_path != NULL) {
     aux = iteration_path;
     iteration_path = iteration_path->next;
-    remove_notification_path(aux);
+    if(!aux->in_pack) {
+      send_notification(aux);
+      remove_notification_path(aux);
+    }
   }
 }
 #endif /* LWM2M_QUEUE_MODE_ENABLED */
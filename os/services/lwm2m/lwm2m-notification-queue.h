@@ -51,8 +51,10 @@
 
 typedef struct notification_path {
   struct notification_path *next;
+  struct notification_path *hash_next; /* next path in the same bucket */
   uint16_t reduced_path[3];
   uint8_t level; /* The depth level of the path: 1. object, 2. object/instance, 3. object/instance/resource */
+  uint8_t in_pack; /* sent in a pack that is waiting for the server response */
 } notification_path_t;
 
 void lwm2m_notification_queue_init(void);
@@ -61,5 +63,8 @@ void lwm2m_notification_queue_add_notification_path(uint16_t object_id, uint16_t
 
 void lwm2m_notification_queue_send_notifications();
 
+/* Called on each (re-)registration with a server */
+void lwm2m_notification_queue_registered(void);
+
 #endif /* LWM2M_NOTIFICATION_QUEUE_H */
 /** @} */
\ No newline at end of file
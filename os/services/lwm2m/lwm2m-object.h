@@ -158,6 +158,8 @@ typedef struct lwm2m_context {
   uint16_t last_value_len;
 
   uint8_t writer_flags; /* flags for reader/writer */
+  /* Time of the values written, in seconds since the epoch, or 0 if unknown */
+  int32_t timestamp;
   const lwm2m_reader_t *reader;
   const lwm2m_writer_t *writer;
 } lwm2m_context_t;
@@ -80,6 +80,15 @@
 #define LWM2M_QUEUE_MODE_DEFAULT_DYNAMIC_ADAPTATION_FLAG 0 /* disabled */
 #endif /* LWM2M_QUEUE_MODE_DEFAULT_DYNAMIC_ADAPTATION_FLAG */
 
+/* Report the queued notifications in one SenML CBOR pack with the LWM2M
+   Send operation (POST /dp) instead of one notification per observer. The
+   server must support Send. */
+#ifdef LWM2M_QUEUE_MODE_CONF_SEND_PACK
+#define LWM2M_QUEUE_MODE_SEND_PACK LWM2M_QUEUE_MODE_CONF_SEND_PACK
+#else
+#define LWM2M_QUEUE_MODE_SEND_PACK 0 /* disabled */
+#endif /* LWM2M_QUEUE_MODE_CONF_SEND_PACK */
+
 /* Length of the list of times for the dynamic adaptation */
 #define LWM2M_QUEUE_MODE_DYNAMIC_ADAPTATION_WINDOW_LENGTH 10
 
@@ -203,6 +203,12 @@ lwm2m_rd_client_is_registered(void)
   return rd_state == REGISTRATION_DONE || rd_state == UPDATE_SENT;
 }
 /*---------------------------------------------------------------------------*/
+coap_endpoint_t *
+lwm2m_rd_client_get_server_endpoint(void)
+{
+  return &session_info.server_ep;
+}
+/*---------------------------------------------------------------------------*/
 void
 lwm2m_rd_client_use_bootstrap_server(int use)
 {
@@ -449,6 +455,7 @@ registration_callback(coap_callback_request_state_t *callback_state)
         session_info.assigned_ep[state->response->location_path_len] = 0;
         /* if we decide to not pass the lt-argument on registration, we should force an initial "update" to register lifetime with server */
 #if LWM2M_QUEUE_MODE_ENABLED
+        lwm2m_notification_queue_registered();
 #if LWM2M_QUEUE_MODE_INCLUDE_DYNAMIC_ADAPTATION
         if(lwm2m_queue_mode_get_dynamic_adaptation_flag()) {
           lwm2m_queue_mode_set_first_request();
@@ -59,6 +59,7 @@ struct lwm2m_session_info;
 typedef void (*session_callback_t)(struct lwm2m_session_info *session, int status);
 
 int  lwm2m_rd_client_is_registered(void);
+coap_endpoint_t *lwm2m_rd_client_get_server_endpoint(void);
 void lwm2m_rd_client_use_bootstrap_server(int use);
 void lwm2m_rd_client_use_registration_server(int use);
 void lwm2m_rd_client_register_with_server(const coap_endpoint_t *server);
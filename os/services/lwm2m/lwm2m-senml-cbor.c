@@ -0,0 +1,391 @@
+/*
+ * Copyright (c) 2019, RISE SICS AB.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \addtogroup lwm2m
+ * @{
+ */
+
+/**
+ * \file
+ *         Implementation of the Contiki OMA LWM2M SenML CBOR writer and reader
+ */
+
+#include "lwm2m-object.h"
+#include "lwm2m-cbor.h"
+#include "lwm2m-senml-cbor.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Log configuration */
+#include "coap-log.h"
+#define LOG_MODULE "lwm2m-senml"
+#define LOG_LEVEL  LOG_LEVEL_NONE
+/*---------------------------------------------------------------------------*/
+
+/* [{-2:"/3303/0/",0:"5700",2:22.5},{0:"5701",3:"Cel"}] */
+
+/*
+ * Read the next record from the SenML pack in the input buffer. The base
+ * name and base time are only updated when the record has them. Returns
+ * zero at the end of the pack or on malformed input.
+ */
+int
+lwm2m_senml_cbor_next_record(lwm2m_context_t *ctx,
+                             struct senml_cbor_record *record)
+{
+  const uint8_t *inbuf = ctx->inbuf->buffer;
+  size_t pos = ctx->inbuf->pos;
+  size_t size = ctx->inbuf->size;
+  lwm2m_cbor_t item;
+  lwm2m_cbor_t key;
+  uint64_t count;
+  uint8_t indefinite;
+  size_t s;
+  int32_t label;
+  int32_t time;
+
+  if(pos == 0) {
+    /* Start of the pack */
+    s = lwm2m_cbor_read(&item, inbuf, size);
+    if(s == 0 || item.type != LWM2M_CBOR_TYPE_ARRAY) {
+      LOG_DBG("not a SenML pack\n");
+      return 0;
+    }
+    pos += s;
+  }
+  if(pos >= size || inbuf[pos] == LWM2M_CBOR_BREAK) {
+    return 0;
+  }
+
+  s = lwm2m_cbor_read(&item, &inbuf[pos], size - pos);
+  if(s == 0 || item.type != LWM2M_CBOR_TYPE_MAP) {
+    return 0;
+  }
+  pos += s;
+  count = item.value;
+  indefinite = item.info == LWM2M_CBOR_INDEFINITE;
+
+  record->name = NULL;
+  record->name_len = 0;
+  record->value = NULL;
+  record->value_len = 0;
+  record->time = 0;
+
+  while(indefinite || count > 0) {
+    if(pos >= size) {
+      return 0;
+    }
+    if(indefinite && inbuf[pos] == LWM2M_CBOR_BREAK) {
+      pos++;
+      break;
+    }
+    count--;
+
+    s = lwm2m_cbor_read(&key, &inbuf[pos], size - pos);
+    if(s == 0 || pos + s >= size) {
+      return 0;
+    }
+    pos += s;
+    if(!lwm2m_cbor_get_int32(&key, &label)) {
+      /* Text labels are not used by LWM2M - skip the value */
+      label = LWM2M_SENML_CBOR_BASE_NAME - 1;
+    }
+
+    if(label == LWM2M_SENML_CBOR_BASE_NAME || label == LWM2M_SENML_CBOR_NAME) {
+      s = lwm2m_cbor_read(&item, &inbuf[pos], size - pos);
+      if(s == 0 || item.type != LWM2M_CBOR_TYPE_TEXT || item.value > 0xff) {
+        return 0;
+      }
+      if(label == LWM2M_SENML_CBOR_BASE_NAME) {
+        record->base_name = item.data;
+        record->base_name_len = item.value;
+      } else {
+        record->name = item.data;
+        record->name_len = item.value;
+      }
+    } else if(label == LWM2M_SENML_CBOR_BASE_TIME ||
+              label == LWM2M_SENML_CBOR_TIME) {
+      s = lwm2m_cbor_skip(&inbuf[pos], size - pos);
+      if(s == 0) {
+        return 0;
+      }
+      /* Only integer times are decoded, others are ignored */
+      if(lwm2m_cbor_read(&item, &inbuf[pos], s) == s &&
+         lwm2m_cbor_get_int32(&item, &time)) {
+        if(label == LWM2M_SENML_CBOR_TIME) {
+          record->time = time;
+        } else {
+          record->base_time = time;
+        }
+      }
+    } else {
+      s = lwm2m_cbor_skip(&inbuf[pos], size - pos);
+      if(s == 0) {
+        return 0;
+      }
+      if(label == LWM2M_SENML_CBOR_VALUE ||
+         label == LWM2M_SENML_CBOR_STRING_VALUE ||
+         label == LWM2M_SENML_CBOR_BOOLEAN_VALUE ||
+         label == LWM2M_SENML_CBOR_DATA_VALUE) {
+        record->value = &inbuf[pos];
+        record->value_len = s;
+      }
+    }
+    pos += s;
+  }
+
+  ctx->inbuf->pos = pos;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Write a label followed by a text string */
+static size_t
+write_text_label(uint8_t *outbuf, size_t outlen, int label,
+                 const char *value, int len)
+{
+  size_t s;
+  size_t t;
+
+  s = lwm2m_cbor_write_int(outbuf, outlen, label);
+  if(s == 0 || len < 0 ||
+     (t = lwm2m_cbor_write_text(&outbuf[s], outlen - s, value, len)) == 0) {
+    return 0;
+  }
+  return s + t;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Write the start of a record - a map with the name, the base name and,
+ * when the time of the values is known, the base time if this is the
+ * first record, and the label of the value that follows. All values are
+ * read at the same time, so records have no time of their own.
+ */
+static size_t
+write_record_head(lwm2m_context_t *ctx, uint8_t *outbuf, size_t outlen,
+                  int label)
+{
+  char name[16];
+  size_t len;
+  size_t s;
+  int first;
+  int n;
+
+  first = !(ctx->writer_flags & WRITER_OUTPUT_VALUE);
+  len = lwm2m_cbor_write_head(outbuf, outlen, LWM2M_CBOR_TYPE_MAP,
+                              !first ? 2 : ctx->timestamp != 0 ? 4 : 3);
+  if(len == 0) {
+    return 0;
+  }
+
+  if(first && ctx->timestamp != 0) {
+    s = lwm2m_cbor_write_int(&outbuf[len], outlen - len,
+                             LWM2M_SENML_CBOR_BASE_TIME);
+    if(s == 0) {
+      return 0;
+    }
+    len += s;
+    s = lwm2m_cbor_write_int(&outbuf[len], outlen - len, ctx->timestamp);
+    if(s == 0) {
+      return 0;
+    }
+    len += s;
+  }
+
+  if(first) {
+    n = snprintf(name, sizeof(name), "/%u/%u/",
+                 ctx->object_id, ctx->object_instance_id);
+    s = write_text_label(&outbuf[len], outlen - len,
+                         LWM2M_SENML_CBOR_BASE_NAME, name, n);
+    if(s == 0) {
+      return 0;
+    }
+    len += s;
+  }
+
+  if(ctx->writer_flags & WRITER_RESOURCE_INSTANCE) {
+    n = snprintf(name, sizeof(name), "%u/%u",
+                 ctx->resource_id, ctx->resource_instance_id);
+  } else {
+    n = snprintf(name, sizeof(name), "%u", ctx->resource_id);
+  }
+  s = write_text_label(&outbuf[len], outlen - len,
+                       LWM2M_SENML_CBOR_NAME, name, n);
+  if(s == 0) {
+    return 0;
+  }
+  len += s;
+
+  s = lwm2m_cbor_write_int(&outbuf[len], outlen - len, label);
+  if(s == 0) {
+    return 0;
+  }
+  return len + s;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+init_write(lwm2m_context_t *ctx)
+{
+  ctx->writer_flags = 0; /* set flags to zero */
+  if(ctx->outbuf->len >= ctx->outbuf->size) {
+    return 0;
+  }
+  /* The number of records is not known - use an indefinite length array */
+  ctx->outbuf->buffer[ctx->outbuf->len] =
+    (LWM2M_CBOR_TYPE_ARRAY << 5) | LWM2M_CBOR_INDEFINITE;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+end_write(lwm2m_context_t *ctx)
+{
+  if(ctx->outbuf->len >= ctx->outbuf->size) {
+    return 0;
+  }
+  ctx->outbuf->buffer[ctx->outbuf->len] = LWM2M_CBOR_BREAK;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+enter_sub(lwm2m_context_t *ctx)
+{
+  /* set some flags in state */
+  LOG_DBG("Enter sub-resource rsc=%d\n", ctx->resource_id);
+  ctx->writer_flags |= WRITER_RESOURCE_INSTANCE;
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+exit_sub(lwm2m_context_t *ctx)
+{
+  /* clear out state info */
+  LOG_DBG("Exit sub-resource rsc=%d\n", ctx->resource_id);
+  ctx->writer_flags &= ~WRITER_RESOURCE_INSTANCE;
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+write_boolean(lwm2m_context_t *ctx, uint8_t *outbuf, size_t outlen,
+              int value)
+{
+  size_t len;
+  size_t s;
+
+  len = write_record_head(ctx, outbuf, outlen, LWM2M_SENML_CBOR_BOOLEAN_VALUE);
+  if(len == 0 ||
+     (s = lwm2m_cbor_write_boolean(&outbuf[len], outlen - len, value)) == 0) {
+    return 0;
+  }
+  ctx->writer_flags |= WRITER_OUTPUT_VALUE;
+  return len + s;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+write_int(lwm2m_context_t *ctx, uint8_t *outbuf, size_t outlen,
+          int32_t value)
+{
+  size_t len;
+  size_t s;
+
+  len = write_record_head(ctx, outbuf, outlen, LWM2M_SENML_CBOR_VALUE);
+  if(len == 0 ||
+     (s = lwm2m_cbor_write_int(&outbuf[len], outlen - len, value)) == 0) {
+    return 0;
+  }
+  ctx->writer_flags |= WRITER_OUTPUT_VALUE;
+  return len + s;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+write_float32fix(lwm2m_context_t *ctx, uint8_t *outbuf, size_t outlen,
+                 int32_t value, int bits)
+{
+  size_t len;
+  size_t s;
+
+  len = write_record_head(ctx, outbuf, outlen, LWM2M_SENML_CBOR_VALUE);
+  if(len == 0 ||
+     (s = lwm2m_cbor_write_float32fix(&outbuf[len], outlen - len,
+                                      value, bits)) == 0) {
+    return 0;
+  }
+  ctx->writer_flags |= WRITER_OUTPUT_VALUE;
+  return len + s;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+write_string(lwm2m_context_t *ctx, uint8_t *outbuf, size_t outlen,
+             const char *value, size_t stringlen)
+{
+  size_t len;
+  size_t s;
+
+  len = write_record_head(ctx, outbuf, outlen,
+                          LWM2M_SENML_CBOR_STRING_VALUE);
+  if(len == 0 ||
+     (s = lwm2m_cbor_write_text(&outbuf[len], outlen - len,
+                                value, stringlen)) == 0) {
+    return 0;
+  }
+  ctx->writer_flags |= WRITER_OUTPUT_VALUE;
+  return len + s;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+write_opaque_header(lwm2m_context_t *ctx, size_t payloadsize)
+{
+  uint8_t *outbuf = &ctx->outbuf->buffer[ctx->outbuf->len];
+  size_t outlen = ctx->outbuf->size - ctx->outbuf->len;
+  size_t len;
+  size_t s;
+
+  len = write_record_head(ctx, outbuf, outlen, LWM2M_SENML_CBOR_DATA_VALUE);
+  if(len == 0 ||
+     (s = lwm2m_cbor_write_head(&outbuf[len], outlen - len,
+                                LWM2M_CBOR_TYPE_BYTES, payloadsize)) == 0) {
+    return 0;
+  }
+  ctx->writer_flags |= WRITER_OUTPUT_VALUE;
+  return len + s;
+}
+/*---------------------------------------------------------------------------*/
+const lwm2m_writer_t lwm2m_senml_cbor_writer = {
+  init_write,
+  end_write,
+  enter_sub,
+  exit_sub,
+  write_int,
+  write_string,
+  write_float32fix,
+  write_boolean,
+  write_opaque_header
+};
+/*---------------------------------------------------------------------------*/
+/** @} */
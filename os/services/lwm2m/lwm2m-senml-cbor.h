@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2019, RISE SICS AB.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \addtogroup lwm2m
+ * @{
+ */
+
+/**
+ * \file
+ *         Header file for the Contiki OMA LWM2M SenML CBOR writer and reader
+ */
+
+#ifndef LWM2M_SENML_CBOR_H_
+#define LWM2M_SENML_CBOR_H_
+
+#include "lwm2m-object.h"
+
+/* SenML labels (RFC 8428, CBOR representation) */
+#define LWM2M_SENML_CBOR_BASE_TIME    -3
+#define LWM2M_SENML_CBOR_BASE_NAME    -2
+#define LWM2M_SENML_CBOR_NAME          0
+#define LWM2M_SENML_CBOR_VALUE         2
+#define LWM2M_SENML_CBOR_STRING_VALUE  3
+#define LWM2M_SENML_CBOR_BOOLEAN_VALUE 4
+#define LWM2M_SENML_CBOR_TIME          6
+#define LWM2M_SENML_CBOR_DATA_VALUE    8
+
+/* Smaller times are relative to the time the pack is received */
+#define LWM2M_SENML_MIN_ABSOLUTE_TIME  (1L << 28)
+
+/* One SenML record - the base name and base time are kept between records */
+struct senml_cbor_record {
+  const uint8_t *base_name;
+  const uint8_t *name;
+  const uint8_t *value; /* the CBOR encoded value */
+  int32_t base_time;
+  int32_t time;
+  uint16_t value_len;
+  uint8_t base_name_len;
+  uint8_t name_len;
+};
+
+extern const lwm2m_writer_t lwm2m_senml_cbor_writer;
+
+int lwm2m_senml_cbor_next_record(lwm2m_context_t *ctx,
+                                 struct senml_cbor_record *record);
+
+#endif /* LWM2M_SENML_CBOR_H_ */
+/** @} */
@@ -0,0 +1,442 @@
+/*
+ * Copyright (c) 2019, RISE SICS AB.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \addtogroup metrics
+ * @{
+ */
+
+/**
+ * \file
+ *         Network-wide node metrics with compact binary reports
+ */
+
+#include "contiki.h"
+#include "services/metrics/metrics.h"
+#include "net/ipv6/uip-ds6.h"
+#include "net/ipv6/simple-udp.h"
+#include "net/routing/routing.h"
+#include "net/link-stats.h"
+#include "net/queuebuf.h"
+#include "lib/heapmem.h"
+#include "lib/list.h"
+#include "lib/memb.h"
+#include "lib/random.h"
+#include "sys/energest.h"
+
+#if ROUTING_CONF_RPL_LITE
+#include "net/routing/rpl-lite/rpl.h"
+#elif ROUTING_CONF_RPL_CLASSIC
+#include "net/routing/rpl-classic/rpl.h"
+#endif
+
+#include <string.h>
+
+/* Log configuration */
+#include "sys/log.h"
+#define LOG_MODULE "Metrics"
+#define LOG_LEVEL LOG_LEVEL_WARN
+
+static const char *field_names[METRICS_FIELD_MAX] = {
+  "uptime", "cpu", "lpm", "deep-lpm", "tx", "listen", "rank", "parent",
+  "parent-etx", "parent-rssi", "neighbors", "queuebuf", "heap"
+};
+
+static struct simple_udp_connection udp_conn;
+static struct metrics_record local;
+static struct metrics_record last_sent;
+static uint8_t since_full;
+
+MEMB(nodes_memb, struct metrics_node, METRICS_MAX_NODES);
+LIST(nodes_list);
+
+PROCESS(metrics_process, "Metrics");
+/*---------------------------------------------------------------------------*/
+static int
+put_varint(uint8_t *buf, uint16_t size, uint16_t pos, uint32_t value)
+{
+  do {
+    if(pos >= size) {
+      return -1;
+    }
+    buf[pos++] = (value & 0x7f) | (value > 0x7f ? 0x80 : 0);
+    value >>= 7;
+  } while(value > 0);
+  return pos;
+}
+/*---------------------------------------------------------------------------*/
+static int
+get_varint(const uint8_t *buf, uint16_t len, uint16_t pos, uint32_t *value)
+{
+  uint8_t shift;
+
+  *value = 0;
+  for(shift = 0; shift < 35; shift += 7) {
+    if(pos >= len) {
+      return -1;
+    }
+    *value |= (uint32_t)(buf[pos] & 0x7f) << shift;
+    if((buf[pos++] & 0x80) == 0) {
+      return pos;
+    }
+  }
+  return -1;
+}
+/*---------------------------------------------------------------------------*/
+static uint32_t
+zigzag_encode(int32_t value)
+{
+  return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+/*---------------------------------------------------------------------------*/
+static int32_t
+zigzag_decode(uint32_t value)
+{
+  return (int32_t)((value >> 1) ^ (~(value & 1) + 1));
+}
+/*---------------------------------------------------------------------------*/
+int
+metrics_encode(uint8_t *buf, uint16_t size,
+               const struct metrics_record *record,
+               const struct metrics_record *base)
+{
+  int pos;
+  uint8_t i;
+  int32_t delta;
+
+  if(size < 3) {
+    return -1;
+  }
+  buf[0] = (METRICS_VERSION << 4) | (base == NULL ? METRICS_FLAG_FULL : 0);
+  buf[1] = record->seq;
+  buf[2] = METRICS_FIELD_MAX;
+  pos = 3;
+
+  for(i = 0; i < METRICS_FIELD_MAX; i++) {
+    delta = (int32_t)(record->values[i] - (base != NULL ? base->values[i] : 0));
+    pos = put_varint(buf, size, pos, zigzag_encode(delta));
+    if(pos < 0) {
+      return -1;
+    }
+  }
+  return pos;
+}
+/*---------------------------------------------------------------------------*/
+int
+metrics_decode(const uint8_t *buf, uint16_t len, struct metrics_record *record)
+{
+  int pos;
+  uint8_t i;
+  uint8_t count;
+  uint8_t full;
+  uint32_t value;
+  struct metrics_record decoded;
+
+  if(len < 3 || (buf[0] >> 4) != METRICS_VERSION) {
+    return -1;
+  }
+  full = buf[0] & METRICS_FLAG_FULL;
+  decoded.seq = buf[1];
+  count = buf[2];
+  pos = 3;
+
+  for(i = 0; i < count; i++) {
+    pos = get_varint(buf, len, pos, &value);
+    if(pos < 0) {
+      return -1;
+    }
+    /* Fields unknown to this version are skipped */
+    if(i < METRICS_FIELD_MAX) {
+      decoded.values[i] = (full ? 0 : record->values[i]) + zigzag_decode(value);
+    }
+  }
+  /* Fields missing from an older sender are kept, or cleared for a full record */
+  for(; i < METRICS_FIELD_MAX; i++) {
+    decoded.values[i] = full ? 0 : record->values[i];
+  }
+
+  *record = decoded;
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+const char *
+metrics_field_name(uint8_t field)
+{
+  return field < METRICS_FIELD_MAX ? field_names[field] : "unknown";
+}
+/*---------------------------------------------------------------------------*/
+static uint32_t
+energest_ms(energest_type_t type)
+{
+  return (uint32_t)(energest_type_time(type) * 1000 / ENERGEST_SECOND);
+}
+/*---------------------------------------------------------------------------*/
+static void
+sample_parent(struct metrics_record *record)
+{
+  const linkaddr_t *lladdr = NULL;
+  const struct link_stats *stats;
+#if ROUTING_CONF_RPL_LITE || ROUTING_CONF_RPL_CLASSIC
+  rpl_dag_t *dag = rpl_get_any_dag();
+
+  if(dag != NULL) {
+    record->values[METRICS_RANK] = dag->rank;
+    if(dag->preferred_parent != NULL) {
+#if ROUTING_CONF_RPL_LITE
+      lladdr = rpl_neighbor_get_lladdr(dag->preferred_parent);
+#else /* ROUTING_CONF_RPL_LITE */
+      lladdr = rpl_get_parent_lladdr(dag->preferred_parent);
+#endif /* ROUTING_CONF_RPL_LITE */
+    }
+  }
+#endif /* ROUTING_CONF_RPL_LITE || ROUTING_CONF_RPL_CLASSIC */
+
+  if(lladdr != NULL) {
+    record->values[METRICS_PARENT] = (lladdr->u8[LINKADDR_SIZE - 2] << 8)
+      | lladdr->u8[LINKADDR_SIZE - 1];
+    stats = link_stats_from_lladdr(lladdr);
+    if(stats != NULL) {
+      record->values[METRICS_PARENT_ETX] = stats->etx;
+      record->values[METRICS_PARENT_RSSI] = (uint32_t)(int32_t)stats->rssi;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+metrics_sample(struct metrics_record *record)
+{
+  heapmem_stats_t heap;
+
+  memset(record->values, 0, sizeof(record->values));
+  record->values[METRICS_UPTIME] = clock_seconds();
+
+  energest_flush();
+  record->values[METRICS_CPU] = energest_ms(ENERGEST_TYPE_CPU);
+  record->values[METRICS_LPM] = energest_ms(ENERGEST_TYPE_LPM);
+  record->values[METRICS_DEEP_LPM] = energest_ms(ENERGEST_TYPE_DEEP_LPM);
+  record->values[METRICS_TX] = energest_ms(ENERGEST_TYPE_TRANSMIT);
+  record->values[METRICS_LISTEN] = energest_ms(ENERGEST_TYPE_LISTEN);
+
+  record->values[METRICS_RANK] = 0xffff;
+  sample_parent(record);
+
+  record->values[METRICS_NEIGHBORS] = uip_ds6_nbr_num();
+  record->values[METRICS_QUEUEBUF] = QUEUEBUF_NUM - queuebuf_numfree();
+  heapmem_stats(&heap);
+  record->values[METRICS_HEAP] = heap.allocated;
+}
+/*---------------------------------------------------------------------------*/
+const struct metrics_record *
+metrics_local(void)
+{
+  return &local;
+}
+/*---------------------------------------------------------------------------*/
+struct metrics_node *
+metrics_table_head(void)
+{
+  return list_head(nodes_list);
+}
+/*---------------------------------------------------------------------------*/
+struct metrics_node *
+metrics_table_next(struct metrics_node *node)
+{
+  return list_item_next(node);
+}
+/*---------------------------------------------------------------------------*/
+struct metrics_node *
+metrics_table_lookup(const uip_ipaddr_t *addr)
+{
+  struct metrics_node *node;
+
+  for(node = list_head(nodes_list); node != NULL; node = list_item_next(node)) {
+    if(uip_ipaddr_cmp(&node->addr, addr)) {
+      return node;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static struct metrics_node *
+table_add(const uip_ipaddr_t *addr)
+{
+  struct metrics_node *node;
+  struct metrics_node *oldest;
+
+  node = memb_alloc(&nodes_memb);
+  if(node == NULL) {
+    /* Evict the node we heard from the longest time ago */
+    oldest = list_head(nodes_list);
+    for(node = oldest; node != NULL; node = list_item_next(node)) {
+      if(node->last_update < oldest->last_update) {
+        oldest = node;
+      }
+    }
+    LOG_WARN("table full, evicting ");
+    LOG_WARN_6ADDR(&oldest->addr);
+    LOG_WARN_("\n");
+    list_remove(nodes_list, oldest);
+    node = oldest;
+  }
+
+  memset(node, 0, sizeof(*node));
+  uip_ipaddr_copy(&node->addr, addr);
+  list_add(nodes_list, node);
+  return node;
+}
+/*---------------------------------------------------------------------------*/
+static void
+table_update(const uip_ipaddr_t *addr, const uint8_t *data, uint16_t len)
+{
+  struct metrics_node *node;
+
+  if(len < 3) {
+    return;
+  }
+
+  node = metrics_table_lookup(addr);
+  if(node == NULL) {
+    node = table_add(addr);
+  }
+  node->last_update = clock_seconds();
+
+  if(!(data[0] & METRICS_FLAG_FULL)
+     && (!node->valid || data[1] != (uint8_t)(node->record.seq + 1))) {
+    /* The base of this delta is gone; wait for the next full record */
+    node->lost++;
+    node->valid = 0;
+    return;
+  }
+
+  if(metrics_decode(data, len, &node->record) < 0) {
+    LOG_WARN("malformed record from ");
+    LOG_WARN_6ADDR(addr);
+    LOG_WARN_("\n");
+    node->valid = 0;
+    return;
+  }
+  node->valid = 1;
+  node->reports++;
+}
+/*---------------------------------------------------------------------------*/
+static void
+udp_rx_callback(struct simple_udp_connection *c,
+                const uip_ipaddr_t *sender_addr,
+                uint16_t sender_port,
+                const uip_ipaddr_t *receiver_addr,
+                uint16_t receiver_port,
+                const uint8_t *data,
+                uint16_t datalen)
+{
+  if(!NETSTACK_ROUTING.node_is_root()) {
+    return;
+  }
+  LOG_DBG("received %u bytes from ", datalen);
+  LOG_DBG_6ADDR(sender_addr);
+  LOG_DBG_("\n");
+  table_update(sender_addr, data, datalen);
+}
+/*---------------------------------------------------------------------------*/
+static void
+report(void)
+{
+  uip_ipaddr_t root;
+  uint8_t buf[METRICS_MAX_RECORD_LEN];
+  int len;
+  uint8_t full;
+
+  local.seq++;
+  metrics_sample(&local);
+
+  if(!NETSTACK_ROUTING.get_root_ipaddr(&root)) {
+    return;
+  }
+
+  if(NETSTACK_ROUTING.node_is_root()) {
+    /* The root keeps its own metrics in the table, too */
+    len = metrics_encode(buf, sizeof(buf), &local, NULL);
+    table_update(&root, buf, len);
+    return;
+  }
+
+  if(!NETSTACK_ROUTING.node_is_reachable()) {
+    /* Restart with a full record once the root can be reached again */
+    since_full = 0;
+    return;
+  }
+
+  full = since_full == 0 || (uint8_t)(local.seq - 1) != last_sent.seq;
+  len = metrics_encode(buf, sizeof(buf), &local, full ? NULL : &last_sent);
+  if(len < 0) {
+    return;
+  }
+
+  LOG_INFO("sending %s record %u (%d bytes) to ", full ? "full" : "delta",
+           local.seq, len);
+  LOG_INFO_6ADDR(&root);
+  LOG_INFO_("\n");
+  simple_udp_sendto(&udp_conn, buf, len, &root);
+
+  last_sent = local;
+  since_full = full ? 1 : since_full + 1;
+  if(since_full >= METRICS_FULL_INTERVAL) {
+    since_full = 0;
+  }
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(metrics_process, ev, data)
+{
+  static struct etimer periodic_timer;
+
+  PROCESS_BEGIN();
+
+  simple_udp_register(&udp_conn, METRICS_UDP_PORT, NULL,
+                      METRICS_UDP_PORT, udp_rx_callback);
+
+  /* Spread the reports of the nodes over the period */
+  etimer_set(&periodic_timer, random_rand() % METRICS_PERIOD);
+  while(1) {
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&periodic_timer));
+    etimer_set(&periodic_timer, METRICS_PERIOD);
+    report();
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+void
+metrics_init(void)
+{
+  memb_init(&nodes_memb);
+  list_init(nodes_list);
+  process_start(&metrics_process, NULL);
+}
+/*---------------------------------------------------------------------------*/
+/** @} */
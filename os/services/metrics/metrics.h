@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2019, RISE SICS AB.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \addtogroup services
+ * @{
+ */
+
+/**
+ * \defgroup metrics Network-wide node metrics
+ * @{
+ *
+ * Every node periodically samples its energest times, the RPL rank and
+ * parent, the ETX and RSSI of the link to the parent, the number of
+ * neighbors, the queuebuf occupancy and the heapmem usage. It sends them
+ * to the RPL root in a compact binary record over UDP. The root keeps the
+ * latest record of every node in a table.
+ *
+ * A record starts with a header byte (version and flags), a sequence
+ * number and the number of fields. Then comes one varint per field. A
+ * delta record holds the zigzag-encoded difference of each field to the
+ * previous record of the node. A full record, sent first and then every
+ * METRICS_FULL_INTERVAL records, holds the values themselves. After a
+ * lost delta record, the root waits for the next full record.
+ */
+
+/**
+ * \file
+ *         Network-wide node metrics with compact binary reports
+ */
+
+#ifndef METRICS_H_
+#define METRICS_H_
+
+#include "contiki.h"
+#include "net/ipv6/uip.h"
+
+/** \brief The period at which metrics are sampled and reported */
+#ifdef METRICS_CONF_PERIOD
+#define METRICS_PERIOD METRICS_CONF_PERIOD
+#else /* METRICS_CONF_PERIOD */
+#define METRICS_PERIOD (CLOCK_SECOND * 60)
+#endif /* METRICS_CONF_PERIOD */
+
+/** \brief Every how many records a full record is sent */
+#ifdef METRICS_CONF_FULL_INTERVAL
+#define METRICS_FULL_INTERVAL METRICS_CONF_FULL_INTERVAL
+#else /* METRICS_CONF_FULL_INTERVAL */
+#define METRICS_FULL_INTERVAL 10
+#endif /* METRICS_CONF_FULL_INTERVAL */
+
+/** \brief The UDP port of the reports */
+#ifdef METRICS_CONF_UDP_PORT
+#define METRICS_UDP_PORT METRICS_CONF_UDP_PORT
+#else /* METRICS_CONF_UDP_PORT */
+#define METRICS_UDP_PORT 5679
+#endif /* METRICS_CONF_UDP_PORT */
+
+/** \brief The number of nodes in the table of the root */
+#ifdef METRICS_CONF_MAX_NODES
+#define METRICS_MAX_NODES METRICS_CONF_MAX_NODES
+#else /* METRICS_CONF_MAX_NODES */
+#define METRICS_MAX_NODES 16
+#endif /* METRICS_CONF_MAX_NODES */
+
+#define METRICS_VERSION 1
+#define METRICS_FLAG_FULL 0x01
+
+/** \brief The maximum length of an encoded record */
+#define METRICS_MAX_RECORD_LEN (3 + 5 * METRICS_FIELD_MAX)
+
+/** \brief The fields of a record. New fields are added at the end. */
+enum metrics_field {
+  METRICS_UPTIME,       /* Seconds */
+  METRICS_CPU,          /* Energest times, in milliseconds */
+  METRICS_LPM,
+  METRICS_DEEP_LPM,
+  METRICS_TX,
+  METRICS_LISTEN,
+  METRICS_RANK,         /* RPL rank, or 0xffff when not joined */
+  METRICS_PARENT,       /* Last two bytes of the parent's link-layer address */
+  METRICS_PARENT_ETX,   /* In units of 1/LINK_STATS_ETX_DIVISOR */
+  METRICS_PARENT_RSSI,  /* Signed */
+  METRICS_NEIGHBORS,
+  METRICS_QUEUEBUF,     /* Queue buffers in use */
+  METRICS_HEAP,         /* Bytes allocated from heapmem */
+  METRICS_FIELD_MAX
+};
+
+struct metrics_record {
+  uint8_t seq;
+  uint32_t values[METRICS_FIELD_MAX];
+};
+
+/** \brief A node in the table of the root */
+struct metrics_node {
+  struct metrics_node *next;
+  uip_ipaddr_t addr;
+  struct metrics_record record;
+  unsigned long last_update; /* clock_seconds() */
+  uint16_t reports;
+  uint16_t lost;
+  uint8_t valid;
+};
+
+/**
+ * \brief Samples the current metrics of this node
+ * \param record The record to fill in; its sequence number is left as is
+ */
+void metrics_sample(struct metrics_record *record);
+
+/**
+ * \brief Encodes a record
+ * \param buf The output buffer
+ * \param size The size of the output buffer
+ * \param record The record to encode
+ * \param base The previous record for a delta record, or NULL for a full record
+ * \return The length of the encoded record, or -1 if it does not fit
+ */
+int metrics_encode(uint8_t *buf, uint16_t size,
+                   const struct metrics_record *record,
+                   const struct metrics_record *base);
+
+/**
+ * \brief Decodes a record
+ * \param buf The encoded record
+ * \param len The length of the encoded record
+ * \param record Holds the previous record of the node for a delta
+ * record, and is updated with the decoded one
+ * \return 0 on success, -1 for a malformed record
+ */
+int metrics_decode(const uint8_t *buf, uint16_t len, struct metrics_record *record);
+
+/**
+ * \brief Returns the name of a field
+ */
+const char *metrics_field_name(uint8_t field);
+
+/**
+ * \brief Returns the first node of the table of the root
+ */
+struct metrics_node *metrics_table_head(void);
+
+/**
+ * \brief Returns the next node of the table of the root
+ */
+struct metrics_node *metrics_table_next(struct metrics_node *node);
+
+/**
+ * \brief Looks up a node in the table of the root
+ * \param addr The IPv6 address of the node
+ * \return The node, or NULL if it is not in the table
+ */
+struct metrics_node *metrics_table_lookup(const uip_ipaddr_t *addr);
+
+/**
+ * \brief Returns the record last sampled by this node
+ */
+const struct metrics_record *metrics_local(void);
+
+/**
+ * \brief Initializes the metrics service
+ */
+void metrics_init(void);
+
+#endif /* METRICS_H_ */
+/** @} */
+/** @} */
@@ -0,0 +1,2 @@
+#define BUILD_WITH_METRICS 1
+#define ENERGEST_CONF_ON 1
@@ -0,0 +1 @@
+#define BUILD_WITH_RADIO_ACCOUNTING 1
@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2019, RISE SICS AB.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \addtogroup radio-accounting
+ * @{
+ *
+ * \file
+ *         Radio airtime accounting per traffic category
+ */
+
+#include "contiki.h"
+#if NETSTACK_CONF_WITH_IPV6
+#include "net/ipv6/uip.h"
+#include "net/ipv6/uipbuf.h"
+#include "net/ipv6/uip-icmp6.h"
+#endif /* NETSTACK_CONF_WITH_IPV6 */
+#include "services/radio-accounting/radio-accounting.h"
+
+#include <string.h>
+
+#if NETSTACK_CONF_WITH_IPV6
+#define UIP_IP_BUF ((struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN])
+#endif /* NETSTACK_CONF_WITH_IPV6 */
+
+static struct radio_accounting_stats stats[RADIO_ACCOUNTING_CATEGORY_MAX];
+
+static const char *const category_names[RADIO_ACCOUNTING_CATEGORY_MAX] = {
+  "other",
+  "mac",
+  "6lowpan-frag",
+  "rpl",
+  "icmp6",
+  "coap",
+  "udp",
+  "tcp",
+};
+/*---------------------------------------------------------------------------*/
+void
+radio_accounting_tx(uint8_t category, uint16_t len, uint8_t count)
+{
+  if(category >= RADIO_ACCOUNTING_CATEGORY_MAX) {
+    category = RADIO_ACCOUNTING_OTHER;
+  }
+  stats[category].tx.frames += count;
+  stats[category].tx.bytes += (uint32_t)len * count;
+}
+/*---------------------------------------------------------------------------*/
+void
+radio_accounting_rx(uint8_t category, uint16_t len)
+{
+  if(category >= RADIO_ACCOUNTING_CATEGORY_MAX) {
+    category = RADIO_ACCOUNTING_OTHER;
+  }
+  stats[category].rx.frames++;
+  stats[category].rx.bytes += len;
+}
+/*---------------------------------------------------------------------------*/
+#if NETSTACK_CONF_WITH_IPV6
+uint8_t
+radio_accounting_classify(void)
+{
+  uint8_t *hdr;
+  uint8_t proto;
+  struct uip_udp_hdr *udp;
+
+  if(uip_len < UIP_IPH_LEN) {
+    return RADIO_ACCOUNTING_OTHER;
+  }
+  hdr = uipbuf_get_last_header((uint8_t *)UIP_IP_BUF, uip_len, &proto);
+  if(hdr + 4 > (uint8_t *)UIP_IP_BUF + uip_len) {
+    return RADIO_ACCOUNTING_OTHER;
+  }
+
+  switch(proto) {
+  case UIP_PROTO_ICMP6:
+    return ((struct uip_icmp_hdr *)hdr)->type == ICMP6_RPL ?
+      RADIO_ACCOUNTING_RPL : RADIO_ACCOUNTING_ICMP6;
+  case UIP_PROTO_UDP:
+    udp = (struct uip_udp_hdr *)hdr;
+    if(udp->srcport == UIP_HTONS(RADIO_ACCOUNTING_COAP_PORT) ||
+       udp->destport == UIP_HTONS(RADIO_ACCOUNTING_COAP_PORT) ||
+       udp->srcport == UIP_HTONS(RADIO_ACCOUNTING_COAP_SECURE_PORT) ||
+       udp->destport == UIP_HTONS(RADIO_ACCOUNTING_COAP_SECURE_PORT)) {
+      return RADIO_ACCOUNTING_COAP;
+    }
+    return RADIO_ACCOUNTING_UDP;
+  case UIP_PROTO_TCP:
+    return RADIO_ACCOUNTING_TCP;
+  default:
+    return RADIO_ACCOUNTING_OTHER;
+  }
+}
+#else /* NETSTACK_CONF_WITH_IPV6 */
+uint8_t
+radio_accounting_classify(void)
+{
+  /* Without IPv6, there is no packet in uip_buf to look into */
+  return RADIO_ACCOUNTING_OTHER;
+}
+#endif /* NETSTACK_CONF_WITH_IPV6 */
+/*---------------------------------------------------------------------------*/
+const struct radio_accounting_stats *
+radio_accounting_get(uint8_t category)
+{
+  if(category >= RADIO_ACCOUNTING_CATEGORY_MAX) {
+    return NULL;
+  }
+  return &stats[category];
+}
+/*---------------------------------------------------------------------------*/
+uint64_t
+radio_accounting_airtime(const struct radio_accounting_counters *counters)
+{
+  return ((uint64_t)counters->bytes
+          + (uint64_t)counters->frames * RADIO_ACCOUNTING_FRAME_OVERHEAD)
+    * RADIO_ACCOUNTING_BYTE_AIRTIME;
+}
+/*---------------------------------------------------------------------------*/
+const char *
+radio_accounting_category_name(uint8_t category)
+{
+  if(category >= RADIO_ACCOUNTING_CATEGORY_MAX) {
+    return "unknown";
+  }
+  return category_names[category];
+}
+/*---------------------------------------------------------------------------*/
+void
+radio_accounting_reset(void)
+{
+  memset(stats, 0, sizeof(stats));
+}
+/*---------------------------------------------------------------------------*/
+/** @} */
@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2019, RISE SICS AB.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \addtogroup services
+ * @{
+ */
+
+/**
+ * \defgroup radio-accounting Radio accounting per traffic category
+ * @{
+ *
+ * Counts the frames and bytes sent and received per traffic category
+ * (RPL, CoAP, TSCH EBs, 6LoWPAN fragments, ...) and derives the radio
+ * airtime from them. Outgoing frames are tagged with their category
+ * through the PACKETBUF_ATTR_RADIO_ACCOUNTING attribute by the layer that
+ * creates them, and counted by the MAC for every transmission. Incoming
+ * frames are counted when the network layer has identified their
+ * category. Frames dropped by the MAC, such as duplicates, are not
+ * counted.
+ */
+
+/**
+ * \file
+ *         Radio airtime accounting per traffic category
+ */
+
+#ifndef RADIO_ACCOUNTING_H_
+#define RADIO_ACCOUNTING_H_
+
+#include "contiki.h"
+#include "net/packetbuf.h"
+
+/** \brief Airtime of one byte, in microseconds (2.4 GHz O-QPSK) */
+#ifdef RADIO_ACCOUNTING_CONF_BYTE_AIRTIME
+#define RADIO_ACCOUNTING_BYTE_AIRTIME RADIO_ACCOUNTING_CONF_BYTE_AIRTIME
+#else /* RADIO_ACCOUNTING_CONF_BYTE_AIRTIME */
+#define RADIO_ACCOUNTING_BYTE_AIRTIME 32
+#endif /* RADIO_ACCOUNTING_CONF_BYTE_AIRTIME */
+
+/** \brief Bytes sent per frame on top of the MAC frame: preamble, SFD,
+ * PHY header and FCS */
+#ifdef RADIO_ACCOUNTING_CONF_FRAME_OVERHEAD
+#define RADIO_ACCOUNTING_FRAME_OVERHEAD RADIO_ACCOUNTING_CONF_FRAME_OVERHEAD
+#else /* RADIO_ACCOUNTING_CONF_FRAME_OVERHEAD */
+#define RADIO_ACCOUNTING_FRAME_OVERHEAD 8
+#endif /* RADIO_ACCOUNTING_CONF_FRAME_OVERHEAD */
+
+/** \brief UDP ports counted as CoAP */
+#ifdef RADIO_ACCOUNTING_CONF_COAP_PORT
+#define RADIO_ACCOUNTING_COAP_PORT RADIO_ACCOUNTING_CONF_COAP_PORT
+#else /* RADIO_ACCOUNTING_CONF_COAP_PORT */
+#define RADIO_ACCOUNTING_COAP_PORT 5683
+#endif /* RADIO_ACCOUNTING_CONF_COAP_PORT */
+
+#ifdef RADIO_ACCOUNTING_CONF_COAP_SECURE_PORT
+#define RADIO_ACCOUNTING_COAP_SECURE_PORT RADIO_ACCOUNTING_CONF_COAP_SECURE_PORT
+#else /* RADIO_ACCOUNTING_CONF_COAP_SECURE_PORT */
+#define RADIO_ACCOUNTING_COAP_SECURE_PORT 5684
+#endif /* RADIO_ACCOUNTING_CONF_COAP_SECURE_PORT */
+
+/** \brief Traffic categories */
+typedef enum radio_accounting_category {
+  RADIO_ACCOUNTING_OTHER,   /* Untagged frames, e.g. from NullNet */
+  RADIO_ACCOUNTING_MAC,     /* MAC control frames: TSCH EBs and keepalives */
+  RADIO_ACCOUNTING_FRAG,    /* 6LoWPAN fragments */
+  RADIO_ACCOUNTING_RPL,
+  RADIO_ACCOUNTING_ICMP6,   /* ICMPv6 other than RPL: ND, ping */
+  RADIO_ACCOUNTING_COAP,
+  RADIO_ACCOUNTING_UDP,     /* UDP other than CoAP */
+  RADIO_ACCOUNTING_TCP,
+  RADIO_ACCOUNTING_CATEGORY_MAX
+} radio_accounting_category_t;
+
+struct radio_accounting_counters {
+  uint32_t frames;
+  uint32_t bytes;
+};
+
+struct radio_accounting_stats {
+  struct radio_accounting_counters tx;
+  struct radio_accounting_counters rx;
+};
+
+#if BUILD_WITH_RADIO_ACCOUNTING
+
+/** \brief Tags the frame in packetbuf with a traffic category */
+#define RADIO_ACCOUNTING_SET_CATEGORY(category) \
+  packetbuf_set_attr(PACKETBUF_ATTR_RADIO_ACCOUNTING, (category))
+/** \brief Counts count transmissions of the len-byte frame in packetbuf */
+#define RADIO_ACCOUNTING_TX(len, count) \
+  radio_accounting_tx(packetbuf_attr(PACKETBUF_ATTR_RADIO_ACCOUNTING), (len), (count))
+/** \brief Counts the reception of a len-byte frame */
+#define RADIO_ACCOUNTING_RX(category, len) \
+  radio_accounting_rx((category), (len))
+
+#else /* BUILD_WITH_RADIO_ACCOUNTING */
+
+#define RADIO_ACCOUNTING_SET_CATEGORY(category) do { } while(0)
+#define RADIO_ACCOUNTING_TX(len, count) do { } while(0)
+#define RADIO_ACCOUNTING_RX(category, len) do { } while(0)
+
+#endif /* BUILD_WITH_RADIO_ACCOUNTING */
+
+/**
+ * \brief Counts transmissions of a frame
+ * \param category The traffic category of the frame
+ * \param len The length of the frame
+ * \param count The number of transmissions
+ */
+void radio_accounting_tx(uint8_t category, uint16_t len, uint8_t count);
+
+/**
+ * \brief Counts the reception of a frame
+ * \param category The traffic category of the frame
+ * \param len The length of the frame
+ */
+void radio_accounting_rx(uint8_t category, uint16_t len);
+
+/**
+ * \brief Returns the traffic category of the IPv6 packet in uip_buf,
+ * or RADIO_ACCOUNTING_OTHER when built without IPv6
+ */
+uint8_t radio_accounting_classify(void);
+
+/**
+ * \brief Returns the counters of a traffic category
+ * \param category The traffic category
+ * \return The counters, or NULL for an unknown category
+ */
+const struct radio_accounting_stats *radio_accounting_get(uint8_t category);
+
+/**
+ * \brief Returns the airtime of frames
+ * \param counters Frame and byte counters, e.g. the tx counters of a category
+ * \return The airtime in microseconds
+ */
+uint64_t radio_accounting_airtime(const struct radio_accounting_counters *counters);
+
+/**
+ * \brief Returns the name of a traffic category
+ */
+const char *radio_accounting_category_name(uint8_t category);
+
+/**
+ * \brief Resets all counters
+ */
+void radio_accounting_reset(void);
+
+#endif /* RADIO_ACCOUNTING_H_ */
+/** @} */
+/** @} */
@@ -57,6 +57,12 @@
 #endif /* MAC_CONF_WITH_TSCH */
 #include "net/routing/routing.h"
 #include "net/mac/llsec802154.h"
+#if BUILD_WITH_RADIO_ACCOUNTING
+#include "services/radio-accounting/radio-accounting.h"
+#endif /* BUILD_WITH_RADIO_ACCOUNTING */
+#if BUILD_WITH_METRICS
+#include "services/metrics/metrics.h"
+#endif /* BUILD_WITH_METRICS */
 
 /* For RPL-specific commands */
 #if ROUTING_CONF_RPL_LITE
@@ -202,6 +208,17 @@ PT_THREAD(cmd_rpl_status(struct pt *pt, shell_output_func output, char *args))
     } else {
       SHELL_OUTPUT(output, "None\n");
     }
+    {
+      const struct rpl_parent_stats *stats = rpl_neighbor_get_parent_stats();
+      SHELL_OUTPUT(output, "-- Parent changes: %u selections, %u switches, %u losses",
+          stats->selections, stats->switches, stats->losses);
+      if(stats->last_change > 0) {
+        SHELL_OUTPUT(output, ", last %lu seconds ago\n",
+            (unsigned long)((clock_time() - stats->last_change) / CLOCK_SECOND));
+      } else {
+        SHELL_OUTPUT(output, "\n");
+      }
+    }
     SHELL_OUTPUT(output, "-- Rank: %u\n", curr_instance.dag.rank);
     SHELL_OUTPUT(output, "-- Lowest rank: %u (%u)\n", curr_instance.dag.lowest_rank, curr_instance.max_rankinc);
     SHELL_OUTPUT(output, "-- DTSN out: %u\n", curr_instance.dtsn_out);
@@ -662,6 +679,87 @@ PT_THREAD(cmd_reboot(struct pt *pt, shell_output_func output, char *args))
   watchdog_reboot();
   PT_END(pt);
 }
+#if BUILD_WITH_RADIO_ACCOUNTING
+/*---------------------------------------------------------------------------*/
+static
+PT_THREAD(cmd_airtime(struct pt *pt, shell_output_func output, char *args))
+{
+  const struct radio_accounting_stats *stats;
+  char *next_args;
+  uint8_t i;
+
+  PT_BEGIN(pt);
+
+  SHELL_ARGS_INIT(args, next_args);
+  SHELL_ARGS_NEXT(args, next_args);
+
+  if(args != NULL && !strcmp(args, "reset")) {
+    radio_accounting_reset();
+    SHELL_OUTPUT(output, "Radio accounting reset\n");
+    PT_EXIT(pt);
+  }
+
+  SHELL_OUTPUT(output, "Radio airtime per category (tx/rx frames, bytes, ms):\n");
+  for(i = 0; i < RADIO_ACCOUNTING_CATEGORY_MAX; i++) {
+    stats = radio_accounting_get(i);
+    if(stats->tx.frames == 0 && stats->rx.frames == 0) {
+      continue;
+    }
+    SHELL_OUTPUT(output, "-- %-12s tx %lu %lu %lu, rx %lu %lu %lu\n",
+                 radio_accounting_category_name(i),
+                 (unsigned long)stats->tx.frames, (unsigned long)stats->tx.bytes,
+                 (unsigned long)(radio_accounting_airtime(&stats->tx) / 1000),
+                 (unsigned long)stats->rx.frames, (unsigned long)stats->rx.bytes,
+                 (unsigned long)(radio_accounting_airtime(&stats->rx) / 1000));
+  }
+
+  PT_END(pt);
+}
+#endif /* BUILD_WITH_RADIO_ACCOUNTING */
+#if BUILD_WITH_METRICS
+/*---------------------------------------------------------------------------*/
+static void
+output_metrics_record(shell_output_func output, const struct metrics_record *record)
+{
+  uint8_t i;
+
+  for(i = 0; i < METRICS_FIELD_MAX; i++) {
+    SHELL_OUTPUT(output, " %s=%ld", metrics_field_name(i),
+                 i == METRICS_PARENT_RSSI ? (long)(int32_t)record->values[i]
+                 : (long)record->values[i]);
+  }
+  SHELL_OUTPUT(output, "\n");
+}
+/*---------------------------------------------------------------------------*/
+static
+PT_THREAD(cmd_metrics(struct pt *pt, shell_output_func output, char *args))
+{
+  static struct metrics_node *node;
+
+  PT_BEGIN(pt);
+
+  if(!NETSTACK_ROUTING.node_is_root()) {
+    SHELL_OUTPUT(output, "Local metrics (record %u):", metrics_local()->seq);
+    output_metrics_record(output, metrics_local());
+    PT_EXIT(pt);
+  }
+
+  SHELL_OUTPUT(output, "Metrics of the network:\n");
+  for(node = metrics_table_head(); node != NULL; node = metrics_table_next(node)) {
+    SHELL_OUTPUT(output, "-- ");
+    shell_output_6addr(output, &node->addr);
+    SHELL_OUTPUT(output, " (%lu s ago, %u reports, %u lost)",
+                 clock_seconds() - node->last_update, node->reports, node->lost);
+    if(node->valid) {
+      output_metrics_record(output, &node->record);
+    } else {
+      SHELL_OUTPUT(output, " waiting for a full record\n");
+    }
+  }
+
+  PT_END(pt);
+}
+#endif /* BUILD_WITH_METRICS */
 #if MAC_CONF_WITH_TSCH
 /*---------------------------------------------------------------------------*/
 static
@@ -776,6 +874,12 @@ shell_command_lookup(const char *name)
 const struct shell_command_t builtin_shell_commands[] = {
   { "help",                 cmd_help,                 "'> help': Shows this help" },
   { "reboot",               cmd_reboot,               "'> reboot': Reboot the board by watchdog_reboot()" },
+#if BUILD_WITH_RADIO_ACCOUNTING
+  { "airtime",              cmd_airtime,              "'> airtime [reset]': Shows the radio frames, bytes and airtime per traffic category, or resets them" },
+#endif /* BUILD_WITH_RADIO_ACCOUNTING */
+#if BUILD_WITH_METRICS
+  { "metrics",              cmd_metrics,              "'> metrics': Shows the metrics of all nodes on the root, or the local metrics otherwise" },
+#endif /* BUILD_WITH_METRICS */
   { "ip-addr",              cmd_ipaddr,               "'> ip-addr': Shows all IPv6 addresses" },
   { "ip-nbr",               cmd_ip_neighbors,         "'> ip-nbr': Shows all IPv6 neighbors" },
   { "log",                  cmd_log,                  "'> log module level': Sets log level (0--4) for a given module (or \"all\"). For module \"mac\", level 4 also enables per-slot logging." },
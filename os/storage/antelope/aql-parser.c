@@ -489,6 +489,19 @@ PARSER(join)
   RETURN(OK);
 }
 
+PARSER(group)
+{
+  CONSUME(BY);
+  CONSUME(IDENTIFIER);
+
+  PRINTF("group by: %s\n", VALUE);
+  if(DB_ERROR(aql_set_group_attribute(adt, VALUE))) {
+    RETURN(SYNTAX_ERROR);
+  }
+
+  RETURN(OK);
+}
+
 PARSER(select)
 {
   AQL_SET_TYPE(adt, AQL_TYPE_SELECT);
@@ -512,11 +525,20 @@ PARSER(select)
     }
 
     AQL_SET_CONDITION(adt, &p);
-  } else {
+    NEXT;
+  } else if(TOKEN != GROUP) {
     REWIND;
     RETURN(OK);
   }
 
+  if(TOKEN == GROUP) {
+    if(!PARSE(group)) {
+      RETURN(SYNTAX_ERROR);
+    }
+  } else {
+    REWIND;
+  }
+
   CONSUME(END);
 
   return OK;
@@ -655,6 +677,9 @@ PARSER_TOKEN(index_type)
   case MEMHASH:
     type = INDEX_MEMHASH;
     break;
+  case BPTREE:
+    type = INDEX_BPTREE;
+    break;
   default:
     return NONE;
   };
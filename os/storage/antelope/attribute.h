@@ -56,11 +56,11 @@ typedef enum {
 #define ATTRIBUTE_FLAG_INVALID		0x2
 #define ATTRIBUTE_FLAG_PRIMARY_KEY	0x4
 #define ATTRIBUTE_FLAG_UNIQUE		0x8
+#define ATTRIBUTE_FLAG_GROUP		0x10
 
 struct attribute {
   struct attribute *next;
   void *index;
-  long aggregation_value;
   uint8_t aggregator;
   uint8_t domain;
   uint8_t element_size;
@@ -111,6 +111,28 @@
 #define DB_VM_BYTECODE_SIZE		256
 #endif /* DB_VM_BYTECODE_SIZE */
 
+/* The size of the pages in which tuples are read from storage. */
+#ifndef DB_PAGE_SIZE
+#define DB_PAGE_SIZE			128
+#endif /* DB_PAGE_SIZE */
+
+/* The number of tuple pages cached in memory. */
+#ifndef DB_PAGE_CACHE_SIZE
+#define DB_PAGE_CACHE_SIZE		2
+#endif /* DB_PAGE_CACHE_SIZE */
+
+/* The size of the buffer in which inserted tuples are collected before
+   they are written to storage. Set to 0 to write each tuple directly. */
+#ifndef DB_WRITE_BUFFER_SIZE
+#define DB_WRITE_BUFFER_SIZE		128
+#endif /* DB_WRITE_BUFFER_SIZE */
+
+/* The maximum number of groups that are aggregated in one scan of
+   a relation. Selections with more groups scan the relation again. */
+#ifndef DB_GROUP_LIMIT
+#define DB_GROUP_LIMIT			8
+#endif /* DB_GROUP_LIMIT */
+
 /*----------------------------------------------------------------------------*/
 
 /* Language options. */
@@ -215,6 +237,37 @@
 #define DB_HEAP_CACHE_LIMIT		1
 #endif /* DB_HEAP_CACHE_LIMIT */
 
+/* The maximum number of B+-tree indexes. */
+#ifndef DB_BPTREE_INDEX_LIMIT
+#define DB_BPTREE_INDEX_LIMIT		1
+#endif /* DB_BPTREE_INDEX_LIMIT */
+
+/* The maximum number of keys in a B+-tree node. */
+#ifndef DB_BPTREE_ORDER
+#define DB_BPTREE_ORDER			16
+#endif /* DB_BPTREE_ORDER */
+
+/* The maximum number of nodes in a B+-tree index file. The file is
+   reserved when the index is created, and the tree cannot grow beyond
+   it. The tree holds up to DB_BPTREE_NODE_LIMIT * DB_BPTREE_ORDER keys
+   when they are inserted in increasing order, and about two thirds of
+   that when they are inserted in random order. With the default
+   settings, that is about 950 and 650 keys. An insertion into a full
+   tree fails with DB_INDEX_ERROR and leaves the index unchanged. */
+#ifndef DB_BPTREE_NODE_LIMIT
+#define DB_BPTREE_NODE_LIMIT		64
+#endif /* DB_BPTREE_NODE_LIMIT */
+
+/* The maximum height of a B+-tree. */
+#ifndef DB_BPTREE_MAX_HEIGHT
+#define DB_BPTREE_MAX_HEIGHT		6
+#endif /* DB_BPTREE_MAX_HEIGHT */
+
+/* The number of B+-tree nodes cached in memory. */
+#ifndef DB_BPTREE_CACHE_SIZE
+#define DB_BPTREE_CACHE_SIZE		4
+#endif /* DB_BPTREE_CACHE_SIZE */
+
 /*----------------------------------------------------------------------------*/
 
 /* LVM options. */
@@ -236,5 +289,17 @@
 #define LVM_USE_FLOATS			DB_FEATURE_FLOATS
 #endif /* LVM_USE_FLOATS */
 
+/* The maximum number of instructions in a compiled LVM program.
+   Conditions that do not fit are interpreted from the bytecode.
+   Set to 0 to disable the compilation. */
+#ifndef LVM_PROGRAM_SIZE
+#define LVM_PROGRAM_SIZE		32
+#endif /* LVM_PROGRAM_SIZE */
+
+/* The maximum depth of the value stack used by compiled programs. */
+#ifndef LVM_STACK_DEPTH
+#define LVM_STACK_DEPTH			8
+#endif /* LVM_STACK_DEPTH */
+
 
 #endif /* !DB_OPTIONS_H */
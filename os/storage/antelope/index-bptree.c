@@ -0,0 +1,760 @@
+/*
+ * Copyright (c) 2019, RISE SICS AB.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *     BPTree - A B+-tree index for flash memory.
+ *
+ *     The BPTree index keeps (key, tuple id) pairs sorted in fixed-size
+ *     leaf nodes that are chained from left to right. Internal nodes
+ *     hold only separator keys, so a range query descends once to the
+ *     leaf holding the lower bound of the range and then follows the
+ *     leaf chain until the upper bound has been passed.
+ *
+ *     All nodes are stored in a single file that is reserved when the
+ *     index is created, so the number of keys is limited by
+ *     DB_BPTREE_NODE_LIMIT. Node 0 of the file holds the tree header. A
+ *     small LRU cache of nodes, sized at build time through
+ *     DB_BPTREE_CACHE_SIZE, absorbs the repeated reads of the upper
+ *     levels of the tree. Writes go through to storage immediately, so
+ *     the index stays consistent if the system restarts.
+ *
+ *     Sensor data is typically inserted in increasing key order (e.g.,
+ *     timestamps). When a key is appended at the right edge of the tree,
+ *     a full node is not split in half; the new key starts an empty
+ *     right sibling instead. Loading sorted data therefore produces
+ *     completely filled nodes, which is equivalent to a bulk load and
+ *     minimizes the number of node rewrites in flash.
+ */
+
+#include <limits.h>
+#include <string.h>
+
+#include "cfs/cfs.h"
+#include "lib/memb.h"
+
+#include "db-options.h"
+#include "index.h"
+#include "result.h"
+#include "storage.h"
+
+#define DEBUG DEBUG_NONE
+#include "net/ipv6/uip-debug.h"
+
+#define BPTREE_MAGIC		0xb7ee
+#define BPTREE_FLAG_LEAF	0x01
+
+#define NO_NODE			0
+#define HEADER_NODE		0
+
+#if DB_BPTREE_ORDER < 3 || DB_BPTREE_ORDER > 255
+#error "DB_BPTREE_ORDER must be in the range [3, 255]."
+#endif
+
+/* LONG attribute values are stored in 32 bits in the relation, so the
+   keys have the same width. */
+typedef int32_t bptree_key_t;
+typedef uint16_t bptree_node_id_t;
+
+struct bptree_node {
+  uint8_t flags;
+  uint8_t count;
+  /* The right sibling of a leaf node. */
+  bptree_node_id_t next;
+  bptree_key_t keys[DB_BPTREE_ORDER];
+  union {
+    tuple_id_t values[DB_BPTREE_ORDER];
+    bptree_node_id_t children[DB_BPTREE_ORDER + 1];
+  } u;
+};
+typedef struct bptree_node bptree_node_t;
+
+struct bptree_header {
+  uint16_t magic;
+  bptree_node_id_t root;
+  bptree_node_id_t node_count;
+  uint8_t height;
+};
+
+struct bptree {
+  db_storage_id_t storage;
+  struct bptree_header header;
+};
+typedef struct bptree bptree_t;
+
+struct node_cache {
+  bptree_t *tree;
+  bptree_node_id_t node_id;
+  uint16_t last_use;
+  bptree_node_t node;
+};
+
+/* The path from the root to a leaf, recorded during an insertion. */
+struct path_element {
+  bptree_node_id_t node_id;
+  uint8_t child;
+  uint8_t full;
+};
+
+static struct node_cache node_cache[DB_BPTREE_CACHE_SIZE];
+static uint16_t cache_clock;
+MEMB(trees, bptree_t, DB_BPTREE_INDEX_LIMIT);
+
+/* Scratch space for node splits, which handle one more entry than
+   a node can hold. */
+static bptree_key_t split_keys[DB_BPTREE_ORDER + 1];
+static union {
+  tuple_id_t values[DB_BPTREE_ORDER + 1];
+  bptree_node_id_t children[DB_BPTREE_ORDER + 2];
+} split_u;
+
+static db_result_t create(index_t *);
+static db_result_t destroy(index_t *);
+static db_result_t load(index_t *);
+static db_result_t release(index_t *);
+static db_result_t insert(index_t *, attribute_value_t *, tuple_id_t);
+static db_result_t delete(index_t *, attribute_value_t *);
+static tuple_id_t get_next(index_iterator_t *);
+
+index_api_t index_bptree = {
+  INDEX_BPTREE,
+  INDEX_API_EXTERNAL | INDEX_API_RANGE_QUERIES,
+  create,
+  destroy,
+  load,
+  release,
+  insert,
+  delete,
+  get_next
+};
+
+static struct node_cache *
+cache_lookup(bptree_t *tree, bptree_node_id_t node_id)
+{
+  int i;
+
+  for(i = 0; i < DB_BPTREE_CACHE_SIZE; i++) {
+    if(node_cache[i].tree == tree && node_cache[i].node_id == node_id) {
+      node_cache[i].last_use = ++cache_clock;
+      return &node_cache[i];
+    }
+  }
+  return NULL;
+}
+
+static struct node_cache *
+cache_victim(void)
+{
+  int i;
+  struct node_cache *victim;
+
+  victim = &node_cache[0];
+  for(i = 0; i < DB_BPTREE_CACHE_SIZE; i++) {
+    if(node_cache[i].tree == NULL) {
+      return &node_cache[i];
+    }
+    if((uint16_t)(cache_clock - node_cache[i].last_use) >
+       (uint16_t)(cache_clock - victim->last_use)) {
+      victim = &node_cache[i];
+    }
+  }
+  return victim;
+}
+
+static void
+cache_invalidate(bptree_t *tree)
+{
+  int i;
+
+  for(i = 0; i < DB_BPTREE_CACHE_SIZE; i++) {
+    if(node_cache[i].tree == tree) {
+      node_cache[i].tree = NULL;
+    }
+  }
+}
+
+static int
+node_read(bptree_t *tree, bptree_node_id_t node_id, bptree_node_t *node)
+{
+  struct node_cache *cache;
+
+  cache = cache_lookup(tree, node_id);
+  if(cache == NULL) {
+    cache = cache_victim();
+    if(DB_ERROR(storage_read(tree->storage, &cache->node,
+                             (unsigned long)node_id * sizeof(bptree_node_t),
+                             sizeof(bptree_node_t)))) {
+      PRINTF("DB: Failed to read B+-tree node %u\n", (unsigned)node_id);
+      cache->tree = NULL;
+      return 0;
+    }
+    cache->tree = tree;
+    cache->node_id = node_id;
+    cache->last_use = ++cache_clock;
+  }
+
+  memcpy(node, &cache->node, sizeof(*node));
+  return 1;
+}
+
+static int
+node_write(bptree_t *tree, bptree_node_id_t node_id, bptree_node_t *node)
+{
+  struct node_cache *cache;
+
+  if(DB_ERROR(storage_write(tree->storage, node,
+                            (unsigned long)node_id * sizeof(bptree_node_t),
+                            sizeof(bptree_node_t)))) {
+    PRINTF("DB: Failed to write B+-tree node %u\n", (unsigned)node_id);
+    cache = cache_lookup(tree, node_id);
+    if(cache != NULL) {
+      cache->tree = NULL;
+    }
+    return 0;
+  }
+
+  cache = cache_lookup(tree, node_id);
+  if(cache == NULL) {
+    cache = cache_victim();
+    cache->tree = tree;
+    cache->node_id = node_id;
+    cache->last_use = ++cache_clock;
+  }
+  memcpy(&cache->node, node, sizeof(*node));
+
+  return 1;
+}
+
+static int
+header_write(bptree_t *tree)
+{
+  return !DB_ERROR(storage_write(tree->storage, &tree->header,
+                                 HEADER_NODE, sizeof(tree->header)));
+}
+
+static bptree_node_id_t
+node_allocate(bptree_t *tree)
+{
+  if(tree->header.node_count >= DB_BPTREE_NODE_LIMIT) {
+    PRINTF("DB: No more B+-tree nodes available\n");
+    return NO_NODE;
+  }
+
+  return ++tree->header.node_count;
+}
+
+/* Returns the position of the first key that is larger than or equal
+   to the given key. */
+static int
+lower_bound(bptree_node_t *node, long key)
+{
+  int low, high, mid;
+
+  low = 0;
+  high = node->count;
+  while(low < high) {
+    mid = (low + high) / 2;
+    if(node->keys[mid] < key) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+/* Returns the position of the first key that is larger than the
+   given key. */
+static int
+upper_bound(bptree_node_t *node, long key)
+{
+  int low, high, mid;
+
+  low = 0;
+  high = node->count;
+  while(low < high) {
+    mid = (low + high) / 2;
+    if(node->keys[mid] <= key) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+/* Finds the leftmost leaf that may contain the key. */
+static bptree_node_id_t
+find_leaf(bptree_t *tree, long key, bptree_node_t *node)
+{
+  bptree_node_id_t node_id;
+
+  node_id = tree->header.root;
+  for(;;) {
+    if(node_read(tree, node_id, node) == 0) {
+      return NO_NODE;
+    }
+    if(node->flags & BPTREE_FLAG_LEAF) {
+      return node_id;
+    }
+    node_id = node->u.children[lower_bound(node, key)];
+  }
+}
+
+static int
+grow_root(bptree_t *tree, bptree_key_t separator,
+          bptree_node_id_t left, bptree_node_id_t right)
+{
+  bptree_node_t root;
+  bptree_node_id_t root_id;
+
+  root_id = node_allocate(tree);
+  if(root_id == NO_NODE) {
+    return 0;
+  }
+
+  memset(&root, 0, sizeof(root));
+  root.count = 1;
+  root.keys[0] = separator;
+  root.u.children[0] = left;
+  root.u.children[1] = right;
+
+  if(node_write(tree, root_id, &root) == 0) {
+    return 0;
+  }
+
+  tree->header.root = root_id;
+  tree->header.height++;
+  return header_write(tree);
+}
+
+static int
+insert_item(bptree_t *tree, bptree_key_t key, tuple_id_t value)
+{
+  static struct path_element path[DB_BPTREE_MAX_HEIGHT];
+  static bptree_node_t node;
+  static bptree_node_t sibling;
+  bptree_node_id_t node_id;
+  bptree_node_id_t sibling_id;
+  bptree_node_id_t child_id;
+  bptree_key_t separator;
+  int depth;
+  int pos;
+  int total;
+  int left_count;
+  int rightmost;
+  int level;
+  int needed;
+
+  /* Descend to the leaf, recording the path. Equal keys are placed
+     after the existing ones, which keeps the insertion order of
+     duplicates. */
+  node_id = tree->header.root;
+  rightmost = 1;
+  for(depth = 0;; depth++) {
+    if(node_read(tree, node_id, &node) == 0) {
+      return 0;
+    }
+    if(node.flags & BPTREE_FLAG_LEAF) {
+      break;
+    }
+    if(depth >= DB_BPTREE_MAX_HEIGHT) {
+      PRINTF("DB: The B+-tree is too deep\n");
+      return 0;
+    }
+    pos = upper_bound(&node, key);
+    rightmost = rightmost && pos == node.count;
+    path[depth].node_id = node_id;
+    path[depth].child = pos;
+    path[depth].full = node.count == DB_BPTREE_ORDER;
+    node_id = node.u.children[pos];
+  }
+
+  pos = upper_bound(&node, key);
+  rightmost = rightmost && pos == node.count;
+
+  if(node.count < DB_BPTREE_ORDER) {
+    memmove(&node.keys[pos + 1], &node.keys[pos],
+            (node.count - pos) * sizeof(node.keys[0]));
+    memmove(&node.u.values[pos + 1], &node.u.values[pos],
+            (node.count - pos) * sizeof(node.u.values[0]));
+    node.keys[pos] = key;
+    node.u.values[pos] = value;
+    node.count++;
+    return node_write(tree, node_id, &node);
+  }
+
+  /* The leaf is full and has to be split. Count the nodes that the
+     split will allocate on its way up, so that a tree without enough
+     free nodes is left untouched instead of being split halfway. */
+  needed = 1;
+  for(level = depth - 1; level >= 0 && path[level].full; level--) {
+    needed++;
+  }
+  if(level < 0) {
+    /* The root is split as well, which adds a new root. */
+    needed++;
+  }
+  if(tree->header.node_count + needed > DB_BPTREE_NODE_LIMIT) {
+    PRINTF("DB: The B+-tree is full\n");
+    return 0;
+  }
+
+  sibling_id = node_allocate(tree);
+  if(sibling_id == NO_NODE) {
+    return 0;
+  }
+
+  memcpy(split_keys, node.keys, pos * sizeof(split_keys[0]));
+  memcpy(split_u.values, node.u.values, pos * sizeof(split_u.values[0]));
+  split_keys[pos] = key;
+  split_u.values[pos] = value;
+  memcpy(&split_keys[pos + 1], &node.keys[pos],
+         (node.count - pos) * sizeof(split_keys[0]));
+  memcpy(&split_u.values[pos + 1], &node.u.values[pos],
+         (node.count - pos) * sizeof(split_u.values[0]));
+  total = DB_BPTREE_ORDER + 1;
+
+  left_count = rightmost ? DB_BPTREE_ORDER : total / 2;
+
+  memset(&sibling, 0, sizeof(sibling));
+  sibling.flags = BPTREE_FLAG_LEAF;
+  sibling.count = total - left_count;
+  sibling.next = node.next;
+  memcpy(sibling.keys, &split_keys[left_count],
+         sibling.count * sizeof(sibling.keys[0]));
+  memcpy(sibling.u.values, &split_u.values[left_count],
+         sibling.count * sizeof(sibling.u.values[0]));
+
+  node.count = left_count;
+  node.next = sibling_id;
+  memcpy(node.keys, split_keys, left_count * sizeof(node.keys[0]));
+  memcpy(node.u.values, split_u.values, left_count * sizeof(node.u.values[0]));
+
+  /* Write the new sibling first, so that the leaf chain never points
+     to an unwritten node. */
+  if(node_write(tree, sibling_id, &sibling) == 0 ||
+     node_write(tree, node_id, &node) == 0) {
+    return 0;
+  }
+
+  separator = sibling.keys[0];
+  child_id = sibling_id;
+
+  /* Propagate the split upwards. */
+  while(depth-- > 0) {
+    node_id = path[depth].node_id;
+    pos = path[depth].child;
+    if(node_read(tree, node_id, &node) == 0) {
+      return 0;
+    }
+
+    if(node.count < DB_BPTREE_ORDER) {
+      memmove(&node.keys[pos + 1], &node.keys[pos],
+              (node.count - pos) * sizeof(node.keys[0]));
+      memmove(&node.u.children[pos + 2], &node.u.children[pos + 1],
+              (node.count - pos) * sizeof(node.u.children[0]));
+      node.keys[pos] = separator;
+      node.u.children[pos + 1] = child_id;
+      node.count++;
+      if(node_write(tree, node_id, &node) == 0) {
+        return 0;
+      }
+      return header_write(tree);
+    }
+
+    sibling_id = node_allocate(tree);
+    if(sibling_id == NO_NODE) {
+      return 0;
+    }
+
+    memcpy(split_keys, node.keys, pos * sizeof(split_keys[0]));
+    split_keys[pos] = separator;
+    memcpy(&split_keys[pos + 1], &node.keys[pos],
+           (node.count - pos) * sizeof(split_keys[0]));
+    memcpy(split_u.children, node.u.children,
+           (pos + 1) * sizeof(split_u.children[0]));
+    split_u.children[pos + 1] = child_id;
+    memcpy(&split_u.children[pos + 2], &node.u.children[pos + 1],
+           (node.count - pos) * sizeof(split_u.children[0]));
+    total = DB_BPTREE_ORDER + 1;
+
+    /* The key at position left_count moves up to the parent. */
+    left_count = rightmost ? DB_BPTREE_ORDER : total / 2;
+
+    memset(&sibling, 0, sizeof(sibling));
+    sibling.count = total - left_count - 1;
+    memcpy(sibling.keys, &split_keys[left_count + 1],
+           sibling.count * sizeof(sibling.keys[0]));
+    memcpy(sibling.u.children, &split_u.children[left_count + 1],
+           (sibling.count + 1) * sizeof(sibling.u.children[0]));
+
+    node.count = left_count;
+    memcpy(node.keys, split_keys, left_count * sizeof(node.keys[0]));
+    memcpy(node.u.children, split_u.children,
+           (left_count + 1) * sizeof(node.u.children[0]));
+
+    if(node_write(tree, sibling_id, &sibling) == 0 ||
+       node_write(tree, node_id, &node) == 0) {
+      return 0;
+    }
+
+    separator = split_keys[left_count];
+    child_id = sibling_id;
+  }
+
+  PRINTF("DB: The B+-tree root was split\n");
+  return grow_root(tree, separator, tree->header.root, child_id);
+}
+
+static db_result_t
+create(index_t *index)
+{
+  char *filename;
+  bptree_t *tree;
+  bptree_node_t root;
+
+  filename = storage_generate_file("bptree",
+                                   (unsigned long)(DB_BPTREE_NODE_LIMIT + 1) *
+                                   sizeof(bptree_node_t));
+  if(filename == NULL) {
+    PRINTF("DB: Failed to generate a B+-tree file\n");
+    return DB_INDEX_ERROR;
+  }
+
+  memcpy(index->descriptor_file, filename, sizeof(index->descriptor_file));
+
+  index->opaque_data = tree = memb_alloc(&trees);
+  if(tree == NULL) {
+    PRINTF("DB: Failed to allocate a B+-tree\n");
+    cfs_remove(index->descriptor_file);
+    index->descriptor_file[0] = '\0';
+    return DB_ALLOCATION_ERROR;
+  }
+
+  tree->storage = storage_open(index->descriptor_file);
+  if(tree->storage < 0) {
+    goto error;
+  }
+
+  tree->header.magic = BPTREE_MAGIC;
+  tree->header.root = 1;
+  tree->header.node_count = 1;
+  tree->header.height = 1;
+
+  memset(&root, 0, sizeof(root));
+  root.flags = BPTREE_FLAG_LEAF;
+
+  if(node_write(tree, tree->header.root, &root) == 0 ||
+     header_write(tree) == 0) {
+    goto error;
+  }
+
+  PRINTF("DB: Created a B+-tree index in \"%s\"\n", index->descriptor_file);
+
+  return DB_OK;
+
+error:
+  cache_invalidate(tree);
+  storage_close(tree->storage);
+  memb_free(&trees, tree);
+  cfs_remove(index->descriptor_file);
+  index->descriptor_file[0] = '\0';
+  return DB_STORAGE_ERROR;
+}
+
+static db_result_t
+destroy(index_t *index)
+{
+  /* The tree has already been released by the index layer. */
+  if(cfs_remove(index->descriptor_file) < 0) {
+    return DB_STORAGE_ERROR;
+  }
+  return DB_OK;
+}
+
+static db_result_t
+load(index_t *index)
+{
+  bptree_t *tree;
+
+  index->opaque_data = tree = memb_alloc(&trees);
+  if(tree == NULL) {
+    PRINTF("DB: Failed to allocate a B+-tree\n");
+    return DB_ALLOCATION_ERROR;
+  }
+
+  tree->storage = storage_open(index->descriptor_file);
+  if(tree->storage < 0) {
+    memb_free(&trees, tree);
+    return DB_STORAGE_ERROR;
+  }
+
+  if(DB_ERROR(storage_read(tree->storage, &tree->header, HEADER_NODE,
+                           sizeof(tree->header))) ||
+     tree->header.magic != BPTREE_MAGIC) {
+    PRINTF("DB: Invalid B+-tree header in %s\n", index->descriptor_file);
+    storage_close(tree->storage);
+    memb_free(&trees, tree);
+    return DB_STORAGE_ERROR;
+  }
+
+  PRINTF("DB: Loaded a B+-tree index of height %u with %u nodes from %s\n",
+         (unsigned)tree->header.height, (unsigned)tree->header.node_count,
+         index->descriptor_file);
+
+  return DB_OK;
+}
+
+static db_result_t
+release(index_t *index)
+{
+  bptree_t *tree;
+
+  tree = index->opaque_data;
+  cache_invalidate(tree);
+  storage_close(tree->storage);
+  memb_free(&trees, tree);
+
+  return DB_OK;
+}
+
+static db_result_t
+insert(index_t *index, attribute_value_t *key, tuple_id_t value)
+{
+  bptree_t *tree;
+  long long_key;
+
+  tree = (bptree_t *)index->opaque_data;
+  long_key = db_value_to_long(key);
+
+  if(long_key < INT32_MIN || long_key > INT32_MAX) {
+    PRINTF("DB: The key %ld does not fit in a B+-tree index\n", long_key);
+    return DB_INDEX_ERROR;
+  }
+
+  if(insert_item(tree, (bptree_key_t)long_key, value) == 0) {
+    PRINTF("DB: Failed to insert key %ld into a B+-tree index\n", long_key);
+    return DB_INDEX_ERROR;
+  }
+
+  return DB_OK;
+}
+
+static db_result_t
+delete(index_t *index, attribute_value_t *value)
+{
+  bptree_t *tree;
+  bptree_node_t node;
+  bptree_node_id_t node_id;
+  long key;
+  int pos;
+
+  tree = (bptree_t *)index->opaque_data;
+  key = db_value_to_long(value);
+
+  /* Remove the first occurrence of the key. Nodes are not merged,
+     since that would require additional rewrites of flash pages. */
+  for(node_id = find_leaf(tree, key, &node); node_id != NO_NODE;) {
+    pos = lower_bound(&node, key);
+    if(pos < node.count) {
+      if(node.keys[pos] != key) {
+        break;
+      }
+      node.count--;
+      memmove(&node.keys[pos], &node.keys[pos + 1],
+              (node.count - pos) * sizeof(node.keys[0]));
+      memmove(&node.u.values[pos], &node.u.values[pos + 1],
+              (node.count - pos) * sizeof(node.u.values[0]));
+      return node_write(tree, node_id, &node) ? DB_OK : DB_STORAGE_ERROR;
+    }
+
+    node_id = node.next;
+    if(node_id != NO_NODE && node_read(tree, node_id, &node) == 0) {
+      return DB_STORAGE_ERROR;
+    }
+  }
+
+  return DB_INDEX_ERROR;
+}
+
+static tuple_id_t
+get_next(index_iterator_t *iterator)
+{
+  bptree_t *tree;
+  bptree_node_t node;
+  bptree_node_id_t node_id;
+  long min;
+  long max;
+  int slot;
+
+  tree = (bptree_t *)iterator->index->opaque_data;
+  min = db_value_to_long(&iterator->min_value);
+  max = db_value_to_long(&iterator->max_value);
+
+  if(iterator->next_item_no == 0) {
+    /* Position the cursor at the lower bound of the range. */
+    node_id = find_leaf(tree, min, &node);
+    if(node_id == NO_NODE) {
+      return INVALID_TUPLE;
+    }
+    slot = lower_bound(&node, min);
+  } else {
+    node_id = iterator->cursor_node;
+    slot = iterator->cursor_slot;
+    if(node_id == NO_NODE || node_read(tree, node_id, &node) == 0) {
+      return INVALID_TUPLE;
+    }
+  }
+
+  /* Skip over exhausted leaves along the leaf chain. */
+  while(slot >= node.count) {
+    node_id = node.next;
+    slot = 0;
+    if(node_id == NO_NODE || node_read(tree, node_id, &node) == 0) {
+      iterator->cursor_node = NO_NODE;
+      return INVALID_TUPLE;
+    }
+  }
+
+  if(node.keys[slot] > max) {
+    iterator->cursor_node = NO_NODE;
+    return INVALID_TUPLE;
+  }
+
+  iterator->cursor_node = node_id;
+  iterator->cursor_slot = slot + 1;
+  iterator->next_item_no++;
+
+  PRINTF("DB: Found key %ld with value %lu in the B+-tree\n",
+         (long)node.keys[slot], (unsigned long)node.u.values[slot]);
+
+  return node.u.values[slot];
+}
@@ -43,7 +43,8 @@ typedef enum {
   INDEX_NONE = 0,
   INDEX_INLINE = 1,
   INDEX_MEMHASH = 2,
-  INDEX_MAXHEAP = 3
+  INDEX_MAXHEAP = 3,
+  INDEX_BPTREE = 4
 } index_type_t;
 
 #define INDEX_READY		0x00
@@ -77,6 +78,9 @@ struct index_iterator {
   attribute_value_t max_value;
   tuple_id_t next_item_no;
   tuple_id_t found_items;
+  /* Iteration position for index types that keep their keys ordered. */
+  uint16_t cursor_node;
+  uint8_t cursor_slot;
 };
 typedef struct index_iterator index_iterator_t;
 
@@ -97,6 +101,7 @@ typedef struct index_api index_api_t;
 extern index_api_t index_inline;
 extern index_api_t index_maxheap;
 extern index_api_t index_memhash;
+extern index_api_t index_bptree;
 
 void index_init(void);
 db_result_t index_create(index_type_t, relation_t *, attribute_t *);
@@ -64,11 +64,31 @@
 #define LVM_USE_FLOATS			0
 #endif
 
+#ifndef LVM_PROGRAM_SIZE
+#define LVM_PROGRAM_SIZE		32
+#endif
+
+#ifndef LVM_STACK_DEPTH
+#define LVM_STACK_DEPTH			8
+#endif
+
 #define IS_CONNECTIVE(op) ((op) & LVM_CONNECTIVE)
 
+/* Fields are stored in big-endian order. The casts sign-extend the
+   values to the width of long. */
+#define FIELD_INT(field)  ((long)(int16_t)((uint16_t)(field)[0] << 8 | \
+                                           (field)[1]))
+#define FIELD_LONG(field) ((long)(int32_t)((uint32_t)(field)[0] << 24 | \
+                                           (uint32_t)(field)[1] << 16 | \
+                                           (uint32_t)(field)[2] << 8 | \
+                                           (field)[3]))
+
 struct variable {
   operand_type_t type;
   operand_value_t value;
+  /* A bound variable reads its value directly from a field in a row. */
+  unsigned char *field;
+  uint8_t field_size;
   char name[LVM_MAX_NAME_LENGTH + 1];
 };
 typedef struct variable variable_t;
@@ -87,6 +107,62 @@ static variable_t variables[LVM_MAX_VARIABLE_ID];
 /* Range derivations of variables that are used for index searches. */
 static derivation_t derivations[LVM_MAX_VARIABLE_ID];
 
+#if LVM_PROGRAM_SIZE > 0
+/*
+ * A compiled program is a flat sequence of instructions in postfix
+ * order, which operate on a small stack of values. Variables are
+ * resolved to identifiers or row fields, constant subexpressions are
+ * folded, and logical connectives become conditional jumps that skip
+ * the evaluation of the second operand when the result is already
+ * known. A second operand that contains a division is left to the
+ * interpreter, which evaluates it and reports a division by zero.
+ */
+enum opcode {
+  OP_END,
+  OP_PUSH,
+  OP_LOAD,
+  OP_LOAD_INT,
+  OP_LOAD_LONG,
+  OP_ADD,
+  OP_SUB,
+  OP_MUL,
+  OP_DIV,
+  OP_EQ,
+  OP_NEQ,
+  OP_GE,
+  OP_GEQ,
+  OP_LE,
+  OP_LEQ,
+  OP_NOT,
+  /* Jump if the top of the stack is false, or pop it otherwise. */
+  OP_AND,
+  /* Jump if the top of the stack is true, or pop it otherwise. */
+  OP_OR
+};
+
+struct instruction {
+  uint8_t opcode;
+  union {
+    long value;
+    variable_id_t id;
+    unsigned char *field;
+    uint8_t target;
+  } arg;
+};
+
+#if LVM_PROGRAM_SIZE > 255
+#error "LVM_PROGRAM_SIZE must not exceed 255 instructions."
+#endif
+
+static struct instruction program[LVM_PROGRAM_SIZE];
+static uint8_t program_length;
+static uint8_t stack_depth;
+static uint8_t max_stack_depth;
+
+/* The instance whose bytecode the program has been compiled from. */
+static lvm_instance_t *compiled_instance;
+#endif /* LVM_PROGRAM_SIZE > 0 */
+
 #if DEBUG
 static void
 print_derivations(derivation_t *d)
@@ -144,6 +220,31 @@ get_type(lvm_instance_t *p)
   return node_type;
 }
 
+static long
+field_to_long(unsigned char *field, unsigned size)
+{
+  return size == 2 ? FIELD_INT(field) : FIELD_LONG(field);
+}
+
+static long
+variable_to_long(variable_id_t id)
+{
+  if(variables[id].field != NULL) {
+    return field_to_long(variables[id].field, variables[id].field_size);
+  }
+  return variables[id].value.l;
+}
+
+static void
+invalidate_program(lvm_instance_t *p)
+{
+#if LVM_PROGRAM_SIZE > 0
+  if(compiled_instance == p) {
+    compiled_instance = NULL;
+  }
+#endif /* LVM_PROGRAM_SIZE > 0 */
+}
+
 static long
 operand_to_long(operand_t *operand)
 {
@@ -156,7 +257,7 @@ operand_to_long(operand_t *operand)
     break;
 #endif /* LVM_USE_FLOATS */
   case LVM_VARIABLE:
-    return variables[operand->value.id].value.l;
+    return variable_to_long(operand->value.id);
   default:
     return 0;
   }
@@ -297,9 +398,383 @@ eval_logic(lvm_instance_t *p, operator_t *op)
   return LVM_EXECUTION_ERROR;
 }
 
+#if LVM_PROGRAM_SIZE > 0
+static int
+emit(uint8_t opcode)
+{
+  if(program_length >= LVM_PROGRAM_SIZE) {
+    return -1;
+  }
+
+  program[program_length].opcode = opcode;
+  program[program_length].arg.value = 0;
+
+  switch(opcode) {
+  case OP_PUSH:
+  case OP_LOAD:
+  case OP_LOAD_INT:
+  case OP_LOAD_LONG:
+    if(++stack_depth > max_stack_depth) {
+      max_stack_depth = stack_depth;
+    }
+    break;
+  case OP_NOT:
+  case OP_END:
+    break;
+  default:
+    /* Binary operators and connectives consume one value. */
+    stack_depth--;
+    break;
+  }
+
+  return program_length++;
+}
+
+static int
+is_constant(int start)
+{
+  return program_length == start + 1 && program[start].opcode == OP_PUSH;
+}
+
+/* Replace the code generated from the start position with a constant. */
+static void
+fold(int start, uint8_t depth, long value)
+{
+  program_length = start;
+  stack_depth = depth;
+  emit(OP_PUSH);
+  program[start].arg.value = value;
+}
+
+static lvm_status_t
+compile_operand(lvm_instance_t *p)
+{
+  operand_t operand;
+  variable_t *var;
+  int i;
+
+  get_operand(p, &operand);
+
+  switch(operand.type) {
+  case LVM_VARIABLE:
+    if(operand.value.id >= LVM_MAX_VARIABLE_ID) {
+      return LVM_SEMANTIC_ERROR;
+    }
+    var = &variables[operand.value.id];
+    if(var->field == NULL) {
+      i = emit(OP_LOAD);
+      if(i >= 0) {
+        program[i].arg.id = operand.value.id;
+      }
+    } else {
+      i = emit(var->field_size == 2 ? OP_LOAD_INT : OP_LOAD_LONG);
+      if(i >= 0) {
+        program[i].arg.field = var->field;
+      }
+    }
+    break;
+  default:
+    i = emit(OP_PUSH);
+    if(i >= 0) {
+      program[i].arg.value = operand_to_long(&operand);
+    }
+    break;
+  }
+
+  return i < 0 ? LVM_STACK_OVERFLOW : LVM_TRUE;
+}
+
+static long
+apply(uint8_t opcode, long l1, long l2)
+{
+  switch(opcode) {
+  case OP_ADD:
+    return l1 + l2;
+  case OP_SUB:
+    return l1 - l2;
+  case OP_MUL:
+    return l1 * l2;
+  case OP_DIV:
+    return l1 / l2;
+  case OP_EQ:
+    return l1 == l2;
+  case OP_NEQ:
+    return l1 != l2;
+  case OP_GE:
+    return l1 > l2;
+  case OP_GEQ:
+    return l1 >= l2;
+  case OP_LE:
+    return l1 < l2;
+  case OP_LEQ:
+    return l1 <= l2;
+  default:
+    return 0;
+  }
+}
+
+static uint8_t
+operator_to_opcode(operator_t op)
+{
+  switch(op) {
+  case LVM_ADD:
+    return OP_ADD;
+  case LVM_SUB:
+    return OP_SUB;
+  case LVM_MUL:
+    return OP_MUL;
+  case LVM_DIV:
+    return OP_DIV;
+  case LVM_EQ:
+    return OP_EQ;
+  case LVM_NEQ:
+    return OP_NEQ;
+  case LVM_GE:
+    return OP_GE;
+  case LVM_GEQ:
+    return OP_GEQ;
+  case LVM_LE:
+    return OP_LE;
+  case LVM_LEQ:
+    return OP_LEQ;
+  case LVM_AND:
+    return OP_AND;
+  case LVM_OR:
+    return OP_OR;
+  case LVM_NOT:
+    return OP_NOT;
+  default:
+    return OP_END;
+  }
+}
+
+/* Compile the two operands of an arithmetic or relational operator. */
+static lvm_status_t
+compile_binary(lvm_instance_t *p, operator_t op)
+{
+  int i;
+  int start;
+  int operand_start[2];
+  uint8_t depth;
+  node_type_t type;
+  operator_t *operator;
+  lvm_status_t r;
+  uint8_t opcode;
+
+  opcode = operator_to_opcode(op);
+  if(opcode == OP_END) {
+    return LVM_EXECUTION_ERROR;
+  }
+
+  start = program_length;
+  depth = stack_depth;
+  for(i = 0; i < 2; i++) {
+    operand_start[i] = program_length;
+    type = get_type(p);
+    switch(type) {
+    case LVM_ARITH_OP:
+      operator = get_operator(p);
+      r = compile_binary(p, *operator);
+      break;
+    case LVM_OPERAND:
+      r = compile_operand(p);
+      break;
+    default:
+      return LVM_SEMANTIC_ERROR;
+    }
+    if(LVM_ERROR(r)) {
+      return r;
+    }
+  }
+
+  if(program[operand_start[0]].opcode == OP_PUSH &&
+     operand_start[1] == operand_start[0] + 1 && is_constant(operand_start[1]) &&
+     !(opcode == OP_DIV && program[operand_start[1]].arg.value == 0)) {
+    /* Both operands are constant. A division by zero is left for the
+       execution, so that it is reported as an error. */
+    fold(start, depth, apply(opcode, program[operand_start[0]].arg.value,
+                             program[operand_start[1]].arg.value));
+    return LVM_TRUE;
+  }
+
+  return emit(opcode) < 0 ? LVM_STACK_OVERFLOW : LVM_TRUE;
+}
+
+/* Checks whether the instructions from the given position onwards
+   can fail at run time. */
+static int
+may_fail(int start)
+{
+  for(; start < program_length; start++) {
+    if(program[start].opcode == OP_DIV) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static lvm_status_t
+compile_logic(lvm_instance_t *p, operator_t op)
+{
+  int i;
+  int start;
+  int second;
+  int jump;
+  uint8_t depth;
+  unsigned arguments;
+  node_type_t type;
+  operator_t *operator;
+  lvm_status_t r;
+  long value;
+
+  if(!IS_CONNECTIVE(op)) {
+    if(!(op & LVM_CMP_OP)) {
+      return LVM_EXECUTION_ERROR;
+    }
+    return compile_binary(p, op);
+  }
+
+  start = program_length;
+  depth = stack_depth;
+  jump = -1;
+  arguments = op == LVM_NOT ? 1 : 2;
+  second = -1;
+  for(i = 0; i < arguments; i++) {
+    type = get_type(p);
+    if(type != LVM_CMP_OP) {
+      return LVM_SEMANTIC_ERROR;
+    }
+    operator = get_operator(p);
+    if(i == 1) {
+      second = program_length;
+    }
+    r = compile_logic(p, *operator);
+    if(LVM_ERROR(r)) {
+      return r;
+    }
+
+    if(i == 0 && arguments == 2) {
+      if(is_constant(start)) {
+        value = program[start].arg.value;
+        if((op == LVM_AND && !value) || (op == LVM_OR && value)) {
+          /* The result is given by the first operand. Compile the
+             second operand to advance the instruction pointer, and
+             then discard it. */
+          type = get_type(p);
+          if(type != LVM_CMP_OP) {
+            return LVM_SEMANTIC_ERROR;
+          }
+          operator = get_operator(p);
+          second = program_length;
+          r = compile_logic(p, *operator);
+          if(LVM_ERROR(r)) {
+            return r;
+          }
+          if(may_fail(second)) {
+            /* The interpreter reports the error. */
+            return LVM_EXECUTION_ERROR;
+          }
+          fold(start, depth, value != 0);
+          return LVM_TRUE;
+        }
+        /* The result is given by the second operand. */
+        program_length = start;
+        stack_depth--;
+        continue;
+      }
+      jump = emit(operator_to_opcode(op));
+      if(jump < 0) {
+        return LVM_STACK_OVERFLOW;
+      }
+    }
+  }
+
+  if(op == LVM_NOT) {
+    if(is_constant(start)) {
+      fold(start, depth, !program[start].arg.value);
+      return LVM_TRUE;
+    }
+    return emit(OP_NOT) < 0 ? LVM_STACK_OVERFLOW : LVM_TRUE;
+  }
+
+  if(jump >= 0) {
+    if(may_fail(second)) {
+      /* A skipped division by zero would go unnoticed, whereas the
+         interpreter evaluates both operands and reports it. */
+      return LVM_EXECUTION_ERROR;
+    }
+    /* The jump skips the second operand, leaving the first one
+       as the result. */
+    program[jump].arg.target = program_length;
+  }
+
+  return LVM_TRUE;
+}
+
+static lvm_status_t
+execute_program(void)
+{
+  long stack[LVM_STACK_DEPTH];
+  long *sp;
+  struct instruction *instruction;
+  unsigned char *field;
+
+  sp = stack;
+  for(instruction = program;; instruction++) {
+    switch(instruction->opcode) {
+    case OP_END:
+      return sp[-1] ? LVM_TRUE : LVM_FALSE;
+    case OP_PUSH:
+      *sp++ = instruction->arg.value;
+      break;
+    case OP_LOAD:
+      *sp++ = variables[instruction->arg.id].value.l;
+      break;
+    case OP_LOAD_INT:
+      field = instruction->arg.field;
+      *sp++ = FIELD_INT(field);
+      break;
+    case OP_LOAD_LONG:
+      field = instruction->arg.field;
+      *sp++ = FIELD_LONG(field);
+      break;
+    case OP_DIV:
+      if(sp[-1] == 0) {
+        return LVM_MATH_ERROR;
+      }
+      sp--;
+      sp[-1] /= sp[0];
+      break;
+    case OP_NOT:
+      sp[-1] = !sp[-1];
+      break;
+    case OP_AND:
+      if(!sp[-1]) {
+        instruction = &program[instruction->arg.target - 1];
+      } else {
+        sp--;
+      }
+      break;
+    case OP_OR:
+      if(sp[-1]) {
+        instruction = &program[instruction->arg.target - 1];
+      } else {
+        sp--;
+      }
+      break;
+    default:
+      sp--;
+      sp[-1] = apply(instruction->opcode, sp[-1], sp[0]);
+      break;
+    }
+  }
+}
+#endif /* LVM_PROGRAM_SIZE > 0 */
+
 void
 lvm_reset(lvm_instance_t *p, unsigned char *code, lvm_ip_t size)
 {
+  invalidate_program(p);
   memset(code, 0, size);
   p->code = code;
   p->size = size;
@@ -316,6 +791,7 @@ lvm_jump_to_operand(lvm_instance_t *p)
 {
   lvm_ip_t old_end;
 
+  invalidate_program(p);
   old_end = p->end;
   p->end += sizeof(operator_t) + sizeof(node_type_t);
   if(p->end >= p->size) {
@@ -332,6 +808,7 @@ lvm_shift_for_operator(lvm_instance_t *p, lvm_ip_t end)
   unsigned char *ptr;
   lvm_ip_t old_end;
 
+  invalidate_program(p);
   old_end = p->end;
 
   if(p->end + sizeof(operator_t) + sizeof(node_type_t) > p->size ||
@@ -364,12 +841,51 @@ lvm_set_end(lvm_instance_t *p, lvm_ip_t end)
     return p->end;
   }
 
+  invalidate_program(p);
   old_end = p->end;
   p->end = end;
 
   return old_end;
 }
 
+lvm_status_t
+lvm_compile(lvm_instance_t *p)
+{
+#if LVM_PROGRAM_SIZE > 0
+  operator_t *operator;
+  lvm_status_t status;
+
+  invalidate_program(p);
+  program_length = stack_depth = max_stack_depth = 0;
+
+  p->ip = 0;
+  if(get_type(p) != LVM_CMP_OP) {
+    PRINTF("Error: The code must start with a relational operator\n");
+    return LVM_SEMANTIC_ERROR;
+  }
+
+  operator = get_operator(p);
+  status = compile_logic(p, *operator);
+  if(LVM_ERROR(status)) {
+    PRINTF("Compilation error: %d\n", (int)status);
+    return status;
+  }
+
+  if(emit(OP_END) < 0 || max_stack_depth > LVM_STACK_DEPTH) {
+    PRINTF("The program does not fit; using the interpreter\n");
+    return LVM_STACK_OVERFLOW;
+  }
+
+  PRINTF("Compiled %u instructions using a stack depth of %u\n",
+         (unsigned)program_length, (unsigned)max_stack_depth);
+
+  compiled_instance = p;
+  return LVM_TRUE;
+#else
+  return LVM_EXECUTION_ERROR;
+#endif /* LVM_PROGRAM_SIZE > 0 */
+}
+
 lvm_status_t
 lvm_execute(lvm_instance_t *p)
 {
@@ -377,6 +893,12 @@ lvm_execute(lvm_instance_t *p)
   operator_t *operator;
   lvm_status_t status;
 
+#if LVM_PROGRAM_SIZE > 0
+  if(compiled_instance == p) {
+    return execute_program();
+  }
+#endif /* LVM_PROGRAM_SIZE > 0 */
+
   p->ip = 0;
   status = LVM_EXECUTION_ERROR;
   type = get_type(p);
@@ -405,6 +927,7 @@ lvm_set_type(lvm_instance_t *p, node_type_t type)
     return LVM_STACK_OVERFLOW;
   }
 
+  invalidate_program(p);
   *(node_type_t *)(p->code + p->end) = type;
   p->end += sizeof(type);
   return LVM_TRUE;
@@ -516,6 +1039,30 @@ lvm_set_variable_value(char *name, operand_value_t value)
   return LVM_TRUE;
 }
 
+lvm_status_t
+lvm_bind_variable(char *name, unsigned char *field, unsigned size)
+{
+  variable_id_t id;
+
+  id = lookup(name);
+  if(id == LVM_MAX_VARIABLE_ID || variables[id].name[0] == '\0') {
+    return LVM_INVALID_IDENTIFIER;
+  }
+
+  if(field != NULL && size != 2 && size != 4) {
+    return LVM_TYPE_ERROR;
+  }
+
+  /* Compiled programs refer to the fields directly. */
+#if LVM_PROGRAM_SIZE > 0
+  compiled_instance = NULL;
+#endif /* LVM_PROGRAM_SIZE > 0 */
+
+  variables[id].field = field;
+  variables[id].field_size = size;
+  return LVM_TRUE;
+}
+
 lvm_status_t
 lvm_set_variable(lvm_instance_t *p, char *name)
 {
@@ -536,6 +1083,7 @@ lvm_set_variable(lvm_instance_t *p, char *name)
 void
 lvm_clone(lvm_instance_t *dst, lvm_instance_t *src)
 {
+  invalidate_program(dst);
   memcpy(dst, src, sizeof(*dst));
 }
 
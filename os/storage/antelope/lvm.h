@@ -127,9 +127,12 @@ lvm_status_t lvm_get_derived_range(lvm_instance_t *p, char *name,
                                    operand_value_t *min,
                                    operand_value_t *max);
 void lvm_print_derivations(lvm_instance_t *p);
+lvm_status_t lvm_compile(lvm_instance_t *p);
 lvm_status_t lvm_execute(lvm_instance_t *p);
 lvm_status_t lvm_register_variable(char *name, operand_type_t type);
 lvm_status_t lvm_set_variable_value(char *name, operand_value_t value);
+lvm_status_t lvm_bind_variable(char *name, unsigned char *field,
+                               unsigned size);
 void lvm_print_code(lvm_instance_t *p);
 lvm_ip_t lvm_jump_to_operand(lvm_instance_t *p);
 lvm_ip_t lvm_shift_for_operator(lvm_instance_t *p, lvm_ip_t end);
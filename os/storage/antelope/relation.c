@@ -81,6 +81,34 @@ struct source_map {
 static struct source_map source_map[AQL_ATTRIBUTE_LIMIT];
 #endif /* DB_FEATURE_JOIN */
 
+/*
+ * Aggregates are computed during the scan of the relation, without
+ * storing the selected tuples. A grouped selection keeps at most
+ * DB_GROUP_LIMIT groups, sorted by their keys. If there are more groups,
+ * the groups with the smallest keys are completed and returned first,
+ * and the relation is then scanned again for the remaining groups.
+ * A selection without a GROUP BY clause aggregates into a single group.
+ */
+struct group {
+  long key;
+  tuple_id_t count;
+  long values[AQL_ATTRIBUTE_LIMIT];
+};
+
+#if DB_GROUP_LIMIT < 1
+#error "DB_GROUP_LIMIT must be at least 1."
+#endif
+
+static struct group groups[DB_GROUP_LIMIT];
+static uint8_t group_count;
+static uint8_t next_group;
+/* Set if groups have been left for a later scan. */
+static uint8_t groups_deferred;
+/* Set if the groups up to last_group_key have been returned. */
+static uint8_t groups_returned;
+static long last_group_key;
+static struct source_dest_map *group_attr;
+
 static unsigned char row[DB_MAX_ATTRIBUTES_PER_RELATION * DB_MAX_ELEMENT_SIZE];
 static unsigned char extra_row[DB_MAX_ATTRIBUTES_PER_RELATION * DB_MAX_ELEMENT_SIZE];
 static unsigned char result_row[AQL_ATTRIBUTE_LIMIT * DB_MAX_ELEMENT_SIZE];
@@ -250,7 +278,10 @@ relation_load(char *name)
   list_add(relations, rel);
 
 end:
-  if(rel->dir == DB_STORAGE && DB_ERROR(storage_load(rel))) {
+  /* A relation that is already loaded keeps its open tuple file, along
+     with any tuples buffered for insertion into it. */
+  if(rel->dir == DB_STORAGE && !RELATION_HAS_TUPLES(rel) &&
+     DB_ERROR(storage_load(rel))) {
     relation_release(rel);
     return NULL;
   }
@@ -548,10 +579,15 @@ relation_insert(relation_t *rel, attribute_value_t *values)
 }
 
 static void
-aggregate(attribute_t *attr, attribute_value_t *value)
+aggregate(uint8_t aggregator, long *state, attribute_value_t *value)
 {
   long long_value;
 
+  if(aggregator == AQL_COUNT) {
+    (*state)++;
+    return;
+  }
+
   switch(value->domain) {
   case DOMAIN_INT:
     long_value = VALUE_INT(value);
@@ -563,25 +599,21 @@ aggregate(attribute_t *attr, attribute_value_t *value)
     return;
   }
 
-  switch(attr->aggregator) {
-  case AQL_COUNT:
-    attr->aggregation_value++;
-    break;
+  switch(aggregator) {
   case AQL_SUM:
-    attr->aggregation_value += long_value;
-    break;
   case AQL_MEAN:
+    *state += long_value;
     break;
   case AQL_MEDIAN:
     break;
   case AQL_MAX:
-    if(long_value > attr->aggregation_value) {
-      attr->aggregation_value = long_value;
+    if(long_value > *state) {
+      *state = long_value;
     }
     break;
   case AQL_MIN:
-    if(long_value < attr->aggregation_value) {
-      attr->aggregation_value = long_value;
+    if(long_value < *state) {
+      *state = long_value;
     }
     break;
   default:
@@ -589,6 +621,150 @@ aggregate(attribute_t *attr, attribute_value_t *value)
   }
 }
 
+static void
+group_init(struct group *group, long key, unsigned attribute_count)
+{
+  unsigned i;
+
+  group->key = key;
+  group->count = 0;
+  for(i = 0; i < attribute_count; i++) {
+    switch(attr_map[i].to_attr->aggregator) {
+    case AQL_MAX:
+      group->values[i] = LONG_MIN;
+      break;
+    case AQL_MIN:
+      group->values[i] = LONG_MAX;
+      break;
+    default:
+      group->values[i] = 0;
+      break;
+    }
+  }
+}
+
+static struct group *
+group_lookup(long key, unsigned attribute_count)
+{
+  int low;
+  int high;
+  int middle;
+
+  if(groups_returned && key <= last_group_key) {
+    /* The group has been returned after an earlier scan. */
+    return NULL;
+  }
+
+  low = 0;
+  high = group_count;
+  while(low < high) {
+    middle = (low + high) / 2;
+    if(groups[middle].key < key) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+
+  if(low < group_count && groups[low].key == key) {
+    return &groups[low];
+  }
+
+  if(group_count == DB_GROUP_LIMIT) {
+    /* Defer the group with the largest key to a later scan. */
+    groups_deferred = 1;
+    if(low == group_count) {
+      return NULL;
+    }
+    group_count--;
+  }
+
+  memmove(&groups[low + 1], &groups[low],
+          (group_count - low) * sizeof(groups[0]));
+  group_count++;
+  group_init(&groups[low], key, attribute_count);
+
+  return &groups[low];
+}
+
+static db_result_t
+aggregate_row(unsigned attribute_count)
+{
+  struct source_dest_map *attr_map_ptr;
+  struct group *group;
+  attribute_value_t value;
+  db_result_t result;
+  long key;
+  unsigned i;
+
+  key = 0;
+  if(group_attr != NULL) {
+    result = db_phy_to_value(&value, group_attr->from_attr,
+                             row + group_attr->from_offset);
+    if(DB_ERROR(result)) {
+      return result;
+    }
+    key = db_value_to_long(&value);
+  }
+
+  group = group_lookup(key, attribute_count);
+  if(group == NULL) {
+    return DB_OK;
+  }
+
+  group->count++;
+  for(i = 0; i < attribute_count; i++) {
+    attr_map_ptr = &attr_map[i];
+    if(attr_map_ptr->to_attr->aggregator == AQL_NONE) {
+      continue;
+    }
+    result = db_phy_to_value(&value, attr_map_ptr->from_attr,
+                             row + attr_map_ptr->from_offset);
+    if(DB_ERROR(result)) {
+      return result;
+    }
+    aggregate(attr_map_ptr->to_attr->aggregator, &group->values[i], &value);
+  }
+
+  return DB_OK;
+}
+
+static void
+generate_group_result(struct group *group, unsigned attribute_count)
+{
+  struct source_dest_map *attr_map_ptr;
+  attribute_t *result_attr;
+  attribute_value_t value;
+  long long_value;
+  unsigned i;
+
+  for(i = 0; i < attribute_count; i++) {
+    attr_map_ptr = &attr_map[i];
+    result_attr = attr_map_ptr->to_attr;
+    if(result_attr->flags & ATTRIBUTE_FLAG_NO_STORE) {
+      continue;
+    }
+
+    long_value = group->values[i];
+    if(result_attr->flags & ATTRIBUTE_FLAG_GROUP) {
+      long_value = group->key;
+    } else if(group->count == 0) {
+      /* An aggregation over no tuples yields zeroes. */
+      long_value = 0;
+    } else if(result_attr->aggregator == AQL_MEAN) {
+      long_value /= (long)group->count;
+    }
+
+    value.domain = result_attr->domain;
+    if(value.domain == DOMAIN_INT) {
+      VALUE_INT(&value) = long_value;
+    } else {
+      VALUE_LONG(&value) = long_value;
+    }
+    db_value_to_phy(result_row + attr_map_ptr->to_offset, result_attr, &value);
+  }
+}
+
 static db_result_t
 generate_attribute_map(struct source_dest_map *attr_map, unsigned attribute_count,
                        relation_t *from_rel, relation_t *to_rel, 
@@ -636,11 +812,13 @@ select_index(db_handle_t *handle, lvm_instance_t *lvm_instance)
   operand_value_t max;
   attribute_value_t av_min;
   attribute_value_t av_max;
-  long range;
+  unsigned long range;
   unsigned long min_range;
+  unsigned long max_emulated_range;
 
   index = NULL;
   min_range = ULONG_MAX;
+  max_emulated_range = relation_cardinality(handle->rel) / DB_INDEX_COST;
 
   /* Find all indexed and derived attributes, and select the index of 
      the attribute with the smallest range. */
@@ -650,12 +828,22 @@ select_index(db_handle_t *handle, lvm_instance_t *lvm_instance)
     if(attr->index != NULL &&
        !LVM_ERROR(lvm_get_derived_range(lvm_instance, attr->name, &min, &max))) {
       range = (unsigned long)max.l - (unsigned long)min.l;
-      PRINTF("DB: The search range for attribute \"%s\" comprises %ld values\n",
+      PRINTF("DB: The search range for attribute \"%s\" comprises %lu values\n",
              attr->name, range + 1);
 
+      /* A wide range is only worth an index search if the index
+         can iterate over ranges without probing every key. */
+      if(range > max_emulated_range &&
+         !(((index_t *)attr->index)->api->flags & INDEX_API_RANGE_QUERIES)) {
+        PRINTF("DB: The index of attribute \"%s\" cannot search the range\n",
+               attr->name);
+        continue;
+      }
+
       if(range <= min_range) {
         index = attr->index;
-        av_min.domain = av_max.domain = DOMAIN_INT;
+        min_range = range;
+        av_min.domain = av_max.domain = DOMAIN_LONG;
         VALUE_LONG(&av_min) = min.l;
         VALUE_LONG(&av_max) = max.l;
       }
@@ -671,12 +859,37 @@ select_index(db_handle_t *handle, lvm_instance_t *lvm_instance)
   }
 }
 
+static void
+bind_condition(lvm_instance_t *lvm_instance, unsigned attribute_count)
+{
+  struct source_dest_map *attr_map_ptr;
+  attribute_t *from_attr;
+
+  /* Let the condition read the attribute values directly from the
+     row buffer, instead of updating its variables for each tuple. */
+  for(attr_map_ptr = attr_map;
+      attr_map_ptr < attr_map + attribute_count;
+      attr_map_ptr++) {
+    from_attr = attr_map_ptr->from_attr;
+    if(from_attr->domain == DOMAIN_INT) {
+      lvm_bind_variable(from_attr->name, row + attr_map_ptr->from_offset, 2);
+    } else if(from_attr->domain == DOMAIN_LONG) {
+      lvm_bind_variable(from_attr->name, row + attr_map_ptr->from_offset, 4);
+    }
+  }
+
+  if(LVM_ERROR(lvm_compile(lvm_instance))) {
+    PRINTF("DB: The condition will be interpreted\n");
+  }
+}
+
 static db_result_t
 generate_selection_result(db_handle_t *handle, relation_t *rel, aql_adt_t *adt)
 {
   relation_t *result_rel;
   unsigned attribute_count;
   attribute_t *attr;
+  unsigned i;
 
   result_rel = handle->result_rel;
 
@@ -696,11 +909,28 @@ generate_selection_result(db_handle_t *handle, relation_t *rel, aql_adt_t *adt)
     return DB_IMPLEMENTATION_ERROR;
   }
 
+  group_count = 0;
+  groups_deferred = 0;
+  groups_returned = 0;
+  group_attr = NULL;
+  if(AQL_GET_FLAGS(adt) & AQL_FLAG_GROUP) {
+    for(i = 0; i < attribute_count; i++) {
+      if(attr_map[i].to_attr->flags & ATTRIBUTE_FLAG_GROUP) {
+        group_attr = &attr_map[i];
+      }
+    }
+  }
+
   if(adt->lvm_instance != NULL) {
-    /* Try to establish acceptable ranges for the attribute values. */
-    if(!LVM_ERROR(lvm_derive(adt->lvm_instance))) {
+    /* Try to establish acceptable ranges for the attribute values.
+       A removal keeps the tuples for which the condition is false,
+       and these cannot be found through the derived ranges. */
+    if(!(AQL_GET_FLAGS(adt) & AQL_FLAG_INVERSE_LOGIC) &&
+       !LVM_ERROR(lvm_derive(adt->lvm_instance))) {
       select_index(handle, adt->lvm_instance);
     }
+
+    bind_condition(adt->lvm_instance, attribute_count);
   }
 
   handle->flags |= DB_HANDLE_FLAG_PROCESSING;
@@ -731,6 +961,52 @@ relation_process_remove(void *handle_ptr)
 }
 #endif
 
+static db_result_t
+process_groups(db_handle_t *handle, aql_adt_t *adt, unsigned attribute_count)
+{
+  if(!(handle->flags & DB_HANDLE_FLAG_GROUPS_READY)) {
+    /* The scan has been completed. */
+    handle->flags |= DB_HANDLE_FLAG_GROUPS_READY;
+    next_group = 0;
+    if(group_attr == NULL && group_count == 0) {
+      group_init(&groups[0], 0, attribute_count);
+      group_count = 1;
+    }
+  }
+
+  if(next_group == group_count) {
+    if(!groups_deferred) {
+      return DB_FINISHED;
+    }
+
+    PRINTF("DB: Scanning relation %s again for the deferred groups\n",
+           handle->rel->name);
+    last_group_key = groups[group_count - 1].key;
+    groups_returned = 1;
+    groups_deferred = 0;
+    group_count = 0;
+    handle->flags &= ~DB_HANDLE_FLAG_GROUPS_READY;
+    handle->tuple_id = 0;
+    if(handle->flags & DB_HANDLE_FLAG_SEARCH_INDEX) {
+      handle->flags &= ~DB_HANDLE_FLAG_SEARCH_INDEX;
+      select_index(handle, adt->lvm_instance);
+    }
+    return DB_OK;
+  }
+
+  generate_group_result(&groups[next_group++], attribute_count);
+
+  if(AQL_GET_FLAGS(adt) & AQL_FLAG_ASSIGN) {
+    if(DB_ERROR(storage_put_row(handle->result_rel, result_row))) {
+      PRINTF("DB: Failed to store a row in the result relation!\n");
+      return DB_STORAGE_ERROR;
+    }
+  }
+
+  handle->current_row++;
+  return DB_GOT_ROW;
+}
+
 db_result_t
 relation_process_select(void *handle_ptr)
 {
@@ -741,10 +1017,6 @@ relation_process_select(void *handle_ptr)
   struct source_dest_map *attr_map_ptr, *attr_map_end;
   attribute_t *result_attr;
   unsigned char *from_ptr;
-  unsigned char *to_ptr;
-  operand_value_t operand_value;
-  uint8_t intbuf[2];
-  attribute_value_t value;
   lvm_status_t wanted_result;
 
   handle = (db_handle_t *)handle_ptr;
@@ -753,16 +1025,21 @@ relation_process_select(void *handle_ptr)
   attribute_count = handle->result_rel->attribute_count;
   attr_map_end = attr_map + attribute_count;
 
+  if(handle->flags & DB_HANDLE_FLAG_GROUPS_READY) {
+    return process_groups(handle, adt, attribute_count);
+  }
+
   if(handle->flags & DB_HANDLE_FLAG_SEARCH_INDEX) {
     handle->tuple_id = index_get_next(&handle->index_iterator);
     if(handle->tuple_id == INVALID_TUPLE) {
       PRINTF("DB: An attribute value could not be found in the index\n");
-      if(handle->index_iterator.next_item_no == 0) {
+      if(handle->index_iterator.next_item_no == 0 &&
+         !(handle->index_iterator.index->api->flags & INDEX_API_RANGE_QUERIES)) {
         return DB_INDEX_ERROR;
       }
 
-      if(adt->flags & AQL_FLAG_AGGREGATE) {
-        goto end_aggregation;
+      if(AQL_GET_FLAGS(adt) & AQL_FLAG_AGGREGATE) {
+        return process_groups(handle, adt, attribute_count);
       }
 
       return DB_FINISHED;
@@ -778,35 +1055,23 @@ relation_process_select(void *handle_ptr)
     return result;
   } else if(result == DB_FINISHED) {
     if(AQL_GET_FLAGS(adt) & AQL_FLAG_AGGREGATE) {
-      goto end_aggregation;
+      return process_groups(handle, adt, attribute_count);
     }
     return DB_FINISHED;
   }
 
-  /* Process the attributes in the result relation. */
-  for(attr_map_ptr = attr_map; attr_map_ptr < attr_map_end; attr_map_ptr++) {
-    from_ptr = row + attr_map_ptr->from_offset;
-    result_attr = attr_map_ptr->to_attr;
-
-    /* Update the internal state of the PLE. */
-    if(result_attr->domain == DOMAIN_INT) {
-      operand_value.l = from_ptr[0] << 8 | from_ptr[1];
-      lvm_set_variable_value(result_attr->name, operand_value);
-    } else if(result_attr->domain == DOMAIN_LONG) {
-      operand_value.l = (uint32_t)from_ptr[0] << 24 |
-                        (uint32_t)from_ptr[1] << 16 |
-                        (uint32_t)from_ptr[2] << 8 |
-                        from_ptr[3];
-      lvm_set_variable_value(result_attr->name, operand_value);
-    }
+  if(!(AQL_GET_FLAGS(adt) & AQL_FLAG_AGGREGATE)) {
+    /* Process the attributes in the result relation. */
+    for(attr_map_ptr = attr_map; attr_map_ptr < attr_map_end; attr_map_ptr++) {
+      from_ptr = row + attr_map_ptr->from_offset;
+      result_attr = attr_map_ptr->to_attr;
 
-    if(result_attr->flags & ATTRIBUTE_FLAG_NO_STORE) {
-      /* The attribute is used just for the predicate,
-         so do not copy the current value into the result. */
-      continue;
-    }
+      if(result_attr->flags & ATTRIBUTE_FLAG_NO_STORE) {
+        /* The attribute is used just for the predicate,
+           so do not copy the current value into the result. */
+        continue;
+      }
 
-    if(!(AQL_GET_FLAGS(adt) & AQL_FLAG_AGGREGATE)) {
       /* No aggregators. Copy the original value into the resulting tuple. */
       memcpy(result_row + attr_map_ptr->to_offset, from_ptr,
              result_attr->element_size);
@@ -822,14 +1087,7 @@ relation_process_select(void *handle_ptr)
   if(adt->lvm_instance == NULL ||
      lvm_execute(adt->lvm_instance) == wanted_result) {
     if(AQL_GET_FLAGS(adt) & AQL_FLAG_AGGREGATE) {
-      for(attr_map_ptr = attr_map; attr_map_ptr < attr_map_end; attr_map_ptr++) {
-        from_ptr = row + attr_map_ptr->from_offset;
-        result = db_phy_to_value(&value, attr_map_ptr->to_attr, from_ptr);
-        if(DB_ERROR(result)) {
-	  return result;
-        }
-        aggregate(attr_map_ptr->to_attr, &value);
-      }
+      return aggregate_row(attribute_count);
     } else {
       if(AQL_GET_FLAGS(adt) & AQL_FLAG_ASSIGN) {
         if(DB_ERROR(storage_put_row(handle->result_rel, result_row))) {
@@ -843,30 +1101,6 @@ relation_process_select(void *handle_ptr)
   }
 
   return DB_OK;
-
-end_aggregation:
-  /* Generate aggregated result if requested. */
-  for(attr_map_ptr = attr_map; attr_map_ptr < attr_map_end; attr_map_ptr++) {
-    result_attr = attr_map_ptr->to_attr;
-    to_ptr = result_row + attr_map_ptr->to_offset;
-
-    intbuf[0] = result_attr->aggregation_value >> 8;
-    intbuf[1] = result_attr->aggregation_value & 0xff;
-    from_ptr = intbuf;
-    memcpy(to_ptr, from_ptr, result_attr->element_size);
-  }
-
-  if(AQL_GET_FLAGS(adt) & AQL_FLAG_ASSIGN) {
-    if(DB_ERROR(storage_put_row(handle->result_rel, result_row))) {
-      PRINTF("DB: Failed to store a row in the result relation!\n");
-      return DB_STORAGE_ERROR;
-    }
-  }
-
-  handle->current_row = 1;
-  AQL_GET_FLAGS(adt) &= ~AQL_FLAG_AGGREGATE; /* Stop the aggregation. */
-
-  return DB_GOT_ROW;
 }
 
 db_result_t
@@ -880,6 +1114,9 @@ relation_select(void *handle_ptr, relation_t *rel, void *adt_ptr)
   attribute_t *attr;
   int i;
   int normal_attributes;
+  int aggregated_attributes;
+  domain_t domain;
+  size_t element_size;
 
   adt = (aql_adt_t *)adt_ptr;
 
@@ -903,7 +1140,8 @@ relation_select(void *handle_ptr, relation_t *rel, void *adt_ptr)
     return DB_ALLOCATION_ERROR;
   }
 
-  for(i = normal_attributes = 0; i < AQL_ATTRIBUTE_COUNT(adt); i++) {
+  normal_attributes = aggregated_attributes = 0;
+  for(i = 0; i < AQL_ATTRIBUTE_COUNT(adt); i++) {
     attribute_name = adt->attributes[i].name;
 
     attr = relation_attribute_get(rel, attribute_name);
@@ -916,10 +1154,24 @@ relation_select(void *handle_ptr, relation_t *rel, void *adt_ptr)
     PRINTF("DB: Found attribute %s in relation %s\n",
 	attribute_name, rel->name);
 
+    /* Aggregates have the domain of the aggregated attribute, except
+       for counts. Only integers can be used for other aggregates
+       and for grouping. */
+    domain = attr->domain;
+    element_size = attr->element_size;
+    if(adt->aggregators[i] == AQL_COUNT) {
+      domain = DOMAIN_INT;
+      element_size = 2;
+    } else if((adt->aggregators[i] != AQL_NONE ||
+               (adt->attributes[i].flags & ATTRIBUTE_FLAG_GROUP)) &&
+              domain != DOMAIN_INT && domain != DOMAIN_LONG) {
+      PRINTF("DB: Cannot aggregate or group by attribute %s\n",
+             attribute_name);
+      return DB_TYPE_ERROR;
+    }
+
     attr = relation_attribute_add(handle->result_rel, dir,
-				  attribute_name, 
-				  adt->aggregators[i] ? DOMAIN_INT : attr->domain,
-				  attr->element_size);
+				  attribute_name, domain, element_size);
     if(attr == NULL) {
       PRINTF("DB: Failed to add a result attribute\n");
       relation_release(handle->result_rel);
@@ -927,31 +1179,20 @@ relation_select(void *handle_ptr, relation_t *rel, void *adt_ptr)
     }
 
     attr->aggregator = adt->aggregators[i];
-    switch(attr->aggregator) {
-    case AQL_NONE:
-      if(!(adt->attributes[i].flags & ATTRIBUTE_FLAG_NO_STORE)) {
-        /* Only count attributes projected into the result set. */
-        normal_attributes++;
-      }
-      break;
-    case AQL_MAX:
-      attr->aggregation_value = LONG_MIN;
-      break;
-    case AQL_MIN:
-      attr->aggregation_value = LONG_MAX;
-      break;
-    default:
-      attr->aggregation_value = 0;
-      break;
-    }
-
     attr->flags = adt->attributes[i].flags;
+
+    if(attr->aggregator != AQL_NONE) {
+      aggregated_attributes++;
+    } else if(!(attr->flags & (ATTRIBUTE_FLAG_NO_STORE | ATTRIBUTE_FLAG_GROUP))) {
+      /* Only count attributes projected into the result set. */
+      normal_attributes++;
+    }
   }
 
   /* Preclude mixes of normal attributes and aggregated ones in 
      selection results. */
   if(normal_attributes > 0 &&
-     handle->result_rel->attribute_count > normal_attributes) {
+     (aggregated_attributes > 0 || (AQL_GET_FLAGS(adt) & AQL_FLAG_GROUP))) {
      return DB_RELATIONAL_ERROR;
   }
 
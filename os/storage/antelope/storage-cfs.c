@@ -68,6 +68,189 @@ struct index_record {
 
 #define ROW_XOR 0xf6U
 
+/*
+ * Tuples are read in pages that contain a whole number of rows. The
+ * pages are cached, so that a relation scan or a sequence of index
+ * lookups in the same area of a tuple file can be served without
+ * accessing the file system for each tuple.
+ */
+struct page {
+  cfs_offset_t offset;
+  db_storage_id_t fd;
+  /* The number of valid bytes in the page, or 0 if the page is unused. */
+  uint16_t length;
+  uint16_t last_use;
+  unsigned char data[DB_PAGE_SIZE];
+};
+
+#if DB_PAGE_CACHE_SIZE < 1
+#error "DB_PAGE_CACHE_SIZE must be at least 1."
+#endif
+
+static struct page page_cache[DB_PAGE_CACHE_SIZE];
+static uint16_t page_clock;
+
+#if DB_WRITE_BUFFER_SIZE > 0
+/* Inserted tuples are collected for one relation at a time, and are
+   written to storage when the buffer is full or when the relation
+   is read from or unloaded. */
+static relation_t *write_rel;
+static unsigned write_length;
+static unsigned char write_buffer[DB_WRITE_BUFFER_SIZE];
+#endif /* DB_WRITE_BUFFER_SIZE > 0 */
+
+static void
+page_invalidate(db_storage_id_t fd)
+{
+  int i;
+
+  for(i = 0; i < DB_PAGE_CACHE_SIZE; i++) {
+    if(page_cache[i].fd == fd) {
+      page_cache[i].length = 0;
+    }
+  }
+}
+
+static struct page *
+page_victim(void)
+{
+  int i;
+  struct page *victim;
+
+  victim = &page_cache[0];
+  for(i = 0; i < DB_PAGE_CACHE_SIZE; i++) {
+    if(page_cache[i].length == 0) {
+      return &page_cache[i];
+    }
+    if((uint16_t)(page_clock - page_cache[i].last_use) >
+       (uint16_t)(page_clock - victim->last_use)) {
+      victim = &page_cache[i];
+    }
+  }
+  return victim;
+}
+
+static db_result_t
+page_get(db_storage_id_t fd, cfs_offset_t offset, struct page **pagep)
+{
+  int i;
+  int r;
+  struct page *page;
+  cfs_offset_t end;
+  unsigned length;
+
+  for(i = 0; i < DB_PAGE_CACHE_SIZE; i++) {
+    page = &page_cache[i];
+    if(page->length > 0 && page->fd == fd && page->offset == offset) {
+      page->last_use = ++page_clock;
+      *pagep = page;
+      return DB_OK;
+    }
+  }
+
+  /* Avoid seeking past the end of the file, because Coffee would
+     then extend it. */
+  end = cfs_seek(fd, 0, CFS_SEEK_END);
+  if(end == (cfs_offset_t)-1) {
+    return DB_STORAGE_ERROR;
+  }
+
+  if(offset >= end) {
+    return DB_FINISHED;
+  }
+
+  if(cfs_seek(fd, offset, CFS_SEEK_SET) == (cfs_offset_t)-1) {
+    return DB_STORAGE_ERROR;
+  }
+
+  page = page_victim();
+  page->length = 0;
+
+  length = end - offset < DB_PAGE_SIZE ? end - offset : DB_PAGE_SIZE;
+  for(i = 0; i < length; i += r) {
+    r = cfs_read(fd, page->data + i, length - i);
+    if(r <= 0) {
+      PRINTF("DB: Reading failed on fd %d\n", fd);
+      return DB_STORAGE_ERROR;
+    }
+  }
+
+  PRINTF("DB: Read a page of %u bytes at offset %lu from fd %d\n",
+         length, (unsigned long)offset, fd);
+
+  page->fd = fd;
+  page->offset = offset;
+  page->length = length;
+  page->last_use = ++page_clock;
+  *pagep = page;
+
+  return DB_OK;
+}
+
+static db_result_t
+write_rows(relation_t *rel, unsigned char *rows, unsigned length)
+{
+  cfs_offset_t end;
+  int r;
+#if DB_FEATURE_INTEGRITY
+  int missing_bytes;
+  char buf[rel->row_length];
+#endif
+
+  /* The cached tail page of the file would otherwise be outdated. */
+  page_invalidate(rel->tuple_storage);
+
+  end = cfs_seek(rel->tuple_storage, 0, CFS_SEEK_END);
+  if(end == (cfs_offset_t)-1) {
+    return DB_STORAGE_ERROR;
+  }
+
+#if DB_FEATURE_INTEGRITY
+  missing_bytes = end % rel->row_length;
+  if(missing_bytes > 0) {
+    memset(buf, 0xff, sizeof(buf));
+    r = cfs_write(rel->tuple_storage, buf, sizeof(buf));
+    if(r != missing_bytes) {
+      return DB_STORAGE_ERROR;
+    }
+  }
+#endif
+
+  do {
+    r = cfs_write(rel->tuple_storage, rows, length);
+    if(r < 0) {
+      PRINTF("DB: Failed to store %u bytes\n", length);
+      return DB_STORAGE_ERROR;
+    }
+    rows += r;
+    length -= r;
+  } while(length > 0);
+
+  return DB_OK;
+}
+
+static db_result_t
+flush_rows(relation_t *rel)
+{
+#if DB_WRITE_BUFFER_SIZE > 0
+  unsigned length;
+
+  if(rel == NULL || rel != write_rel) {
+    return DB_OK;
+  }
+
+  length = write_length;
+  write_rel = NULL;
+  write_length = 0;
+
+  PRINTF("DB: Flushing %u bytes to relation %s\n", length, rel->name);
+
+  return write_rows(rel, write_buffer, length);
+#else
+  return DB_OK;
+#endif /* DB_WRITE_BUFFER_SIZE > 0 */
+}
+
 static void
 merge_strings(char *dest, char *prefix, char *suffix)
 {
@@ -120,6 +303,10 @@ storage_unload(relation_t *rel)
   if(RELATION_HAS_TUPLES(rel)) {
     PRINTF("DB: Unload tuple file %s\n", rel->tuple_filename);
 
+    if(DB_ERROR(flush_rows(rel))) {
+      PRINTF("DB: Failed to write the buffered tuples of %s\n", rel->name);
+    }
+    page_invalidate(rel->tuple_storage);
     cfs_close(rel->tuple_storage);
     rel->tuple_storage = -1;
   }
@@ -279,8 +466,21 @@ storage_put_attribute(relation_t *rel, attribute_t *attr)
 db_result_t
 storage_drop_relation(relation_t *rel, int remove_tuples)
 {
-  if(remove_tuples && RELATION_HAS_TUPLES(rel)) {
-    cfs_remove(rel->tuple_filename);
+#if DB_WRITE_BUFFER_SIZE > 0
+  if(rel == write_rel) {
+    /* Keep the buffered tuples if the tuple file is kept. */
+    if(remove_tuples || DB_ERROR(flush_rows(rel))) {
+      write_rel = NULL;
+      write_length = 0;
+    }
+  }
+#endif /* DB_WRITE_BUFFER_SIZE > 0 */
+
+  if(RELATION_HAS_TUPLES(rel)) {
+    page_invalidate(rel->tuple_storage);
+    if(remove_tuples) {
+      cfs_remove(rel->tuple_filename);
+    }
   }
   return cfs_remove(rel->name) < 0 ? DB_STORAGE_ERROR : DB_OK;
 }
@@ -400,8 +600,8 @@ storage_put_index(index_t *index)
   return result;
 }
 
-db_result_t
-storage_get_row(relation_t *rel, tuple_id_t *tuple_id, storage_row_t row)
+static db_result_t
+read_row(relation_t *rel, tuple_id_t *tuple_id, storage_row_t row)
 {
   int r;
   tuple_id_t nrows;
@@ -432,6 +632,44 @@ storage_get_row(relation_t *rel, tuple_id_t *tuple_id, storage_row_t row)
 
   row[rel->row_length - 1] ^= ROW_XOR;
 
+  return DB_OK;
+}
+
+db_result_t
+storage_get_row(relation_t *rel, tuple_id_t *tuple_id, storage_row_t row)
+{
+  unsigned rows_per_page;
+  unsigned position;
+  struct page *page;
+  db_result_t result;
+
+  if(DB_ERROR(flush_rows(rel))) {
+    return DB_STORAGE_ERROR;
+  }
+
+  rows_per_page = DB_PAGE_SIZE / rel->row_length;
+  if(rows_per_page == 0) {
+    /* Rows that do not fit in a page are read directly. */
+    return read_row(rel, tuple_id, row);
+  }
+
+  result = page_get(rel->tuple_storage,
+                    (cfs_offset_t)(*tuple_id / rows_per_page) *
+                    rows_per_page * rel->row_length, &page);
+  if(result != DB_OK) {
+    return result;
+  }
+
+  /* An incomplete record at the end of the file is not counted as a
+     row, just as in storage_get_row_amount(). */
+  position = (*tuple_id % rows_per_page) * rel->row_length;
+  if(position + rel->row_length > page->length) {
+    return DB_FINISHED;
+  }
+
+  memcpy(row, page->data + position, rel->row_length);
+  row[rel->row_length - 1] ^= ROW_XOR;
+
   PRINTF("DB: Read %d bytes from relation %s\n", rel->row_length, rel->name);
 
   return DB_OK;
@@ -440,53 +678,46 @@ storage_get_row(relation_t *rel, tuple_id_t *tuple_id, storage_row_t row)
 db_result_t
 storage_put_row(relation_t *rel, storage_row_t row)
 {
-  cfs_offset_t end;
-  unsigned remaining;
-  int r;
   unsigned char *last_byte;
-#if DB_FEATURE_INTEGRITY
-  int missing_bytes;
-  char buf[rel->row_length];
-#endif
-
-  end = cfs_seek(rel->tuple_storage, 0, CFS_SEEK_END);
-  if(end == (cfs_offset_t)-1) {
-    return DB_STORAGE_ERROR;
-  }
+  db_result_t result;
 
-#if DB_FEATURE_INTEGRITY
-  missing_bytes = end % rel->row_length;
-  if(missing_bytes > 0) {
-    memset(buf, 0xff, sizeof(buf));
-    r = cfs_write(rel->tuple_storage, buf, sizeof(buf));
-    if(r != missing_bytes) {
+#if DB_WRITE_BUFFER_SIZE > 0
+  if(rel->row_length <= sizeof(write_buffer)) {
+    if(rel != write_rel && DB_ERROR(flush_rows(write_rel))) {
       return DB_STORAGE_ERROR;
     }
+
+    memcpy(write_buffer + write_length, row, rel->row_length);
+    write_length += rel->row_length;
+    write_buffer[write_length - 1] ^= ROW_XOR;
+    write_rel = rel;
+
+    PRINTF("DB: Buffered a row of %d bytes\n", rel->row_length);
+
+    if(write_length + rel->row_length > sizeof(write_buffer)) {
+      return flush_rows(rel);
+    }
+    return DB_OK;
   }
-#endif
+
+  if(DB_ERROR(flush_rows(rel))) {
+    return DB_STORAGE_ERROR;
+  }
+#endif /* DB_WRITE_BUFFER_SIZE > 0 */
 
   /* Ensure that last written byte is separated from 0, to make file
      lengths correct in Coffee. */
   last_byte = row + rel->row_length - 1;
   *last_byte ^= ROW_XOR;
 
-  remaining = rel->row_length;
-  do {
-    r = cfs_write(rel->tuple_storage, row, remaining);
-    if(r < 0) {
-      PRINTF("DB: Failed to store %u bytes\n", remaining);
-      *last_byte ^= ROW_XOR;
-      return DB_STORAGE_ERROR;
-    }
-    row += r;
-    remaining -= r;
-  } while(remaining > 0);
-
-  PRINTF("DB: Stored a of %d bytes\n", rel->row_length);
+  result = write_rows(rel, row, rel->row_length);
+  if(!DB_ERROR(result)) {
+    PRINTF("DB: Stored a of %d bytes\n", rel->row_length);
+  }
 
   *last_byte ^= ROW_XOR;
 
-  return DB_OK;
+  return result;
 }
 
 db_result_t
@@ -497,6 +728,10 @@ storage_get_row_amount(relation_t *rel, tuple_id_t *amount)
   if(rel->row_length == 0) {
     *amount = 0;
   } else {
+    if(DB_ERROR(flush_rows(rel))) {
+      return DB_STORAGE_ERROR;
+    }
+
     offset = cfs_seek(rel->tuple_storage, 0, CFS_SEEK_END);
     if(offset == (cfs_offset_t)-1) {
       return DB_STORAGE_ERROR;
@@ -75,6 +75,14 @@
 #define LOG_WITH_ANNOTATE 0
 #endif /* LOG_CONF_WITH_ANNOTATE */
 
+/* Defer formatting and output of the LOG_* macros to a process, see
+ * log-deferred.h */
+#ifdef LOG_CONF_DEFERRED
+#define LOG_DEFERRED LOG_CONF_DEFERRED
+#else /* LOG_CONF_DEFERRED */
+#define LOG_DEFERRED 0
+#endif /* LOG_CONF_DEFERRED */
+
 /* Custom output function -- default is printf */
 #ifdef LOG_CONF_OUTPUT
 #define LOG_OUTPUT(...) LOG_CONF_OUTPUT(__VA_ARGS__)
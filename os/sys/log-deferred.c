@@ -0,0 +1,503 @@
+/*
+ * Copyright (c) 2019, RISE SICS AB.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \addtogroup log
+ * @{
+ *
+ * \file
+ *         Deferred backend for the logging system
+ */
+
+#include "contiki.h"
+#include "sys/log.h"
+#include "sys/rtimer.h"
+#include "sys/int-master.h"
+#include "lib/ringbufindex.h"
+
+#include <stdarg.h>
+#include <string.h>
+
+#if LOG_DEFERRED
+
+/* Check if LOG_DEFERRED_QUEUE_LEN is a power of two */
+#if (LOG_DEFERRED_QUEUE_LEN & (LOG_DEFERRED_QUEUE_LEN - 1)) != 0
+#error LOG_DEFERRED_QUEUE_LEN must be power of two
+#endif
+
+/* The maximum length of a single conversion specification, e.g. "%-08lx" */
+#define SPEC_LEN 12
+
+enum {
+  LOG_DEFERRED_FORMAT,
+  LOG_DEFERRED_MESSAGE,
+  LOG_DEFERRED_LLADDR,
+  LOG_DEFERRED_6ADDR,
+};
+
+enum {
+  ARG_NONE,
+  ARG_INT,
+  ARG_UINT,
+  ARG_LONG,
+  ARG_ULONG,
+  ARG_PTR,
+  ARG_STR,
+  ARG_UNSUPPORTED,
+};
+
+union log_deferred_arg {
+  long l;
+  unsigned long ul;
+  const void *p;
+};
+
+/* The space for a message formatted when it is logged */
+#define MESSAGE_LEN (sizeof(union log_deferred_arg) * LOG_DEFERRED_MAX_ARGS \
+                     + LOG_DEFERRED_STR_LEN)
+
+struct log_deferred_entry {
+  const struct log_deferred_site *site;
+  const char *fmt;
+  rtimer_clock_t timestamp;
+  /* Set once the entry is filled in; entries are reserved before */
+  volatile uint8_t ready;
+  uint8_t type;
+  /* The number of arguments, or 0 for a NULL address */
+  uint8_t nargs;
+  union {
+    /* The raw arguments and copies of the string arguments */
+    struct {
+      union log_deferred_arg args[LOG_DEFERRED_MAX_ARGS];
+      char str[LOG_DEFERRED_STR_LEN];
+    } f;
+    char message[MESSAGE_LEN];
+    linkaddr_t lladdr;
+#if NETSTACK_CONF_WITH_IPV6
+    uip_ipaddr_t ipaddr;
+#endif /* NETSTACK_CONF_WITH_IPV6 */
+  } u;
+};
+
+PROCESS(log_deferred_process, "Deferred log");
+
+/* The queue may be filled before log_deferred_init() is called */
+static struct ringbufindex log_ringbuf = { LOG_DEFERRED_QUEUE_LEN - 1, 0, 0 };
+static struct log_deferred_entry log_array[LOG_DEFERRED_QUEUE_LEN];
+static unsigned log_dropped;
+/* Set by log_deferred_init(); until then, a full queue is flushed at once */
+static uint8_t log_started;
+/* Set while a context outputs the queue */
+static volatile uint8_t log_flushing;
+
+/*---------------------------------------------------------------------------*/
+/* Parses the conversion specification that follows a '%'. Returns its
+ * length and stores the type of its argument in type. */
+static int
+parse_spec(const char *spec, uint8_t *type)
+{
+  const char *p = spec;
+  int is_long = 0;
+
+  *type = ARG_UNSUPPORTED;
+  while(*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0') {
+    p++;
+  }
+  while(*p >= '0' && *p <= '9') {
+    p++;
+  }
+  if(*p == '.') {
+    p++;
+    while(*p >= '0' && *p <= '9') {
+      p++;
+    }
+  }
+  if(*p == 'h') {
+    p++;
+    if(*p == 'h') {
+      p++;
+    }
+  } else if(*p == 'l') {
+    p++;
+    is_long = 1;
+  }
+  if(*p == '\0') {
+    return p - spec;
+  }
+  if(p - spec >= SPEC_LEN - 2) {
+    return p - spec + 1;
+  }
+
+  switch(*p) {
+  case 'd':
+  case 'i':
+    *type = is_long ? ARG_LONG : ARG_INT;
+    break;
+  case 'u':
+  case 'x':
+  case 'X':
+  case 'o':
+    *type = is_long ? ARG_ULONG : ARG_UINT;
+    break;
+  case 'c':
+    *type = is_long ? ARG_UNSUPPORTED : ARG_INT;
+    break;
+  case 'p':
+    *type = ARG_PTR;
+    break;
+  case 's':
+    *type = is_long ? ARG_UNSUPPORTED : ARG_STR;
+    break;
+  case '%':
+    *type = p == spec ? ARG_NONE : ARG_UNSUPPORTED;
+    break;
+  }
+  /* Everything else, including '*' widths, "%ll", "%z" and floating
+     point, cannot be stored as a single raw argument */
+  return p - spec + 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Stores the arguments of fmt. Returns 0 if they cannot be stored. */
+static int
+store_args(struct log_deferred_entry *e, const char *fmt, va_list ap)
+{
+  union log_deferred_arg *arg;
+  const char *s;
+  unsigned str_len = 0;
+  unsigned n;
+  uint8_t type;
+
+  e->nargs = 0;
+  while((fmt = strchr(fmt, '%')) != NULL) {
+    fmt++;
+    fmt += parse_spec(fmt, &type);
+    if(type == ARG_NONE) {
+      continue;
+    }
+    if(type == ARG_UNSUPPORTED || e->nargs == LOG_DEFERRED_MAX_ARGS) {
+      return 0;
+    }
+    arg = &e->u.f.args[e->nargs++];
+    switch(type) {
+    case ARG_INT:
+      arg->l = va_arg(ap, int);
+      break;
+    case ARG_UINT:
+      arg->ul = va_arg(ap, unsigned);
+      break;
+    case ARG_LONG:
+      arg->l = va_arg(ap, long);
+      break;
+    case ARG_ULONG:
+      arg->ul = va_arg(ap, unsigned long);
+      break;
+    case ARG_PTR:
+      arg->p = va_arg(ap, void *);
+      break;
+    case ARG_STR:
+      /* The string may not outlive the call; keep a copy of it */
+      s = va_arg(ap, const char *);
+      if(s == NULL) {
+        s = "(null)";
+      }
+      if(str_len == LOG_DEFERRED_STR_LEN) {
+        /* No space left: point to the terminator of the previous copy */
+        arg->ul = str_len - 1;
+        break;
+      }
+      arg->ul = str_len;
+      n = strlen(s);
+      if(n > LOG_DEFERRED_STR_LEN - str_len - 1) {
+        n = LOG_DEFERRED_STR_LEN - str_len - 1;
+      }
+      memcpy(&e->u.f.str[str_len], s, n);
+      str_len += n;
+      e->u.f.str[str_len++] = '\0';
+      break;
+    }
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Reserves the next entry of the queue. Interrupts are disabled while
+ * reserving, so that several contexts can log. The entry is filled in
+ * with interrupts enabled and is output only after commit(). */
+static struct log_deferred_entry *
+prepare_add(uint8_t type)
+{
+  int_master_status_t status;
+  int index;
+
+  status = int_master_read_and_disable();
+  index = ringbufindex_peek_put(&log_ringbuf);
+  if(index == -1 && !log_started) {
+    /* Still booting: make room rather than dropping boot messages */
+    int_master_status_set(status);
+    log_deferred_flush();
+    status = int_master_read_and_disable();
+    index = ringbufindex_peek_put(&log_ringbuf);
+  }
+  if(index == -1) {
+    log_dropped++;
+  } else {
+    log_array[index].ready = 0;
+    ringbufindex_put(&log_ringbuf);
+  }
+  int_master_status_set(status);
+
+  if(index == -1) {
+    return NULL;
+  }
+  log_array[index].type = type;
+  return &log_array[index];
+}
+/*---------------------------------------------------------------------------*/
+static void
+commit(struct log_deferred_entry *e)
+{
+  e->ready = 1;
+  process_poll(&log_deferred_process);
+}
+/*---------------------------------------------------------------------------*/
+void
+log_deferred_add(const struct log_deferred_site *site, const char *fmt, ...)
+{
+  struct log_deferred_entry *e;
+  va_list ap;
+  int stored;
+  int newline;
+  int len;
+
+  e = prepare_add(LOG_DEFERRED_FORMAT);
+  if(e == NULL) {
+    return;
+  }
+  e->site = site;
+  e->fmt = fmt;
+  e->timestamp = RTIMER_NOW();
+
+  va_start(ap, fmt);
+  stored = store_args(e, fmt, ap);
+  va_end(ap);
+  if(!stored) {
+    /* Fall back to formatting the message now */
+    e->type = LOG_DEFERRED_MESSAGE;
+    va_start(ap, fmt);
+    len = vsnprintf(e->u.message, sizeof(e->u.message), fmt, ap);
+    va_end(ap);
+    if(len >= (int)sizeof(e->u.message)) {
+      /* Mark the truncation, keeping the line ending */
+      newline = fmt[strlen(fmt) - 1] == '\n';
+      strcpy(&e->u.message[sizeof(e->u.message) - 4 - newline],
+             newline ? "...\n" : "...");
+    }
+  }
+  commit(e);
+}
+/*---------------------------------------------------------------------------*/
+void
+log_deferred_add_lladdr(const linkaddr_t *lladdr)
+{
+  struct log_deferred_entry *e = prepare_add(LOG_DEFERRED_LLADDR);
+  if(e == NULL) {
+    return;
+  }
+  e->site = NULL;
+  e->nargs = lladdr != NULL;
+  if(lladdr != NULL) {
+    linkaddr_copy(&e->u.lladdr, lladdr);
+  }
+  commit(e);
+}
+/*---------------------------------------------------------------------------*/
+#if NETSTACK_CONF_WITH_IPV6
+void
+log_deferred_add_6addr(const uip_ipaddr_t *ipaddr)
+{
+  struct log_deferred_entry *e = prepare_add(LOG_DEFERRED_6ADDR);
+  if(e == NULL) {
+    return;
+  }
+  e->site = NULL;
+  e->nargs = ipaddr != NULL;
+  if(ipaddr != NULL) {
+    uip_ipaddr_copy(&e->u.ipaddr, ipaddr);
+  }
+  commit(e);
+}
+#endif /* NETSTACK_CONF_WITH_IPV6 */
+/*---------------------------------------------------------------------------*/
+/* Outputs a format string with the stored arguments, one conversion
+ * specification at a time */
+static void
+output_format(const struct log_deferred_entry *e)
+{
+  const union log_deferred_arg *arg = e->u.f.args;
+  const char *fmt = e->fmt;
+  const char *next;
+  char spec[SPEC_LEN];
+  uint8_t type;
+  int len;
+
+  while((next = strchr(fmt, '%')) != NULL) {
+    if(next > fmt) {
+      LOG_OUTPUT("%.*s", (int)(next - fmt), fmt);
+    }
+    len = 1 + parse_spec(next + 1, &type);
+    memcpy(spec, next, len);
+    spec[len] = '\0';
+    switch(type) {
+    case ARG_NONE:
+      LOG_OUTPUT("%%");
+      break;
+    case ARG_INT:
+      LOG_OUTPUT(spec, (int)arg++->l);
+      break;
+    case ARG_UINT:
+      LOG_OUTPUT(spec, (unsigned)arg++->ul);
+      break;
+    case ARG_LONG:
+      LOG_OUTPUT(spec, arg++->l);
+      break;
+    case ARG_ULONG:
+      LOG_OUTPUT(spec, arg++->ul);
+      break;
+    case ARG_PTR:
+      LOG_OUTPUT(spec, arg++->p);
+      break;
+    case ARG_STR:
+      LOG_OUTPUT(spec, &e->u.f.str[arg++->ul]);
+      break;
+    }
+    fmt = next + len;
+  }
+  if(*fmt != '\0') {
+    LOG_OUTPUT("%s", fmt);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+output_entry(const struct log_deferred_entry *e)
+{
+  const struct log_deferred_site *site = e->site;
+
+  if(site != NULL && site->newline) {
+    if(LOG_DEFERRED_WITH_TIMESTAMP) {
+      LOG_OUTPUT("%lu ", (unsigned long)e->timestamp);
+    }
+    if(LOG_WITH_MODULE_PREFIX && site->module != NULL) {
+      LOG_OUTPUT_PREFIX(site->level, site->levelstr, site->module);
+    }
+    if(site->file != NULL) {
+      LOG_OUTPUT("[%s: %d] ", site->file, site->line);
+    }
+  }
+
+  switch(e->type) {
+  case LOG_DEFERRED_FORMAT:
+    output_format(e);
+    break;
+  case LOG_DEFERRED_MESSAGE:
+    LOG_OUTPUT("%s", e->u.message);
+    break;
+  case LOG_DEFERRED_LLADDR:
+    if(LOG_WITH_COMPACT_ADDR) {
+      log_lladdr_compact(e->nargs ? &e->u.lladdr : NULL);
+    } else {
+      log_lladdr(e->nargs ? &e->u.lladdr : NULL);
+    }
+    break;
+#if NETSTACK_CONF_WITH_IPV6
+  case LOG_DEFERRED_6ADDR:
+    if(LOG_WITH_COMPACT_ADDR) {
+      log_6addr_compact(e->nargs ? &e->u.ipaddr : NULL);
+    } else {
+      log_6addr(e->nargs ? &e->u.ipaddr : NULL);
+    }
+    break;
+#endif /* NETSTACK_CONF_WITH_IPV6 */
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+log_deferred_flush(void)
+{
+  static unsigned last_log_dropped;
+  int_master_status_t status;
+  int index;
+
+  /* Claim the queue. A flush that interrupts another one returns at
+     once, rather than outputting the entries a second time. */
+  status = int_master_read_and_disable();
+  if(log_flushing) {
+    int_master_status_set(status);
+    return;
+  }
+  log_flushing = 1;
+  int_master_status_set(status);
+
+  /* Stop at an entry that is still being filled in. It is output when
+     it is committed. */
+  while((index = ringbufindex_peek_get(&log_ringbuf)) != -1
+        && log_array[index].ready) {
+    output_entry(&log_array[index]);
+    ringbufindex_get(&log_ringbuf);
+  }
+  if(log_dropped != last_log_dropped) {
+    LOG_OUTPUT_PREFIX(LOG_LEVEL_WARN, "WARN", "Log");
+    LOG_OUTPUT("logs dropped %u\n", log_dropped - last_log_dropped);
+    last_log_dropped = log_dropped;
+  }
+
+  log_flushing = 0;
+}
+/*---------------------------------------------------------------------------*/
+void
+log_deferred_init(void)
+{
+  log_started = 1;
+  process_start(&log_deferred_process, NULL);
+  process_poll(&log_deferred_process);
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(log_deferred_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  while(1) {
+    PROCESS_YIELD_UNTIL(ev == PROCESS_EVENT_POLL);
+    log_deferred_flush();
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+#endif /* LOG_DEFERRED */
+/** @} */
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2019, RISE SICS AB.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \addtogroup log
+ * @{
+ *
+ * \file
+ *         Deferred backend for the logging system. When enabled with
+ *         LOG_CONF_DEFERRED, the LOG_* macros only store the format
+ *         string, the raw arguments and a time stamp in a ring buffer.
+ *         The messages are formatted and output later by a process.
+ *
+ *         Messages may be logged from the main context and from
+ *         interrupts. A queue entry is reserved with interrupts
+ *         disabled and is output once it has been filled in. Until
+ *         log_deferred_init() is called at the end of the boot, a full
+ *         queue is flushed at once instead of dropping messages.
+ *
+ *         The CoAP and DTLS address and string macros flush the queue
+ *         before writing directly. Other output that bypasses the LOG_*
+ *         macros, such as plain printf(), is not ordered with the
+ *         deferred messages.
+ */
+
+#ifndef LOG_DEFERRED_H_
+#define LOG_DEFERRED_H_
+
+#include "net/linkaddr.h"
+#if NETSTACK_CONF_WITH_IPV6
+#include "net/ipv6/uip.h"
+#endif /* NETSTACK_CONF_WITH_IPV6 */
+
+/******** Configuration *******/
+
+/* The length of the log queue. Must be a power of two, up to 128 */
+#ifdef LOG_DEFERRED_CONF_QUEUE_LEN
+#define LOG_DEFERRED_QUEUE_LEN LOG_DEFERRED_CONF_QUEUE_LEN
+#else /* LOG_DEFERRED_CONF_QUEUE_LEN */
+#define LOG_DEFERRED_QUEUE_LEN 32
+#endif /* LOG_DEFERRED_CONF_QUEUE_LEN */
+
+/* The maximum number of arguments per message */
+#ifdef LOG_DEFERRED_CONF_MAX_ARGS
+#define LOG_DEFERRED_MAX_ARGS LOG_DEFERRED_CONF_MAX_ARGS
+#else /* LOG_DEFERRED_CONF_MAX_ARGS */
+#define LOG_DEFERRED_MAX_ARGS 6
+#endif /* LOG_DEFERRED_CONF_MAX_ARGS */
+
+/*
+ * The space per message for copies of string arguments. Longer strings
+ * are truncated. Messages that cannot be stored as raw arguments
+ * (floating point, "%*d", "%lld", or too many arguments) are formatted
+ * at once into the space of both the arguments and the strings,
+ * LOG_DEFERRED_MAX_ARGS * sizeof(long) + LOG_DEFERRED_STR_LEN bytes.
+ * Longer messages are truncated and end with "...".
+ */
+#ifdef LOG_DEFERRED_CONF_STR_LEN
+#define LOG_DEFERRED_STR_LEN LOG_DEFERRED_CONF_STR_LEN
+#else /* LOG_DEFERRED_CONF_STR_LEN */
+#define LOG_DEFERRED_STR_LEN 32
+#endif /* LOG_DEFERRED_CONF_STR_LEN */
+
+/* Prefix each message with the rtimer time at which it was logged */
+#ifdef LOG_DEFERRED_CONF_WITH_TIMESTAMP
+#define LOG_DEFERRED_WITH_TIMESTAMP LOG_DEFERRED_CONF_WITH_TIMESTAMP
+#else /* LOG_DEFERRED_CONF_WITH_TIMESTAMP */
+#define LOG_DEFERRED_WITH_TIMESTAMP 0
+#endif /* LOG_DEFERRED_CONF_WITH_TIMESTAMP */
+
+/********** Data types **********/
+
+/*
+ * The constant part of a log message, one per LOG_* call site. The
+ * address of the site identifies the message in the queue.
+ */
+struct log_deferred_site {
+  const char *module;
+  const char *levelstr;
+  const char *file;
+  int line;
+  uint8_t level;
+  uint8_t newline;
+};
+
+/********** Functions *********/
+
+/**
+ * Queues a log message for deferred output
+ * \param site The call site of the message
+ * \param fmt The printf format string, which must be constant
+*/
+void log_deferred_add(const struct log_deferred_site *site, const char *fmt, ...);
+
+/**
+ * Queues a link-layer address for deferred output
+ * \param lladdr The link-layer address
+*/
+void log_deferred_add_lladdr(const linkaddr_t *lladdr);
+
+#if NETSTACK_CONF_WITH_IPV6
+/**
+ * Queues an IPv6 address for deferred output
+ * \param ipaddr The IPv6 address
+*/
+void log_deferred_add_6addr(const uip_ipaddr_t *ipaddr);
+#endif /* NETSTACK_CONF_WITH_IPV6 */
+
+/**
+ * Formats and outputs all pending messages at once. Called before a
+ * reboot, on a failed assertion, before exiting a native program and
+ * before output that bypasses the queue. May be called from interrupts.
+ * Only one context outputs the queue at a time: a call that interrupts
+ * another flush returns without output and leaves the messages to the
+ * interrupted flush.
+*/
+void log_deferred_flush(void);
+
+/**
+ * Starts the process that outputs the queued messages, at the end of
+ * the boot. Messages logged before are kept in the queue.
+*/
+void log_deferred_init(void);
+
+#endif /* LOG_DEFERRED_H_ */
+/** @} */
@@ -57,6 +57,9 @@
 #if NETSTACK_CONF_WITH_IPV6
 #include "net/ipv6/uip.h"
 #endif /* NETSTACK_CONF_WITH_IPV6 */
+#if LOG_DEFERRED
+#include "sys/log-deferred.h"
+#endif /* LOG_DEFERRED */
 
 /* The different log levels available */
 #define LOG_LEVEL_NONE         0 /* No log */
@@ -101,6 +104,46 @@ extern struct log_module all_modules[];
 
 /* Main log function */
 
+#if LOG_DEFERRED
+
+/* Deferred backend: store the call site and the raw arguments only */
+#define LOG(newline, level, levelstr, ...) do {  \
+                            if(level <= (LOG_LEVEL)) { \
+                              static const struct log_deferred_site log_site = { \
+                                LOG_MODULE, levelstr, LOG_WITH_LOC ? __FILE__ : NULL, \
+                                __LINE__, level, newline }; \
+                              log_deferred_add(&log_site, __VA_ARGS__); \
+                            } \
+                          } while (0)
+
+/* For Cooja annotations */
+#define LOG_ANNOTATE(...) do {  \
+                            if(LOG_WITH_ANNOTATE) { \
+                              static const struct log_deferred_site log_site = { \
+                                NULL, NULL, NULL, 0, 0, 0 }; \
+                              log_deferred_add(&log_site, __VA_ARGS__); \
+                            } \
+                        } while (0)
+
+/* Link-layer address */
+#define LOG_LLADDR(level, lladdr) do {  \
+                            if(level <= (LOG_LEVEL)) { \
+                              log_deferred_add_lladdr(lladdr); \
+                            } \
+                        } while (0)
+
+/* IPv6 address */
+#define LOG_6ADDR(level, ipaddr) do {  \
+                           if(level <= (LOG_LEVEL)) { \
+                             log_deferred_add_6addr(ipaddr); \
+                           } \
+                         } while (0)
+
+/* Outputs the queued messages before writing around the queue */
+#define LOG_SYNC() log_deferred_flush()
+
+#else /* LOG_DEFERRED */
+
 #define LOG(newline, level, levelstr, ...) do {  \
                             if(level <= (LOG_LEVEL)) { \
                               if(newline) { \
@@ -144,6 +187,10 @@ extern struct log_module all_modules[];
                            } \
                          } while (0)
 
+#define LOG_SYNC()
+
+#endif /* LOG_DEFERRED */
+
 /* More compact versions of LOG macros */
 #define LOG_PRINT(...)         LOG(1, 0, "PRI", __VA_ARGS__)
 #define LOG_ERR(...)           LOG(1, LOG_LEVEL_ERR, "ERR", __VA_ARGS__)
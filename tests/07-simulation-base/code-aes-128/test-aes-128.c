@@ -0,0 +1,266 @@
+/*
+ * Copyright (c) 2019, RISE SICS AB.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+#include "lib/aes-128.h"
+#include "lib/random.h"
+#include "services/unit-test/unit-test.h"
+
+#include <string.h>
+#include <stdint.h>
+#include <stdio.h>
+/*---------------------------------------------------------------------------*/
+PROCESS(aes_128_test_process, "AES-128 test process");
+AUTOSTART_PROCESSES(&aes_128_test_process);
+/*---------------------------------------------------------------------------*/
+#define BENCHMARK_BLOCKS 8
+#define BENCHMARK_ROUNDS 20000
+/*---------------------------------------------------------------------------*/
+/* NIST SP 800-38A, F.1.1 ECB-AES128.Encrypt */
+static const uint8_t key[AES_128_KEY_LENGTH] = {
+  0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+  0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c
+};
+static const uint8_t plaintexts[4 * AES_128_BLOCK_SIZE] = {
+  0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96,
+  0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+  0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c,
+  0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+  0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11,
+  0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef,
+  0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17,
+  0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10
+};
+static const uint8_t ciphertexts[4 * AES_128_BLOCK_SIZE] = {
+  0x3a, 0xd7, 0x7b, 0xb4, 0x0d, 0x7a, 0x36, 0x60,
+  0xa8, 0x9e, 0xca, 0xf3, 0x24, 0x66, 0xef, 0x97,
+  0xf5, 0xd3, 0xd5, 0x85, 0x03, 0xb9, 0x69, 0x9d,
+  0xe7, 0x85, 0x89, 0x5a, 0x96, 0xfd, 0xba, 0xaf,
+  0x43, 0xb1, 0xcd, 0x7f, 0x59, 0x8e, 0xce, 0x23,
+  0x88, 0x1b, 0x00, 0xe3, 0xed, 0x03, 0x06, 0x88,
+  0x7b, 0x0c, 0x78, 0x5e, 0x27, 0xe8, 0xad, 0x3f,
+  0x82, 0x23, 0x20, 0x71, 0x04, 0x72, 0x5d, 0xd4
+};
+/* FIPS-197, Appendix C.1 */
+static const uint8_t fips_key[AES_128_KEY_LENGTH] = {
+  0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+  0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f
+};
+static const uint8_t fips_plaintext[AES_128_BLOCK_SIZE] = {
+  0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+  0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff
+};
+static const uint8_t fips_ciphertext[AES_128_BLOCK_SIZE] = {
+  0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30,
+  0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a
+};
+/*---------------------------------------------------------------------------*/
+static uint8_t blocks[BENCHMARK_BLOCKS * AES_128_BLOCK_SIZE];
+static uint8_t expected[BENCHMARK_BLOCKS * AES_128_BLOCK_SIZE];
+/*---------------------------------------------------------------------------*/
+void
+print_test_report(const unit_test_t *utp)
+{
+  printf("=check-me= ");
+  if(utp->result == unit_test_failure) {
+    printf("FAILED   - %s: exit at L%u\n", utp->descr, utp->exit_line);
+  } else {
+    printf("SUCCEEDED - %s\n", utp->descr);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static int
+check_vectors(const struct aes_128_driver *driver)
+{
+  uint8_t i;
+
+  driver->set_key(fips_key);
+  memcpy(blocks, fips_plaintext, AES_128_BLOCK_SIZE);
+  driver->encrypt(blocks);
+  if(memcmp(blocks, fips_ciphertext, AES_128_BLOCK_SIZE)) {
+    return 0;
+  }
+
+  driver->set_key(key);
+  for(i = 0; i < 4; i++) {
+    memcpy(blocks, plaintexts + i * AES_128_BLOCK_SIZE, AES_128_BLOCK_SIZE);
+    driver->encrypt(blocks);
+    if(memcmp(blocks, ciphertexts + i * AES_128_BLOCK_SIZE, AES_128_BLOCK_SIZE)) {
+      return 0;
+    }
+  }
+
+  for(i = 1; i <= 4; i++) {
+    memcpy(blocks, plaintexts, sizeof(plaintexts));
+    driver->encrypt_blocks(blocks, i);
+    if(memcmp(blocks, ciphertexts, i * AES_128_BLOCK_SIZE)
+       || memcmp(blocks + i * AES_128_BLOCK_SIZE,
+                 plaintexts + i * AES_128_BLOCK_SIZE,
+                 (4 - i) * AES_128_BLOCK_SIZE)) {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_vectors, "Test vectors");
+UNIT_TEST(test_vectors)
+{
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(check_vectors(&aes_128_driver));
+  UNIT_TEST_ASSERT(check_vectors(&AES_128));
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_key_switch, "Key switching");
+UNIT_TEST(test_key_switch)
+{
+  static const uint8_t *keys[] = { key, fips_key, plaintexts, ciphertexts };
+  uint8_t results[4][AES_128_BLOCK_SIZE];
+  uint16_t i;
+  uint8_t k;
+
+  UNIT_TEST_BEGIN();
+
+  for(k = 0; k < 4; k++) {
+    aes_128_driver.set_key(keys[k]);
+    memcpy(results[k], fips_plaintext, AES_128_BLOCK_SIZE);
+    aes_128_driver.encrypt(results[k]);
+  }
+
+  /* Use more keys than the cache holds, in a random order */
+  for(i = 0; i < 100; i++) {
+    k = random_rand() % 4;
+    aes_128_driver.set_key(keys[k]);
+    memcpy(blocks, fips_plaintext, AES_128_BLOCK_SIZE);
+    aes_128_driver.encrypt(blocks);
+    UNIT_TEST_ASSERT(memcmp(blocks, results[k], AES_128_BLOCK_SIZE) == 0);
+  }
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_random_blocks, "Single and multiple blocks");
+UNIT_TEST(test_random_blocks)
+{
+  uint16_t i;
+  uint8_t j;
+
+  UNIT_TEST_BEGIN();
+
+  aes_128_driver.set_key(key);
+  AES_128.set_key(key);
+  for(i = 0; i < 100; i++) {
+    for(j = 0; j < sizeof(blocks); j++) {
+      blocks[j] = random_rand();
+    }
+    memcpy(expected, blocks, sizeof(blocks));
+    for(j = 0; j < BENCHMARK_BLOCKS; j++) {
+      aes_128_driver.encrypt(expected + j * AES_128_BLOCK_SIZE);
+    }
+    AES_128.encrypt_blocks(blocks, BENCHMARK_BLOCKS);
+    UNIT_TEST_ASSERT(memcmp(blocks, expected, sizeof(blocks)) == 0);
+  }
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+static void
+benchmark(const char *name, const struct aes_128_driver *driver)
+{
+  rtimer_clock_t start;
+  rtimer_clock_t single;
+  rtimer_clock_t multiple;
+  rtimer_clock_t rekeyed;
+  uint32_t i;
+  uint8_t j;
+
+  driver->set_key(key);
+
+  start = RTIMER_NOW();
+  for(i = 0; i < BENCHMARK_ROUNDS; i++) {
+    for(j = 0; j < BENCHMARK_BLOCKS; j++) {
+      driver->encrypt(blocks + j * AES_128_BLOCK_SIZE);
+    }
+  }
+  single = RTIMER_NOW() - start;
+
+  start = RTIMER_NOW();
+  for(i = 0; i < BENCHMARK_ROUNDS; i++) {
+    driver->encrypt_blocks(blocks, BENCHMARK_BLOCKS);
+  }
+  multiple = RTIMER_NOW() - start;
+
+  /* Alternate between two keys, as with separate keys for frame types */
+  start = RTIMER_NOW();
+  for(i = 0; i < BENCHMARK_ROUNDS; i++) {
+    driver->set_key((i & 1) ? key : fips_key);
+    driver->encrypt_blocks(blocks, BENCHMARK_BLOCKS);
+  }
+  rekeyed = RTIMER_NOW() - start;
+
+  printf("%s: %lu blocks in %lu ticks (encrypt), %lu ticks (encrypt_blocks), "
+         "%lu ticks (with key switches), %lu ticks per second\n",
+         name, (unsigned long)BENCHMARK_ROUNDS * BENCHMARK_BLOCKS,
+         (unsigned long)single, (unsigned long)multiple,
+         (unsigned long)rekeyed, (unsigned long)RTIMER_SECOND);
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_benchmark, "Benchmark");
+UNIT_TEST(test_benchmark)
+{
+  UNIT_TEST_BEGIN();
+
+  benchmark("software", &aes_128_driver);
+  benchmark("default", &AES_128);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(aes_128_test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  UNIT_TEST_RUN(test_vectors);
+  UNIT_TEST_RUN(test_key_switch);
+  UNIT_TEST_RUN(test_random_blocks);
+  UNIT_TEST_RUN(test_benchmark);
+
+  printf("=check-me= DONE\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
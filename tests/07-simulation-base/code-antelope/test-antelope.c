@@ -0,0 +1,334 @@
+/*
+ * Copyright (c) 2019, RISE SICS AB.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+#include "antelope.h"
+#include "db-options.h"
+#include "relation.h"
+#include "lib/random.h"
+#include "services/unit-test/unit-test.h"
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+/*---------------------------------------------------------------------------*/
+PROCESS(antelope_test_process, "Antelope test process");
+AUTOSTART_PROCESSES(&antelope_test_process);
+/*---------------------------------------------------------------------------*/
+#define TUPLE_COUNT  1500
+#define KEY_LIMIT    1000
+#define MAX_KEYS     (DB_BPTREE_NODE_LIMIT * DB_BPTREE_ORDER)
+#define KEY_RANGE    30000
+
+/*
+ * Lower bounds of the number of keys that a B+-tree holds when they
+ * are inserted in random and in increasing order. Split leaves are at
+ * least half full, and sorted insertions fill them completely.
+ */
+#define BPTREE_RANDOM_CAPACITY     (MAX_KEYS * 3 / 8)
+#define BPTREE_SORTED_CAPACITY     (MAX_KEYS * 7 / 8)
+/*---------------------------------------------------------------------------*/
+static db_handle_t handle;
+static long keys[MAX_KEYS];
+/*---------------------------------------------------------------------------*/
+void
+print_test_report(const unit_test_t *utp)
+{
+  printf("=check-me= ");
+  if(utp->result == unit_test_failure) {
+    printf("FAILED   - %s: exit at L%u\n", utp->descr, utp->exit_line);
+  } else {
+    printf("SUCCEEDED - %s\n", utp->descr);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static db_result_t
+execute(const char *query)
+{
+  db_result_t result;
+
+  result = db_query(&handle, query);
+  if(DB_ERROR(result)) {
+    db_free(&handle);
+    return result;
+  }
+
+  while(db_processing(&handle)) {
+    result = db_process(&handle);
+    if(result == DB_FINISHED) {
+      result = DB_OK;
+      break;
+    }
+    if(DB_ERROR(result)) {
+      db_free(&handle);
+      return result;
+    }
+  }
+  db_free(&handle);
+
+  return result == DB_GOT_ROW ? DB_OK : result;
+}
+/*---------------------------------------------------------------------------*/
+/* Returns the number of rows that a selection produces, or -1. */
+static long
+count_rows(const char *query)
+{
+  db_result_t result;
+  long rows;
+
+  if(DB_ERROR(db_query(&handle, query))) {
+    db_free(&handle);
+    return -1;
+  }
+
+  rows = 0;
+  while(db_processing(&handle)) {
+    result = db_process(&handle);
+    if(result == DB_GOT_ROW) {
+      rows++;
+    } else if(result == DB_FINISHED) {
+      break;
+    } else if(DB_ERROR(result)) {
+      rows = -1;
+      break;
+    }
+  }
+  db_free(&handle);
+
+  return rows;
+}
+/*---------------------------------------------------------------------------*/
+static int
+create_relation(const char *index_type)
+{
+  char query[64];
+
+  execute("REMOVE RELATION r;");
+  if(DB_ERROR(execute("CREATE RELATION r;")) ||
+     DB_ERROR(execute("CREATE ATTRIBUTE id DOMAIN INT IN r;")) ||
+     DB_ERROR(execute("CREATE ATTRIBUTE v DOMAIN LONG IN r;"))) {
+    return 0;
+  }
+
+  if(index_type != NULL) {
+    snprintf(query, sizeof(query), "CREATE INDEX r.v TYPE %s;", index_type);
+    if(DB_ERROR(execute(query))) {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+insert(int id, long value)
+{
+  char query[64];
+
+  snprintf(query, sizeof(query), "INSERT (%d, %ld) INTO r;", id, value);
+  return !DB_ERROR(execute(query));
+}
+/*---------------------------------------------------------------------------*/
+static long
+count_keys(int count, long min, long max)
+{
+  long matching;
+  int i;
+
+  for(matching = 0, i = 0; i < count; i++) {
+    if(keys[i] >= min && keys[i] <= max) {
+      matching++;
+    }
+  }
+  return matching;
+}
+/*---------------------------------------------------------------------------*/
+static int
+check_select_remove(const char *index_type)
+{
+  int i;
+
+  if(!create_relation(index_type)) {
+    return 0;
+  }
+
+  for(i = 0; i < TUPLE_COUNT; i++) {
+    keys[i] = (i * 7L) % KEY_LIMIT;
+    if(!insert(i, keys[i])) {
+      return 0;
+    }
+  }
+
+  if(count_rows("SELECT id FROM r WHERE v < 500;") !=
+     count_keys(TUPLE_COUNT, 0, 499) ||
+     count_rows("SELECT id FROM r WHERE v >= 200 AND v <= 300;") !=
+     count_keys(TUPLE_COUNT, 200, 300) ||
+     count_rows("SELECT id FROM r WHERE v = 7;") !=
+     count_keys(TUPLE_COUNT, 7, 7)) {
+    return 0;
+  }
+
+  if(DB_ERROR(execute("REMOVE FROM r WHERE v < 500;"))) {
+    return 0;
+  }
+
+  return count_rows("SELECT id FROM r;") ==
+         count_keys(TUPLE_COUNT, 500, KEY_LIMIT - 1) &&
+         count_rows("SELECT id FROM r WHERE v < 500;") == 0 &&
+         count_rows("SELECT id FROM r WHERE v >= 500;") ==
+         count_keys(TUPLE_COUNT, 500, KEY_LIMIT - 1);
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_select_remove, "Select and remove");
+UNIT_TEST(test_select_remove)
+{
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(check_select_remove(NULL));
+  UNIT_TEST_ASSERT(check_select_remove("BPTREE"));
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+/* Inserts keys until the index is full, and verifies that all keys
+   inserted before that are found. */
+static int
+check_capacity(int sorted, int capacity)
+{
+  int count;
+  long key;
+
+  if(!create_relation("BPTREE")) {
+    return 0;
+  }
+
+  for(count = 0; count < MAX_KEYS; count++) {
+    key = sorted ? count : (long)(random_rand() % KEY_RANGE);
+    if(!insert(count, key)) {
+      break;
+    }
+    keys[count] = key;
+  }
+
+  printf("B+-tree capacity: %d keys in %s order\n",
+         count, sorted ? "increasing" : "random");
+
+  if(count < capacity || count >= MAX_KEYS) {
+    return 0;
+  }
+
+  /* The leaf of the rejected key cannot be split, and the failed
+     insertion has left the tree unchanged. */
+  if(insert(count, key)) {
+    return 0;
+  }
+
+  return count_rows("SELECT id FROM r;") == count &&
+         count_rows("SELECT id FROM r WHERE v >= 0 AND v < 30000;") ==
+         count_keys(count, 0, KEY_RANGE - 1) &&
+         count_rows("SELECT id FROM r WHERE v >= 1000 AND v < 2000;") ==
+         count_keys(count, 1000, 1999) &&
+         count_rows("SELECT id FROM r WHERE v > 29000;") ==
+         count_keys(count, 29001, LONG_MAX);
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_bptree_capacity, "B+-tree capacity");
+UNIT_TEST(test_bptree_capacity)
+{
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(check_capacity(0, BPTREE_RANDOM_CAPACITY));
+  UNIT_TEST_ASSERT(check_capacity(1, BPTREE_SORTED_CAPACITY));
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+static db_result_t
+insert_long(relation_t *rel, int id, long value)
+{
+  attribute_value_t values[2];
+
+  values[0].domain = DOMAIN_INT;
+  VALUE_INT(&values[0]) = id;
+  values[1].domain = DOMAIN_LONG;
+  VALUE_LONG(&values[1]) = value;
+
+  return relation_insert(rel, values);
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_bptree_long_keys, "B+-tree LONG keys");
+UNIT_TEST(test_bptree_long_keys)
+{
+  relation_t *rel;
+
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(create_relation("BPTREE"));
+  rel = relation_load("r");
+  UNIT_TEST_ASSERT(rel != NULL);
+
+  UNIT_TEST_ASSERT(!DB_ERROR(insert_long(rel, 1, INT32_MAX)));
+  UNIT_TEST_ASSERT(!DB_ERROR(insert_long(rel, 2, INT32_MIN)));
+  UNIT_TEST_ASSERT(!DB_ERROR(insert_long(rel, 3, 0)));
+#if LONG_MAX > INT32_MAX
+  /* Values that do not fit in a stored LONG are not truncated. */
+  UNIT_TEST_ASSERT(insert_long(rel, 4, (long)INT32_MAX + 1) == DB_INDEX_ERROR);
+  UNIT_TEST_ASSERT(insert_long(rel, 5, (long)INT32_MIN - 1) == DB_INDEX_ERROR);
+#endif
+  relation_release(rel);
+
+  UNIT_TEST_ASSERT(count_rows("SELECT id FROM r;") == 3);
+  UNIT_TEST_ASSERT(count_rows("SELECT id FROM r WHERE v >= 2147483647;") == 1);
+  UNIT_TEST_ASSERT(count_rows("SELECT id FROM r WHERE v <= -2147483648;") == 1);
+  UNIT_TEST_ASSERT(count_rows("SELECT id FROM r WHERE v > -10 AND v < 10;") == 1);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(antelope_test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  db_init();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  UNIT_TEST_RUN(test_select_remove);
+  UNIT_TEST_RUN(test_bptree_capacity);
+  UNIT_TEST_RUN(test_bptree_long_keys);
+
+  execute("REMOVE RELATION r;");
+
+  printf("=check-me= DONE\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
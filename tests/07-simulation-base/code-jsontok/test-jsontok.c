@@ -0,0 +1,389 @@
+/*
+ * Copyright (c) 2019, RISE SICS AB.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+#include "jsontok.h"
+#include "services/unit-test/unit-test.h"
+
+#include <string.h>
+#include <stdio.h>
+/*---------------------------------------------------------------------------*/
+PROCESS(jsontok_test_process, "JSON tokenizer test process");
+AUTOSTART_PROCESSES(&jsontok_test_process);
+/*---------------------------------------------------------------------------*/
+#define MAX_INPUT 128
+#define MAX_OUTPUT 512
+
+/* Feed the input as one chunk */
+#define WHOLE -1
+
+struct split_vector {
+  const char *input;
+  /* The tokens as written by tokenize() */
+  const char *tokens;
+};
+
+static const struct split_vector split_vectors[] = {
+  { "{\"name\":\"value\",\"n\":-12.5e+3,\"t\":true,\"f\":false,\"z\":null}",
+    "{0 N1:name \"1:value N1:n 01:-12.5e+3 N1:t t1:true N1:f f1:false "
+    "N1:z n1:null }0 done" },
+  { " [ 1 , [2,[3,{}]] ,[],\"x\" ] ",
+    "[0 01:1 [1 02:2 [2 03:3 {3 }3 ]2 ]1 [1 ]1 \"1:x ]0 done" },
+  { "[true,false,null,123456789012345678901234567890]",
+    "[0 t1:true f1:false n1:null 01:123456789012345678901234567890 ]0 done" },
+  { "\"top-level string\"", "\"0:top-level string done" },
+  { "-0.5e-7", "00:-0.5e-7 done" },
+  /* Escape sequences, decoded after the pieces are joined */
+  { "{\"esc\":\"a\\\"b\\\\c\\u00e9\\ud83d\\ude00\\n\",\"\\t\":\"\\/\"}",
+    "{0 N1:esc \"1e:a\"b\\c\xc3\xa9\xf0\x9f\x98\x80\n N1e:\t \"1e:/ }0 done" },
+  /* Errors are found at the same token */
+  { "{\"a\":1,}", "{0 N1:a 01:1 error 5" },
+  { "[tru]", "[0 error 1" },
+  { "\"unterminated", "error 1" },
+  { "{\"a\" \"b\"}", "{0 N1:a error 6" },
+};
+/*---------------------------------------------------------------------------*/
+static char output[MAX_OUTPUT];
+static char expected[MAX_OUTPUT];
+/* The pieces of a string token, joined */
+static char joined[MAX_INPUT];
+static char decoded[MAX_INPUT];
+/*---------------------------------------------------------------------------*/
+void
+print_test_report(const unit_test_t *utp)
+{
+  printf("=check-me= ");
+  if(utp->result == unit_test_failure) {
+    printf("FAILED   - %s: exit at L%u\n", utp->descr, utp->exit_line);
+  } else {
+    printf("SUCCEEDED - %s\n", utp->descr);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Tokenizes the input and writes the tokens to out in a form that does
+ * not depend on how the input was split. The first chunk ends at split,
+ * or at step for WHOLE, and the following chunks are step bytes long.
+ * The pieces of strings are joined and decoded.
+ */
+static void
+tokenize(const char *input, int split, int step, char *out, int size)
+{
+  static char chunk[MAX_INPUT + 16];
+  struct jsontok_state state;
+  struct jsontok_token token;
+  struct jsontok_slice slice;
+  int len = strlen(input);
+  int pos = 0;
+  int end;
+  int more;
+  int o = 0;
+  int joined_len = 0;
+  uint8_t escaped = 0;
+  uint8_t pending = 0;
+  int r;
+
+  jsontok_init(&state);
+  do {
+    if(split != WHOLE) {
+      end = split;
+      more = 1;
+      split = WHOLE;
+    } else {
+      end = pos + step < len ? pos + step : len;
+      more = end < len;
+    }
+
+    /* Quotes after the chunk show reads beyond its end */
+    memset(chunk, '"', sizeof(chunk));
+    memcpy(chunk, input + pos, end - pos);
+    jsontok_feed(&state, chunk, end - pos, more);
+    pos = end;
+
+    while((r = jsontok_next(&state, &token)) == JSONTOK_TOKEN) {
+      switch(token.type) {
+      case JSON_TYPE_PAIR_NAME:
+      case JSON_TYPE_STRING:
+        if(!(token.flags & JSONTOK_FLAG_CONTINUED) != !pending) {
+          o += snprintf(out + o, size - o, "? ");
+        }
+        if(!pending) {
+          joined_len = 0;
+          escaped = 0;
+        }
+        memcpy(joined + joined_len, token.value.ptr, token.value.len);
+        joined_len += token.value.len;
+        escaped |= token.flags & JSONTOK_FLAG_ESCAPED;
+        pending = token.flags & JSONTOK_FLAG_PARTIAL;
+        if(!pending) {
+          slice.ptr = joined;
+          slice.len = joined_len;
+          jsontok_copy_string(&slice, decoded, sizeof(decoded));
+          o += snprintf(out + o, size - o, "%c%u%s:%s ", token.type,
+                        token.depth, escaped ? "e" : "", decoded);
+        }
+        break;
+      case JSON_TYPE_NUMBER:
+      case JSON_TYPE_TRUE:
+      case JSON_TYPE_FALSE:
+      case JSON_TYPE_NULL:
+        o += snprintf(out + o, size - o, "%c%u:%.*s ", token.type,
+                      token.depth, token.value.len, token.value.ptr);
+        break;
+      default:
+        o += snprintf(out + o, size - o, "%c%u ", token.type, token.depth);
+        break;
+      }
+    }
+  } while(r == JSONTOK_NEED_MORE && more);
+
+  if(r == JSONTOK_DONE) {
+    snprintf(out + o, size - o, "done");
+  } else if(r == JSONTOK_ERROR) {
+    snprintf(out + o, size - o, "error %d", state.error);
+  } else {
+    snprintf(out + o, size - o, "stuck");
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Returns non-zero if every split of the input gives the same tokens */
+static int
+check_splits(const char *input)
+{
+  int len = strlen(input);
+  int split;
+
+  tokenize(input, WHOLE, len, expected, sizeof(expected));
+  for(split = 0; split <= len; split++) {
+    tokenize(input, split, len, output, sizeof(output));
+    if(strcmp(output, expected) != 0) {
+      printf("split at %d: %s\n", split, output);
+      return 0;
+    }
+  }
+
+  tokenize(input, WHOLE, 1, output, sizeof(output));
+  if(strcmp(output, expected) != 0) {
+    printf("byte by byte: %s\n", output);
+    return 0;
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_split, "Same tokens for every split of the input");
+UNIT_TEST(test_split)
+{
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  for(i = 0; i < sizeof(split_vectors) / sizeof(split_vectors[0]); i++) {
+    tokenize(split_vectors[i].input, WHOLE, strlen(split_vectors[i].input),
+             output, sizeof(output));
+    if(strcmp(output, split_vectors[i].tokens) != 0) {
+      printf("%s: %s\n", split_vectors[i].input, output);
+    }
+    UNIT_TEST_ASSERT(strcmp(output, split_vectors[i].tokens) == 0);
+    UNIT_TEST_ASSERT(check_splits(split_vectors[i].input));
+  }
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_pieces, "Partial and continued strings");
+UNIT_TEST(test_pieces)
+{
+  struct jsontok_state state;
+  struct jsontok_token token;
+
+  UNIT_TEST_BEGIN();
+
+  /* A name split in two */
+  jsontok_init(&state);
+  jsontok_feed(&state, "{\"abc", 5, 1);
+  UNIT_TEST_ASSERT(jsontok_next(&state, &token) == JSONTOK_TOKEN);
+  UNIT_TEST_ASSERT(token.type == '{');
+  UNIT_TEST_ASSERT(jsontok_next(&state, &token) == JSONTOK_TOKEN);
+  UNIT_TEST_ASSERT(token.type == JSON_TYPE_PAIR_NAME);
+  UNIT_TEST_ASSERT(token.flags == JSONTOK_FLAG_PARTIAL);
+  UNIT_TEST_ASSERT(jsontok_slice_cmp(&token.value, "abc") == 0);
+  UNIT_TEST_ASSERT(jsontok_next(&state, &token) == JSONTOK_NEED_MORE);
+
+  jsontok_feed(&state, "def\":\"ghij\"}", 12, 0);
+  UNIT_TEST_ASSERT(jsontok_next(&state, &token) == JSONTOK_TOKEN);
+  UNIT_TEST_ASSERT(token.type == JSON_TYPE_PAIR_NAME);
+  UNIT_TEST_ASSERT(token.flags == JSONTOK_FLAG_CONTINUED);
+  UNIT_TEST_ASSERT(token.depth == 1);
+  UNIT_TEST_ASSERT(jsontok_slice_cmp(&token.value, "def") == 0);
+  UNIT_TEST_ASSERT(jsontok_next(&state, &token) == JSONTOK_TOKEN);
+  UNIT_TEST_ASSERT(token.type == JSON_TYPE_STRING);
+  UNIT_TEST_ASSERT(token.flags == 0);
+  UNIT_TEST_ASSERT(jsontok_slice_cmp(&token.value, "ghij") == 0);
+  UNIT_TEST_ASSERT(jsontok_next(&state, &token) == JSONTOK_TOKEN);
+  UNIT_TEST_ASSERT(token.type == '}');
+  UNIT_TEST_ASSERT(jsontok_next(&state, &token) == JSONTOK_DONE);
+
+  /* A string that spans three chunks, the middle one inside it */
+  jsontok_init(&state);
+  jsontok_feed(&state, "\"ab", 3, 1);
+  UNIT_TEST_ASSERT(jsontok_next(&state, &token) == JSONTOK_TOKEN);
+  UNIT_TEST_ASSERT(token.flags == JSONTOK_FLAG_PARTIAL);
+  UNIT_TEST_ASSERT(jsontok_next(&state, &token) == JSONTOK_NEED_MORE);
+  jsontok_feed(&state, "cd", 2, 1);
+  UNIT_TEST_ASSERT(jsontok_next(&state, &token) == JSONTOK_TOKEN);
+  UNIT_TEST_ASSERT(token.flags ==
+                   (JSONTOK_FLAG_PARTIAL | JSONTOK_FLAG_CONTINUED));
+  UNIT_TEST_ASSERT(jsontok_slice_cmp(&token.value, "cd") == 0);
+  UNIT_TEST_ASSERT(jsontok_next(&state, &token) == JSONTOK_NEED_MORE);
+  jsontok_feed(&state, "e\"", 2, 0);
+  UNIT_TEST_ASSERT(jsontok_next(&state, &token) == JSONTOK_TOKEN);
+  UNIT_TEST_ASSERT(token.flags == JSONTOK_FLAG_CONTINUED);
+  UNIT_TEST_ASSERT(jsontok_slice_cmp(&token.value, "e") == 0);
+  UNIT_TEST_ASSERT(jsontok_next(&state, &token) == JSONTOK_DONE);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_escape, "Escape sequences split by a chunk boundary");
+UNIT_TEST(test_escape)
+{
+  struct jsontok_state state;
+  struct jsontok_token token;
+  int len;
+
+  UNIT_TEST_BEGIN();
+
+  /* The chunk ends with the backslash of an escaped quote */
+  jsontok_init(&state);
+  jsontok_feed(&state, "\"a\\", 3, 1);
+  UNIT_TEST_ASSERT(jsontok_next(&state, &token) == JSONTOK_TOKEN);
+  UNIT_TEST_ASSERT(token.flags ==
+                   (JSONTOK_FLAG_PARTIAL | JSONTOK_FLAG_ESCAPED));
+  UNIT_TEST_ASSERT(jsontok_slice_cmp(&token.value, "a\\") == 0);
+  memcpy(joined, token.value.ptr, token.value.len);
+  len = token.value.len;
+  UNIT_TEST_ASSERT(jsontok_next(&state, &token) == JSONTOK_NEED_MORE);
+
+  /* The quote is part of the string, not its end */
+  jsontok_feed(&state, "\"b\"", 3, 0);
+  UNIT_TEST_ASSERT(jsontok_next(&state, &token) == JSONTOK_TOKEN);
+  UNIT_TEST_ASSERT(token.flags ==
+                   (JSONTOK_FLAG_CONTINUED | JSONTOK_FLAG_ESCAPED));
+  UNIT_TEST_ASSERT(jsontok_slice_cmp(&token.value, "\"b") == 0);
+  memcpy(joined + len, token.value.ptr, token.value.len);
+  len += token.value.len;
+  UNIT_TEST_ASSERT(jsontok_next(&state, &token) == JSONTOK_DONE);
+
+  token.value.ptr = joined;
+  token.value.len = len;
+  UNIT_TEST_ASSERT(jsontok_copy_string(&token.value, decoded,
+                                       sizeof(decoded)) == 3);
+  UNIT_TEST_ASSERT(strcmp(decoded, "a\"b") == 0);
+
+  /* Every split of \uXXXX escapes and surrogate pairs */
+  UNIT_TEST_ASSERT(check_splits("[\"\\\\\\u0041\\ud83d\\ude00\\\"\"]"));
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_carry, "Numbers and literals split by a chunk boundary");
+UNIT_TEST(test_carry)
+{
+  static char input[JSONTOK_CARRY_LEN + 2];
+  int split;
+
+  UNIT_TEST_BEGIN();
+
+  /* The longest number that can be split */
+  memset(input, '7', JSONTOK_CARRY_LEN);
+  input[JSONTOK_CARRY_LEN] = '\0';
+  UNIT_TEST_ASSERT(check_splits(input));
+  UNIT_TEST_ASSERT(strncmp(expected, "00:7777", 7) == 0);
+
+  /* One digit more fits in a single chunk, but cannot be carried */
+  strcat(input, "7");
+  tokenize(input, WHOLE, sizeof(input), output, sizeof(output));
+  UNIT_TEST_ASSERT(strncmp(output, "00:7777", 7) == 0);
+  tokenize(input, 0, sizeof(input), output, sizeof(output));
+  UNIT_TEST_ASSERT(strncmp(output, "00:7777", 7) == 0);
+  for(split = 1; split <= JSONTOK_CARRY_LEN + 1; split++) {
+    tokenize(input, split, sizeof(input), output, sizeof(output));
+    UNIT_TEST_ASSERT(strcmp(output, "error 8") == 0);
+  }
+
+  /* Literals are carried like numbers */
+  UNIT_TEST_ASSERT(check_splits("[null,true,false,nul]"));
+  UNIT_TEST_ASSERT(strcmp(expected, "[0 n1:null t1:true f1:false error 1") == 0);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_depth, "Nesting deeper than JSONTOK_MAX_DEPTH");
+UNIT_TEST(test_depth)
+{
+  static char input[2 * JSONTOK_MAX_DEPTH + 3];
+
+  UNIT_TEST_BEGIN();
+
+  /* The deepest nesting */
+  memset(input, '[', JSONTOK_MAX_DEPTH);
+  memset(input + JSONTOK_MAX_DEPTH, ']', JSONTOK_MAX_DEPTH);
+  input[2 * JSONTOK_MAX_DEPTH] = '\0';
+  UNIT_TEST_ASSERT(check_splits(input));
+  UNIT_TEST_ASSERT(strcmp(expected + strlen(expected) - 4, "done") == 0);
+
+  /* One level more */
+  memset(input, '[', JSONTOK_MAX_DEPTH + 1);
+  memset(input + JSONTOK_MAX_DEPTH + 1, ']', JSONTOK_MAX_DEPTH + 1);
+  input[2 * JSONTOK_MAX_DEPTH + 2] = '\0';
+  UNIT_TEST_ASSERT(check_splits(input));
+  UNIT_TEST_ASSERT(strcmp(expected + strlen(expected) - 7, "error 7") == 0);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(jsontok_test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  UNIT_TEST_RUN(test_split);
+  UNIT_TEST_RUN(test_pieces);
+  UNIT_TEST_RUN(test_escape);
+  UNIT_TEST_RUN(test_carry);
+  UNIT_TEST_RUN(test_depth);
+
+  printf("=check-me= DONE\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
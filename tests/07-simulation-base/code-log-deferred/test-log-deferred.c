@@ -0,0 +1,299 @@
+/*
+ * Copyright (c) 2019, RISE SICS AB.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+#include "sys/log.h"
+#include "services/unit-test/unit-test.h"
+
+#include <stdarg.h>
+#include <string.h>
+#include <stdio.h>
+
+#define LOG_MODULE "Test"
+#define LOG_LEVEL LOG_LEVEL_DBG
+/*---------------------------------------------------------------------------*/
+PROCESS(log_deferred_test_process, "Deferred log test process");
+AUTOSTART_PROCESSES(&log_deferred_test_process);
+/*---------------------------------------------------------------------------*/
+void
+print_test_report(const unit_test_t *utp)
+{
+  printf("=check-me= ");
+  if(utp->result == unit_test_failure) {
+    printf("FAILED   - %s: exit at L%u\n", utp->descr, utp->exit_line);
+  } else {
+    printf("SUCCEEDED - %s\n", utp->descr);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static char capture_buf[1024];
+static int capture_len;
+static int capturing;
+/* Set to flush the queue from within the output, as an interrupt would */
+static int reenter;
+
+/* The LOG_OUTPUT of this test. Appends to capture_buf while capturing. */
+int
+log_capture(const char *fmt, ...)
+{
+  va_list ap;
+  int len;
+
+  if(reenter) {
+    reenter = 0;
+    log_deferred_flush();
+  }
+
+  va_start(ap, fmt);
+  if(capturing) {
+    len = vsnprintf(&capture_buf[capture_len],
+                    sizeof(capture_buf) - capture_len, fmt, ap);
+    if(len > 0) {
+      capture_len += len;
+      if(capture_len >= sizeof(capture_buf)) {
+        capture_len = sizeof(capture_buf) - 1;
+      }
+    }
+  } else {
+    len = vprintf(fmt, ap);
+  }
+  va_end(ap);
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+static void
+capture_start(void)
+{
+  capture_len = 0;
+  capture_buf[0] = '\0';
+  capturing = 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+capture_stop(char *buf, size_t size)
+{
+  capturing = 0;
+  strncpy(buf, capture_buf, size - 1);
+  buf[size - 1] = '\0';
+}
+/*---------------------------------------------------------------------------*/
+static char queued[1024];
+static char immediate[1024];
+
+/*
+ * Logs a message through the queue and formats the same message with
+ * the prefix that the immediate backend outputs, and asserts that the
+ * two are equal
+ */
+#define ASSERT_SAME_OUTPUT(...) do {                               \
+    capture_start();                                               \
+    LOG_INFO(__VA_ARGS__);                                         \
+    log_deferred_flush();                                          \
+    capture_stop(queued, sizeof(queued));                          \
+    capture_start();                                               \
+    LOG_OUTPUT_PREFIX(LOG_LEVEL_INFO, "INFO", LOG_MODULE);         \
+    LOG_OUTPUT(__VA_ARGS__);                                       \
+    capture_stop(immediate, sizeof(immediate));                    \
+    UNIT_TEST_ASSERT(strcmp(queued, immediate) == 0);              \
+  } while(0)
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_same_output, "Queued output matches immediate output");
+UNIT_TEST(test_same_output)
+{
+  linkaddr_t lladdr = { { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08 } };
+  char name[8];
+
+  UNIT_TEST_BEGIN();
+
+  ASSERT_SAME_OUTPUT("no arguments\n");
+  ASSERT_SAME_OUTPUT("int %d %i %5d %-3d|\n", -5, 17, 42, 1);
+  ASSERT_SAME_OUTPUT("unsigned %u %x %04X %o\n",
+                     40000u, 0xbeefu, 0xau, 8u);
+  ASSERT_SAME_OUTPUT("long %ld %lu %08lx\n",
+                     -100000L, 3000000000UL, 0xc0ffeeUL);
+  ASSERT_SAME_OUTPUT("char %c%c, percent 100%%\n", 'o', 'k');
+  ASSERT_SAME_OUTPUT("string %s %.3s %s\n",
+                     "abc", "truncated", (char *)NULL);
+  ASSERT_SAME_OUTPUT("six %d %d %d %d %d %d\n", 1, 2, 3, 4, 5, 6);
+
+  /* String arguments are copied when the message is logged */
+  strcpy(name, "before");
+  capture_start();
+  LOG_INFO("name %s\n", name);
+  strcpy(name, "after");
+  log_deferred_flush();
+  capture_stop(queued, sizeof(queued));
+  UNIT_TEST_ASSERT(strcmp(queued, "[INFO: Test      ] name before\n") == 0);
+
+  /* Messages without a prefix, and an address in the middle of a line */
+  capture_start();
+  LOG_INFO("address ");
+  LOG_INFO_LLADDR(&lladdr);
+  LOG_INFO_(" end\n");
+  LOG_INFO_LLADDR(NULL);
+  LOG_ANNOTATE("#A test\n");
+  log_deferred_flush();
+  capture_stop(queued, sizeof(queued));
+  capture_start();
+  LOG_OUTPUT_PREFIX(LOG_LEVEL_INFO, "INFO", LOG_MODULE);
+  LOG_OUTPUT("address ");
+  log_lladdr(&lladdr);
+  LOG_OUTPUT(" end\n");
+  log_lladdr(NULL);
+  if(LOG_WITH_ANNOTATE) {
+    LOG_OUTPUT("#A test\n");
+  }
+  capture_stop(immediate, sizeof(immediate));
+  UNIT_TEST_ASSERT(strcmp(queued, immediate) == 0);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_formatted, "Messages formatted when logged");
+UNIT_TEST(test_formatted)
+{
+  UNIT_TEST_BEGIN();
+
+  /* Arguments that cannot be stored raw are formatted at once */
+  ASSERT_SAME_OUTPUT("width %*d\n", 4, 7);
+  ASSERT_SAME_OUTPUT("seven %d %d %d %d %d %d %d\n",
+                     1, 2, 3, 4, 5, 6, 7);
+
+  /* They may be longer than the space for string arguments */
+  ASSERT_SAME_OUTPUT("%*d %s\n", 5, 12345,
+                     "is longer than LOG_DEFERRED_STR_LEN");
+
+  /* Longer messages end with "...", keeping the newline */
+  capture_start();
+  LOG_INFO("%*d %s %s %s\n", 5, 12345,
+           "is longer than the space for it,", "which holds the",
+           "arguments and the strings of a message");
+  log_deferred_flush();
+  capture_stop(queued, sizeof(queued));
+  UNIT_TEST_ASSERT(strlen(queued) == strlen("[INFO: Test      ] ")
+                   + sizeof(long) * LOG_DEFERRED_MAX_ARGS
+                   + LOG_DEFERRED_STR_LEN - 1);
+  UNIT_TEST_ASSERT(strcmp(&queued[strlen(queued) - 4], "...\n") == 0);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_dropped, "Messages dropped when the queue is full");
+UNIT_TEST(test_dropped)
+{
+  static char expected[LOG_DEFERRED_QUEUE_LEN * 32];
+  int len = 0;
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  /* The queue is only flushed by the process; fill it beyond its size.
+     It holds LOG_DEFERRED_QUEUE_LEN - 1 messages. */
+  capture_start();
+  for(i = 0; i < LOG_DEFERRED_QUEUE_LEN + 2; i++) {
+    LOG_INFO("message %d\n", i);
+  }
+  log_deferred_flush();
+  capture_stop(queued, sizeof(queued));
+  for(i = 0; i < LOG_DEFERRED_QUEUE_LEN - 1; i++) {
+    len += sprintf(&expected[len], "[INFO: Test      ] message %d\n", i);
+  }
+  sprintf(&expected[len], "[WARN: Log       ] logs dropped 3\n");
+  UNIT_TEST_ASSERT(strcmp(queued, expected) == 0);
+
+  /* The queue is usable again, and the drops are reported only once */
+  ASSERT_SAME_OUTPUT("after %d\n", 3);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_nested, "A nested flush outputs nothing twice");
+UNIT_TEST(test_nested)
+{
+  UNIT_TEST_BEGIN();
+
+  capture_start();
+  LOG_INFO("first\n");
+  LOG_INFO("second\n");
+  reenter = 1;
+  log_deferred_flush();
+  capture_stop(queued, sizeof(queued));
+  UNIT_TEST_ASSERT(strcmp(queued, "[INFO: Test      ] first\n"
+                          "[INFO: Test      ] second\n") == 0);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_boot, "No messages dropped while booting");
+UNIT_TEST(test_boot)
+{
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  /* Before log_deferred_init(), a full queue is flushed instead */
+  log_deferred_flush();
+  capture_start();
+  for(i = 0; i < LOG_DEFERRED_QUEUE_LEN * 2; i++) {
+    LOG_INFO("boot %d\n", i);
+  }
+  log_deferred_flush();
+  capture_stop(queued, sizeof(queued));
+  UNIT_TEST_ASSERT(strstr(queued, "[INFO: Test      ] boot 0\n") == queued);
+  UNIT_TEST_ASSERT(strstr(queued, "boot 31\n") != NULL);
+  UNIT_TEST_ASSERT(strstr(queued, "dropped") == NULL);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(log_deferred_test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  /* Autostarted processes run before the end of the boot */
+  UNIT_TEST_RUN(test_boot);
+
+  /* Run the rest once the queue is no longer flushed when full */
+  PROCESS_PAUSE();
+
+  UNIT_TEST_RUN(test_same_output);
+  UNIT_TEST_RUN(test_formatted);
+  UNIT_TEST_RUN(test_dropped);
+  UNIT_TEST_RUN(test_nested);
+
+  printf("=check-me= DONE\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2019, RISE SICS AB.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+#include "lwm2m-object.h"
+#include "lwm2m-cbor.h"
+#include "lwm2m-senml-cbor.h"
+#include "services/unit-test/unit-test.h"
+
+#include <string.h>
+#include <stdint.h>
+#include <stdio.h>
+/*---------------------------------------------------------------------------*/
+PROCESS(lwm2m_cbor_test_process, "LWM2M CBOR test process");
+AUTOSTART_PROCESSES(&lwm2m_cbor_test_process);
+/*---------------------------------------------------------------------------*/
+#define BITS 10
+/*---------------------------------------------------------------------------*/
+struct decode_vector {
+  const char *descr;
+  uint8_t len;
+  uint8_t data[9];
+  uint8_t ok;
+  int32_t value;
+};
+
+static const struct decode_vector decode_vectors[] = {
+  /* Integers are scaled by 2^BITS */
+  { "uint 0", 1, { 0x00 }, 1, 0 },
+  { "uint 2097151", 5, { 0x1a, 0x00, 0x1f, 0xff, 0xff }, 1, 2097151L * 1024 },
+  { "uint 2097152", 5, { 0x1a, 0x00, 0x20, 0x00, 0x00 }, 0, 0 },
+  { "uint 3000000", 5, { 0x1a, 0x00, 0x2d, 0xc6, 0xc0 }, 0, 0 },
+  { "nint -2097152", 5, { 0x3a, 0x00, 0x1f, 0xff, 0xff }, 1, INT32_MIN },
+  { "nint -2097153", 5, { 0x3a, 0x00, 0x20, 0x00, 0x00 }, 0, 0 },
+  { "uint 2^31", 5, { 0x1a, 0x80, 0x00, 0x00, 0x00 }, 0, 0 },
+  /* Half, single and double precision floats */
+  { "float16 -4.25", 3, { 0xf9, 0xc4, 0x40 }, 1, -4352 },
+  { "float16 inf", 3, { 0xf9, 0x7c, 0x00 }, 0, 0 },
+  { "float16 subnormal", 3, { 0xf9, 0x00, 0x01 }, 1, 0 },
+  { "float32 22.5", 5, { 0xfa, 0x41, 0xb4, 0x00, 0x00 }, 1, 23040 },
+  { "float32 NaN", 5, { 0xfa, 0x7f, 0xc0, 0x00, 0x00 }, 0, 0 },
+  { "float64 2^20", 9, { 0xfb, 0x41, 0x30, 0, 0, 0, 0, 0, 0 }, 1, 1L << 30 },
+  { "float64 -2^21", 9, { 0xfb, 0xc1, 0x40, 0, 0, 0, 0, 0, 0 }, 0, 0 },
+  { "float64 2^21", 9, { 0xfb, 0x41, 0x40, 0, 0, 0, 0, 0, 0 }, 0, 0 },
+  { "float64 2^54", 9, { 0xfb, 0x43, 0x50, 0, 0, 0, 0, 0, 0 }, 0, 0 },
+  { "float64 2^56", 9, { 0xfb, 0x43, 0x70, 0, 0, 0, 0, 0, 0 }, 0, 0 },
+  { "float64 1e300", 9, { 0xfb, 0x7e, 0x37, 0xe4, 0x3c, 0x88, 0x00, 0x75, 0x9c }, 0, 0 },
+  { "float64 -0.5", 9, { 0xfb, 0xbf, 0xe0, 0, 0, 0, 0, 0, 0 }, 1, -512 },
+  /* Other types */
+  { "text", 2, { 0x61, 0x31 }, 0, 0 },
+  { "true", 1, { 0xf5 }, 0, 0 },
+};
+/*---------------------------------------------------------------------------*/
+/* [{-2: "/3303/0/", 0: "5700", 2: 22.5}, {0: "5701", 3: "Cel"},
+    {0: "5702", 2: 3000000}] */
+static const uint8_t pack[] = {
+  0x83,
+  0xa3, 0x21, 0x68, '/', '3', '3', '0', '3', '/', '0', '/',
+  0x00, 0x64, '5', '7', '0', '0',
+  0x02, 0xfa, 0x41, 0xb4, 0x00, 0x00,
+  0xa2, 0x00, 0x64, '5', '7', '0', '1',
+  0x03, 0x63, 'C', 'e', 'l',
+  0xa2, 0x00, 0x64, '5', '7', '0', '2',
+  0x02, 0x1a, 0x00, 0x2d, 0xc6, 0xc0
+};
+/*---------------------------------------------------------------------------*/
+void
+print_test_report(const unit_test_t *utp)
+{
+  printf("=check-me= ");
+  if(utp->result == unit_test_failure) {
+    printf("FAILED   - %s: exit at L%u\n", utp->descr, utp->exit_line);
+  } else {
+    printf("SUCCEEDED - %s\n", utp->descr);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static int
+check_vector(const struct decode_vector *vector)
+{
+  lwm2m_cbor_t item;
+  int32_t value;
+  int ok;
+
+  if(lwm2m_cbor_read(&item, vector->data, vector->len) != vector->len) {
+    printf("%s: not read\n", vector->descr);
+    return 0;
+  }
+
+  value = 0;
+  ok = lwm2m_cbor_get_float32fix(&item, &value, BITS);
+  if(ok != vector->ok || (ok && value != vector->value)) {
+    printf("%s: ok %d value %ld, expected ok %d value %ld\n",
+           vector->descr, ok, (long)value, vector->ok, (long)vector->value);
+    return 0;
+  }
+
+  /* A truncated item is not read at all */
+  return lwm2m_cbor_read(&item, vector->data, vector->len - 1) == 0;
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_float32fix, "CBOR float32fix decoding");
+UNIT_TEST(test_float32fix)
+{
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  for(i = 0; i < sizeof(decode_vectors) / sizeof(decode_vectors[0]); i++) {
+    UNIT_TEST_ASSERT(check_vector(&decode_vectors[i]));
+  }
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+static int
+record_value(struct senml_cbor_record *record, int32_t *value)
+{
+  lwm2m_cbor_t item;
+
+  return lwm2m_cbor_read(&item, record->value, record->value_len) ==
+         record->value_len &&
+         lwm2m_cbor_get_float32fix(&item, value, BITS);
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_senml_cbor, "SenML CBOR decoding");
+UNIT_TEST(test_senml_cbor)
+{
+  static uint8_t buffer[sizeof(pack)];
+  lwm2m_buffer_t inbuf;
+  lwm2m_context_t ctx;
+  struct senml_cbor_record record;
+  int32_t value;
+
+  UNIT_TEST_BEGIN();
+
+  memcpy(buffer, pack, sizeof(pack));
+  memset(&ctx, 0, sizeof(ctx));
+  memset(&record, 0, sizeof(record));
+  inbuf.buffer = buffer;
+  inbuf.size = inbuf.len = sizeof(pack);
+  inbuf.pos = 0;
+  ctx.inbuf = &inbuf;
+
+  UNIT_TEST_ASSERT(lwm2m_senml_cbor_next_record(&ctx, &record));
+  UNIT_TEST_ASSERT(record.base_name_len == 8 &&
+                   memcmp(record.base_name, "/3303/0/", 8) == 0);
+  UNIT_TEST_ASSERT(record.name_len == 4 && memcmp(record.name, "5700", 4) == 0);
+  UNIT_TEST_ASSERT(record_value(&record, &value) && value == 23040);
+
+  UNIT_TEST_ASSERT(lwm2m_senml_cbor_next_record(&ctx, &record));
+  UNIT_TEST_ASSERT(record.base_name_len == 8);
+  UNIT_TEST_ASSERT(record.name_len == 4 && memcmp(record.name, "5701", 4) == 0);
+  UNIT_TEST_ASSERT(record.value_len == 4 && record.value[0] == 0x63);
+  UNIT_TEST_ASSERT(!record_value(&record, &value));
+
+  /* The value is out of range for the fixed-point representation */
+  UNIT_TEST_ASSERT(lwm2m_senml_cbor_next_record(&ctx, &record));
+  UNIT_TEST_ASSERT(record.name_len == 4 && memcmp(record.name, "5702", 4) == 0);
+  UNIT_TEST_ASSERT(!record_value(&record, &value));
+
+  UNIT_TEST_ASSERT(!lwm2m_senml_cbor_next_record(&ctx, &record));
+
+  /* A truncated pack ends inside the first record */
+  inbuf.size = inbuf.len = 20;
+  inbuf.pos = 0;
+  UNIT_TEST_ASSERT(!lwm2m_senml_cbor_next_record(&ctx, &record));
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(lwm2m_cbor_test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  UNIT_TEST_RUN(test_float32fix);
+  UNIT_TEST_RUN(test_senml_cbor);
+
+  printf("=check-me= DONE\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
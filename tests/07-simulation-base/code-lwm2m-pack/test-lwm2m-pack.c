@@ -0,0 +1,273 @@
+/*
+ * Copyright (c) 2019, RISE SICS AB.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+#include "coap-callback-api.h"
+#include "lwm2m-engine.h"
+#include "lwm2m-object.h"
+#include "lwm2m-cbor.h"
+#include "lwm2m-senml-cbor.h"
+#include "lwm2m-notification-queue.h"
+#include "lwm2m-device.h"
+#include "services/unit-test/unit-test.h"
+
+#include <string.h>
+#include <stdio.h>
+/*---------------------------------------------------------------------------*/
+PROCESS(lwm2m_pack_test_process, "LWM2M pack test process");
+AUTOSTART_PROCESSES(&lwm2m_pack_test_process);
+/*---------------------------------------------------------------------------*/
+static const lwm2m_resource_id_t resources[] = { RO(5700), RO(5701) };
+
+static lwm2m_status_t
+read_callback(lwm2m_object_instance_t *object, lwm2m_context_t *ctx)
+{
+  if(ctx->operation != LWM2M_OP_READ) {
+    return LWM2M_STATUS_OPERATION_NOT_ALLOWED;
+  }
+  /* The value identifies the resource */
+  lwm2m_object_write_int(ctx, object->object_id + ctx->resource_id);
+  return LWM2M_STATUS_OK;
+}
+
+static lwm2m_object_instance_t objects[] = {
+  { .object_id = 3303, .instance_id = 0, .resource_ids = resources,
+    .resource_count = 2, .callback = read_callback },
+  { .object_id = 3304, .instance_id = 0, .resource_ids = resources,
+    .resource_count = 2, .callback = read_callback },
+};
+/*---------------------------------------------------------------------------*/
+/* The Send requests are captured instead of sent */
+static coap_callback_request_state_t *sent_state;
+static void (*sent_callback)(coap_callback_request_state_t *callback_state);
+static uint8_t sent_payload[COAP_MAX_CHUNK_SIZE];
+static uint16_t sent_len;
+static unsigned sent_count;
+
+int
+coap_send_request(coap_callback_request_state_t *callback_state,
+                  coap_endpoint_t *endpoint, coap_message_t *request,
+                  void (*callback)(coap_callback_request_state_t *callback_state))
+{
+  const char *uri;
+
+  if(coap_get_header_uri_path(request, &uri) != 2 ||
+     memcmp(uri, "dp", 2) != 0) {
+    return 0;
+  }
+  sent_state = callback_state;
+  sent_callback = callback;
+  sent_len = request->payload_len;
+  memcpy(sent_payload, request->payload, sent_len);
+  sent_count++;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Completes the last Send request with a status and a response code */
+static void
+complete(coap_request_status_t status, uint8_t code)
+{
+  static coap_message_t response[1];
+
+  response->code = code;
+  sent_state->state.status = status;
+  sent_state->state.response = status == COAP_REQUEST_STATUS_RESPONSE
+    || status == COAP_REQUEST_STATUS_MORE ? response : NULL;
+  sent_callback(sent_state);
+}
+/*---------------------------------------------------------------------------*/
+/* Queues paths and sends them. Returns the number of new Send requests. */
+static unsigned
+send_paths(const uint16_t (*paths)[3], int count)
+{
+  unsigned before = sent_count;
+  int i;
+
+  for(i = 0; i < count; i++) {
+    lwm2m_notification_queue_add_notification_path(paths[i][0], paths[i][1],
+                                                    paths[i][2]);
+  }
+  lwm2m_notification_queue_send_notifications();
+  return sent_count - before;
+}
+/*---------------------------------------------------------------------------*/
+void
+print_test_report(const unit_test_t *utp)
+{
+  printf("=check-me= ");
+  if(utp->result == unit_test_failure) {
+    printf("FAILED   - %s: exit at L%u\n", utp->descr, utp->exit_line);
+  } else {
+    printf("SUCCEEDED - %s\n", utp->descr);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static int
+next_record(lwm2m_context_t *ctx, struct senml_cbor_record *record,
+            const char *base_name, const char *name, int32_t value)
+{
+  lwm2m_cbor_t item;
+  int32_t v;
+
+  return lwm2m_senml_cbor_next_record(ctx, record) &&
+    record->base_name_len == strlen(base_name) &&
+    memcmp(record->base_name, base_name, record->base_name_len) == 0 &&
+    record->name_len == strlen(name) &&
+    memcmp(record->name, name, record->name_len) == 0 &&
+    lwm2m_cbor_read(&item, record->value, record->value_len) ==
+    record->value_len &&
+    lwm2m_cbor_get_float32fix(&item, &v, 0) && v == value;
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_pack, "Queued resources coalesced into one pack");
+UNIT_TEST(test_pack)
+{
+  static const uint16_t paths[][3] = {
+    { 3303, 0, 5700 }, { 3303, 0, 5701 }, { 3304, 0, 5700 }, { 3303, 0, 5700 }
+  };
+  lwm2m_buffer_t inbuf;
+  lwm2m_context_t ctx;
+  struct senml_cbor_record record;
+
+  UNIT_TEST_BEGIN();
+
+  /* One Send request for all paths, the duplicate included once */
+  UNIT_TEST_ASSERT(send_paths(paths, 4) == 1);
+
+  memset(&ctx, 0, sizeof(ctx));
+  memset(&record, 0, sizeof(record));
+  memset(&inbuf, 0, sizeof(inbuf));
+  inbuf.buffer = sent_payload;
+  inbuf.size = inbuf.len = sent_len;
+  ctx.inbuf = &inbuf;
+  UNIT_TEST_ASSERT(next_record(&ctx, &record, "/3303/0/", "5700", 9003));
+  /* The device time has not been set: no base time */
+  UNIT_TEST_ASSERT(record.base_time == 0);
+  UNIT_TEST_ASSERT(next_record(&ctx, &record, "/3303/0/", "5701", 9004));
+  UNIT_TEST_ASSERT(next_record(&ctx, &record, "/3304/0/", "5700", 9004));
+  UNIT_TEST_ASSERT(!lwm2m_senml_cbor_next_record(&ctx, &record));
+
+  /* Nothing is sent again once the pack is acknowledged */
+  complete(COAP_REQUEST_STATUS_RESPONSE, CHANGED_2_04);
+  complete(COAP_REQUEST_STATUS_FINISHED, 0);
+  UNIT_TEST_ASSERT(send_paths(paths, 0) == 0);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_failures, "Fallback on failed packs");
+UNIT_TEST(test_failures)
+{
+  static const uint16_t path[][3] = { { 3303, 0, 5700 } };
+
+  UNIT_TEST_BEGIN();
+
+  /* While a pack is in flight, changes are notified one by one */
+  UNIT_TEST_ASSERT(send_paths(path, 1) == 1);
+  UNIT_TEST_ASSERT(send_paths(path, 1) == 0);
+
+  /* A block in the middle of the response does not end the request */
+  complete(COAP_REQUEST_STATUS_MORE, CHANGED_2_04);
+  UNIT_TEST_ASSERT(send_paths(path, 1) == 0);
+
+  /* Every terminal status ends the request */
+  complete(COAP_REQUEST_STATUS_BLOCK_ERROR, 0);
+  UNIT_TEST_ASSERT(send_paths(path, 1) == 1);
+  complete(COAP_REQUEST_STATUS_TIMEOUT, 0);
+  UNIT_TEST_ASSERT(send_paths(path, 1) == 1);
+  complete(COAP_REQUEST_STATUS_FINISHED, 0);
+  UNIT_TEST_ASSERT(send_paths(path, 1) == 1);
+
+  /* A server without Send gets notifications until it registers again */
+  complete(COAP_REQUEST_STATUS_RESPONSE, NOT_FOUND_4_04);
+  UNIT_TEST_ASSERT(send_paths(path, 1) == 0);
+  lwm2m_notification_queue_registered();
+  UNIT_TEST_ASSERT(send_paths(path, 1) == 1);
+  complete(COAP_REQUEST_STATUS_RESPONSE, CHANGED_2_04);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_time, "Base time of a pack");
+UNIT_TEST(test_time)
+{
+  static const uint16_t paths[][3] = { { 3303, 0, 5700 }, { 3304, 0, 5700 } };
+  lwm2m_buffer_t inbuf;
+  lwm2m_context_t ctx;
+  struct senml_cbor_record record;
+
+  UNIT_TEST_BEGIN();
+
+  lwm2m_device_set_time(1700000000);
+  UNIT_TEST_ASSERT(send_paths(paths, 2) == 1);
+
+  memset(&ctx, 0, sizeof(ctx));
+  memset(&record, 0, sizeof(record));
+  memset(&inbuf, 0, sizeof(inbuf));
+  inbuf.buffer = sent_payload;
+  inbuf.size = inbuf.len = sent_len;
+  ctx.inbuf = &inbuf;
+  UNIT_TEST_ASSERT(next_record(&ctx, &record, "/3303/0/", "5700", 9003));
+  UNIT_TEST_ASSERT(record.base_time >= 1700000000 &&
+                   record.base_time <= 1700000001);
+  UNIT_TEST_ASSERT(record.time == 0);
+
+  /* The base time is written once, even when the base name is repeated */
+  record.base_time = 0;
+  UNIT_TEST_ASSERT(next_record(&ctx, &record, "/3304/0/", "5700", 9004));
+  UNIT_TEST_ASSERT(record.base_time == 0);
+  UNIT_TEST_ASSERT(!lwm2m_senml_cbor_next_record(&ctx, &record));
+
+  complete(COAP_REQUEST_STATUS_RESPONSE, CHANGED_2_04);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(lwm2m_pack_test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  lwm2m_notification_queue_init();
+  lwm2m_engine_add_object(&objects[0]);
+  lwm2m_engine_add_object(&objects[1]);
+
+  UNIT_TEST_RUN(test_pack);
+  UNIT_TEST_RUN(test_failures);
+  UNIT_TEST_RUN(test_time);
+
+  printf("=check-me= DONE\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
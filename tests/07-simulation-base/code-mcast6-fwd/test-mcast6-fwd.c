@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2019, RISE SICS AB.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+#include "contiki-net.h"
+#include "net/ipv6/multicast/uip-mcast6-fwd.h"
+#include "services/unit-test/unit-test.h"
+
+#include <string.h>
+#include <stdio.h>
+/*---------------------------------------------------------------------------*/
+PROCESS(mcast6_fwd_test_process, "Multicast forwarding test process");
+AUTOSTART_PROCESSES(&mcast6_fwd_test_process);
+/*---------------------------------------------------------------------------*/
+#define UIP_IP_BUF        ((struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN])
+#define PAYLOAD_LEN       8
+/*---------------------------------------------------------------------------*/
+/* Put a multicast datagram from fd00::<src> with the given payload in uip_buf */
+static void
+make_datagram(uint8_t src, uint8_t payload, uint8_t ttl)
+{
+  memset(UIP_IP_BUF, 0, UIP_IPH_LEN + PAYLOAD_LEN);
+  UIP_IP_BUF->vtc = 0x60;
+  UIP_IP_BUF->len[1] = PAYLOAD_LEN;
+  UIP_IP_BUF->proto = UIP_PROTO_UDP;
+  UIP_IP_BUF->ttl = ttl;
+  uip_ip6addr(&UIP_IP_BUF->srcipaddr, 0xfd00, 0, 0, 0, 0, 0, 0, src);
+  uip_ip6addr(&UIP_IP_BUF->destipaddr, 0xff1e, 0, 0, 0, 0, 0, 0x89, 0xabcd);
+  memset(&uip_buf[UIP_LLH_LEN + UIP_IPH_LEN], payload, PAYLOAD_LEN);
+  uip_len = UIP_IPH_LEN + PAYLOAD_LEN;
+}
+/*---------------------------------------------------------------------------*/
+void
+print_test_report(const unit_test_t *utp)
+{
+  printf("=check-me= ");
+  if(utp->result == unit_test_failure) {
+    printf("FAILED   - %s: exit at L%u\n", utp->descr, utp->exit_line);
+  } else {
+    printf("SUCCEEDED - %s\n", utp->descr);
+  }
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_dup, "Duplicate detection");
+UNIT_TEST(test_dup)
+{
+  UNIT_TEST_BEGIN();
+
+  uip_mcast6_fwd_init();
+
+  make_datagram(1, 0xaa, 64);
+  UNIT_TEST_ASSERT(uip_mcast6_fwd_is_dup() == 0);
+  UNIT_TEST_ASSERT(uip_mcast6_fwd_is_dup() == 1);
+
+  /* The same datagram relayed again, with a lower hop limit */
+  make_datagram(1, 0xaa, 63);
+  UNIT_TEST_ASSERT(uip_mcast6_fwd_is_dup() == 1);
+
+  /* Another payload or another source is another datagram */
+  make_datagram(1, 0xbb, 64);
+  UNIT_TEST_ASSERT(uip_mcast6_fwd_is_dup() == 0);
+  make_datagram(2, 0xaa, 64);
+  UNIT_TEST_ASSERT(uip_mcast6_fwd_is_dup() == 0);
+
+  /* The cache holds two datagrams: the first one has been replaced */
+  make_datagram(1, 0xaa, 64);
+  UNIT_TEST_ASSERT(uip_mcast6_fwd_is_dup() == 0);
+  make_datagram(2, 0xaa, 64);
+  UNIT_TEST_ASSERT(uip_mcast6_fwd_is_dup() == 1);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_dup_expiry, "Duplicate lifetime");
+UNIT_TEST(test_dup_expiry)
+{
+  UNIT_TEST_BEGIN();
+
+  /* Seen by test_dup more than UIP_MCAST6_FWD_DUP_LIFETIME ago */
+  make_datagram(2, 0xaa, 64);
+  UNIT_TEST_ASSERT(uip_mcast6_fwd_is_dup() == 0);
+  UNIT_TEST_ASSERT(uip_mcast6_fwd_is_dup() == 1);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_queue, "Forwarding queue");
+UNIT_TEST(test_queue)
+{
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  uip_mcast6_fwd_init();
+
+  /* Long delays: the datagrams are never sent while the test runs */
+  for(i = 0; i < UIP_MCAST6_FWD_QUEUE_SIZE; i++) {
+    make_datagram(1, i, 64);
+    UNIT_TEST_ASSERT(uip_mcast6_fwd_schedule(CLOCK_SECOND * 3600) == 0);
+  }
+  make_datagram(1, i, 64);
+  UNIT_TEST_ASSERT(uip_mcast6_fwd_schedule(CLOCK_SECOND * 3600) == -1);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(mcast6_fwd_test_process, ev, data)
+{
+  static struct etimer et;
+
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  UNIT_TEST_RUN(test_dup);
+
+  etimer_set(&et, UIP_MCAST6_FWD_DUP_LIFETIME + 1);
+  PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+  UNIT_TEST_RUN(test_dup_expiry);
+
+  UNIT_TEST_RUN(test_queue);
+
+  printf("=check-me= DONE\n");
+
+  PROCESS_END();
+}
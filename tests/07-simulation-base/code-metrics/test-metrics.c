@@ -0,0 +1,257 @@
+/*
+ * Copyright (c) 2019, RISE SICS AB.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+#include "services/metrics/metrics.h"
+#include "services/unit-test/unit-test.h"
+
+#include <string.h>
+#include <stdio.h>
+/*---------------------------------------------------------------------------*/
+PROCESS(metrics_test_process, "Metrics encoding test process");
+AUTOSTART_PROCESSES(&metrics_test_process);
+/*---------------------------------------------------------------------------*/
+static struct metrics_record base;
+static struct metrics_record record;
+static struct metrics_record decoded;
+static uint8_t buf[METRICS_MAX_RECORD_LEN + 8];
+/*---------------------------------------------------------------------------*/
+/* A record as sampled by a joined node, with values of all sizes */
+static void
+make_record(struct metrics_record *r, uint8_t seq)
+{
+  uint8_t i;
+
+  r->seq = seq;
+  for(i = 0; i < METRICS_FIELD_MAX; i++) {
+    r->values[i] = (uint32_t)(i + 1) * 1000003UL;
+  }
+  r->values[METRICS_UPTIME] = 0xfffffffe;
+  r->values[METRICS_RANK] = 0xffff;
+  r->values[METRICS_PARENT_RSSI] = (uint32_t)(int32_t)-70;
+  r->values[METRICS_NEIGHBORS] = 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+records_equal(const struct metrics_record *a, const struct metrics_record *b)
+{
+  return a->seq == b->seq
+    && memcmp(a->values, b->values, sizeof(a->values)) == 0;
+}
+/*---------------------------------------------------------------------------*/
+void
+print_test_report(const unit_test_t *utp)
+{
+  printf("=check-me= ");
+  if(utp->result == unit_test_failure) {
+    printf("FAILED   - %s: exit at L%u\n", utp->descr, utp->exit_line);
+  } else {
+    printf("SUCCEEDED - %s\n", utp->descr);
+  }
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_full, "Full record round trip");
+UNIT_TEST(test_full)
+{
+  int len;
+
+  UNIT_TEST_BEGIN();
+
+  make_record(&record, 1);
+  len = metrics_encode(buf, sizeof(buf), &record, NULL);
+  UNIT_TEST_ASSERT(len > 3 && len <= METRICS_MAX_RECORD_LEN);
+  UNIT_TEST_ASSERT(buf[0] == ((METRICS_VERSION << 4) | METRICS_FLAG_FULL));
+  UNIT_TEST_ASSERT(buf[1] == 1);
+  UNIT_TEST_ASSERT(buf[2] == METRICS_FIELD_MAX);
+
+  /* A full record does not depend on what the decoder held before */
+  memset(&decoded, 0x5a, sizeof(decoded));
+  UNIT_TEST_ASSERT(metrics_decode(buf, len, &decoded) == 0);
+  UNIT_TEST_ASSERT(records_equal(&decoded, &record));
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_delta, "Delta record round trip");
+UNIT_TEST(test_delta)
+{
+  int len;
+
+  UNIT_TEST_BEGIN();
+
+  make_record(&base, 1);
+  record = base;
+  record.seq = 2;
+  record.values[METRICS_UPTIME] += 60;          /* Wraps around */
+  record.values[METRICS_CPU] += 1500;
+  record.values[METRICS_RANK] = 512;            /* Joined: large decrease */
+  record.values[METRICS_PARENT_RSSI] = (uint32_t)(int32_t)-75;
+  record.values[METRICS_NEIGHBORS] = 3;
+  record.values[METRICS_HEAP] -= 1;
+
+  len = metrics_encode(buf, sizeof(buf), &record, &base);
+  UNIT_TEST_ASSERT(len > 3);
+  UNIT_TEST_ASSERT((buf[0] & METRICS_FLAG_FULL) == 0);
+
+  decoded = base;
+  UNIT_TEST_ASSERT(metrics_decode(buf, len, &decoded) == 0);
+  UNIT_TEST_ASSERT(records_equal(&decoded, &record));
+
+  /* An unchanged record takes one byte per field */
+  len = metrics_encode(buf, sizeof(buf), &record, &record);
+  UNIT_TEST_ASSERT(len == 3 + METRICS_FIELD_MAX);
+  UNIT_TEST_ASSERT(metrics_decode(buf, len, &decoded) == 0);
+  UNIT_TEST_ASSERT(records_equal(&decoded, &record));
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_extremes, "Extreme deltas");
+UNIT_TEST(test_extremes)
+{
+  int len;
+  uint8_t i;
+
+  UNIT_TEST_BEGIN();
+
+  /* Every field moves by the largest amount, which takes five bytes */
+  for(i = 0; i < METRICS_FIELD_MAX; i++) {
+    base.values[i] = i & 1 ? 0x7fffffff : 0;
+    record.values[i] = base.values[i] + 0x80000000;
+  }
+  base.seq = 255;
+  record.seq = 0;
+
+  len = metrics_encode(buf, sizeof(buf), &record, &base);
+  UNIT_TEST_ASSERT(len == METRICS_MAX_RECORD_LEN);
+  decoded = base;
+  UNIT_TEST_ASSERT(metrics_decode(buf, len, &decoded) == 0);
+  UNIT_TEST_ASSERT(records_equal(&decoded, &record));
+
+  /* And back */
+  len = metrics_encode(buf, sizeof(buf), &base, &record);
+  UNIT_TEST_ASSERT(len == METRICS_MAX_RECORD_LEN);
+  UNIT_TEST_ASSERT(metrics_decode(buf, len, &decoded) == 0);
+  UNIT_TEST_ASSERT(records_equal(&decoded, &base));
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_malformed, "Short buffers and malformed records");
+UNIT_TEST(test_malformed)
+{
+  int len;
+
+  UNIT_TEST_BEGIN();
+
+  make_record(&record, 7);
+  len = metrics_encode(buf, sizeof(buf), &record, NULL);
+  UNIT_TEST_ASSERT(len > 3);
+
+  /* The output buffer is one byte too short */
+  UNIT_TEST_ASSERT(metrics_encode(buf, len - 1, &record, NULL) == -1);
+  UNIT_TEST_ASSERT(metrics_encode(buf, 2, &record, NULL) == -1);
+
+  len = metrics_encode(buf, sizeof(buf), &record, NULL);
+  decoded = record;
+  UNIT_TEST_ASSERT(metrics_decode(buf, len - 1, &decoded) == -1);
+  UNIT_TEST_ASSERT(metrics_decode(buf, 2, &decoded) == -1);
+  /* A failed decoding leaves the record as it was */
+  UNIT_TEST_ASSERT(records_equal(&decoded, &record));
+
+  buf[0] = ((METRICS_VERSION + 1) << 4) | METRICS_FLAG_FULL;
+  UNIT_TEST_ASSERT(metrics_decode(buf, len, &decoded) == -1);
+
+  /* A varint longer than five bytes */
+  buf[0] = (METRICS_VERSION << 4) | METRICS_FLAG_FULL;
+  buf[2] = 1;
+  memset(&buf[3], 0x80, 5);
+  buf[8] = 0x01;
+  UNIT_TEST_ASSERT(metrics_decode(buf, 9, &decoded) == -1);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_versions, "Records with more or fewer fields");
+UNIT_TEST(test_versions)
+{
+  int len;
+
+  UNIT_TEST_BEGIN();
+
+  /* A newer sender appends a field that is skipped */
+  make_record(&record, 3);
+  len = metrics_encode(buf, sizeof(buf), &record, NULL);
+  buf[2]++;
+  buf[len++] = 0x81;
+  buf[len++] = 0x01;
+  UNIT_TEST_ASSERT(metrics_decode(buf, len, &decoded) == 0);
+  UNIT_TEST_ASSERT(records_equal(&decoded, &record));
+
+  /* An older sender without the last field: kept for a delta record */
+  base = record;
+  record.seq = 4;
+  record.values[METRICS_CPU] += 10;
+  len = metrics_encode(buf, sizeof(buf), &record, &base);
+  buf[2]--;
+  len--;
+  decoded = base;
+  UNIT_TEST_ASSERT(metrics_decode(buf, len, &decoded) == 0);
+  UNIT_TEST_ASSERT(records_equal(&decoded, &record));
+
+  /* ... and cleared for a full record; a small value takes one byte */
+  record.values[METRICS_HEAP] = 40;
+  len = metrics_encode(buf, sizeof(buf), &record, NULL);
+  buf[2]--;
+  len--;
+  UNIT_TEST_ASSERT(metrics_decode(buf, len, &decoded) == 0);
+  UNIT_TEST_ASSERT(decoded.values[METRICS_HEAP] == 0);
+  UNIT_TEST_ASSERT(decoded.values[METRICS_CPU] == record.values[METRICS_CPU]);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(metrics_test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  UNIT_TEST_RUN(test_full);
+  UNIT_TEST_RUN(test_delta);
+  UNIT_TEST_RUN(test_extremes);
+  UNIT_TEST_RUN(test_malformed);
+  UNIT_TEST_RUN(test_versions);
+
+  printf("=check-me= DONE\n");
+
+  PROCESS_END();
+}
@@ -0,0 +1,311 @@
+/*
+ * Copyright (c) 2019, RISE SICS AB.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+#include "net/netstack.h"
+#include "net/packetbuf.h"
+#include "services/radio-accounting/radio-accounting.h"
+#include "services/unit-test/unit-test.h"
+#if NETSTACK_CONF_WITH_IPV6
+#include "net/ipv6/uip.h"
+#include "net/ipv6/uip-icmp6.h"
+#else /* NETSTACK_CONF_WITH_IPV6 */
+#include "net/nullnet/nullnet.h"
+#endif /* NETSTACK_CONF_WITH_IPV6 */
+
+#include <string.h>
+#include <stdio.h>
+/*---------------------------------------------------------------------------*/
+PROCESS(radio_accounting_test_process, "Radio accounting test process");
+AUTOSTART_PROCESSES(&radio_accounting_test_process);
+/*---------------------------------------------------------------------------*/
+/* The results of the next transmissions, then RADIO_TX_OK */
+static const int tx_results[] = { RADIO_TX_COLLISION, RADIO_TX_COLLISION };
+static unsigned tx_attempts;
+/*---------------------------------------------------------------------------*/
+static int
+init(void)
+{
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+prepare(const void *payload, unsigned short payload_len)
+{
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+transmit(unsigned short transmit_len)
+{
+  int result = RADIO_TX_OK;
+
+  if(tx_attempts < sizeof(tx_results) / sizeof(tx_results[0])) {
+    result = tx_results[tx_attempts];
+  }
+  tx_attempts++;
+  return result;
+}
+/*---------------------------------------------------------------------------*/
+static int
+send(const void *payload, unsigned short payload_len)
+{
+  prepare(payload, payload_len);
+  return transmit(payload_len);
+}
+/*---------------------------------------------------------------------------*/
+static int
+radio_read(void *buf, unsigned short buf_len)
+{
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+channel_clear(void)
+{
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+receiving_packet(void)
+{
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+pending_packet(void)
+{
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+on(void)
+{
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+off(void)
+{
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static radio_result_t
+get_value(radio_param_t param, radio_value_t *value)
+{
+  return RADIO_RESULT_NOT_SUPPORTED;
+}
+/*---------------------------------------------------------------------------*/
+static radio_result_t
+set_value(radio_param_t param, radio_value_t value)
+{
+  return RADIO_RESULT_NOT_SUPPORTED;
+}
+/*---------------------------------------------------------------------------*/
+static radio_result_t
+get_object(radio_param_t param, void *dest, size_t size)
+{
+  return RADIO_RESULT_NOT_SUPPORTED;
+}
+/*---------------------------------------------------------------------------*/
+static radio_result_t
+set_object(radio_param_t param, const void *src, size_t size)
+{
+  return RADIO_RESULT_NOT_SUPPORTED;
+}
+/*---------------------------------------------------------------------------*/
+const struct radio_driver test_radio_driver = {
+  init,
+  prepare,
+  transmit,
+  send,
+  radio_read,
+  channel_clear,
+  receiving_packet,
+  pending_packet,
+  on,
+  off,
+  get_value,
+  set_value,
+  get_object,
+  set_object
+};
+/*---------------------------------------------------------------------------*/
+void
+print_test_report(const unit_test_t *utp)
+{
+  printf("=check-me= ");
+  if(utp->result == unit_test_failure) {
+    printf("FAILED   - %s: exit at L%u\n", utp->descr, utp->exit_line);
+  } else {
+    printf("SUCCEEDED - %s\n", utp->descr);
+  }
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_counters, "Counters and airtime");
+UNIT_TEST(test_counters)
+{
+  const struct radio_accounting_stats *stats;
+
+  UNIT_TEST_BEGIN();
+
+  radio_accounting_reset();
+  radio_accounting_tx(RADIO_ACCOUNTING_RPL, 50, 3);
+  radio_accounting_rx(RADIO_ACCOUNTING_RPL, 40);
+  radio_accounting_rx(RADIO_ACCOUNTING_RPL, 60);
+  /* Unknown categories are counted as other */
+  radio_accounting_tx(RADIO_ACCOUNTING_CATEGORY_MAX, 10, 1);
+
+  stats = radio_accounting_get(RADIO_ACCOUNTING_RPL);
+  UNIT_TEST_ASSERT(stats->tx.frames == 3 && stats->tx.bytes == 150);
+  UNIT_TEST_ASSERT(stats->rx.frames == 2 && stats->rx.bytes == 100);
+  UNIT_TEST_ASSERT(radio_accounting_airtime(&stats->tx) ==
+                   (150 + 3 * RADIO_ACCOUNTING_FRAME_OVERHEAD)
+                   * RADIO_ACCOUNTING_BYTE_AIRTIME);
+  stats = radio_accounting_get(RADIO_ACCOUNTING_OTHER);
+  UNIT_TEST_ASSERT(stats->tx.frames == 1 && stats->tx.bytes == 10);
+  UNIT_TEST_ASSERT(radio_accounting_get(RADIO_ACCOUNTING_CATEGORY_MAX) == NULL);
+
+  UNIT_TEST_ASSERT(strcmp(radio_accounting_category_name(RADIO_ACCOUNTING_RPL),
+                          "rpl") == 0);
+  UNIT_TEST_ASSERT(strcmp(radio_accounting_category_name(RADIO_ACCOUNTING_CATEGORY_MAX),
+                          "unknown") == 0);
+
+  radio_accounting_reset();
+  stats = radio_accounting_get(RADIO_ACCOUNTING_RPL);
+  UNIT_TEST_ASSERT(stats->tx.frames == 0 && stats->rx.bytes == 0);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+#if NETSTACK_CONF_WITH_IPV6
+/* Builds an IPv6 packet in uip_buf and classifies it */
+static uint8_t
+classify(uint8_t proto, const uint8_t *payload, uint16_t len)
+{
+  struct uip_ip_hdr *ip = (struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN];
+
+  memset(ip, 0, UIP_IPH_LEN);
+  ip->vtc = 0x60;
+  ip->proto = proto;
+  memcpy((uint8_t *)ip + UIP_IPH_LEN, payload, len);
+  uip_len = UIP_IPH_LEN + len;
+  return radio_accounting_classify();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_classify, "Classification of IPv6 packets");
+UNIT_TEST(test_classify)
+{
+  static const uint8_t rpl[] = { ICMP6_RPL, 0, 0, 0 };
+  static const uint8_t echo[] = { ICMP6_ECHO_REQUEST, 0, 0, 0 };
+  /* Source and destination ports */
+  static const uint8_t coap[] = { 0xc0, 0x00, 0x16, 0x33, 0, 8, 0, 0 };
+  static const uint8_t coaps[] = { 0x16, 0x34, 0xc0, 0x00, 0, 8, 0, 0 };
+  static const uint8_t udp[] = { 0xc0, 0x00, 0x04, 0xd2, 0, 8, 0, 0 };
+  static const uint8_t tcp[] = { 0x04, 0xd2, 0x00, 0x50, 0, 0, 0, 0 };
+  /* A hop-by-hop options header, then RPL */
+  static const uint8_t hbh_rpl[] = { UIP_PROTO_ICMP6, 0, 0, 0, 0, 0, 0, 0,
+                                     ICMP6_RPL, 0, 0, 0 };
+
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(classify(UIP_PROTO_ICMP6, rpl, sizeof(rpl))
+                   == RADIO_ACCOUNTING_RPL);
+  UNIT_TEST_ASSERT(classify(UIP_PROTO_ICMP6, echo, sizeof(echo))
+                   == RADIO_ACCOUNTING_ICMP6);
+  UNIT_TEST_ASSERT(classify(UIP_PROTO_UDP, coap, sizeof(coap))
+                   == RADIO_ACCOUNTING_COAP);
+  UNIT_TEST_ASSERT(classify(UIP_PROTO_UDP, coaps, sizeof(coaps))
+                   == RADIO_ACCOUNTING_COAP);
+  UNIT_TEST_ASSERT(classify(UIP_PROTO_UDP, udp, sizeof(udp))
+                   == RADIO_ACCOUNTING_UDP);
+  UNIT_TEST_ASSERT(classify(UIP_PROTO_TCP, tcp, sizeof(tcp))
+                   == RADIO_ACCOUNTING_TCP);
+  UNIT_TEST_ASSERT(classify(UIP_PROTO_HBHO, hbh_rpl, sizeof(hbh_rpl))
+                   == RADIO_ACCOUNTING_RPL);
+  /* Too short to hold the transport header */
+  UNIT_TEST_ASSERT(classify(UIP_PROTO_UDP, udp, 2) == RADIO_ACCOUNTING_OTHER);
+
+  UNIT_TEST_END();
+}
+#else /* NETSTACK_CONF_WITH_IPV6 */
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_csma_attempts, "Every CSMA attempt counted");
+UNIT_TEST(test_csma_attempts)
+{
+  const struct radio_accounting_stats *stats;
+
+  UNIT_TEST_BEGIN();
+
+  /* Without IPv6, all frames are in the other category */
+  UNIT_TEST_ASSERT(radio_accounting_classify() == RADIO_ACCOUNTING_OTHER);
+
+  stats = radio_accounting_get(RADIO_ACCOUNTING_OTHER);
+  UNIT_TEST_ASSERT(tx_attempts > sizeof(tx_results) / sizeof(tx_results[0]));
+  UNIT_TEST_ASSERT(stats->tx.frames == tx_attempts);
+  UNIT_TEST_ASSERT(stats->tx.bytes >= tx_attempts * 4);
+
+  UNIT_TEST_END();
+}
+#endif /* NETSTACK_CONF_WITH_IPV6 */
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(radio_accounting_test_process, ev, data)
+{
+#if !NETSTACK_CONF_WITH_IPV6
+  static struct etimer et;
+  static const char payload[] = "test";
+#endif /* !NETSTACK_CONF_WITH_IPV6 */
+
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  UNIT_TEST_RUN(test_counters);
+
+#if NETSTACK_CONF_WITH_IPV6
+  UNIT_TEST_RUN(test_classify);
+#else /* NETSTACK_CONF_WITH_IPV6 */
+  /* Broadcast a frame; CSMA retries it after each collision */
+  radio_accounting_reset();
+  nullnet_buf = (uint8_t *)payload;
+  nullnet_len = sizeof(payload);
+  NETSTACK_NETWORK.output(NULL);
+  etimer_set(&et, CLOCK_SECOND);
+  PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+  UNIT_TEST_RUN(test_csma_attempts);
+#endif /* NETSTACK_CONF_WITH_IPV6 */
+
+  printf("=check-me= DONE\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2019, RISE SICS AB.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+#include "contiki-net.h"
+#include "net/ipv6/multicast/uip-mcast6.h"
+#include "net/ipv6/multicast/uip-mcast6-stats.h"
+#include "services/unit-test/unit-test.h"
+
+#include <string.h>
+#include <stdio.h>
+/*---------------------------------------------------------------------------*/
+PROCESS(roll_tm_test_process, "ROLL-TM test process");
+AUTOSTART_PROCESSES(&roll_tm_test_process);
+/*---------------------------------------------------------------------------*/
+#define UIP_IP_BUF        ((struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN])
+#define HBHO_LEN          8
+#define PAYLOAD_LEN       4
+#define SEED_A            1
+#define SEED_B            2
+#define SEED_C            3
+#define SEED_D            4
+/*---------------------------------------------------------------------------*/
+/*
+ * Put a datagram from seed fd00::<seed> with the given sequence value in
+ * uip_buf, then pass it to the engine. Returns 1 if it was accepted as a
+ * new message, 0 if it was dropped.
+ */
+static int
+receive(uint8_t seed, uint16_t seq)
+{
+  uint8_t *hbho = &uip_buf[UIP_LLH_LEN + UIP_IPH_LEN];
+  UIP_MCAST6_STATS_DATATYPE unique = UIP_MCAST6_STATS_GET(mcast_in_unique);
+
+  memset(UIP_IP_BUF, 0, UIP_IPH_LEN + HBHO_LEN + UIP_UDPH_LEN + PAYLOAD_LEN);
+  UIP_IP_BUF->vtc = 0x60;
+  UIP_IP_BUF->len[1] = HBHO_LEN + UIP_UDPH_LEN + PAYLOAD_LEN;
+  UIP_IP_BUF->proto = UIP_PROTO_HBHO;
+  UIP_IP_BUF->ttl = 64;
+  uip_ip6addr(&UIP_IP_BUF->srcipaddr, 0xfd00, 0, 0, 0, 0, 0, 0, seed);
+  uip_ip6addr(&UIP_IP_BUF->destipaddr, 0xff1e, 0, 0, 0, 0, 0, 0x89, 0xabcd);
+
+  /* Trickle option with an elided (long) seed ID and the M bit set */
+  hbho[0] = UIP_PROTO_UDP;
+  hbho[1] = 0;
+  hbho[2] = 0x0C;
+  hbho[3] = 2;
+  hbho[4] = 0x80 | (seq >> 8);
+  hbho[5] = seq & 0xff;
+  hbho[6] = UIP_EXT_HDR_OPT_PADN;
+  hbho[7] = 0;
+
+  uip_len = UIP_IPH_LEN + HBHO_LEN + UIP_UDPH_LEN + PAYLOAD_LEN;
+  UIP_MCAST6.in();
+  uip_clear_buf();
+
+  return UIP_MCAST6_STATS_GET(mcast_in_unique) != unique;
+}
+/*---------------------------------------------------------------------------*/
+void
+print_test_report(const unit_test_t *utp)
+{
+  printf("=check-me= ");
+  if(utp->result == unit_test_failure) {
+    printf("FAILED   - %s: exit at L%u\n", utp->descr, utp->exit_line);
+  } else {
+    printf("SUCCEEDED - %s\n", utp->descr);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * The engine cannot be initialised twice, so the tests run in sequence on
+ * the same state: six buffers shared by three windows.
+ */
+UNIT_TEST_REGISTER(test_duplicates, "Duplicates");
+UNIT_TEST(test_duplicates)
+{
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(receive(SEED_A, 1) == 1);
+  UNIT_TEST_ASSERT(receive(SEED_A, 1) == 0);
+
+  /* 9 falls in the same hash bucket as 1 */
+  UNIT_TEST_ASSERT(receive(SEED_A, 9) == 1);
+  UNIT_TEST_ASSERT(receive(SEED_A, 9) == 0);
+  UNIT_TEST_ASSERT(receive(SEED_A, 1) == 0);
+
+  /* The same values from another seed are other messages */
+  UNIT_TEST_ASSERT(receive(SEED_B, 1) == 1);
+  UNIT_TEST_ASSERT(receive(SEED_B, 9) == 1);
+  UNIT_TEST_ASSERT(receive(SEED_B, 9) == 0);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_window, "Window slide");
+UNIT_TEST(test_window)
+{
+  UNIT_TEST_BEGIN();
+
+  /* 40 is 32 or more values past 1: the window of A slides past 1 */
+  UNIT_TEST_ASSERT(receive(SEED_A, 40) == 1);
+  UNIT_TEST_ASSERT(receive(SEED_A, 1) == 0);
+  UNIT_TEST_ASSERT(receive(SEED_A, 8) == 0);
+  UNIT_TEST_ASSERT(receive(SEED_A, 9) == 0);
+  UNIT_TEST_ASSERT(receive(SEED_A, 40) == 0);
+
+  /* 41 maps to the same window bit as 9, but is new: the window slides */
+  UNIT_TEST_ASSERT(receive(SEED_A, 41) == 1);
+  UNIT_TEST_ASSERT(receive(SEED_A, 41) == 0);
+  UNIT_TEST_ASSERT(receive(SEED_A, 9) == 0);
+  UNIT_TEST_ASSERT(receive(SEED_A, 10) == 0);
+
+  /* Sequence values wrap at 0x8000 */
+  UNIT_TEST_ASSERT(receive(SEED_C, 0x7ffe) == 1);
+  UNIT_TEST_ASSERT(receive(SEED_C, 2) == 1);
+  UNIT_TEST_ASSERT(receive(SEED_C, 0x7ffe) == 0);
+  UNIT_TEST_ASSERT(receive(SEED_C, 2) == 0);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_buffers, "Buffer reclaim");
+UNIT_TEST(test_buffers)
+{
+  UNIT_TEST_BEGIN();
+
+  /*
+   * All six buffers are in use, two per window. A new message is given the
+   * buffer of the oldest message of the first largest window, 40 of A
+   */
+  UNIT_TEST_ASSERT(receive(SEED_B, 10) == 1);
+  UNIT_TEST_ASSERT(receive(SEED_A, 40) == 0);
+  UNIT_TEST_ASSERT(receive(SEED_A, 41) == 0);
+  UNIT_TEST_ASSERT(receive(SEED_B, 10) == 0);
+
+  /* B is now the largest window and gives up 1 */
+  UNIT_TEST_ASSERT(receive(SEED_B, 11) == 1);
+  UNIT_TEST_ASSERT(receive(SEED_B, 1) == 0);
+  UNIT_TEST_ASSERT(receive(SEED_B, 9) == 0);
+  UNIT_TEST_ASSERT(receive(SEED_B, 11) == 0);
+
+  /* No window left for a fourth seed */
+  UNIT_TEST_ASSERT(receive(SEED_D, 1) == 0);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(roll_tm_test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  UNIT_TEST_RUN(test_duplicates);
+  UNIT_TEST_RUN(test_window);
+  UNIT_TEST_RUN(test_buffers);
+
+  printf("=check-me= DONE\n");
+
+  PROCESS_END();
+}
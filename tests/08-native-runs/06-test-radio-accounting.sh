@@ -0,0 +1,45 @@
+#!/bin/bash
+source ../utils.sh
+
+# Contiki directory
+CONTIKI=$1
+
+# Example code directory
+CODE_DIR=$CONTIKI/tests/07-simulation-base/code-radio-accounting/
+CODE=test-radio-accounting
+
+# The CSMA test runs with NullNet, the classification with IPv6
+for NET in MAKE_NET_NULLNET MAKE_NET_IPV6; do
+  # Starting Contiki-NG native node
+  echo "Starting native node ($NET)"
+  make -C $CODE_DIR TARGET=native clean > /dev/null 2>&1
+  make -C $CODE_DIR TARGET=native MAKE_NET=$NET >> make.log 2>> make.err
+  $CODE_DIR/$CODE.native >> $CODE.log 2>> $CODE.err &
+  CPID=$!
+  sleep 2
+
+  echo "Closing native node"
+  sleep 2
+  kill_bg $CPID
+done
+
+if grep -q "=check-me= FAILED" $CODE.log || [ $(grep -c "=check-me= DONE" $CODE.log) != 2 ]; then
+  echo "==== make.log ====" ; cat make.log;
+  echo "==== make.err ====" ; cat make.err;
+  echo "==== $CODE.log ====" ; cat $CODE.log;
+  echo "==== $CODE.err ====" ; cat $CODE.err;
+
+  printf "%-32s TEST FAIL\n" "$CODE" | tee $CODE.testlog;
+else
+  cp $CODE.log $CODE.testlog
+  printf "%-32s TEST OK\n" "$CODE" | tee $CODE.testlog;
+fi
+
+rm make.log
+rm make.err
+rm $CODE.log
+rm $CODE.err
+
+# We do not want Make to stop -> Return 0
+# The Makefile will check if a log contains FAIL at the end
+exit 0
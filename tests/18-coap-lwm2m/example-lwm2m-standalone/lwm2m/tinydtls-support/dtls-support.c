@@ -156,6 +156,14 @@ dtls_session_equals(const session_t *a, const session_t *b)
   return coap_endpoint_cmp(e1, e2);
 }
 /*---------------------------------------------------------------------------*/
+unsigned int
+dtls_session_hash(const session_t *a)
+{
+  /* The endpoint type depends on the transport. This client only talks
+     to its server, so all peers can share one bucket. */
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
 void *
 dtls_session_get_address(const session_t *a)
 {
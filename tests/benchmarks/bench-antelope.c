@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2019, RISE SICS AB.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         Benchmarks of Antelope condition evaluation
+ */
+
+#include "contiki.h"
+#include "lvm.h"
+#include "benchmark.h"
+
+static lvm_instance_t lvm;
+static unsigned char code[DB_VM_BYTECODE_SIZE];
+static char *names[] = { "x", "y", "z" };
+/* Attribute values as stored in a row, in big-endian order */
+static unsigned char fields[3][4];
+static unsigned long counter;
+/*---------------------------------------------------------------------------*/
+/* x > 3 AND y < 8 AND z <> 5 AND x + y <= 12 */
+static void
+setup_condition(void)
+{
+  int i;
+
+  lvm_reset(&lvm, code, sizeof(code));
+  for(i = 0; i < 3; i++) {
+    lvm_register_variable(names[i], LVM_LONG);
+  }
+
+  lvm_set_relation(&lvm, LVM_AND);
+  lvm_set_relation(&lvm, LVM_GE);
+  lvm_set_variable(&lvm, "x");
+  lvm_set_long(&lvm, 3);
+  lvm_set_relation(&lvm, LVM_AND);
+  lvm_set_relation(&lvm, LVM_LE);
+  lvm_set_variable(&lvm, "y");
+  lvm_set_long(&lvm, 8);
+  lvm_set_relation(&lvm, LVM_AND);
+  lvm_set_relation(&lvm, LVM_NEQ);
+  lvm_set_variable(&lvm, "z");
+  lvm_set_long(&lvm, 5);
+  lvm_set_relation(&lvm, LVM_LEQ);
+  lvm_set_op(&lvm, LVM_ADD);
+  lvm_set_variable(&lvm, "x");
+  lvm_set_variable(&lvm, "y");
+  lvm_set_long(&lvm, 12);
+}
+/*---------------------------------------------------------------------------*/
+static void
+setup_interpreted(void)
+{
+  setup_condition();
+}
+/*---------------------------------------------------------------------------*/
+static void
+run_interpreted(void)
+{
+  operand_value_t value;
+
+  /* The values of the current tuple are copied into the variables */
+  counter++;
+  value.l = counter & 7;
+  lvm_set_variable_value("x", value);
+  value.l = counter & 15;
+  lvm_set_variable_value("y", value);
+  value.l = counter & 3;
+  lvm_set_variable_value("z", value);
+  BENCHMARK_USE(lvm_execute(&lvm));
+}
+/*---------------------------------------------------------------------------*/
+static void
+setup_compiled(void)
+{
+  int i;
+
+  setup_condition();
+  for(i = 0; i < 3; i++) {
+    lvm_bind_variable(names[i], fields[i], sizeof(fields[i]));
+  }
+  lvm_compile(&lvm);
+}
+/*---------------------------------------------------------------------------*/
+static void
+run_compiled(void)
+{
+  /* The variables read the values from the row buffer */
+  counter++;
+  fields[0][3] = counter & 7;
+  fields[1][3] = counter & 15;
+  fields[2][3] = counter & 3;
+  BENCHMARK_USE(lvm_execute(&lvm));
+}
+/*---------------------------------------------------------------------------*/
+const benchmark_t benchmarks_antelope[] = {
+  { "lvm-condition-interpreted", setup_interpreted, run_interpreted },
+  { "lvm-condition-compiled",    setup_compiled,    run_compiled },
+  { NULL, NULL, NULL }
+};
+/*---------------------------------------------------------------------------*/
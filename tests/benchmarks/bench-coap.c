@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2019, RISE SICS AB.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         Benchmarks of CoAP message parsing and serialization
+ */
+
+#include "contiki.h"
+#include "coap.h"
+#include "benchmark.h"
+
+#include <string.h>
+
+static coap_message_t message[1];
+static uint8_t buffer[COAP_MAX_PACKET_SIZE];
+static size_t len;
+static const uint8_t token[] = { 0x4a, 0x1f, 0x07, 0xc2 };
+static const char payload[] = "{\"temp\":21.5}";
+/*---------------------------------------------------------------------------*/
+static void
+build_message(void)
+{
+  /* A typical confirmable request with a token, a path, a query,
+   * options and a short payload */
+  coap_init_message(message, COAP_TYPE_CON, COAP_PUT, 0x1234);
+  coap_set_token(message, token, sizeof(token));
+  coap_set_header_uri_path(message, "sensors/temperature");
+  coap_set_header_uri_query(message, "unit=c");
+  coap_set_header_content_format(message, APPLICATION_JSON);
+  coap_set_header_accept(message, APPLICATION_JSON);
+  coap_set_payload(message, payload, sizeof(payload) - 1);
+}
+/*---------------------------------------------------------------------------*/
+static void
+setup_coap(void)
+{
+  build_message();
+  len = coap_serialize_message(message, buffer);
+}
+/*---------------------------------------------------------------------------*/
+static void
+run_coap_serialize(void)
+{
+  build_message();
+  BENCHMARK_USE(coap_serialize_message(message, buffer));
+}
+/*---------------------------------------------------------------------------*/
+static void
+run_coap_parse(void)
+{
+  BENCHMARK_USE(coap_parse_message(message, buffer, len));
+}
+/*---------------------------------------------------------------------------*/
+const benchmark_t benchmarks_coap[] = {
+  { "coap-serialize",       setup_coap,     run_coap_serialize },
+  { "coap-parse",           setup_coap,     run_coap_parse },
+  { NULL, NULL, NULL }
+};
+/*---------------------------------------------------------------------------*/
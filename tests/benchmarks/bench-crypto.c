@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2019, RISE SICS AB.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         Benchmarks of the CCM* authenticated encryption
+ */
+
+#include "contiki.h"
+#include "lib/ccm-star.h"
+#include "lib/aes-128.h"
+#include "benchmark.h"
+
+#define CCM_STAR_MESSAGE_LEN 64
+#define CCM_STAR_HEADER_LEN 16
+#define CCM_STAR_MIC_LEN 8
+
+static const uint8_t key[AES_128_KEY_LENGTH] = {
+  0xc0, 0xc1, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7,
+  0xc8, 0xc9, 0xca, 0xcb, 0xcc, 0xcd, 0xce, 0xcf
+};
+static uint8_t nonce[CCM_STAR_NONCE_LENGTH];
+static uint8_t message[CCM_STAR_MESSAGE_LEN];
+static uint8_t header[CCM_STAR_HEADER_LEN];
+static uint8_t mic[CCM_STAR_MIC_LEN];
+/*---------------------------------------------------------------------------*/
+static void
+setup_ccm_star(void)
+{
+  CCM_STAR.set_key(key);
+}
+/*---------------------------------------------------------------------------*/
+static void
+run_ccm_star_encrypt(void)
+{
+  CCM_STAR.aead(nonce, message, sizeof(message), header, sizeof(header),
+                mic, sizeof(mic), 1);
+  BENCHMARK_USE(mic[0]);
+}
+/*---------------------------------------------------------------------------*/
+static void
+run_ccm_star_auth(void)
+{
+  /* Authentication only, as for frames without encryption */
+  CCM_STAR.aead(nonce, NULL, 0, header, sizeof(header),
+                mic, sizeof(mic), 1);
+  BENCHMARK_USE(mic[0]);
+}
+/*---------------------------------------------------------------------------*/
+const benchmark_t benchmarks_crypto[] = {
+  { "ccm-star-encrypt-64",  setup_ccm_star, run_ccm_star_encrypt },
+  { "ccm-star-auth-16",     setup_ccm_star, run_ccm_star_auth },
+  { NULL, NULL, NULL }
+};
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,255 @@
+/*
+ * Copyright (c) 2019, RISE SICS AB.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         Benchmarks of the ip64 translation: address mapping lookups
+ *         with many flows, and the transport checksum update for small
+ *         and large packets
+ */
+
+#include "contiki.h"
+#include "ip64/ip64.h"
+#include "ip64/ip64-addrmap.h"
+#include "benchmark.h"
+
+#include <string.h>
+
+#define IPV6_HDRLEN 40
+#define IPV4_HDRLEN 20
+#define UDP_HDRLEN  8
+
+#define MAX_FLOWS   1000
+#define SMALL_LEN   64
+#define LARGE_LEN   1024
+#define FLOW_LEN    16
+
+#define FIRST_PORT  50000
+#define SERVER_PORT 5683
+
+/* The UDP headers of the IPv6 datagrams of each flow */
+static uint8_t headers6[MAX_FLOWS][IPV6_HDRLEN + UDP_HDRLEN];
+/* The IPv4 replies of each flow */
+static uint8_t packets4[MAX_FLOWS][IPV4_HDRLEN + UDP_HDRLEN + FLOW_LEN];
+/* Room for the IPv6 datagram translated in place, or for a 4to6 result */
+static uint8_t packet[IPV6_HDRLEN + UDP_HDRLEN + LARGE_LEN];
+static uint8_t large4[IPV4_HDRLEN + UDP_HDRLEN + LARGE_LEN];
+
+static unsigned num_flows;
+static unsigned payload_len;
+static unsigned flow;
+
+static const uip_ip4addr_t hostaddr = { { 10, 0, 0, 1 } };
+static const uip_ip4addr_t netmask = { { 255, 255, 255, 0 } };
+static const uip_ip4addr_t server = { { 192, 168, 1, 2 } };
+/*---------------------------------------------------------------------------*/
+static uint32_t
+sum16(uint32_t sum, const uint8_t *p, unsigned len)
+{
+  for(; len > 1; p += 2, len -= 2) {
+    sum += (p[0] << 8) | p[1];
+  }
+  if(len) {
+    sum += p[0] << 8;
+  }
+  return sum;
+}
+/*---------------------------------------------------------------------------*/
+/* Fill in a valid UDP checksum, since translators may verify it */
+static void
+set_udp_checksum(uint8_t *udp, const uint8_t *addrs, unsigned addrslen,
+                 const uint8_t *payload, unsigned len)
+{
+  uint32_t sum;
+
+  udp[6] = udp[7] = 0;
+  sum = sum16(0, addrs, addrslen);
+  sum += UIP_PROTO_UDP + UDP_HDRLEN + len;
+  sum = sum16(sum, udp, UDP_HDRLEN);
+  sum = sum16(sum, payload, len);
+  while(sum >> 16) {
+    sum = (sum & 0xffff) + (sum >> 16);
+  }
+  sum = ~sum & 0xffff;
+  if(sum == 0) {
+    sum = 0xffff;
+  }
+  udp[6] = sum >> 8;
+  udp[7] = sum & 0xff;
+}
+/*---------------------------------------------------------------------------*/
+static void
+make_header6(uint8_t *p, unsigned n, unsigned len)
+{
+  uip_ip6addr_t addr;
+
+  memset(p, 0, IPV6_HDRLEN + UDP_HDRLEN);
+  p[0] = 0x60;
+  p[4] = (UDP_HDRLEN + len) >> 8;
+  p[5] = (UDP_HDRLEN + len) & 0xff;
+  p[6] = UIP_PROTO_UDP;
+  p[7] = 64;
+  /* Each flow is another host */
+  uip_ip6addr(&addr, 0xfd00, 0, 0, 0, 0, 0, n >> 16, n & 0xffff);
+  memcpy(&p[8], &addr, sizeof(addr));
+  /* The server, as an IPv4-mapped address */
+  uip_ip6addr(&addr, 0, 0, 0, 0, 0, 0xffff, 0, 0);
+  memcpy(&addr.u8[12], &server, sizeof(server));
+  memcpy(&p[24], &addr, sizeof(addr));
+
+  p[IPV6_HDRLEN + 0] = (FIRST_PORT + n) >> 8;
+  p[IPV6_HDRLEN + 1] = (FIRST_PORT + n) & 0xff;
+  p[IPV6_HDRLEN + 2] = SERVER_PORT >> 8;
+  p[IPV6_HDRLEN + 3] = SERVER_PORT & 0xff;
+  p[IPV6_HDRLEN + 4] = (UDP_HDRLEN + len) >> 8;
+  p[IPV6_HDRLEN + 5] = (UDP_HDRLEN + len) & 0xff;
+  set_udp_checksum(&p[IPV6_HDRLEN], &p[8], 32,
+                   &packet[IPV6_HDRLEN + UDP_HDRLEN], len);
+}
+/*---------------------------------------------------------------------------*/
+/* Translate the datagram of a flow in place; the payload is not moved */
+static int
+translate6to4(unsigned n)
+{
+  memcpy(packet, headers6[n], sizeof(headers6[n]));
+  return ip64_6to4(packet, IPV6_HDRLEN + UDP_HDRLEN + payload_len,
+                   &packet[IPV6_HDRLEN - IPV4_HDRLEN]);
+}
+/*---------------------------------------------------------------------------*/
+/* Turn the IPv4 datagram just translated into the reply of the server,
+   with a zero payload */
+static void
+make_reply4(uint8_t *p, unsigned len)
+{
+  const uint8_t *v4 = &packet[IPV6_HDRLEN - IPV4_HDRLEN];
+
+  memset(p, 0, IPV4_HDRLEN + UDP_HDRLEN);
+  p[0] = 0x45;
+  p[2] = (IPV4_HDRLEN + UDP_HDRLEN + len) >> 8;
+  p[3] = (IPV4_HDRLEN + UDP_HDRLEN + len) & 0xff;
+  p[8] = 64;
+  p[9] = UIP_PROTO_UDP;
+  memcpy(&p[12], &server, sizeof(server));
+  memcpy(&p[16], &hostaddr, sizeof(hostaddr));
+
+  /* Swap the ports, the mapped port becomes the destination */
+  p[IPV4_HDRLEN + 0] = v4[IPV4_HDRLEN + 2];
+  p[IPV4_HDRLEN + 1] = v4[IPV4_HDRLEN + 3];
+  p[IPV4_HDRLEN + 2] = v4[IPV4_HDRLEN + 0];
+  p[IPV4_HDRLEN + 3] = v4[IPV4_HDRLEN + 1];
+  p[IPV4_HDRLEN + 4] = (UDP_HDRLEN + len) >> 8;
+  p[IPV4_HDRLEN + 5] = (UDP_HDRLEN + len) & 0xff;
+  set_udp_checksum(&p[IPV4_HDRLEN], &p[12], 8,
+                   &p[IPV4_HDRLEN + UDP_HDRLEN], len);
+}
+/*---------------------------------------------------------------------------*/
+static void
+setup_flows(unsigned flows, unsigned len)
+{
+  unsigned n;
+
+  num_flows = flows;
+  payload_len = len;
+  flow = 0;
+
+  ip64_addrmap_init();
+  ip64_set_hostaddr(&hostaddr);
+  ip64_set_netmask(&netmask);
+
+  memset(packet, 0xa5, sizeof(packet));
+  for(n = 0; n < num_flows; n++) {
+    make_header6(headers6[n], n, payload_len);
+    /* Create the mapping and record the reply to the mapped port */
+    translate6to4(n);
+    if(payload_len == FLOW_LEN) {
+      make_reply4(packets4[n], payload_len);
+    } else {
+      make_reply4(large4, payload_len);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+setup_flows_32(void)
+{
+  setup_flows(32, FLOW_LEN);
+}
+/*---------------------------------------------------------------------------*/
+static void
+setup_flows_1000(void)
+{
+  setup_flows(MAX_FLOWS, FLOW_LEN);
+}
+/*---------------------------------------------------------------------------*/
+static void
+setup_small(void)
+{
+  setup_flows(1, SMALL_LEN);
+}
+/*---------------------------------------------------------------------------*/
+static void
+setup_large(void)
+{
+  setup_flows(1, LARGE_LEN);
+}
+/*---------------------------------------------------------------------------*/
+static void
+run_6to4(void)
+{
+  BENCHMARK_USE(translate6to4(flow));
+  flow = flow + 1 < num_flows ? flow + 1 : 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+run_4to6_flows(void)
+{
+  BENCHMARK_USE(ip64_4to6(packets4[flow], sizeof(packets4[flow]), packet));
+  flow = flow + 1 < num_flows ? flow + 1 : 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+run_4to6(void)
+{
+  BENCHMARK_USE(ip64_4to6(large4, IPV4_HDRLEN + UDP_HDRLEN + payload_len,
+                          packet));
+}
+/*---------------------------------------------------------------------------*/
+const benchmark_t benchmarks_ip64[] = {
+  { "ip64-6to4-flows-32",     setup_flows_32,   run_6to4 },
+  { "ip64-4to6-flows-32",     setup_flows_32,   run_4to6_flows },
+  { "ip64-6to4-flows-1000",   setup_flows_1000, run_6to4 },
+  { "ip64-4to6-flows-1000",   setup_flows_1000, run_4to6_flows },
+  { "ip64-6to4-udp-64",       setup_small,      run_6to4 },
+  { "ip64-4to6-udp-64",       setup_small,      run_4to6 },
+  { "ip64-6to4-udp-1024",     setup_large,      run_6to4 },
+  { "ip64-4to6-udp-1024",     setup_large,      run_4to6 },
+  { NULL, NULL, NULL }
+};
+/*---------------------------------------------------------------------------*/
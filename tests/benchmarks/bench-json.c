@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2019, RISE SICS AB.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         Benchmarks of JSON parsing
+ */
+
+#include "contiki.h"
+#include "jsonparse.h"
+#include "jsontok.h"
+#include "benchmark.h"
+#include <string.h>
+
+/* A SenML payload as sent by LwM2M, with a long string value */
+static const char payload[] =
+  "{\"bn\":\"/3303/0/\",\"e\":["
+  "{\"n\":\"5700\",\"v\":22.5},"
+  "{\"n\":\"5701\",\"sv\":\"Cel\"},"
+  "{\"n\":\"5601\",\"v\":-4.25},"
+  "{\"n\":\"5602\",\"v\":31.75},"
+  "{\"n\":\"5750\",\"sv\":\"Temperature sensor in the north-east corner "
+  "of the second floor, next to the ventilation duct\"},"
+  "{\"n\":\"5605\",\"bv\":false}]}";
+
+#define CHUNK_LEN 32
+/*---------------------------------------------------------------------------*/
+static void
+run_jsonparse(void)
+{
+  struct jsonparse_state state;
+  int count = 0;
+
+  jsonparse_setup(&state, payload, sizeof(payload) - 1);
+  while(jsonparse_next(&state) != 0) {
+    count++;
+  }
+  BENCHMARK_USE(count);
+}
+/*---------------------------------------------------------------------------*/
+static void
+run_jsontok(void)
+{
+  struct jsontok_state state;
+  struct jsontok_token token;
+  int count = 0;
+
+  jsontok_init(&state);
+  jsontok_feed(&state, payload, sizeof(payload) - 1, 0);
+  while(jsontok_next(&state, &token) == JSONTOK_TOKEN) {
+    count++;
+  }
+  BENCHMARK_USE(count);
+}
+/*---------------------------------------------------------------------------*/
+static void
+run_jsontok_chunked(void)
+{
+  struct jsontok_state state;
+  struct jsontok_token token;
+  int count = 0;
+  int offset = 0;
+  int len;
+  int ret;
+
+  /* As received in CoAP blocks */
+  jsontok_init(&state);
+  do {
+    len = MIN(CHUNK_LEN, sizeof(payload) - 1 - offset);
+    offset += len;
+    jsontok_feed(&state, payload + offset - len, len,
+                 offset < sizeof(payload) - 1);
+    while((ret = jsontok_next(&state, &token)) == JSONTOK_TOKEN) {
+      count++;
+    }
+  } while(ret == JSONTOK_NEED_MORE);
+  BENCHMARK_USE(count);
+}
+/*---------------------------------------------------------------------------*/
+const benchmark_t benchmarks_json[] = {
+  { "jsonparse-senml",       NULL, run_jsonparse },
+  { "jsontok-senml",         NULL, run_jsontok },
+  { "jsontok-senml-chunked", NULL, run_jsontok_chunked },
+  { NULL, NULL, NULL }
+};
+/*---------------------------------------------------------------------------*/
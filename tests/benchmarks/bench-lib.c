@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2019, RISE SICS AB.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         Benchmarks of the data structures and checksums in os/lib
+ */
+
+#include "contiki.h"
+#include "lib/list.h"
+#include "lib/memb.h"
+#include "lib/crc16.h"
+#include "net/ipv6/uip.h"
+#include "benchmark.h"
+
+#define LIST_ITEMS 32
+#define MEMB_ITEMS 32
+#define CHECKSUM_LEN 128
+
+struct item {
+  struct item *next;
+  uint32_t value;
+};
+
+static struct item items[LIST_ITEMS + 1];
+LIST(bench_list);
+MEMB(bench_memb, struct item, MEMB_ITEMS);
+static struct item *allocated[MEMB_ITEMS];
+static unsigned next_index;
+static uint8_t data[CHECKSUM_LEN];
+/*---------------------------------------------------------------------------*/
+static void
+setup_list(void)
+{
+  int i;
+
+  list_init(bench_list);
+  for(i = 0; i < LIST_ITEMS; i++) {
+    items[i].value = i;
+    list_add(bench_list, &items[i]);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+run_list_add_remove(void)
+{
+  /* Add at the tail and remove again, both walk the whole list */
+  list_add(bench_list, &items[LIST_ITEMS]);
+  list_remove(bench_list, &items[LIST_ITEMS]);
+}
+/*---------------------------------------------------------------------------*/
+static void
+run_list_push_chop(void)
+{
+  /* Rotate the list: the tail becomes the head */
+  list_push(bench_list, list_chop(bench_list));
+}
+/*---------------------------------------------------------------------------*/
+static void
+run_list_walk(void)
+{
+  struct item *item;
+  uint32_t sum = 0;
+
+  for(item = list_head(bench_list); item != NULL; item = list_item_next(item)) {
+    sum += item->value;
+  }
+  BENCHMARK_USE(sum);
+}
+/*---------------------------------------------------------------------------*/
+static void
+setup_memb(void)
+{
+  int i;
+
+  memb_init(&bench_memb);
+  /* Half full, so that allocations have to search */
+  for(i = 0; i < MEMB_ITEMS / 2; i++) {
+    allocated[i] = memb_alloc(&bench_memb);
+  }
+  next_index = 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+run_memb_alloc_free(void)
+{
+  /* Free one of the allocated blocks and allocate a new one */
+  memb_free(&bench_memb, allocated[next_index]);
+  allocated[next_index] = memb_alloc(&bench_memb);
+  next_index = (next_index + 7) % (MEMB_ITEMS / 2);
+}
+/*---------------------------------------------------------------------------*/
+static void
+setup_checksum(void)
+{
+  int i;
+
+  for(i = 0; i < CHECKSUM_LEN; i++) {
+    data[i] = i * 37;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+run_uip_chksum(void)
+{
+  BENCHMARK_USE(uip_chksum((uint16_t *)data, CHECKSUM_LEN));
+}
+/*---------------------------------------------------------------------------*/
+static void
+run_crc16(void)
+{
+  BENCHMARK_USE(crc16_data(data, CHECKSUM_LEN, 0));
+}
+/*---------------------------------------------------------------------------*/
+const benchmark_t benchmarks_lib[] = {
+  { "list-add-remove-32",   setup_list,     run_list_add_remove },
+  { "list-push-chop-32",    setup_list,     run_list_push_chop },
+  { "list-walk-32",         setup_list,     run_list_walk },
+  { "memb-alloc-free-32",   setup_memb,     run_memb_alloc_free },
+  { "uip-chksum-128",       setup_checksum, run_uip_chksum },
+  { "crc16-128",            setup_checksum, run_crc16 },
+  { NULL, NULL, NULL }
+};
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2019, RISE SICS AB.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         Benchmarks of the LWM2M registry: a large set of IPSO-style
+ *         object instances is registered with the engine, then CoAP reads
+ *         of single resources and of whole instances are handed directly
+ *         to the CoAP handlers.
+ */
+
+#include "contiki.h"
+#include "lwm2m-engine.h"
+#include "coap-engine.h"
+#include "benchmark.h"
+
+#include <stdio.h>
+
+/* Number of registered instances, spread over BENCH_LWM2M_OBJECTS object IDs */
+#ifdef BENCH_LWM2M_CONF_INSTANCES
+#define BENCH_LWM2M_INSTANCES BENCH_LWM2M_CONF_INSTANCES
+#else
+#define BENCH_LWM2M_INSTANCES 400
+#endif
+#define BENCH_LWM2M_OBJECTS   16
+
+/* IPSO objects 3300 (generic sensor) onwards */
+#define FIRST_OBJECT_ID 3300
+
+/* Visits the instances in a scattered order; must be prime to the count */
+#define INSTANCE_STRIDE 97
+
+static const lwm2m_resource_id_t resources[] = {
+  RO(5700), /* Sensor Value */
+  RO(5701), /* Sensor Units */
+  RO(5601), /* Min Measured Value */
+  RO(5602), /* Max Measured Value */
+  RO(5603), /* Min Range Value */
+  RO(5604), /* Max Range Value */
+  RW(5750), /* Application Type */
+  EX(5605)  /* Reset Min and Max Measured Values */
+};
+
+static lwm2m_object_instance_t instances[BENCH_LWM2M_INSTANCES];
+static char paths[BENCH_LWM2M_INSTANCES][2][24];
+static uint8_t buffer[COAP_MAX_BLOCK_SIZE];
+static unsigned next;
+/*---------------------------------------------------------------------------*/
+static lwm2m_status_t
+lwm2m_callback(lwm2m_object_instance_t *object, lwm2m_context_t *ctx)
+{
+  if(ctx->operation == LWM2M_OP_READ) {
+    if(ctx->resource_id == 5701) {
+      lwm2m_object_write_string(ctx, "Cel", 3);
+    } else {
+      lwm2m_object_write_int(ctx, object->instance_id + ctx->resource_id);
+    }
+  }
+  return LWM2M_STATUS_OK;
+}
+/*---------------------------------------------------------------------------*/
+static void
+setup_registry(void)
+{
+  static int registered;
+  int i;
+
+  next = 0;
+  if(registered) {
+    return;
+  }
+  registered = 1;
+
+  lwm2m_engine_init();
+  for(i = 0; i < BENCH_LWM2M_INSTANCES; i++) {
+    instances[i].object_id = FIRST_OBJECT_ID + i % BENCH_LWM2M_OBJECTS;
+    instances[i].instance_id = i / BENCH_LWM2M_OBJECTS;
+    instances[i].resource_ids = resources;
+    instances[i].resource_count = sizeof(resources) / sizeof(resources[0]);
+    instances[i].callback = lwm2m_callback;
+    lwm2m_engine_add_object(&instances[i]);
+    snprintf(paths[i][0], sizeof(paths[i][0]), "%u/%u/%u",
+             instances[i].object_id, instances[i].instance_id,
+             5700 + (i % 2));
+    snprintf(paths[i][1], sizeof(paths[i][1]), "%u/%u",
+             instances[i].object_id, instances[i].instance_id);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static const char *
+next_path(int level)
+{
+  const char *path = paths[next][level];
+
+  next = (next + INSTANCE_STRIDE) % BENCH_LWM2M_INSTANCES;
+  return path;
+}
+/*---------------------------------------------------------------------------*/
+/* Serves a GET of path, fetching all blocks of larger responses */
+static void
+get(const char *path, unsigned int accept)
+{
+  static coap_message_t request[1];
+  static coap_message_t response[1];
+  int32_t offset = 0;
+
+  do {
+    coap_init_message(request, COAP_TYPE_CON, COAP_GET, 0);
+    coap_set_header_uri_path(request, path);
+    coap_set_header_accept(request, accept);
+    coap_init_message(response, COAP_TYPE_ACK, CONTENT_2_05, 0);
+
+    coap_call_handlers(request, response, buffer, sizeof(buffer), &offset);
+    BENCHMARK_USE(response->code);
+    BENCHMARK_USE(response->payload_len);
+  } while(offset > 0);
+}
+/*---------------------------------------------------------------------------*/
+static void
+run_lookup(void)
+{
+  const lwm2m_object_instance_t *instance = &instances[next];
+
+  next = (next + INSTANCE_STRIDE) % BENCH_LWM2M_INSTANCES;
+  BENCHMARK_USE(lwm2m_engine_has_instance(instance->object_id,
+                                          instance->instance_id));
+}
+/*---------------------------------------------------------------------------*/
+static void
+run_read_resource(void)
+{
+  get(next_path(0), TEXT_PLAIN);
+}
+/*---------------------------------------------------------------------------*/
+static void
+run_read_tlv(void)
+{
+  get(next_path(1), LWM2M_TLV);
+}
+/*---------------------------------------------------------------------------*/
+static void
+run_read_json(void)
+{
+  get(next_path(1), LWM2M_JSON);
+}
+/*---------------------------------------------------------------------------*/
+static void
+run_read_senml(void)
+{
+  get(next_path(1), LWM2M_SENML_CBOR);
+}
+/*---------------------------------------------------------------------------*/
+const benchmark_t benchmarks_lwm2m[] = {
+  { "lwm2m-lookup",         setup_registry, run_lookup },
+  { "lwm2m-read-resource",  setup_registry, run_read_resource },
+  { "lwm2m-read-tlv",       setup_registry, run_read_tlv },
+  { "lwm2m-read-json",      setup_registry, run_read_json },
+  { "lwm2m-read-senml",     setup_registry, run_read_senml },
+  { NULL, NULL, NULL }
+};
+/*---------------------------------------------------------------------------*/
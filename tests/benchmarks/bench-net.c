@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) 2019, RISE SICS AB.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         Benchmarks of the neighbor table, the route table and 6LoWPAN
+ */
+
+#include "contiki.h"
+#include "net/nbr-table.h"
+#include "net/packetbuf.h"
+#include "net/ipv6/uip.h"
+#include "net/ipv6/uip-ds6.h"
+#include "net/ipv6/uip-ds6-nbr.h"
+#include "net/ipv6/uip-ds6-route.h"
+#include "net/ipv6/simple-udp.h"
+#include "net/ipv6/sicslowpan.h"
+#include "benchmark.h"
+
+#include <string.h>
+
+#define UIP_IP_BUF   ((struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN])
+#define UIP_UDP_BUF  ((struct uip_udp_hdr *)&uip_buf[UIP_LLH_LEN + UIP_IPH_LEN])
+
+#define NBR_ENTRIES 24
+#define ROUTE_ENTRIES 32
+#define ROUTE_NEXTHOPS 4
+#define UDP_PORT 5678
+#define UDP_PAYLOAD_LEN 32
+
+struct nbr_entry {
+  uint32_t value;
+};
+
+NBR_TABLE(struct nbr_entry, bench_nbrs);
+
+static unsigned next_index;
+static uip_ipaddr_t route_dests[ROUTE_ENTRIES];
+static linkaddr_t peer_addr = { { 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00 } };
+static uint8_t frame[PACKETBUF_SIZE];
+static uint16_t frame_len;
+static struct simple_udp_connection udp_conn;
+/*---------------------------------------------------------------------------*/
+static void
+set_lladdr(linkaddr_t *lladdr, uint8_t prefix, unsigned index)
+{
+  memset(lladdr, 0, sizeof(*lladdr));
+  lladdr->u8[0] = 0x02;
+  lladdr->u8[1] = prefix;
+  lladdr->u8[LINKADDR_SIZE - 1] = index + 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+setup_nbr_table(void)
+{
+  linkaddr_t lladdr;
+  unsigned i;
+
+  nbr_table_register(bench_nbrs, NULL);
+  for(i = 0; i < NBR_ENTRIES; i++) {
+    set_lladdr(&lladdr, 0x01, i);
+    nbr_table_add_lladdr(bench_nbrs, &lladdr, NBR_TABLE_REASON_UNDEFINED, NULL);
+  }
+  next_index = 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+run_nbr_table_lookup(void)
+{
+  linkaddr_t lladdr;
+
+  set_lladdr(&lladdr, 0x01, next_index);
+  BENCHMARK_USE(nbr_table_get_from_lladdr(bench_nbrs, &lladdr));
+  next_index = (next_index + 7) % NBR_ENTRIES;
+}
+/*---------------------------------------------------------------------------*/
+static void
+run_nbr_table_add_remove(void)
+{
+  linkaddr_t lladdr;
+  struct nbr_entry *entry;
+
+  /* Remove an entry and add it back */
+  set_lladdr(&lladdr, 0x01, next_index);
+  entry = nbr_table_get_from_lladdr(bench_nbrs, &lladdr);
+  nbr_table_remove(bench_nbrs, entry);
+  BENCHMARK_USE(nbr_table_add_lladdr(bench_nbrs, &lladdr,
+                                     NBR_TABLE_REASON_UNDEFINED, NULL));
+  next_index = (next_index + 7) % NBR_ENTRIES;
+}
+/*---------------------------------------------------------------------------*/
+static void
+setup_route(void)
+{
+  uip_ipaddr_t nexthops[ROUTE_NEXTHOPS];
+  linkaddr_t lladdr;
+  unsigned i;
+
+  uip_ds6_route_init();
+  for(i = 0; i < ROUTE_NEXTHOPS; i++) {
+    set_lladdr(&lladdr, 0x02, i);
+    uip_create_linklocal_prefix(&nexthops[i]);
+    uip_ds6_set_addr_iid(&nexthops[i], (uip_lladdr_t *)&lladdr);
+    uip_ds6_nbr_add(&nexthops[i], (uip_lladdr_t *)&lladdr, 1, NBR_REACHABLE,
+                    NBR_TABLE_REASON_UNDEFINED, NULL);
+  }
+  for(i = 0; i < ROUTE_ENTRIES; i++) {
+    uip_ip6addr(&route_dests[i], 0xfd00, 0, 0, 0, 0, 0, 0, i + 1);
+    uip_ds6_route_add(&route_dests[i], 128, &nexthops[i % ROUTE_NEXTHOPS]);
+  }
+  next_index = 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+run_route_lookup(void)
+{
+  BENCHMARK_USE(uip_ds6_route_lookup(&route_dests[next_index]));
+  next_index = (next_index + 7) % ROUTE_ENTRIES;
+}
+/*---------------------------------------------------------------------------*/
+static void
+build_udp_packet(const linkaddr_t *src, const linkaddr_t *dest)
+{
+  uint16_t len = UIP_IPH_LEN + UIP_UDPH_LEN + UDP_PAYLOAD_LEN;
+
+  memset(uip_buf, 0, UIP_LLH_LEN + len);
+  UIP_IP_BUF->vtc = 0x60;
+  UIP_IP_BUF->len[0] = (len - UIP_IPH_LEN) >> 8;
+  UIP_IP_BUF->len[1] = (len - UIP_IPH_LEN) & 0xff;
+  UIP_IP_BUF->proto = UIP_PROTO_UDP;
+  UIP_IP_BUF->ttl = 64;
+  uip_create_linklocal_prefix(&UIP_IP_BUF->srcipaddr);
+  uip_ds6_set_addr_iid(&UIP_IP_BUF->srcipaddr, (uip_lladdr_t *)src);
+  uip_create_linklocal_prefix(&UIP_IP_BUF->destipaddr);
+  uip_ds6_set_addr_iid(&UIP_IP_BUF->destipaddr, (uip_lladdr_t *)dest);
+  UIP_UDP_BUF->srcport = UIP_HTONS(UDP_PORT);
+  UIP_UDP_BUF->destport = UIP_HTONS(UDP_PORT);
+  UIP_UDP_BUF->udplen = UIP_HTONS(UIP_UDPH_LEN + UDP_PAYLOAD_LEN);
+  uip_len = len;
+  UIP_UDP_BUF->udpchksum = ~(uip_udpchksum());
+}
+/*---------------------------------------------------------------------------*/
+static void
+setup_sicslowpan_output(void)
+{
+  build_udp_packet(&linkaddr_node_addr, &peer_addr);
+}
+/*---------------------------------------------------------------------------*/
+static void
+run_sicslowpan_output(void)
+{
+  /* Compresses uip_buf into packetbuf and hands it to the MAC */
+  BENCHMARK_USE(sicslowpan_driver.output(&peer_addr));
+}
+/*---------------------------------------------------------------------------*/
+static void
+udp_rx_callback(struct simple_udp_connection *c,
+                const uip_ipaddr_t *sender_addr,
+                uint16_t sender_port,
+                const uip_ipaddr_t *receiver_addr,
+                uint16_t receiver_port,
+                const uint8_t *data,
+                uint16_t datalen)
+{
+  BENCHMARK_USE(datalen);
+}
+/*---------------------------------------------------------------------------*/
+static void
+setup_sicslowpan_input(void)
+{
+  uip_lladdr_t own_lladdr;
+
+  simple_udp_register(&udp_conn, UDP_PORT, NULL, UDP_PORT, udp_rx_callback);
+
+  /* Compress a packet from the peer to us, as the peer would */
+  memcpy(&own_lladdr, &uip_lladdr, sizeof(uip_lladdr));
+  memcpy(&uip_lladdr, &peer_addr, sizeof(uip_lladdr));
+  build_udp_packet(&peer_addr, &linkaddr_node_addr);
+  sicslowpan_driver.output(&linkaddr_node_addr);
+  memcpy(&uip_lladdr, &own_lladdr, sizeof(uip_lladdr));
+
+  frame_len = packetbuf_copyto(frame);
+}
+/*---------------------------------------------------------------------------*/
+static void
+run_sicslowpan_input(void)
+{
+  /* Decompresses the frame and delivers it to the UDP socket */
+  packetbuf_copyfrom(frame, frame_len);
+  packetbuf_set_addr(PACKETBUF_ADDR_SENDER, &peer_addr);
+  packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, &linkaddr_node_addr);
+  sicslowpan_driver.input();
+}
+/*---------------------------------------------------------------------------*/
+const benchmark_t benchmarks_net[] = {
+  { "nbr-table-lookup-24",     setup_nbr_table,        run_nbr_table_lookup },
+  { "nbr-table-add-remove-24", setup_nbr_table,        run_nbr_table_add_remove },
+  { "ds6-route-lookup-32",     setup_route,            run_route_lookup },
+  { "sicslowpan-output-udp",   setup_sicslowpan_output, run_sicslowpan_output },
+  { "sicslowpan-input-udp",    setup_sicslowpan_input,  run_sicslowpan_input },
+  { NULL, NULL, NULL }
+};
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2019, RISE SICS AB.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         A microbenchmark framework for the native platform.
+ */
+
+#include "benchmark.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+volatile uintptr_t benchmark_sink;
+
+static double samples[BENCHMARK_MAX_SAMPLES];
+/*---------------------------------------------------------------------------*/
+static uint64_t
+now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+/*---------------------------------------------------------------------------*/
+static int
+compare_samples(const void *a, const void *b)
+{
+  double x = *(const double *)a;
+  double y = *(const double *)b;
+
+  return x < y ? -1 : x > y;
+}
+/*---------------------------------------------------------------------------*/
+static double
+percentile(unsigned count, unsigned p)
+{
+  /* Nearest rank on the sorted samples */
+  unsigned rank = (count * p + 99) / 100;
+
+  return samples[rank > 0 ? rank - 1 : 0];
+}
+/*---------------------------------------------------------------------------*/
+void
+benchmark_print_header(void)
+{
+  printf("name,samples,iterations,min_ns,p50_ns,p90_ns,p99_ns,mean_ns\n");
+}
+/*---------------------------------------------------------------------------*/
+static void
+run_one(const benchmark_t *b, const benchmark_conf_t *conf)
+{
+  uint64_t start;
+  uint64_t elapsed;
+  unsigned long iterations;
+  unsigned long i;
+  unsigned count;
+  unsigned s;
+  double sum;
+
+  if(b->setup != NULL) {
+    b->setup();
+  }
+
+  /* Warm up caches and branch predictors, and measure the rough
+   * cost of one iteration */
+  iterations = 0;
+  start = now_ns();
+  do {
+    b->run();
+    iterations++;
+    elapsed = now_ns() - start;
+  } while(elapsed < conf->warmup_ms * 1000000ULL);
+
+  iterations = (unsigned long)(conf->sample_us * 1000ULL * iterations / (elapsed + 1));
+  if(iterations == 0) {
+    iterations = 1;
+  }
+
+  count = conf->samples < BENCHMARK_MAX_SAMPLES ? conf->samples : BENCHMARK_MAX_SAMPLES;
+  sum = 0;
+  for(s = 0; s < count; s++) {
+    start = now_ns();
+    for(i = 0; i < iterations; i++) {
+      b->run();
+    }
+    samples[s] = (double)(now_ns() - start) / iterations;
+    sum += samples[s];
+  }
+
+  qsort(samples, count, sizeof(samples[0]), compare_samples);
+  printf("%s,%u,%lu,%.1f,%.1f,%.1f,%.1f,%.1f\n", b->name, count, iterations,
+         samples[0], percentile(count, 50), percentile(count, 90),
+         percentile(count, 99), sum / count);
+  fflush(stdout);
+}
+/*---------------------------------------------------------------------------*/
+int
+benchmark_run_all(const benchmark_t *benchmarks, const benchmark_conf_t *conf)
+{
+  int run = 0;
+
+  for(; benchmarks->name != NULL; benchmarks++) {
+    if(conf->filter == NULL || strstr(benchmarks->name, conf->filter) != NULL) {
+      run_one(benchmarks, conf);
+      run++;
+    }
+  }
+  return run;
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2019, RISE SICS AB.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         A microbenchmark framework for the native platform.
+ *
+ *         A benchmark is a function that performs one iteration of the
+ *         operation under test. Each benchmark is first run for a
+ *         warm-up period, which also sets the number of iterations per
+ *         sample so that a sample lasts about conf->sample_us. The time
+ *         of every sample is then taken on the monotonic clock, and the
+ *         minimum, percentiles and mean time per iteration over all
+ *         samples are printed as a CSV line.
+ */
+
+#ifndef BENCHMARK_H_
+#define BENCHMARK_H_
+
+#include <stdint.h>
+
+/** \brief The maximum number of samples per benchmark */
+#define BENCHMARK_MAX_SAMPLES 1000
+
+typedef struct benchmark {
+  /** The name of the benchmark, as printed in the results */
+  const char *name;
+  /** Called once before the warm-up, or NULL */
+  void (*setup)(void);
+  /** Performs one iteration */
+  void (*run)(void);
+} benchmark_t;
+
+typedef struct benchmark_conf {
+  /** Only run the benchmarks whose name contains this string, or NULL */
+  const char *filter;
+  /** The number of samples per benchmark */
+  unsigned samples;
+  /** The duration of the warm-up, in milliseconds */
+  unsigned warmup_ms;
+  /** The target duration of a sample, in microseconds */
+  unsigned sample_us;
+} benchmark_conf_t;
+
+/**
+ * Benchmarks pass their results to this variable so that the compiler
+ * cannot optimize the operation under test away.
+ */
+extern volatile uintptr_t benchmark_sink;
+
+#define BENCHMARK_USE(x) (benchmark_sink += (uintptr_t)(x))
+
+/**
+ * \brief Prints the CSV header of the results
+ */
+void benchmark_print_header(void);
+
+/**
+ * \brief Runs a set of benchmarks and prints their results
+ * \param benchmarks An array of benchmarks, terminated by one with a NULL name
+ * \param conf The benchmark configuration
+ * \return The number of benchmarks run
+ */
+int benchmark_run_all(const benchmark_t *benchmarks, const benchmark_conf_t *conf);
+
+#endif /* BENCHMARK_H_ */
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2019, RISE SICS AB.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         Runs the microbenchmarks and prints their results as CSV.
+ *
+ *         Usage: benchmarks.native [-f filter] [-n samples]
+ *                                  [-w warmup-ms] [-t sample-us]
+ */
+
+#include "contiki.h"
+#include "benchmark.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+extern int contiki_argc;
+extern char **contiki_argv;
+
+extern const benchmark_t benchmarks_lib[];
+extern const benchmark_t benchmarks_net[];
+extern const benchmark_t benchmarks_coap[];
+extern const benchmark_t benchmarks_crypto[];
+extern const benchmark_t benchmarks_json[];
+extern const benchmark_t benchmarks_antelope[];
+extern const benchmark_t benchmarks_ip64[];
+extern const benchmark_t benchmarks_lwm2m[];
+
+static const benchmark_t *const groups[] = {
+  benchmarks_lib,
+  benchmarks_net,
+  benchmarks_coap,
+  benchmarks_crypto,
+  benchmarks_json,
+  benchmarks_antelope,
+  benchmarks_ip64,
+  benchmarks_lwm2m,
+};
+/*---------------------------------------------------------------------------*/
+PROCESS(benchmarks_process, "Benchmarks");
+AUTOSTART_PROCESSES(&benchmarks_process);
+/*---------------------------------------------------------------------------*/
+static void
+parse_args(benchmark_conf_t *conf)
+{
+  int opt;
+
+  while((opt = getopt(contiki_argc, contiki_argv, "f:n:w:t:")) != -1) {
+    switch(opt) {
+    case 'f':
+      conf->filter = optarg;
+      break;
+    case 'n':
+      conf->samples = atoi(optarg);
+      break;
+    case 'w':
+      conf->warmup_ms = atoi(optarg);
+      break;
+    case 't':
+      conf->sample_us = atoi(optarg);
+      break;
+    default:
+      fprintf(stderr, "usage: %s [-f filter] [-n samples] [-w warmup-ms] [-t sample-us]\n",
+              contiki_argv[0]);
+      exit(1);
+    }
+  }
+  if(conf->samples < 1 || conf->samples > BENCHMARK_MAX_SAMPLES) {
+    fprintf(stderr, "samples must be between 1 and %u\n", BENCHMARK_MAX_SAMPLES);
+    exit(1);
+  }
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(benchmarks_process, ev, data)
+{
+  static benchmark_conf_t conf = {
+    .filter = NULL,
+    .samples = 200,
+    .warmup_ms = 100,
+    .sample_us = 1000,
+  };
+  int run = 0;
+  int i;
+
+  PROCESS_BEGIN();
+
+  parse_args(&conf);
+
+  benchmark_print_header();
+  for(i = 0; i < sizeof(groups) / sizeof(groups[0]); i++) {
+    run += benchmark_run_all(groups[i], &conf);
+  }
+
+  exit(run > 0 ? 0 : 1);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
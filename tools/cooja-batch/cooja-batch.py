@@ -0,0 +1,280 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2019, RISE SICS AB.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+# 1. Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+# 2. Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+# 3. Neither the name of the copyright holder nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+# FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+# COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+# INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+# (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+# HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+# STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+# ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+# OF THE POSSIBILITY OF SUCH DAMAGE.
+
+"""
+Runs a Cooja simulation headless for every combination of a parameter
+matrix and a set of random seeds, several simulations in parallel, and
+collects the global statistics of a parse.py-style log parser from all
+runs into one CSV and one JSON file.
+
+Parameters are make variables appended to the build commands of every
+mote type, e.g. -p CONFIG=CONFIG_CSMA,CONFIG_TSCH. Each run builds its
+firmware in a private copy of the mote source directory, inside the
+run's output directory.
+"""
+
+import argparse
+import concurrent.futures
+import csv
+import itertools
+import json
+import os
+import shutil
+import subprocess
+import sys
+import time
+import xml.etree.ElementTree as ET
+
+CONTIKI = os.path.normpath(os.path.join(os.path.dirname(os.path.abspath(__file__)), "../.."))
+
+# Logs all mote output in the format expected by parse.py and ends the
+# simulation after the given time (ms)
+LOG_SCRIPT = """TIMEOUT(%d, log.testOK());
+while(true) {
+  YIELD();
+  log.log((time / 1000000.0).toFixed(6) + "\\tID:" + id + "\\t" + msg + "\\n");
+}
+"""
+
+# Build artifacts that are not copied to the private source directories
+BUILD_DIRS = ("obj_cooja", "build")
+
+
+def parse_matrix(params):
+    """Returns a list of {variable: value} dicts, one per combination."""
+    names = []
+    values = []
+    for param in params:
+        if "=" not in param:
+            sys.exit("Bad parameter '%s', expected NAME=value1,value2,..." % param)
+        name, vals = param.split("=", 1)
+        names.append(name)
+        values.append(vals.split(","))
+    return [dict(zip(names, combination)) for combination in itertools.product(*values)]
+
+
+def parse_global_stats(output):
+    """Returns the 'global-stats' section of a parse.py output as a dict."""
+    stats = {}
+    in_section = False
+    for line in output.splitlines():
+        if not line.startswith(" "):
+            in_section = line.strip() == "global-stats:"
+            continue
+        if in_section and ":" in line:
+            key, value = line.strip().split(":", 1)
+            try:
+                stats[key] = float(value)
+            except ValueError:
+                stats[key] = value.strip()
+    return stats
+
+
+def shadow_path(root, rel, shadow):
+    """Creates the directories from shadow to shadow/rel. The other entries
+    of the corresponding directories under root become symlinks to the
+    originals, so that relative paths like ../common still resolve."""
+    parts = rel.split(os.sep)
+    for depth in range(len(parts)):
+        orig = os.path.join(root, *parts[:depth])
+        dest = os.path.join(shadow, *parts[:depth])
+        os.makedirs(dest, exist_ok=True)
+        for entry in os.listdir(orig):
+            link = os.path.join(dest, entry)
+            if entry == parts[depth]:
+                # Linked for an earlier mote type in a sibling directory
+                if os.path.islink(link):
+                    os.unlink(link)
+            elif not os.path.lexists(link):
+                os.symlink(os.path.join(orig, entry), link)
+
+
+def copy_sources(simconf, shadow):
+    """Points every mote type at a private copy of its source directory,
+    at the same path under shadow as under the Contiki directory, or as
+    under its parent for projects outside Contiki."""
+    copies = {}
+    for source in simconf.iter("source"):
+        path = source.text.strip().replace("[CONTIKI_DIR]", CONTIKI)
+        srcdir = os.path.dirname(os.path.abspath(path))
+        if srcdir not in copies:
+            if srcdir.startswith(CONTIKI + os.sep):
+                root = CONTIKI
+            else:
+                root = os.path.dirname(srcdir)
+            rel = os.path.relpath(srcdir, root)
+            shadow_path(root, rel, shadow)
+            copies[srcdir] = os.path.join(shadow, rel)
+            shutil.copytree(srcdir, copies[srcdir], symlinks=True,
+                            ignore=shutil.ignore_patterns(*BUILD_DIRS))
+        source.text = os.path.join(copies[srcdir], os.path.basename(path))
+
+
+def prepare(args, run_dir, params):
+    """Writes the simulation file for one run, returns the directory of
+    the source copies."""
+    tree = ET.parse(args.csc)
+    simconf = tree.getroot()
+    shadow = os.path.join(run_dir, "src")
+
+    shutil.rmtree(shadow, ignore_errors=True)
+    copy_sources(simconf, shadow)
+
+    # The copies are not inside Contiki, so it is given to every make
+    make_vars = " ".join(["CONTIKI=" + CONTIKI] +
+                         ["%s=%s" % (name, value) for name, value in params.items()])
+    for commands in simconf.iter("commands"):
+        commands.text = "\n".join(line + " " + make_vars if line.strip().startswith("make") else line
+                                  for line in commands.text.strip().splitlines())
+
+    has_script = any(plugin.text is not None and
+                     plugin.text.strip() == "org.contikios.cooja.plugins.ScriptRunner"
+                     for plugin in simconf.findall("plugin"))
+    if not has_script:
+        plugin = ET.SubElement(simconf, "plugin")
+        plugin.text = "org.contikios.cooja.plugins.ScriptRunner"
+        config = ET.SubElement(plugin, "plugin_config")
+        ET.SubElement(config, "script").text = LOG_SCRIPT % (args.duration * 60 * 1000)
+        ET.SubElement(config, "active").text = "true"
+
+    csc = os.path.join(run_dir, "sim.csc")
+    tree.write(csc, encoding="UTF-8", xml_declaration=True)
+    return csc, shadow
+
+
+def run(args, index, params, seed):
+    """Runs one simulation and its log parser, returns the result row."""
+    run_name = "run-%03d-%d" % (index, seed)
+    run_dir = os.path.join(args.out, run_name)
+    os.makedirs(run_dir, exist_ok=True)
+
+    row = {"run": run_name, "seed": seed}
+    row.update(params)
+
+    csc, shadow = prepare(args, run_dir, params)
+    start = time.time()
+    try:
+        with open(os.path.join(run_dir, "cooja.log"), "w") as log:
+            ret = subprocess.call(["java", "-Xshare:on", "-jar",
+                                   os.path.join(CONTIKI, "tools/cooja/dist/cooja.jar"),
+                                   "-nogui=" + csc, "-contiki=" + CONTIKI,
+                                   "-random-seed=%d" % seed],
+                                  cwd=run_dir, stdout=log, stderr=subprocess.STDOUT)
+    finally:
+        if not args.keep:
+            shutil.rmtree(shadow, ignore_errors=True)
+    row["status"] = "OK" if ret == 0 else "FAIL"
+    row["wallclock"] = round(time.time() - start, 1)
+
+    testlog = os.path.join(run_dir, "COOJA.testlog")
+    if args.parser and ret == 0 and os.path.exists(testlog):
+        try:
+            output = subprocess.check_output([sys.executable, args.parser, testlog],
+                                             cwd=run_dir, stderr=subprocess.STDOUT,
+                                             universal_newlines=True)
+            with open(os.path.join(run_dir, "stats.yml"), "w") as f:
+                f.write(output)
+            row.update(parse_global_stats(output))
+        except subprocess.CalledProcessError as e:
+            row["status"] = "PARSE-FAIL"
+            with open(os.path.join(run_dir, "stats.yml"), "w") as f:
+                f.write(e.output)
+    return row
+
+
+def write_results(out, rows):
+    columns = []
+    for row in rows:
+        for key in row:
+            if key not in columns:
+                columns.append(key)
+    with open(os.path.join(out, "results.csv"), "w", newline="") as f:
+        writer = csv.DictWriter(f, fieldnames=columns)
+        writer.writeheader()
+        writer.writerows(rows)
+    with open(os.path.join(out, "results.json"), "w") as f:
+        json.dump(rows, f, indent=2)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Run Cooja simulations in parallel over a parameter matrix and seeds.")
+    parser.add_argument("csc", help="simulation file")
+    parser.add_argument("-p", "--param", action="append", default=[],
+                        help="make variable and its values, NAME=value1,value2,... (repeatable)")
+    parser.add_argument("-s", "--seeds", type=int, default=1, help="number of random seeds per combination")
+    parser.add_argument("-b", "--base-seed", type=int, default=1, help="first random seed")
+    parser.add_argument("-j", "--jobs", type=int, default=os.cpu_count(), help="simulations to run in parallel")
+    parser.add_argument("-d", "--duration", type=int, default=60,
+                        help="simulated minutes, if the simulation has no script of its own")
+    parser.add_argument("--parser", help="log parser (default: parse.py next to the simulation file)")
+    parser.add_argument("-o", "--out", default="batch", help="output directory")
+    parser.add_argument("-k", "--keep", action="store_true", help="keep the private source copies")
+    args = parser.parse_args()
+
+    args.csc = os.path.abspath(args.csc)
+    args.out = os.path.abspath(args.out)
+    if args.parser is None:
+        default_parser = os.path.join(os.path.dirname(args.csc), "parse.py")
+        args.parser = default_parser if os.path.exists(default_parser) else None
+    elif args.parser == "none":
+        args.parser = None
+    else:
+        args.parser = os.path.abspath(args.parser)
+
+    if not os.path.exists(os.path.join(CONTIKI, "tools/cooja/dist/cooja.jar")):
+        sys.exit("Cooja is not built, run 'ant jar' in %s/tools/cooja" % CONTIKI)
+    os.makedirs(args.out, exist_ok=True)
+
+    runs = [(params, seed)
+            for params in parse_matrix(args.param)
+            for seed in range(args.base_seed, args.base_seed + args.seeds)]
+    print("%d simulations, %d in parallel" % (len(runs), args.jobs))
+
+    rows = []
+    with concurrent.futures.ThreadPoolExecutor(max_workers=args.jobs) as executor:
+        futures = [executor.submit(run, args, index, params, seed)
+                   for index, (params, seed) in enumerate(runs)]
+        for future in concurrent.futures.as_completed(futures):
+            row = future.result()
+            rows.append(row)
+            print("%-16s %-10s %6.1fs %s" % (row["run"], row["status"], row["wallclock"],
+                                             " ".join("%s=%s" % (k, v) for k, v in row.items()
+                                                      if k not in ("run", "status", "wallclock"))))
+
+    rows.sort(key=lambda row: row["run"])
+    write_results(args.out, rows)
+    failed = sum(row["status"] != "OK" for row in rows)
+    print("%d/%d OK, results in %s" % (len(rows) - failed, len(rows),
+                                        os.path.join(args.out, "results.{csv,json}")))
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -54,5 +54,7 @@ public class [CLASSNAME] extends CoreComm {
   public native void init();
   public native void setReferenceAddress(int addr);
   public native void getMemory(int rel_addr, int length, byte[] mem);
+  public native int getChangedMemory(int rel_addr, int length, byte[] mem,
+                                     int block_size, byte[] changed);
   public native void setMemory(int rel_addr, int length, byte[] mem);
 }
@@ -67,6 +67,29 @@ Java_org_contikios_cooja_corecomm_[CLASS_NAME]_getMemory(JNIEnv *env, jobject ob
 
 }
 /*---------------------------------------------------------------------------*/
+JNIEXPORT jint JNICALL
+Java_org_contikios_cooja_corecomm_[CLASS_NAME]_getChangedMemory(JNIEnv *env, jobject obj, jint rel_addr, jint length, jbyteArray mem_arr, jint block_size, jbyteArray changed_arr)
+{
+  jbyte *mem = (*env)->GetByteArrayElements(env, mem_arr, 0);
+  jbyte *changed = (*env)->GetByteArrayElements(env, changed_arr, 0);
+  jbyte *core = (jbyte *) (((long)rel_addr) + referenceVar);
+  jint count = 0;
+  jint start;
+  jint len;
+
+  for(start = 0; start < length; start += block_size) {
+    len = length - start < block_size ? length - start : block_size;
+    changed[start / block_size] = memcmp(mem + start, core + start, len) != 0;
+    if(changed[start / block_size]) {
+      memcpy(mem + start, core + start, len);
+      count++;
+    }
+  }
+  (*env)->ReleaseByteArrayElements(env, changed_arr, changed, 0);
+  (*env)->ReleaseByteArrayElements(env, mem_arr, mem, 0);
+  return count;
+}
+/*---------------------------------------------------------------------------*/
 JNIEXPORT void JNICALL
 Java_org_contikios_cooja_corecomm_[CLASS_NAME]_setMemory(JNIEnv *env, jobject obj, jint rel_addr, jint length, jbyteArray mem_arr)
 {
@@ -66,6 +66,7 @@ import org.contikios.cooja.dialogs.MessageList;
  * <li>init()
  * <li>getReferenceAbsAddr()
  * <li>getMemory(int start, int length, byte[] mem)
+ * <li>getChangedMemory(int start, int length, byte[] mem, int blockSize, byte[] changed)
  * <li>setMemory(int start, int length, byte[] mem)
  *
  * @author Fredrik Osterlind
@@ -357,6 +358,21 @@ public abstract class CoreComm {
    */
   public abstract void getMemory(int relAddr, int length, byte[] mem);
 
+  /**
+   * Updates a byte array with the blocks of the memory segment identified by
+   * start and length that differ from it. Blocks that are equal are compared
+   * in place and not copied.
+   *
+   * @param relAddr Relative memory start address
+   * @param length Length of segment
+   * @param mem Array to update with the memory segment
+   * @param blockSize Size of the compared blocks
+   * @param changed Set to 1 per changed block, and to 0 per unchanged block
+   * @return Number of changed blocks
+   */
+  public abstract int getChangedMemory(int relAddr, int length, byte[] mem,
+                                       int blockSize, byte[] changed);
+
   /**
    * Overwrites a memory segment identified by start and length.
    *
@@ -211,6 +211,13 @@ public class ContikiMoteType implements MoteType {
   // Initial memory for all motes of this type
   private SectionMoteMemory initialMemory = null;
 
+  /* Per section and block: version of the library memory, bumped whenever
+     the block contents change. Motes record the version their copy of a
+     block equals, see SectionMoteMemory.getSyncVersions(). */
+  private final Map<String, long[]> coreVersions = new HashMap<>();
+  private long lastCoreVersion = 0;
+  private byte[] syncBuffer = new byte[0];
+
   /** Offset between native (cooja) and contiki address space */
   long offset;
 
@@ -811,36 +818,77 @@ public class ContikiMoteType implements MoteType {
   /**
    * Copy core memory to given memory. This should not be used directly, but
    * instead via ContikiMote.getMemory().
+   * <p>
+   * The library compares its memory with the given memory and copies only
+   * the blocks that differ, i.e. those changed during the last tick.
    *
    * @param mem
    *          Memory to set
    */
   public void getCoreMemory(SectionMoteMemory mem) {
-    for (MemoryInterface section : mem.getSections().values()) {
-      getCoreMemory(
-              (int) (section.getStartAddr() - offset),
-              section.getTotalSize(),
-              section.getMemory());
+    long version = ++lastCoreVersion;
+    for (Map.Entry<String, MemoryInterface> entry : mem.getSections().entrySet()) {
+      MemoryInterface section = entry.getValue();
+      byte[] data = section.getMemory();
+      long[] core = getCoreVersions(entry.getKey(), data.length);
+      long[] own = mem.getSyncVersions(entry.getKey());
+      byte[] changed = getSyncBuffer(core.length);
+      myCoreComm.getChangedMemory((int) (section.getStartAddr() - offset), data.length,
+              data, SectionMoteMemory.SYNC_BLOCK_SIZE, changed);
+
+      /* Unchanged blocks are still equal to the library memory */
+      for (int block = 0; block < core.length; block++) {
+        if (changed[block] != 0) {
+          core[block] = version;
+        }
+        own[block] = core[block];
+      }
     }
   }
 
-  private void getCoreMemory(int relAddr, int length, byte[] data) {
-    myCoreComm.getMemory(relAddr, length, data);
-  }
-
   /**
    * Copy given memory to the Contiki system. This should not be used directly,
    * but instead via ContikiMote.setMemory().
+   * <p>
+   * Only blocks of the given memory that may differ from the library memory
+   * are copied: those written from Cooja, and those changed by other motes of
+   * this type since the given memory was last synchronized.
    *
    * @param mem
    * New memory
    */
   public void setCoreMemory(SectionMoteMemory mem) {
-    for (MemoryInterface section : mem.getSections().values()) {
-      setCoreMemory(
-              (int) (section.getStartAddr() - offset),
-              section.getTotalSize(),
-              section.getMemory());
+    long version = ++lastCoreVersion;
+    for (Map.Entry<String, MemoryInterface> entry : mem.getSections().entrySet()) {
+      MemoryInterface section = entry.getValue();
+      byte[] data = section.getMemory();
+      long[] core = getCoreVersions(entry.getKey(), data.length);
+      long[] own = mem.getSyncVersions(entry.getKey());
+      int relAddr = (int) (section.getStartAddr() - offset);
+
+      int block = 0;
+      while (block < core.length) {
+        if (own[block] != 0 && own[block] == core[block]) {
+          block++;
+          continue;
+        }
+        /* Copy each run of stale blocks at once */
+        int first = block;
+        while (block < core.length && (own[block] == 0 || own[block] != core[block])) {
+          core[block] = version;
+          own[block] = version;
+          block++;
+        }
+        int start = first * SectionMoteMemory.SYNC_BLOCK_SIZE;
+        int end = Math.min(block * SectionMoteMemory.SYNC_BLOCK_SIZE, data.length);
+        if (start == 0 && end == data.length) {
+          setCoreMemory(relAddr, data.length, data);
+        } else {
+          byte[] buffer = getSyncBuffer(end - start);
+          System.arraycopy(data, start, buffer, 0, end - start);
+          setCoreMemory(relAddr + start, end - start, buffer);
+        }
+      }
     }
   }
 
@@ -848,6 +896,23 @@ public class ContikiMoteType implements MoteType {
     myCoreComm.setMemory(relAddr, length, mem);
   }
 
+  private long[] getCoreVersions(String name, int size) {
+    long[] versions = coreVersions.get(name);
+    int blocks = (size + SectionMoteMemory.SYNC_BLOCK_SIZE - 1) / SectionMoteMemory.SYNC_BLOCK_SIZE;
+    if (versions == null || versions.length != blocks) {
+      versions = new long[blocks];
+      coreVersions.put(name, versions);
+    }
+    return versions;
+  }
+
+  private byte[] getSyncBuffer(int size) {
+    if (syncBuffer.length < size) {
+      syncBuffer = new byte[size];
+    }
+    return syncBuffer;
+  }
+
   @Override
   public String getIdentifier() {
     return identifier;
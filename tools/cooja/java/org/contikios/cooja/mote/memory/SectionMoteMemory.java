@@ -51,8 +51,15 @@ public class SectionMoteMemory implements MemoryInterface {
   private static Logger logger = Logger.getLogger(SectionMoteMemory.class);
   private static final boolean DEBUG = logger.isDebugEnabled();
 
+  /** Granularity at which sections are synchronized with a mote core */
+  public static final int SYNC_BLOCK_SIZE = 64;
+
   private Map<String, MemoryInterface> sections = new HashMap<>();
 
+  /* Per section and block: core version the block is known to equal, 0 if
+     unknown (see getSyncVersions()) */
+  private final Map<String, long[]> syncVersions = new HashMap<>();
+
   private final Map<String, Symbol> symbols;
   private MemoryLayout memLayout;
   private long startAddr = Long.MAX_VALUE;
@@ -98,6 +105,7 @@ public class SectionMoteMemory implements MemoryInterface {
     }
 
     sections.put(name, section);
+    syncVersions.remove(name);
     if (section.getSymbolMap() != null) {
       for (String s : section.getSymbolMap().keySet()) {
         // XXX how to handle double names here?
@@ -179,6 +187,7 @@ public class SectionMoteMemory implements MemoryInterface {
   @Override
   public void clearMemory() {
     sections.clear();
+    syncVersions.clear();
   }
 
   @Override
@@ -227,9 +236,11 @@ public class SectionMoteMemory implements MemoryInterface {
   @Override
   public void setMemorySegment(long address, byte[] data) throws MoteMemoryException {
 
-    for (MemoryInterface section : sections.values()) {
+    for (Map.Entry<String, MemoryInterface> entry : sections.entrySet()) {
+      MemoryInterface section = entry.getValue();
       if (inSection(section, address, data.length)) {
         section.setMemorySegment(address, data);
+        markModified(entry.getKey(), section, address, data.length);
         if (DEBUG) {
           logger.debug(String.format(
                   "Wrote memory segment [0x%x,0x%x]",
@@ -243,6 +254,38 @@ public class SectionMoteMemory implements MemoryInterface {
             address, address + data.length - 1);
   }
 
+  private void markModified(String name, MemoryInterface section, long address, int size) {
+    long[] versions = syncVersions.get(name);
+    if (versions == null || size <= 0) {
+      return;
+    }
+    int first = (int) ((address - section.getStartAddr()) / SYNC_BLOCK_SIZE);
+    int last = (int) ((address + size - 1 - section.getStartAddr()) / SYNC_BLOCK_SIZE);
+    Arrays.fill(versions, first, last + 1, 0);
+  }
+
+  /**
+   * Returns the synchronization state of a section, one entry per
+   * SYNC_BLOCK_SIZE bytes.
+   * <p>
+   * An entry holds the version of the core memory the block was last
+   * synchronized with, as assigned by the mote type, or 0 if the block may
+   * differ from any core memory. Writes through setMemorySegment() reset the
+   * entries they touch to 0. The mote type owns all other updates.
+   *
+   * @param name Name of section
+   * @return Block versions, zero-filled on first use
+   */
+  public long[] getSyncVersions(String name) {
+    long[] versions = syncVersions.get(name);
+    if (versions == null) {
+      int size = sections.get(name).getTotalSize();
+      versions = new long[(size + SYNC_BLOCK_SIZE - 1) / SYNC_BLOCK_SIZE];
+      syncVersions.put(name, versions);
+    }
+    return versions;
+  }
+
   @Override
   public long getStartAddr() {
     return startAddr;
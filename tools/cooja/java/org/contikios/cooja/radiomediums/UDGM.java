@@ -32,6 +32,10 @@ package org.contikios.cooja.radiomediums;
 
 import java.util.ArrayList;
 import java.util.Collection;
+import java.util.Collections;
+import java.util.Comparator;
+import java.util.HashMap;
+import java.util.HashSet;
 import java.util.Observable;
 import java.util.Observer;
 import java.util.Random;
@@ -69,6 +73,12 @@ import org.contikios.cooja.plugins.skins.UDGMVisualizerSkin;
  * 
  * The received radio packet signal strength grows inversely with the distance to the
  * transmitter.
+ * 
+ * Potential destinations are found through a uniform grid with cells the size of
+ * the largest range, so only radios in neighboring cells are compared. When a
+ * single mote moves, only the edges to and from that mote are updated. With
+ * debug logging enabled for this class, every lookup is cross-checked against
+ * a comparison with all radios.
  *
  * @see #SS_STRONG
  * @see #SS_WEAK
@@ -81,72 +91,270 @@ import org.contikios.cooja.plugins.skins.UDGMVisualizerSkin;
 @ClassDescription("Unit Disk Graph Medium (UDGM): Distance Loss")
 public class UDGM extends AbstractRadioMedium {
   private static Logger logger = Logger.getLogger(UDGM.class);
+  private static final boolean VERIFY_EDGES = logger.isDebugEnabled();
 
   public double SUCCESS_RATIO_TX = 1.0; /* Success ratio of TX. If this fails, no radios receive the packet */
   public double SUCCESS_RATIO_RX = 1.0; /* Success ratio of RX. If this fails, the single affected receiver does not receive the packet */
   public double TRANSMITTING_RANGE = 50; /* Transmission range. */
   public double INTERFERENCE_RANGE = 100; /* Interference range. Ignored if below transmission range. */
 
-  private DirectedGraphMedium dgrm; /* Used only for efficient destination lookup */
-
   private Random random = null;
 
+  /* Radios and their potential destinations, by radio and by grid cell */
+  private HashMap<Radio, RadioNode> nodes = new HashMap<Radio, RadioNode>();
+  private HashMap<Long, ArrayList<RadioNode>> grid = new HashMap<Long, ArrayList<RadioNode>>();
+  private double cellSize = 0;
+  private boolean edgesDirty = true;
+
   public UDGM(Simulation simulation) {
     super(simulation);
     random = simulation.getRandomGenerator();
-    dgrm = new DirectedGraphMedium() {
-      protected void analyzeEdges() {
-        /* Create edges according to distances.
-         * XXX May be slow for mobile networks */
-        clearEdges();
-        for (Radio source: UDGM.this.getRegisteredRadios()) {
-          Position sourcePos = source.getPosition();
-          for (Radio dest: UDGM.this.getRegisteredRadios()) {
-            Position destPos = dest.getPosition();
-            /* Ignore ourselves */
-            if (source == dest) {
-              continue;
-            }
-            double distance = sourcePos.getDistanceTo(destPos);
-            if (distance < Math.max(TRANSMITTING_RANGE, INTERFERENCE_RANGE)) {
-              /* Add potential destination */
-              addEdge(
-                  new DirectedGraphMedium.Edge(source, 
-                      new DGRMDestinationRadio(dest)));
-            }
-          }
-        }
-        super.analyzeEdges();
-      }
-    };
 
     /* Register as position observer.
-     * If any positions change, re-analyze potential receivers. */
+     * If any positions change, re-analyze potential receivers of that mote. */
     final Observer positionObserver = new Observer() {
       public void update(Observable o, Object arg) {
-        dgrm.requestEdgeAnalysis();
+        if (arg instanceof Mote) {
+          moteMoved((Mote) arg);
+        } else {
+          requestEdgeAnalysis();
+        }
       }
     };
     /* Re-analyze potential receivers if radios are added/removed. */
     simulation.getEventCentral().addMoteCountListener(new MoteCountListener() {
       public void moteWasAdded(Mote mote) {
         mote.getInterfaces().getPosition().addObserver(positionObserver);
-        dgrm.requestEdgeAnalysis();
+        requestEdgeAnalysis();
       }
       public void moteWasRemoved(Mote mote) {
         mote.getInterfaces().getPosition().deleteObserver(positionObserver);
-        dgrm.requestEdgeAnalysis();
+        requestEdgeAnalysis();
       }
     });
     for (Mote mote: simulation.getMotes()) {
       mote.getInterfaces().getPosition().addObserver(positionObserver);
     }
-    dgrm.requestEdgeAnalysis();
+    requestEdgeAnalysis();
 
     /* Register visualizer skin */
     Visualizer.registerVisualizerSkin(UDGMVisualizerSkin.class);
   }
 
+  /**
+   * A registered radio with its potential destinations, ordered as the
+   * radios were registered.
+   */
+  private static class RadioNode {
+    final Radio radio;
+    final int index;
+    long cell;
+    final ArrayList<RadioNode> neighbors = new ArrayList<RadioNode>();
+    DestinationRadio[] destinations = null; /* Built on demand */
+
+    RadioNode(Radio radio, int index) {
+      this.radio = radio;
+      this.index = index;
+    }
+  }
+
+  private static final Comparator<RadioNode> INDEX_ORDER = new Comparator<RadioNode>() {
+    public int compare(RadioNode a, RadioNode b) {
+      return Integer.compare(a.index, b.index);
+    }
+  };
+
+  private static long getCellKey(int x, int y) {
+    return ((long) x << 32) | (y & 0xFFFFFFFFL);
+  }
+
+  private int getCellCoordinate(double coordinate) {
+    return (int) Math.floor(coordinate / cellSize);
+  }
+
+  private long getCell(Position pos) {
+    return getCellKey(getCellCoordinate(pos.getXCoordinate()),
+        getCellCoordinate(pos.getYCoordinate()));
+  }
+
+  /**
+   * Signal that the ranges or the set of radios changed, and all edges
+   * need to be re-analyzed before used.
+   */
+  private void requestEdgeAnalysis() {
+    edgesDirty = true;
+  }
+
+  /* The public range fields may also have been changed directly */
+  private boolean needsEdgeAnalysis() {
+    return edgesDirty || cellSize != Math.max(TRANSMITTING_RANGE, INTERFERENCE_RANGE);
+  }
+
+  /* Finds all radios within range of the given radio, in registration order */
+  private void findNeighbors(RadioNode node) {
+    Position pos = node.radio.getPosition();
+    double range = Math.max(TRANSMITTING_RANGE, INTERFERENCE_RANGE);
+    int cx = getCellCoordinate(pos.getXCoordinate());
+    int cy = getCellCoordinate(pos.getYCoordinate());
+
+    node.neighbors.clear();
+    node.destinations = null;
+    for (int x = cx - 1; x <= cx + 1; x++) {
+      for (int y = cy - 1; y <= cy + 1; y++) {
+        ArrayList<RadioNode> cell = grid.get(getCellKey(x, y));
+        if (cell == null) {
+          continue;
+        }
+        for (RadioNode other: cell) {
+          /* Ignore ourselves */
+          if (other != node && pos.getDistanceTo(other.radio.getPosition()) < range) {
+            node.neighbors.add(other);
+          }
+        }
+      }
+    }
+    Collections.sort(node.neighbors, INDEX_ORDER);
+  }
+
+  private void addToCell(RadioNode node) {
+    ArrayList<RadioNode> cell = grid.get(node.cell);
+    if (cell == null) {
+      cell = new ArrayList<RadioNode>();
+      grid.put(node.cell, cell);
+    }
+    cell.add(node);
+  }
+
+  private void removeFromCell(RadioNode node) {
+    ArrayList<RadioNode> cell = grid.get(node.cell);
+    if (cell != null) {
+      cell.remove(node);
+      if (cell.isEmpty()) {
+        grid.remove(node.cell);
+      }
+    }
+  }
+
+  /**
+   * Creates edges according to distances. Each radio is only compared to
+   * the radios in its own and the eight surrounding grid cells.
+   */
+  private void analyzeEdges() {
+    nodes.clear();
+    grid.clear();
+    cellSize = Math.max(TRANSMITTING_RANGE, INTERFERENCE_RANGE);
+    edgesDirty = false;
+    if (cellSize <= 0) {
+      /* No radio can reach any other */
+      return;
+    }
+
+    int index = 0;
+    for (Radio radio: getRegisteredRadios()) {
+      RadioNode node = new RadioNode(radio, index++);
+      node.cell = getCell(radio.getPosition());
+      nodes.put(radio, node);
+      addToCell(node);
+    }
+    for (RadioNode node: nodes.values()) {
+      findNeighbors(node);
+    }
+  }
+
+  /**
+   * Updates the edges to and from a single moved mote. Edges are symmetric
+   * as all radios use the same ranges.
+   */
+  private void moteMoved(Mote mote) {
+    if (needsEdgeAnalysis() || cellSize <= 0) {
+      return;
+    }
+    RadioNode node = nodes.get(mote.getInterfaces().getRadio());
+    if (node == null) {
+      requestEdgeAnalysis();
+      return;
+    }
+
+    long cell = getCell(node.radio.getPosition());
+    if (cell != node.cell) {
+      removeFromCell(node);
+      node.cell = cell;
+      addToCell(node);
+    }
+
+    HashSet<RadioNode> oldNeighbors = new HashSet<RadioNode>(node.neighbors);
+    findNeighbors(node);
+    for (RadioNode other: node.neighbors) {
+      if (!oldNeighbors.remove(other)) {
+        /* New edge */
+        int i = Collections.binarySearch(other.neighbors, node, INDEX_ORDER);
+        other.neighbors.add(-i - 1, node);
+        other.destinations = null;
+      }
+    }
+    for (RadioNode other: oldNeighbors) {
+      /* Removed edge */
+      other.neighbors.remove(node);
+      other.destinations = null;
+    }
+  }
+
+  /**
+   * Returns all potential destination radios, i.e. all radios within
+   * interference or transmission range, whichever is larger, at full
+   * output power.
+   *
+   * @param source Source radio
+   * @return All potential destination radios, or null if none
+   */
+  private DestinationRadio[] getPotentialDestinations(Radio source) {
+    if (needsEdgeAnalysis()) {
+      analyzeEdges();
+    }
+    RadioNode node = nodes.get(source);
+    if (VERIFY_EDGES) {
+      verifyNeighbors(source, node);
+    }
+    if (node == null || node.neighbors.isEmpty()) {
+      return null;
+    }
+    if (node.destinations == null) {
+      node.destinations = new DestinationRadio[node.neighbors.size()];
+      for (int i = 0; i < node.destinations.length; i++) {
+        node.destinations[i] = new DestinationRadio(node.neighbors.get(i).radio);
+      }
+    }
+    return node.destinations;
+  }
+
+  /**
+   * Compares the neighbors found through the grid with those found by
+   * comparing the source with all registered radios, in registration order.
+   *
+   * @param source Source radio
+   * @param node Grid node of source, or null if none
+   */
+  private void verifyNeighbors(Radio source, RadioNode node) {
+    double range = Math.max(TRANSMITTING_RANGE, INTERFERENCE_RANGE);
+    ArrayList<Radio> expected = new ArrayList<Radio>();
+    for (Radio radio: getRegisteredRadios()) {
+      if (radio != source &&
+          source.getPosition().getDistanceTo(radio.getPosition()) < range) {
+        expected.add(radio);
+      }
+    }
+    ArrayList<Radio> found = new ArrayList<Radio>();
+    if (node != null) {
+      for (RadioNode other: node.neighbors) {
+        found.add(other.radio);
+      }
+    }
+    if (!found.equals(expected)) {
+      throw new IllegalStateException("UDGM grid neighbors of " + source.getMote() +
+          " differ: found " + found + ", expected " + expected);
+    }
+  }
+
   public void removed() {
   	super.removed();
   	
@@ -155,12 +363,12 @@ public class UDGM extends AbstractRadioMedium {
   
   public void setTxRange(double r) {
     TRANSMITTING_RANGE = r;
-    dgrm.requestEdgeAnalysis();
+    requestEdgeAnalysis();
   }
 
   public void setInterferenceRange(double r) {
     INTERFERENCE_RANGE = r;
-    dgrm.requestEdgeAnalysis();
+    requestEdgeAnalysis();
   }
 
   public RadioConnection createConnections(Radio sender) {
@@ -178,7 +386,7 @@ public class UDGM extends AbstractRadioMedium {
     * ((double) sender.getCurrentOutputPowerIndicator() / (double) sender.getOutputPowerIndicatorMax());
 
     /* Get all potential destination radios */
-    DestinationRadio[] potentialDestinations = dgrm.getPotentialDestinations(sender);
+    DestinationRadio[] potentialDestinations = getPotentialDestinations(sender);
     if (potentialDestinations == null) {
       return newConnection;
     }